@@ -0,0 +1,8 @@
+#!/usr/bin/env python3
+# CGI scenario of the bench: a fixed small page, no input
+import sys
+
+body = "<html><body><h1>hello from cgi</h1></body></html>\n"
+sys.stdout.write("Content-Type: text/html\r\n")
+sys.stdout.write("Content-Length: %d\r\n\r\n" % len(body))
+sys.stdout.write(body)
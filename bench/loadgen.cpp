@@ -0,0 +1,398 @@
+/*
+    HTTP load generator for the bench target. One thread per connection,
+    blocking sockets over loopback; each thread sends the request (or a
+    pipeline of them), reads the responses, and records the latency of
+    each one until the duration is up. The result is one JSON line on
+    stdout:
+
+    {"scenario":"small","connections":16,"duration_s":5.000,"requests":...,
+     "errors":0,"reconnects":...,"rps":...,"mb_per_s":...,
+     "latency_ms":{"p50":...,"p99":...,"p999":...,"max":...},"status":{"200":...}}
+
+    A connection the server closes between responses is reopened and the
+    requests that got no answer are sent again, counted as reconnects,
+    not errors: that is what a browser does with a keep-alive connection
+    that timed out. A request fails when its connection breaks in the
+    middle of a response, or when no response arrives within the timeout.
+
+    usage: loadgen [-a host] [-p port] [-c connections] [-d seconds]
+                   [-k] [-P depth] [-m method] [-b body_file]
+                   [-H "Name: value"]... [-n name] path
+*/
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <ctime>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <netdb.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#define LOADGEN_TIMEOUT_S 5         // per response
+#define LOADGEN_READ_CHUNK 65536
+
+struct Options
+{
+    std::string                 host;
+    std::string                 port;
+    int                         connections;
+    double                      duration;
+    bool                        keepalive;
+    int                         pipeline;
+    std::string                 method;
+    std::string                 body;
+    std::vector<std::string>    headers;
+    std::string                 name;
+    std::string                 path;
+
+    Options() : host("127.0.0.1"), port("8090"), connections(16), duration(5), keepalive(false),
+                pipeline(1), method("GET"), name("bench") {}
+};
+
+struct Worker
+{
+    const Options           *options;
+    const struct addrinfo   *address;
+    std::string             request;
+    double                  deadline;
+    // results
+    std::vector<double>     latencies;      // ms
+    std::map<int, unsigned long> statuses;
+    unsigned long           errors;
+    unsigned long           reconnects;
+    unsigned long long      bytes;
+    pthread_t               thread;
+
+    Worker() : options(NULL), address(NULL), deadline(0), errors(0), reconnects(0), bytes(0) {}
+};
+
+static double now()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool readFile(const std::string &path, std::string &out)
+{
+    FILE *file = fopen(path.c_str(), "rb");
+    char buffer[65536];
+    size_t n;
+
+    if (!file)
+        return false;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        out.append(buffer, n);
+    fclose(file);
+    return true;
+}
+
+static int openConnection(const struct addrinfo *address)
+{
+    int fd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+    struct timeval timeout = { LOADGEN_TIMEOUT_S, 0 };
+    int one = 1;
+
+    if (fd < 0)
+        return -1;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    if (connect(fd, address->ai_addr, address->ai_addrlen) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool sendAll(int fd, const std::string &data)
+{
+    size_t sent = 0;
+
+    while (sent < data.size())
+    {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        sent += n;
+    }
+    return true;
+}
+
+enum { RESPONSE_CLOSED = 0, RESPONSE_OK = 1, RESPONSE_BROKEN = -1 };
+
+// appends what the socket has to pending, false on close, error or timeout
+static bool fill(int fd, std::string &pending, Worker &worker)
+{
+    char buffer[LOADGEN_READ_CHUNK];
+    ssize_t n;
+
+    do
+        n = recv(fd, buffer, sizeof(buffer), 0);
+    while (n < 0 && errno == EINTR);
+    if (n <= 0)
+        return false;
+    worker.bytes += n;
+    pending.append(buffer, n);
+    return true;
+}
+
+/*
+    Reads one response off the connection, starting with whatever the
+    previous one left in pending. RESPONSE_CLOSED: the connection was
+    closed before the first byte, RESPONSE_BROKEN: closed or timed out
+    half way.
+*/
+static int readResponse(int fd, std::string &pending, Worker &worker, int &status, bool &server_closes)
+{
+    size_t head_end;
+
+    while ((head_end = pending.find("\r\n\r\n")) == std::string::npos)
+    {
+        if (!fill(fd, pending, worker))
+            return pending.empty() ? RESPONSE_CLOSED : RESPONSE_BROKEN;
+    }
+    std::string head = pending.substr(0, head_end + 2);
+    pending.erase(0, head_end + 4);
+
+    status = head.size() > 12 ? atoi(head.c_str() + 9) : 0;
+    std::string lower = head;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    server_closes = lower.find("\r\nconnection: close") != std::string::npos;
+    bool head_only = worker.options->method == "HEAD" || status == 204 || status == 304;
+
+    size_t length_at = lower.find("\r\ncontent-length:");
+    if (head_only)
+        return RESPONSE_OK;
+    if (lower.find("\r\ntransfer-encoding: chunked") != std::string::npos)
+    {
+        while (true)
+        {
+            size_t line_end;
+            while ((line_end = pending.find("\r\n")) == std::string::npos)
+                if (!fill(fd, pending, worker))
+                    return RESPONSE_BROKEN;
+            size_t size = strtoul(pending.c_str(), NULL, 16);
+            while (pending.size() < line_end + 2 + size + 2)
+                if (!fill(fd, pending, worker))
+                    return RESPONSE_BROKEN;
+            pending.erase(0, line_end + 2 + size + 2);
+            if (size == 0)
+                return RESPONSE_OK;
+        }
+    }
+    if (length_at != std::string::npos)
+    {
+        size_t length = strtoul(lower.c_str() + length_at + 17, NULL, 10);
+        while (pending.size() < length)
+            if (!fill(fd, pending, worker))
+                return RESPONSE_BROKEN;
+        pending.erase(0, length);
+        return RESPONSE_OK;
+    }
+    // no length: the body runs to the end of the connection
+    while (fill(fd, pending, worker))
+        ;
+    pending.clear();
+    server_closes = true;
+    return RESPONSE_OK;
+}
+
+static void *run(void *arg)
+{
+    Worker &worker = *static_cast<Worker *>(arg);
+    const Options &options = *worker.options;
+    int fd = -1;
+    std::string pending;
+
+    while (now() < worker.deadline)
+    {
+        // without keep-alive the connect is part of every request
+        double started = now();
+        if (fd < 0 && (fd = openConnection(worker.address)) < 0)
+        {
+            ++worker.errors;
+            usleep(1000);
+            continue;
+        }
+        // a pipeline goes out in one write, its answers come back in order
+        int depth = options.pipeline;
+        std::string batch;
+        for (int i = 0; i < depth; ++i)
+            batch += worker.request;
+        bool reopen = !options.keepalive;
+
+        if (!sendAll(fd, batch))
+        {
+            close(fd);
+            fd = -1;
+            ++worker.reconnects;
+            continue;
+        }
+        int answered = 0;
+        while (answered < depth)
+        {
+            int status = 0;
+            bool server_closes = false;
+            int result = readResponse(fd, pending, worker, status, server_closes);
+
+            if (result == RESPONSE_OK)
+            {
+                worker.latencies.push_back((now() - started) * 1000);
+                ++worker.statuses[status];
+                ++answered;
+                if (server_closes)
+                    break;
+                continue;
+            }
+            if (result == RESPONSE_BROKEN)
+                ++worker.errors;
+            else
+                ++worker.reconnects;
+            break;
+        }
+        // a closed keep-alive connection, or what is left of a pipeline, starts over on a new one
+        if (answered < depth || reopen)
+        {
+            close(fd);
+            fd = -1;
+            pending.clear();
+        }
+    }
+    if (fd >= 0)
+        close(fd);
+    return NULL;
+}
+
+static double percentile(const std::vector<double> &sorted, double fraction)
+{
+    if (sorted.empty())
+        return 0;
+    size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+static void usage()
+{
+    fprintf(stderr, "usage: loadgen [-a host] [-p port] [-c connections] [-d seconds] [-k] [-P depth]\n"
+                    "               [-m method] [-b body_file] [-H \"Name: value\"]... [-n name] path\n");
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "a:p:c:d:kP:m:b:H:n:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'a': options.host = optarg; break;
+            case 'p': options.port = optarg; break;
+            case 'c': options.connections = atoi(optarg); break;
+            case 'd': options.duration = atof(optarg); break;
+            case 'k': options.keepalive = true; break;
+            case 'P': options.pipeline = atoi(optarg); break;
+            case 'm': options.method = optarg; break;
+            case 'b':
+                if (!readFile(optarg, options.body))
+                {
+                    fprintf(stderr, "loadgen: cannot read %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'H': options.headers.push_back(optarg); break;
+            case 'n': options.name = optarg; break;
+            default: usage();
+        }
+    }
+    if (optind != argc - 1 || options.connections < 1 || options.duration <= 0 || options.pipeline < 1)
+        usage();
+    options.path = argv[optind];
+    if (options.pipeline > 1)
+        options.keepalive = true;
+
+    struct addrinfo hints;
+    struct addrinfo *address = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(options.host.c_str(), options.port.c_str(), &hints, &address) != 0 || !address)
+    {
+        fprintf(stderr, "loadgen: cannot resolve %s:%s\n", options.host.c_str(), options.port.c_str());
+        return 1;
+    }
+
+    std::string request = options.method + " " + options.path + " HTTP/1.1\r\n"
+        + "Host: " + options.host + ":" + options.port + "\r\n"
+        + "User-Agent: webserv-loadgen\r\n";
+    for (size_t i = 0; i < options.headers.size(); ++i)
+        request += options.headers[i] + "\r\n";
+    if (!options.keepalive)
+        request += "Connection: close\r\n";
+    if (!options.body.empty())
+    {
+        char length[32];
+        snprintf(length, sizeof(length), "%lu", static_cast<unsigned long>(options.body.size()));
+        request += std::string("Content-Length: ") + length + "\r\n";
+    }
+    request += "\r\n" + options.body;
+
+    signal(SIGPIPE, SIG_IGN);
+    std::vector<Worker> workers(options.connections);
+    double started = now();
+    for (size_t i = 0; i < workers.size(); ++i)
+    {
+        workers[i].options = &options;
+        workers[i].address = address;
+        workers[i].request = request;
+        workers[i].deadline = started + options.duration;
+        workers[i].latencies.reserve(65536);
+        pthread_create(&workers[i].thread, NULL, run, &workers[i]);
+    }
+
+    std::vector<double> latencies;
+    std::map<int, unsigned long> statuses;
+    unsigned long errors = 0;
+    unsigned long reconnects = 0;
+    unsigned long long bytes = 0;
+    for (size_t i = 0; i < workers.size(); ++i)
+    {
+        pthread_join(workers[i].thread, NULL);
+        latencies.insert(latencies.end(), workers[i].latencies.begin(), workers[i].latencies.end());
+        for (std::map<int, unsigned long>::const_iterator it = workers[i].statuses.begin(); it != workers[i].statuses.end(); ++it)
+            statuses[it->first] += it->second;
+        errors += workers[i].errors;
+        reconnects += workers[i].reconnects;
+        bytes += workers[i].bytes;
+    }
+    double elapsed = now() - started;
+    freeaddrinfo(address);
+    std::sort(latencies.begin(), latencies.end());
+
+    printf("{\"scenario\":\"%s\",\"connections\":%d,\"pipeline\":%d,\"keepalive\":%s,\"duration_s\":%.3f,"
+           "\"requests\":%lu,\"errors\":%lu,\"reconnects\":%lu,\"rps\":%.1f,\"mb_per_s\":%.2f,"
+           "\"latency_ms\":{\"p50\":%.3f,\"p99\":%.3f,\"p999\":%.3f,\"max\":%.3f},\"status\":{",
+           options.name.c_str(), options.connections, options.pipeline, options.keepalive ? "true" : "false", elapsed,
+           static_cast<unsigned long>(latencies.size()), errors, reconnects, latencies.size() / elapsed,
+           bytes / elapsed / (1024 * 1024), percentile(latencies, 0.50), percentile(latencies, 0.99),
+           percentile(latencies, 0.999), latencies.empty() ? 0 : latencies.back());
+    for (std::map<int, unsigned long>::const_iterator it = statuses.begin(); it != statuses.end(); ++it)
+        printf("%s\"%d\":%lu", it == statuses.begin() ? "" : ",", it->first, it->second);
+    printf("}}\n");
+    return 0;
+}
@@ -0,0 +1,513 @@
+/*
+    make microbench: in-process microbenchmarks of the request hot paths,
+    no sockets to the outside and no server loop. Each benchmark is a
+    function running its body while state.KeepRunning(); the harness
+    grows the iteration count until a run lasts min_time, repeats the run
+    and reports the median time per iteration, so two builds compare on
+    stable numbers.
+
+        bench/micro [-t min_time_s] [-r repetitions] [-j] [filter]
+
+    filter keeps the benchmarks whose name contains it, -j prints one JSON
+    line per benchmark instead of the table.
+
+    The server objects are linked as built by the Makefile: numbers
+    follow its CFLAGS, and LOG_LEVEL=1 leaves the debug statements out.
+*/
+#include "../include/request/HttpRequestBuilder.hpp"
+#include "../include/request/Post.hpp"
+#include "../include/response/HttpResponse.hpp"
+#include "../include/config/ServerConfig.hpp"
+#include "../include/config/Location.hpp"
+#include "../include/Logger.hpp"
+#include "../include/Metrics.hpp"
+#include <algorithm>
+#include <map>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace
+{
+
+class State
+{
+    private:
+        size_t  _iterations;
+        size_t  _done;
+        size_t  _bytes;
+        bool    _running;
+        struct timespec _start;
+        double  _elapsed;
+
+    public:
+        explicit State(size_t iterations) : _iterations(iterations), _done(0), _bytes(0), _running(false), _elapsed(0) {}
+
+        bool KeepRunning()
+        {
+            if (!_running)
+            {
+                _running = true;
+                clock_gettime(CLOCK_MONOTONIC, &_start);
+            }
+            if (_done < _iterations)
+            {
+                ++_done;
+                return true;
+            }
+            struct timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            _elapsed += (now.tv_sec - _start.tv_sec) + (now.tv_nsec - _start.tv_nsec) / 1e9;
+            _running = false;
+            return false;
+        }
+        // bytes handled by one iteration, reported as throughput
+        void SetBytesPerIteration(size_t bytes) { _bytes = bytes; }
+
+        size_t  iterations() const { return _iterations; }
+        size_t  bytes() const { return _bytes; }
+        double  elapsed() const { return _elapsed; }
+};
+
+// keeps the compiler from dropping a result nobody reads
+template <typename T>
+void DoNotOptimize(const T &value)
+{
+    __asm__ __volatile__("" : : "g"(&value) : "memory");
+}
+
+typedef void (*BenchmarkFunction)(State &);
+
+struct Benchmark
+{
+    const char          *name;
+    BenchmarkFunction   function;
+};
+
+/* fixtures */
+
+std::string RequestHead(size_t headers)
+{
+    std::string head = "GET /images/photos/2024/caf%C3%A9/beach.jpg?size=large&format=webp&q=80 HTTP/1.1\r\n"
+                       "Host: localhost:8080\r\n";
+    static const char *NAMES[] = { "User-Agent", "Accept", "Accept-Language", "Accept-Encoding", "Referer",
+                                   "Cookie", "Cache-Control", "Upgrade-Insecure-Requests", "Sec-Fetch-Dest", "Sec-Fetch-Mode" };
+
+    for (size_t i = 0; i < headers; ++i)
+    {
+        head += NAMES[i % 10];
+        if (i >= 10)
+        {
+            char suffix[32];
+            snprintf(suffix, sizeof(suffix), "-%lu", static_cast<unsigned long>(i / 10));
+            head += suffix;
+        }
+        head += ": Mozilla/5.0 (X11; Linux x86_64) text/html,application/xhtml+xml;q=0.9\r\n";
+    }
+    return head + "\r\n";
+}
+
+std::vector<std::string> AllowedMethods()
+{
+    std::vector<std::string> methods;
+
+    methods.push_back("GET");
+    methods.push_back("POST");
+    methods.push_back("DELETE");
+    return methods;
+}
+
+// locations /, then /app0/ .. /appN/ each with a nested /appN/static/
+ServerConfig ServerWithLocations(size_t count)
+{
+    ServerConfig config;
+    Location root;
+
+    root.set_path("/");
+    root.set_allowMethods(AllowedMethods());
+    config.add_location(root);
+    for (size_t i = 0; config.get_locations().size() < count; ++i)
+    {
+        char path[64];
+        Location location;
+
+        snprintf(path, sizeof(path), i % 2 ? "/app%lu/static/" : "/app%lu/", static_cast<unsigned long>(i / 2));
+        location.set_path(path);
+        location.set_allowMethods(AllowedMethods());
+        config.add_location(location);
+    }
+    return config;
+}
+
+std::string MultipartBody(const std::string &boundary, size_t files, size_t file_size)
+{
+    std::string body;
+    std::string content(file_size, 'x');
+
+    // a few lines so the parser's line handling is exercised too
+    for (size_t i = 64; i < content.size(); i += 65)
+        content[i] = '\n';
+    body += "--" + boundary + "\r\nContent-Disposition: form-data; name=\"title\"\r\n\r\nholiday pictures\r\n";
+    for (size_t i = 0; i < files; ++i)
+    {
+        char name[64];
+        snprintf(name, sizeof(name), "photo-%lu.jpg", static_cast<unsigned long>(i));
+        body += "--" + boundary + "\r\nContent-Disposition: form-data; name=\"file\"; filename=\"" + name + "\"\r\n"
+                "Content-Type: image/jpeg\r\n\r\n" + content + "\r\n";
+    }
+    return body + "--" + boundary + "--\r\n";
+}
+
+// counters and histograms filled with long numbers, the widest lines Render can produce
+void FillMetrics()
+{
+    for (int i = 0; i < Metrics::COUNTER_COUNT; ++i)
+        Metrics::Increment(static_cast<Metrics::Counter>(i), 18000000000000000000UL);
+    for (int i = 0; i < Metrics::HISTOGRAM_COUNT; ++i)
+        for (double seconds = 0.00005; seconds < 100; seconds *= 1.5)
+            Metrics::Observe(static_cast<Metrics::Histogram>(i), seconds);
+}
+
+/*
+    Prometheus text format, as far as Render uses it: every line is a
+    "# HELP name text" or "# TYPE name counter|gauge|histogram" comment or
+    a "name value" / "name{labels} value" sample. Returns the first line that is neither,
+    empty when all are well formed.
+*/
+std::string CheckExposition(const std::string &text)
+{
+    size_t start = 0;
+
+    if (text.empty() || text[text.size() - 1] != '\n')
+        return "(no final newline)";
+    while (start < text.size())
+    {
+        size_t end = text.find('\n', start);
+        std::string line = text.substr(start, end - start);
+        start = end + 1;
+        bool help = line.compare(0, 7, "# HELP ") == 0;
+        bool type = line.compare(0, 7, "# TYPE ") == 0;
+        size_t i = help || type ? 7 : 0;
+        size_t name = i;
+        while (i < line.size() && (isalnum(static_cast<unsigned char>(line[i])) || line[i] == '_' || line[i] == ':'))
+            ++i;
+        if (i == name || isdigit(static_cast<unsigned char>(line[name])))
+            return line;
+        if (help)
+        {
+            if (i >= line.size() || line[i] != ' ')
+                return line;
+            continue;
+        }
+        if (type)
+        {
+            std::string kind = line.substr(i);
+            if (kind != " counter" && kind != " gauge" && kind != " histogram")
+                return line;
+            continue;
+        }
+        if (i < line.size() && line[i] == '{')
+        {
+            size_t close = line.find('}', i);
+            if (close == std::string::npos || line.find('{', i + 1) < close)
+                return line;
+            i = close + 1;
+        }
+        if (i >= line.size() || line[i] != ' ' || i + 1 >= line.size())
+            return line;
+        std::string value = line.substr(i + 1);
+        char *endptr;
+        strtod(value.c_str(), &endptr);
+        if (*endptr != '\0')
+            return line;
+    }
+    return "";
+}
+
+/* benchmarks */
+
+void ParseRequestHead(State &state, size_t headers)
+{
+    ServerConfig config = ServerWithLocations(1);
+    const std::string head = RequestHead(headers);
+
+    state.SetBytesPerIteration(head.size());
+    while (state.KeepRunning())
+    {
+        std::string raw = head;
+        HttpRequestBuilder builder;
+        builder.ParseRequest(raw, config);
+        DoNotOptimize(builder.GetHttpRequest());
+    }
+}
+
+void BM_ParseRequest_2Headers(State &state) { ParseRequestHead(state, 2); }
+void BM_ParseRequest_20Headers(State &state) { ParseRequestHead(state, 20); }
+
+void BM_UrlDecode(State &state)
+{
+    HttpRequestBuilder builder;
+    std::string line = "GET /files/r%C3%A9sum%C3%A9%20final%20(2)/notes+and+drafts/%E2%9C%93-done.txt"
+                       "?q=caf%C3%A9+cr%C3%A8me&tags=a%2Cb%2Cc&redirect=%2Fhome%2Fuser HTTP/1.1\r\n";
+
+    state.SetBytesPerIteration(line.size());
+    while (state.KeepRunning())
+        DoNotOptimize(builder.UrlDecode(line));
+}
+
+void BM_ParseQueryString_32Pairs(State &state)
+{
+    std::string query;
+
+    for (int i = 0; i < 32; ++i)
+    {
+        char pair[64];
+        snprintf(pair, sizeof(pair), "%sfield%d=value-%d", i ? "&" : "", i, i * 7919);
+        query += pair;
+    }
+    state.SetBytesPerIteration(query.size());
+    while (state.KeepRunning())
+    {
+        // the pairs pile up in the request, one builder per query like the server
+        HttpRequestBuilder builder;
+        builder.ParseQueryString(query);
+        DoNotOptimize(builder.GetHttpRequest());
+    }
+}
+
+void MatchLocation(State &state, size_t count)
+{
+    ServerConfig config = ServerWithLocations(count);
+    char path[3][64];
+
+    // deepest location, a middle one and a miss falling back to /
+    snprintf(path[0], sizeof(path[0]), "/app%lu/static/js/app.min.js", static_cast<unsigned long>(count / 2 - 1));
+    snprintf(path[1], sizeof(path[1]), "/app%lu/index.html", static_cast<unsigned long>(count / 4));
+    snprintf(path[2], sizeof(path[2]), "/missing/page.html");
+    const std::string paths[3] = { path[0], path[1], path[2] };
+    size_t i = 0;
+
+    while (state.KeepRunning())
+        DoNotOptimize(config.findBestMatchingLocation(paths[i++ % 3]));
+}
+
+void BM_FindBestMatchingLocation_16(State &state) { MatchLocation(state, 16); }
+void BM_FindBestMatchingLocation_256(State &state) { MatchLocation(state, 256); }
+void BM_FindBestMatchingLocation_1024(State &state) { MatchLocation(state, 1024); }
+
+void ParseMultipart(State &state, size_t files, size_t file_size)
+{
+    const std::string boundary = "----WebKitFormBoundary7MA4YWxkTrZu0gW";
+    const std::string body = MultipartBody(boundary, files, file_size);
+    Post post;
+
+    state.SetBytesPerIteration(body.size());
+    while (state.KeepRunning())
+        DoNotOptimize(post.parseMultipartForm(body, boundary).size());
+}
+
+void BM_ParseMultipartForm_1MB(State &state) { ParseMultipart(state, 4, 256 * 1024); }
+void BM_ParseMultipartForm_16MB(State &state) { ParseMultipart(state, 1, 16 * 1024 * 1024); }
+
+std::map<std::string, std::string> ResponseHeaders()
+{
+    std::map<std::string, std::string> headers;
+
+    headers["Server"] = "webserv";
+    headers["Cache-Control"] = "max-age=3600";
+    headers["ETag"] = "\"5f3a-65e1c2b0\"";
+    headers["Last-Modified"] = "Mon, 01 Jan 2024 00:00:00 GMT";
+    headers["Accept-Ranges"] = "bytes";
+    headers["Vary"] = "Accept-Encoding";
+    headers["Set-Cookie"] = "session=8f14e45fceea167a5a36dedd4bea2543; Path=/; HttpOnly";
+    return headers;
+}
+
+void BM_ResponseHeaderBlock(State &state)
+{
+    HttpResponse response(200, ResponseHeaders(), "text/html", false, false);
+    std::string out;
+
+    while (state.KeepRunning())
+    {
+        out.clear();
+        response.appendHeaderBlock(out);
+        DoNotOptimize(out);
+    }
+    state.SetBytesPerIteration(out.size());
+}
+
+// whole serialization of a buffered response into a local socket, drained as it fills
+void SerializeResponse(State &state, size_t body_size)
+{
+    const std::map<std::string, std::string> headers = ResponseHeaders();
+    const std::string body(body_size, 'b');
+    std::vector<char> drain(1 << 20);
+    int sockets[2];
+
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) < 0)
+    {
+        perror("socketpair");
+        exit(1);
+    }
+    // both ends non-blocking, the server's client sockets are from accept4 on
+    fcntl(sockets[0], F_SETFL, O_NONBLOCK);
+    fcntl(sockets[1], F_SETFL, O_NONBLOCK);
+    state.SetBytesPerIteration(body_size);
+    while (state.KeepRunning())
+    {
+        HttpResponse response(200, headers, "text/html", false, false);
+        response.setBuffer(body);
+        while (!response.flushOutput(sockets[0]))
+            while (read(sockets[1], &drain[0], drain.size()) > 0)
+                ;
+        while (read(sockets[1], &drain[0], drain.size()) > 0)
+            ;
+    }
+    close(sockets[0]);
+    close(sockets[1]);
+}
+
+void BM_ResponseSerialize_1KB(State &state) { SerializeResponse(state, 1024); }
+void BM_ResponseSerialize_64KB(State &state) { SerializeResponse(state, 64 * 1024); }
+
+// /metrics page; the page is checked against the text format before the first run
+void BM_MetricsRender(State &state)
+{
+    static bool checked = false;
+
+    if (!checked)
+    {
+        FillMetrics();
+        std::string bad = CheckExposition(Metrics::Render());
+        if (!bad.empty())
+        {
+            fprintf(stderr, "MetricsRender: malformed line: %s\n", bad.c_str());
+            exit(1);
+        }
+        checked = true;
+    }
+    while (state.KeepRunning())
+    {
+        std::string page = Metrics::Render();
+        DoNotOptimize(page);
+    }
+}
+
+const Benchmark BENCHMARKS[] = {
+    { "ParseRequest/2_headers", BM_ParseRequest_2Headers },
+    { "ParseRequest/20_headers", BM_ParseRequest_20Headers },
+    { "UrlDecode", BM_UrlDecode },
+    { "ParseQueryString/32_pairs", BM_ParseQueryString_32Pairs },
+    { "FindBestMatchingLocation/16", BM_FindBestMatchingLocation_16 },
+    { "FindBestMatchingLocation/256", BM_FindBestMatchingLocation_256 },
+    { "FindBestMatchingLocation/1024", BM_FindBestMatchingLocation_1024 },
+    { "ParseMultipartForm/1MB", BM_ParseMultipartForm_1MB },
+    { "ParseMultipartForm/16MB", BM_ParseMultipartForm_16MB },
+    { "ResponseHeaderBlock", BM_ResponseHeaderBlock },
+    { "ResponseSerialize/1KB", BM_ResponseSerialize_1KB },
+    { "ResponseSerialize/64KB", BM_ResponseSerialize_64KB },
+    { "MetricsRender", BM_MetricsRender },
+};
+
+/* harness */
+
+struct Result
+{
+    size_t  iterations;
+    double  median_ns;
+    double  min_ns;
+    double  max_ns;
+    double  mb_per_s;
+};
+
+Result Run(const Benchmark &benchmark, double min_time, int repetitions)
+{
+    std::vector<double> per_iteration;
+    size_t iterations = 1;
+    size_t bytes = 0;
+    Result result;
+
+    // calibration: grow the count until one run takes min_time
+    for (;;)
+    {
+        State state(iterations);
+        benchmark.function(state);
+        if (state.elapsed() >= min_time || iterations >= (size_t(1) << 40))
+            break;
+        double scale = state.elapsed() > 0 ? min_time * 1.4 / state.elapsed() : 100;
+        iterations = static_cast<size_t>(iterations * std::min(std::max(scale, 2.0), 100.0));
+    }
+    for (int r = 0; r < repetitions; ++r)
+    {
+        State state(iterations);
+        benchmark.function(state);
+        per_iteration.push_back(state.elapsed() * 1e9 / iterations);
+        bytes = state.bytes();
+    }
+    std::sort(per_iteration.begin(), per_iteration.end());
+    result.iterations = iterations;
+    result.median_ns = per_iteration[per_iteration.size() / 2];
+    result.min_ns = per_iteration.front();
+    result.max_ns = per_iteration.back();
+    result.mb_per_s = bytes ? bytes / (result.median_ns / 1e9) / (1024 * 1024) : 0;
+    return result;
+}
+
+void Usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-t min_time_s] [-r repetitions] [-j] [filter]\n", name);
+    exit(2);
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    double min_time = 0.5;
+    int repetitions = 5;
+    bool json = false;
+    const char *filter = "";
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:r:j")) != -1)
+    {
+        if (opt == 't')
+            min_time = atof(optarg);
+        else if (opt == 'r')
+            repetitions = atoi(optarg);
+        else if (opt == 'j')
+            json = true;
+        else
+            Usage(argv[0]);
+    }
+    if (optind < argc)
+        filter = argv[optind];
+    if (min_time <= 0 || repetitions < 1)
+        Usage(argv[0]);
+    // the parsers log at info on bad input, nothing here should print
+    Logger::Open("stderr", "error");
+
+    if (!json)
+        printf("%-32s %14s %14s %14s %12s %10s\n", "benchmark", "time/op (ns)", "min (ns)", "max (ns)", "iterations", "MB/s");
+    for (size_t i = 0; i < sizeof(BENCHMARKS) / sizeof(BENCHMARKS[0]); ++i)
+    {
+        if (!strstr(BENCHMARKS[i].name, filter))
+            continue;
+        Result result = Run(BENCHMARKS[i], min_time, repetitions);
+        if (json)
+            printf("{\"benchmark\":\"%s\",\"time_ns\":%.1f,\"min_ns\":%.1f,\"max_ns\":%.1f,\"iterations\":%lu,\"mb_per_s\":%.2f}\n",
+                BENCHMARKS[i].name, result.median_ns, result.min_ns, result.max_ns,
+                static_cast<unsigned long>(result.iterations), result.mb_per_s);
+        else
+            printf("%-32s %14.1f %14.1f %14.1f %12lu %10.2f\n", BENCHMARKS[i].name, result.median_ns, result.min_ns,
+                result.max_ns, static_cast<unsigned long>(result.iterations), result.mb_per_s);
+        fflush(stdout);
+    }
+    return 0;
+}
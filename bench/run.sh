@@ -0,0 +1,77 @@
+#!/bin/bash
+#
+# make bench: starts ./webserver on bench/bench.config in a scratch
+# directory and runs every scenario through bench/loadgen, one JSON line
+# per scenario on stdout (and appended to $BENCH_OUT when set).
+#
+#   BENCH_DIR       scratch directory, recreated on each run (/tmp/webserv-bench)
+#   BENCH_DURATION  seconds per scenario (5)
+#   BENCH_CONNS     concurrent connections (16)
+#   BENCH_OUT       file the results are appended to
+#
+set -e
+
+REPO=$(cd "$(dirname "$0")/.." && pwd)
+BENCH_DIR=${BENCH_DIR:-/tmp/webserv-bench}
+DURATION=${BENCH_DURATION:-5}
+CONNS=${BENCH_CONNS:-16}
+PORT=8090
+LOADGEN="$REPO/bench/loadgen"
+BOUNDARY=webservbenchboundary
+
+# Fixed content: same sizes and listing on every run
+rm -rf "$BENCH_DIR"
+mkdir -p "$BENCH_DIR/www/files" "$BENCH_DIR/www/cgi-bin" "$BENCH_DIR/uploads"
+cp "$REPO/mime.types" "$BENCH_DIR/"
+cp "$REPO/bench/hello.py" "$BENCH_DIR/www/cgi-bin/hello.py"
+head -c 1024 /dev/zero | tr '\0' 'a' > "$BENCH_DIR/www/index.html"
+head -c 1024 /dev/zero | tr '\0' 'a' > "$BENCH_DIR/www/small.html"
+head -c 16777216 /dev/zero > "$BENCH_DIR/www/large.bin"
+i=0
+while [ $i -lt 200 ]; do
+    head -c $((i * 37)) /dev/zero > "$BENCH_DIR/www/files/entry-$i.txt"
+    i=$((i + 1))
+done
+{
+    printf -- '--%s\r\n' "$BOUNDARY"
+    printf 'Content-Disposition: form-data; name="file"; filename="bench.bin"\r\n'
+    printf 'Content-Type: application/octet-stream\r\n\r\n'
+    head -c 65536 /dev/zero
+    printf '\r\n--%s--\r\n' "$BOUNDARY"
+} > "$BENCH_DIR/upload.body"
+
+cd "$BENCH_DIR"
+"$REPO/webserver" "$REPO/bench/bench.config" > server.out 2>&1 &
+SERVER=$!
+# uploaded files can run into gigabytes, they go with the server
+trap 'kill -TERM $SERVER 2>/dev/null; wait $SERVER 2>/dev/null; rm -rf "$BENCH_DIR/uploads"' EXIT INT TERM
+
+tries=0
+until (exec 3<>/dev/tcp/127.0.0.1/$PORT) 2>/dev/null || [ $tries -ge 50 ]; do
+    sleep 0.1
+    tries=$((tries + 1))
+done
+if ! kill -0 $SERVER 2>/dev/null; then
+    echo "bench: the server did not start, see $BENCH_DIR/server.out" >&2
+    exit 1
+fi
+
+scenario() {
+    name=$1
+    shift
+    result=$("$LOADGEN" -p $PORT -d "$DURATION" -n "$name" "$@")
+    echo "$result"
+    if [ -n "$BENCH_OUT" ]; then
+        echo "$result" >> "$BENCH_OUT"
+    fi
+}
+
+scenario small_close      -c "$CONNS"      /small.html
+scenario small_keepalive  -c "$CONNS" -k   /small.html
+scenario small_pipelined  -c "$CONNS" -P 8 /small.html
+scenario large_download   -c 4             /large.bin
+scenario not_found        -c "$CONNS"      /missing.html
+scenario autoindex        -c "$CONNS"      /files/
+scenario cgi              -c 4             /cgi-bin/hello.py
+scenario upload_multipart -c 4 -m POST -b "$BENCH_DIR/upload.body" \
+    -H "Content-Type: multipart/form-data; boundary=$BOUNDARY" /uploads
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "../include/request/HttpRequestBuilder.hpp"
+#include "../include/config/ServerConfig.hpp"
+#include "../include/config/Location.hpp"
+#include "../include/Logger.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <stdint.h>
+
+/*
+    Shared by the fuzz targets: every target is one LLVMFuzzerTestOneInput,
+    built either against libFuzzer (clang, -fsanitize=fuzzer) or against
+    fuzz/driver.cpp, so each fuzz/<name>_fuzzer.cpp is the whole target.
+*/
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+// the parsers log bad input at info, one line per exec would drown the run
+extern "C" int LLVMFuzzerInitialize(int *, char ***)
+{
+    Logger::Open("stderr", "crit");
+    return 0;
+}
+
+// what the location checks of the parser see: / for every method, /upload/ for POST only
+inline const ServerConfig &FuzzServerConfig()
+{
+    static ServerConfig *config = NULL;
+
+    if (!config)
+    {
+        std::vector<std::string> methods;
+        Location root;
+        Location upload;
+
+        config = new ServerConfig();
+        methods.push_back("GET");
+        methods.push_back("HEAD");
+        methods.push_back("POST");
+        methods.push_back("DELETE");
+        root.set_path("/");
+        root.set_allowMethods(methods);
+        config->add_location(root);
+        methods.assign(1, "POST");
+        upload.set_path("/upload/");
+        upload.set_allowMethods(methods);
+        config->add_location(upload);
+    }
+    return *config;
+}
+
+// an invariant broke: report it and abort so the engine keeps the input
+#define FUZZ_CHECK(condition, message) \
+    do { \
+        if (!(condition)) \
+        { \
+            fprintf(stderr, "fuzz check failed: %s (%s:%d)\n", message, __FILE__, __LINE__); \
+            abort(); \
+        } \
+    } while (0)
@@ -0,0 +1,264 @@
+/*
+    Differential check of the request reader: the same byte stream sent in
+    one write and in fragments cut at pseudo-random offsets must give the
+    same request. The first 4 input bytes seed the cuts, so a failing input
+    replays the exact same split.
+
+    Both sides go through the server's own read path. A WebServer listens
+    on a unix socket, accepts the connection, and
+    ClientConnection::GenerateRequest runs once per wakeup as the event loop
+    calls it. GenerateRequest keeps a head that arrives in pieces until its
+    CRLF CRLF, a full buffer or the end of the stream, parses it in one go, then reads the rest of an in-memory
+    body itself. The fragmented side writes one fragment and waits until it
+    has been read before sending the next, so every recv sees exactly one
+    fragment. An incremental parser goes behind GenerateRequest and is held
+    to the same results.
+*/
+#include "FuzzTarget.hpp"
+#include "../include/WebServer.hpp"
+#include "../include/BufferPool.hpp"
+#include <pthread.h>
+#include <sys/ioctl.h>
+
+namespace
+{
+
+// the event loop's side of a connection, without the loop
+class FuzzServer : public WebServer
+{
+    private:
+        std::string _path;
+        int         _listener;
+
+    public:
+        FuzzServer() : _listener(-1) {}
+
+        void Start()
+        {
+            char path[64];
+            std::vector<ServerConfig> configs(1, FuzzServerConfig());
+
+            snprintf(path, sizeof(path), "/tmp/webserv-differential.%d.sock", static_cast<int>(getpid()));
+            _path = path;
+            configs[0].set_unix_path(_path);
+            FUZZ_CHECK(init(configs) == 0, "server did not start");
+            for (int fd = 0; fd < FD_SETSIZE && _listener < 0; ++fd)
+                if (isListeningSocket(fd))
+                    _listener = fd;
+            FUZZ_CHECK(_listener >= 0, "no listening socket");
+        }
+
+        const std::string &Path() const { return _path; }
+
+        // accepts the one pending connection, NULL when there is none
+        ClientConnection *Accept()
+        {
+            acceptNewConnection(_listener);
+            for (int fd = 0; fd < FD_SETSIZE; ++fd)
+                if (getClient(fd))
+                    return getClient(fd);
+            return NULL;
+        }
+
+        void Close(int fd) { closeClientConnection(fd); }
+};
+
+FuzzServer &Server()
+{
+    static FuzzServer *server = NULL;
+
+    if (!server)
+    {
+        server = new FuzzServer();
+        server->Start();
+    }
+    return *server;
+}
+
+// at exit: the pool's free lists die with the statics and LeakSanitizer would report their buffers
+void Shutdown()
+{
+    size_t capacity;
+
+    unlink(Server().Path().c_str());
+    while (BufferPool::Idle(BUFFER_SMALL))
+        delete[] BufferPool::Acquire(BUFFER_SMALL, capacity);
+    while (BufferPool::Idle(BUFFER_LARGE))
+        delete[] BufferPool::Acquire(BUFFER_LARGE, capacity);
+}
+
+struct Parsed
+{
+    int                                                 status;     // HttpException code, 0 when accepted
+    std::string                                         method;
+    std::string                                         location;
+    std::string                                         version;
+    std::string                                         query;
+    std::vector<std::pair<std::string, std::string> >   query_pairs;
+    std::map<std::string, std::string>                  headers;
+    std::string                                         body;
+
+    bool operator==(const Parsed &rhs) const
+    {
+        return status == rhs.status && method == rhs.method && location == rhs.location && version == rhs.version
+            && query == rhs.query && query_pairs == rhs.query_pairs && headers == rhs.headers && body == rhs.body;
+    }
+};
+
+void Dump(const char *label, const Parsed &parsed)
+{
+    fprintf(stderr, "%s: status %d, %s %s %s, query \"%s\", %lu headers, body %lu bytes\n", label, parsed.status,
+        parsed.method.c_str(), Logger::Escape(parsed.location).c_str(), Logger::Escape(parsed.version).c_str(),
+        Logger::Escape(parsed.query).c_str(), static_cast<unsigned long>(parsed.headers.size()),
+        static_cast<unsigned long>(parsed.body.size()));
+    for (std::map<std::string, std::string>::const_iterator it = parsed.headers.begin(); it != parsed.headers.end(); ++it)
+        fprintf(stderr, "    %s: %s\n", Logger::Escape(it->first).c_str(), Logger::Escape(it->second).c_str());
+}
+
+// the client: one write per piece, each read by the server before the next, then end of stream
+struct Writer
+{
+    int                                 client;
+    int                                 server;     // its accepted end, watched for unread bytes
+    const std::vector<std::string>      *pieces;
+    volatile bool                       done;       // the server has its request, the rest is not read
+};
+
+void *WritePieces(void *arg)
+{
+    Writer &writer = *static_cast<Writer *>(arg);
+
+    for (size_t i = 0; i < writer.pieces->size() && !writer.done; ++i)
+    {
+        const std::string &piece = (*writer.pieces)[i];
+        for (size_t sent = 0; sent < piece.size() && !writer.done;)
+        {
+            ssize_t count = send(writer.client, piece.data() + sent, piece.size() - sent, MSG_NOSIGNAL);
+            if (count <= 0)
+                break;
+            sent += count;
+        }
+        int unread = 1;
+        while (!writer.done && ioctl(writer.server, FIONREAD, &unread) == 0 && unread > 0)
+            sched_yield();
+    }
+    shutdown(writer.client, SHUT_WR);
+    return NULL;
+}
+
+// the request the server reads from the pieces, as the event loop would get it
+void Read(const std::vector<std::string> &pieces, Parsed &parsed)
+{
+    FuzzServer &server = Server();
+    sockaddr_un address;
+    int client = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, server.Path().c_str());
+    FUZZ_CHECK(client >= 0 && connect(client, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == 0,
+        "cannot connect to the server");
+    ClientConnection *connection = server.Accept();
+    FUZZ_CHECK(connection != NULL, "connection not accepted");
+    int fd = connection->GetFd();
+
+    Writer writer;
+    pthread_t thread;
+    writer.client = client;
+    writer.server = fd;
+    writer.pieces = &pieces;
+    writer.done = false;
+    FUZZ_CHECK(pthread_create(&thread, NULL, WritePieces, &writer) == 0, "no writer thread");
+
+    parsed = Parsed();
+    try
+    {
+        bool complete = false;
+        while (!complete)
+        {
+            struct pollfd readable;
+            readable.fd = fd;
+            readable.events = POLLIN;
+            FUZZ_CHECK(poll(&readable, 1, 10000) == 1, "server waits for bytes that were sent");
+            complete = connection->GenerateRequest(fd);
+        }
+        const HttpRequest &request = *connection->http_request;
+        parsed.status = 0;
+        parsed.method = request.GetMethod();
+        parsed.location = request.GetLocation();
+        parsed.version = request.GetHttpVersion();
+        parsed.query = request.GetQueryStringStr();
+        parsed.query_pairs = request.GetQueryString();
+        parsed.headers = request.GetHeaders();
+        parsed.body = request.GetBody();
+    }
+    catch (const HttpException &e)
+    {
+        parsed.status = e.GetCode();
+    }
+    writer.done = true;
+    pthread_join(thread, NULL);
+    server.Close(fd);
+    close(client);
+}
+
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    static bool started = false;
+
+    if (!started)
+    {
+        Server();
+        atexit(Shutdown);
+        started = true;
+    }
+    if (size < 4)
+        return 0;
+    uint32_t seed = data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<uint32_t>(data[3]) << 24);
+    std::string stream(reinterpret_cast<const char *>(data + 4), size - 4);
+    // a body past MAX_MEMORY_UPLOAD is streamed to a file in the uploads directory, not what this target reads
+    size_t length_at = stream.find("Content-Length:");
+    if (length_at != std::string::npos && atol(stream.c_str() + length_at + 15) > MAX_MEMORY_UPLOAD)
+        return 0;
+
+    std::vector<std::string> whole(1, stream);
+    std::vector<std::string> fragments;
+    Parsed single;
+    Parsed fragmented;
+
+    // xorshift, cuts of 1 to 64 bytes
+    for (size_t offset = 0; offset < stream.size();)
+    {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        size_t length = 1 + seed % 64;
+        fragments.push_back(stream.substr(offset, length));
+        offset += length;
+    }
+
+    Read(whole, single);
+    Read(fragments, fragmented);
+    if (single.status != fragmented.status)
+    {
+        Dump("whole", single);
+        Dump("fragmented", fragmented);
+    }
+    FUZZ_CHECK(single.status == fragmented.status, "whole and fragmented reads disagree on the status");
+    // without Content-Length ParseRequest keeps whatever followed the head in the read that completed
+    // it as the body, so a fragmented read only has to have seen a prefix of it
+    if (single.headers.find("Content-Length") == single.headers.end())
+    {
+        FUZZ_CHECK(single.body.compare(0, fragmented.body.size(), fragmented.body) == 0, "fragmented body is not a prefix");
+        fragmented.body = single.body;
+    }
+    if (!(single == fragmented))
+    {
+        Dump("whole", single);
+        Dump("fragmented", fragmented);
+    }
+    FUZZ_CHECK(single == fragmented, "whole and fragmented reads disagree on the request");
+    return 0;
+}
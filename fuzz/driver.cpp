@@ -0,0 +1,203 @@
+/*
+    Stand-in for libFuzzer where clang is not around: replays the corpus
+    given on the command line, then runs random mutations of it through
+    LLVMFuzzerTestOneInput. Coverage is not tracked, the sanitizers the
+    target is built with do the catching. The input running when the
+    process dies is written to crash-<run> in the current directory.
+
+        fuzz/<target> [-runs=N] [-seed=S] [-max_len=N] corpus_dir_or_file...
+
+    Flags use libFuzzer's spelling, so make fuzz drives either build.
+*/
+#include <sanitizer/common_interface_defs.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <csignal>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <stdint.h>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+extern "C" int LLVMFuzzerInitialize(int *argc, char ***argv);
+
+namespace
+{
+
+std::string     current;            // the input being run, saved when the process dies
+unsigned long   current_run = 0;
+uint64_t        state = 0;
+
+// tokens of both grammars, spliced in by the mutator
+const char *DICTIONARY[] = {
+    "\r\n", "\r\n\r\n", "\n\n", ": ", "GET ", "POST ", "DELETE ", "HEAD ", " HTTP/1.1", " HTTP/1.0", "/", "?", "&", "=",
+    "%", "%00", "%2F", "%zz", "+", "Host: ", "Content-Length: ", "Content-Type: multipart/form-data; boundary=",
+    "Transfer-Encoding: chunked", "--", "Content-Disposition: form-data; name=\"", "filename=\"", "\"", ";",
+};
+
+uint64_t Random()
+{
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+void SaveCurrent()
+{
+    char name[64];
+
+    snprintf(name, sizeof(name), "crash-%lu", current_run);
+    std::ofstream out(name, std::ios::binary);
+    out.write(current.data(), current.size());
+    fprintf(stderr, "driver: input written to %s (%lu bytes)\n", name, static_cast<unsigned long>(current.size()));
+}
+
+void OnDeath()
+{
+    SaveCurrent();
+}
+
+void OnSignal(int signal_number)
+{
+    SaveCurrent();
+    std::signal(signal_number, SIG_DFL);
+    raise(signal_number);
+}
+
+void Run(const std::string &input)
+{
+    current = input;
+    LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t *>(current.data()), current.size());
+}
+
+void LoadPath(const std::string &path, std::vector<std::string> &corpus)
+{
+    struct stat info;
+
+    if (stat(path.c_str(), &info) < 0)
+    {
+        fprintf(stderr, "driver: cannot stat %s\n", path.c_str());
+        exit(1);
+    }
+    if (S_ISDIR(info.st_mode))
+    {
+        DIR *dir = opendir(path.c_str());
+        struct dirent *entry;
+        while (dir && (entry = readdir(dir)) != NULL)
+        {
+            if (entry->d_name[0] != '.')
+                LoadPath(path + "/" + entry->d_name, corpus);
+        }
+        if (dir)
+            closedir(dir);
+        return;
+    }
+    std::ifstream in(path.c_str(), std::ios::binary);
+    std::ostringstream content;
+    content << in.rdbuf();
+    corpus.push_back(content.str());
+}
+
+void Mutate(std::string &input, const std::vector<std::string> &corpus, size_t max_len)
+{
+    int mutations = 1 + Random() % 4;
+
+    while (mutations-- > 0)
+    {
+        size_t at = input.empty() ? 0 : Random() % (input.size() + 1);
+        switch (Random() % 7)
+        {
+            case 0:     // flip a bit
+                if (!input.empty())
+                    input[at % input.size()] ^= 1 << (Random() % 8);
+                break;
+            case 1:     // random byte
+                input.insert(at, 1, static_cast<char>(Random()));
+                break;
+            case 2:     // drop a range
+                if (!input.empty())
+                    input.erase(at % input.size(), 1 + Random() % 16);
+                break;
+            case 3:     // repeat a range
+                if (!input.empty())
+                {
+                    size_t from = Random() % input.size();
+                    input.insert(at, input.substr(from, 1 + Random() % 32));
+                }
+                break;
+            case 4:     // grammar token
+                input.insert(at, DICTIONARY[Random() % (sizeof(DICTIONARY) / sizeof(DICTIONARY[0]))]);
+                break;
+            case 5:     // interesting byte
+            {
+                static const char BYTES[] = { '\0', '\r', '\n', ' ', '\t', ':', '%', '-', '\xff' };
+                if (!input.empty())
+                    input[at % input.size()] = BYTES[Random() % sizeof(BYTES)];
+                break;
+            }
+            case 6:     // splice another corpus entry
+            {
+                const std::string &other = corpus[Random() % corpus.size()];
+                if (!other.empty())
+                    input.insert(at, other.substr(Random() % other.size()));
+                break;
+            }
+        }
+    }
+    if (input.size() > max_len)
+        input.resize(max_len);
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long runs = 0;
+    unsigned long seed = time(NULL);
+    size_t max_len = 4096;
+    std::vector<std::string> corpus;
+
+    LLVMFuzzerInitialize(&argc, &argv);
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strncmp(argv[i], "-runs=", 6) == 0)
+            runs = strtoul(argv[i] + 6, NULL, 10);
+        else if (strncmp(argv[i], "-seed=", 6) == 0)
+            seed = strtoul(argv[i] + 6, NULL, 10);
+        else if (strncmp(argv[i], "-max_len=", 9) == 0)
+            max_len = strtoul(argv[i] + 9, NULL, 10);
+        else if (argv[i][0] == '-')
+            fprintf(stderr, "driver: ignoring %s\n", argv[i]);
+        else
+            LoadPath(argv[i], corpus);
+    }
+    if (corpus.empty())
+        corpus.push_back("");
+    state = seed ? seed : 1;
+    __sanitizer_set_death_callback(OnDeath);
+    std::signal(SIGABRT, OnSignal);
+    std::signal(SIGSEGV, OnSignal);
+
+    size_t seeds = corpus.size();
+    fprintf(stderr, "driver: %lu corpus inputs, %lu runs, seed %lu\n", static_cast<unsigned long>(seeds), runs, seed);
+    for (size_t i = 0; i < seeds; ++i)
+        Run(corpus[i]);
+    for (current_run = 1; current_run <= runs; ++current_run)
+    {
+        std::string input = corpus[Random() % corpus.size()];
+        Mutate(input, corpus, max_len);
+        Run(input);
+        // keep what did not crash, later mutations build on it
+        if (Random() % 16 == 0)
+            corpus.push_back(input);
+    }
+    fprintf(stderr, "driver: done, %lu inputs run\n", static_cast<unsigned long>(seeds + runs));
+    return 0;
+}
@@ -0,0 +1,30 @@
+/*
+    Post::parseMultipartForm on arbitrary bodies. The first line of the
+    input is the boundary (at most 70 bytes, RFC 2046), the rest is the
+    body, so the corpus entries read like the requests they come from.
+*/
+#include "FuzzTarget.hpp"
+#include "../include/request/Post.hpp"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    static Post post;
+    std::string input(reinterpret_cast<const char *>(data), size);
+    size_t newline = input.find('\n');
+
+    if (newline == std::string::npos || newline == 0 || newline > 70)
+        return 0;
+    std::string boundary = input.substr(0, newline);
+    std::string body = input.substr(newline + 1);
+
+    try
+    {
+        size_t parts = post.parseMultipartForm(body, boundary).size();
+        // every part is introduced by a delimiter line
+        FUZZ_CHECK(parts == 0 || body.find("--" + boundary) != std::string::npos, "parts without a boundary");
+    }
+    catch (const HttpException &)
+    {
+    }
+    return 0;
+}
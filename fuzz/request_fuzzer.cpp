@@ -0,0 +1,26 @@
+/*
+    Request line, headers and body of one raw request through
+    HttpRequestBuilder::ParseRequest, as ClientConnection::GenerateRequest
+    hands them over. An HttpException is the parser rejecting the input,
+    anything else (a crash, a sanitizer report, another exception) is a bug.
+*/
+#include "FuzzTarget.hpp"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    std::string raw(reinterpret_cast<const char *>(data), size);
+    HttpRequestBuilder builder;
+
+    try
+    {
+        builder.ParseRequest(raw, FuzzServerConfig());
+    }
+    catch (const HttpException &)
+    {
+        return 0;
+    }
+    HttpRequest &request = builder.GetHttpRequest();
+    FUZZ_CHECK(!request.GetMethod().empty(), "accepted request without a method");
+    FUZZ_CHECK(!request.GetLocation().empty() && request.GetLocation()[0] == '/', "accepted location not absolute");
+    return 0;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <ctime>
+#include <sys/types.h>
+
+class ClientConnection;
+class HttpRequest;
+class HttpResponse;
+class ServerConfig;
+struct AccessLogOptions;
+
+// nginx's combined format, used when access_log names no format
+#define ACCESS_LOG_COMBINED "$remote_addr - - [$time_local] \"$request\" $status $bytes_sent \"$http_referer\" \"$http_user_agent\""
+
+/*
+    Per-request access records. A log_format template is compiled once at
+    config load into literal and variable segments; a record is rendered
+    by walking them and lands in the buffer of its file, which goes out in
+    one write() when it fills up or when its flush= time is up, so a busy
+    server makes one syscall per buffer, not per request. Servers logging
+    to the same path share the file and its buffer.
+*/
+class AccessLog
+{
+    private:
+        enum Field
+        {
+            LITERAL,
+            REMOTE_ADDR,
+            REMOTE_PORT,
+            TIME_LOCAL,
+            TIME_ISO8601,
+            MSEC,
+            REQUEST,
+            REQUEST_METHOD,
+            REQUEST_URI,
+            URI,
+            ARGS,
+            SERVER_PROTOCOL,
+            STATUS,
+            BYTES_SENT,
+            REQUEST_TIME,
+            UPSTREAM_RESPONSE_TIME,
+            REQUEST_PHASES,
+            PARSE_TIME,
+            BODY_TIME,
+            ROUTE_TIME,
+            HANDLER_TIME,
+            CGI_TIME,
+            SEND_TIME,
+            HOST,
+            SERVER_NAME,
+            HTTP_HEADER
+        };
+
+        struct Segment
+        {
+            Field       field;
+            std::string text;       // the literal, or the header name of $http_*
+        };
+        typedef std::vector<Segment> Format;
+
+        struct File
+        {
+            std::string path;
+            int         fd;
+            std::string buffer;
+            size_t      capacity;   // 0: every record is written right away
+            int         flush;      // seconds a record may wait in the buffer, 0 for no limit
+            time_t      first_buffered;
+        };
+
+        struct Log
+        {
+            size_t          file;
+            const Format    *format;
+        };
+
+        static std::map<std::string, Format>    _formats;
+        static std::vector<File>                _files;
+        static std::vector<Log>                 _logs;
+        static pid_t                            _owner;     // process whose exit flushes the buffers
+
+        static bool         compile(const std::string &source, Format &format, std::string &error);
+        static void         render(std::string &out, const Format &format, const ClientConnection &client,
+                                const HttpRequest *request, const HttpResponse &response, const ServerConfig &config);
+        static void         appendEscaped(std::string &out, const std::string &value);
+        static void         appendPhase(std::string &out, double seconds);
+        static void         flushFile(File &file);
+
+    public:
+        // log_format name template; false with error set for an unknown variable
+        static bool         DefineFormat(const std::string &name, const std::string &source, std::string &error);
+        static bool         CheckFormat(const std::string &source, std::string &error);
+        // handle for Record(), -1 when the options say off or the file cannot be opened
+        static int          Open(const AccessLogOptions &options);
+        static void         Record(int handle, const ClientConnection &client, const HttpRequest *request,
+                                const HttpResponse &response, const ServerConfig &config);
+        // called from the event loop, writes buffers whose flush= time is up
+        static void         FlushExpired(time_t now);
+        static void         FlushAll();
+
+        // seconds since a CLOCK_MONOTONIC time point
+        static double       Elapsed(const struct timespec &since);
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+#define BUFFER_SMALL 16384          // request heads, body pieces
+#define BUFFER_LARGE 65536          // upload streaming, file blocks
+#define BUFFER_POOL_IDLE_MAX 256    // free buffers kept per size, the rest go back to the heap
+
+/*
+    I/O buffers shared by every connection. A connection borrows one for
+    the duration of a read or a refill and gives it back right after, so an
+    idle keep-alive socket holds no buffer at all and the number of buffers
+    alive tracks the number of connections doing I/O at the same moment.
+*/
+class BufferPool
+{
+    private:
+        static std::vector<char *>  _small;
+        static std::vector<char *>  _large;
+        static size_t               _small_borrowed;
+        static size_t               _large_borrowed;
+
+    public:
+        // BUFFER_SMALL bytes when size fits, BUFFER_LARGE otherwise (even past it)
+        static char     *Acquire(size_t size, size_t &capacity);
+        static void     Release(char *buffer, size_t capacity);
+
+        // for the status page: buffers lent out right now and buffers waiting in the pool
+        static size_t   Borrowed(size_t capacity) { return capacity == BUFFER_SMALL ? _small_borrowed : _large_borrowed; }
+        static size_t   Idle(size_t capacity) { return capacity == BUFFER_SMALL ? _small.size() : _large.size(); }
+};
+
+// Borrows a pool buffer for the lifetime of the object
+class PooledBuffer
+{
+    private:
+        char    *_data;
+        size_t  _capacity;
+
+        PooledBuffer(const PooledBuffer &);
+        PooledBuffer &operator=(const PooledBuffer &);
+
+    public:
+        explicit PooledBuffer(size_t size) : _data(BufferPool::Acquire(size, _capacity)) {}
+        ~PooledBuffer() { BufferPool::Release(_data, _capacity); }
+
+        char    *data() { return _data; }
+        size_t  size() const { return _capacity; }
+};
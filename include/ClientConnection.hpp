@@ -10,6 +10,7 @@
 #include <iostream>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <poll.h>
 #include "./request/HttpRequestBuilder.hpp"
 #include "./request/HttpException.hpp"
 #include "./response/HttpResponse.hpp"
@@ -23,17 +24,39 @@ class RequestHandler;
 
 #define REQUSET_LINE_BUFFER 8000
 #define MAX_MEMORY_UPLOAD 512000  // 512KB threshold
-#define STREAM_CHUNK_SIZE 32768    // 32KB chunks
+#define STREAM_CHUNK_SIZE 65536    // 64KB per read, a BUFFER_LARGE from the pool
+#define CLIENT_BODY_TIMEOUT 30000  // ms to wait for the rest of an in-memory body
+
+/*
+    CLOCK_MONOTONIC boundaries of the request being served, zero while not
+    reached. The phases between them: parse (start to parsed), body (parsed
+    to dispatched, a streamed upload), route (location match), handler (file
+    system work or CGI spawn), cgi (handled to upstream) and send (the
+    response ready to its last byte written).
+*/
+struct RequestPhases
+{
+    struct timespec start;      // first byte of the request read
+    struct timespec parsed;     // head parsed
+    struct timespec dispatched; // body complete, handed to the handler chain
+    struct timespec routed;     // location matched
+    struct timespec handled;    // handler chain returned
+    struct timespec upstream;   // CGI output complete
+    struct timespec sent;       // last byte written
+};
 
 class ClientConnection
 {
 public:
     WebServer*              _server;
     int                     fd;
-    std::string             ipAddress;
+    unsigned int            generation;     // of its ConnectionTable slot, see ConnectionTable
+    std::string             ipAddress;      // "unix:" for unix socket clients, like nginx's $remote_addr
     uint16_t                port;
+    int                     limit_slot;     // its address in the server's RateLimiter, -1 when not counted
     time_t                  connectTime;
     time_t                  lastActivity;
+    std::string             pending_head;   // a head cut across reads, kept until its CRLF CRLF arrives
     HttpRequestBuilder      *builder;
     HttpResponse            *http_response;
     HttpRequest             *http_request;
@@ -45,8 +68,15 @@ public:
     size_t                  bytes_received_so_far;
     int                     temp_upload_fd;
     std::string             temp_upload_path;
+    // Resumable uploads: the streamed body lands at this offset of an existing part file
+    bool                    is_resumable_chunk;
+    size_t                  upload_base_offset;
     static int              redirect_counter;
     bool                    should_close;
+    bool                    tcp_corked;     // TCP_CORK set for the response being sent
+    // access log timings: phase boundaries of the request, CGI seconds or -1
+    RequestPhases           phases;
+    double                  upstream_time;
 
     // Filename detection members
     bool                    filename_detected;
@@ -57,7 +87,7 @@ public:
 
     // Constructors and destructor
     ClientConnection(); 
-    ClientConnection(int socketFd, const sockaddr_in& clientAddr);
+    ClientConnection(int socketFd, const sockaddr_storage& clientAddr);
     ~ClientConnection();
     
     // Getter methods
@@ -65,11 +95,21 @@ public:
     bool isStreamingUpload() const { return is_streaming_upload; }
     
     // Main request handling methods
-    void GenerateRequest(int fd);
+    // false when the socket had nothing to read yet, or only part of a head
+    bool GenerateRequest(int fd);
     void ProcessRequest(int fd);
     void RespondToClient(int fd);
     void parseRequest(char *buff);
     
+    // Phase timing
+    static void markPhase(struct timespec &boundary);
+    // seconds between two boundaries, -1 when either was not reached
+    static double phaseTime(const struct timespec &from, const struct timespec &to);
+    // the start of the send phase: CGI output complete, or the handler chain returned
+    const struct timespec &responseReady() const;
+    // "parse=0.000012 body=... send=0.000210", unreached phases as -
+    std::string phaseBreakdown() const;
+
     // Activity and connection management
     void updateActivity();
     bool isStale(time_t timeoutSec) const;
@@ -77,6 +117,7 @@ public:
     // Streaming upload methods
     void initializeStreaming(size_t content_length);
     void initializeStreamingWithFilename(size_t content_length, const std::string& original_filename, const std::string& file_extension);
+    void initializeResumableStreaming(size_t content_length, const std::string& part_path, size_t offset);
     bool continueStreamingRead(int fd);
     void finalizeStreaming();
     void setServerConfig(const ServerConfig& config);
@@ -87,6 +128,18 @@ public:
     bool updateFileExtensionIfNeeded();
 
 private:
+    // owned by the ConnectionTable, never copied
+    ClientConnection(const ClientConnection&);
+    ClientConnection& operator=(const ClientConnection&);
+
+    ssize_t recvWithin(int fd, char *buffer, size_t length, int timeout_ms);
+
+    // Disk placement helpers for streamed uploads
+    void    ensureUploadSpace(const std::string& dir, size_t content_length) const;
+    void    preallocateUpload();
+    void    writeUploadData(const char* data, size_t length);
+    void    trimUploadFile();
+
     // Progress display helpers
     void showProgress();
     void showProgressBar(double speed_mbps);
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <sys/socket.h>
+
+class ClientConnection;
+
+#define CONNECTION_SLAB_BLOCK 64    // ClientConnection cells allocated at a time
+
+/*
+    Live client connections, indexed by socket fd. The objects live in
+    slab blocks that are never moved or freed while the server runs, so a
+    ClientConnection* stays valid until its connection is closed and
+    connections are built in place, never copied. Every fd slot carries a
+    generation that is bumped on close: whoever keeps (fd, generation)
+    around, like a running CGI, can tell its client from a newer one that
+    got the same fd.
+*/
+class ConnectionTable
+{
+    private:
+        struct Slot
+        {
+            ClientConnection    *conn;
+            int                 server_index;
+            unsigned int        generation;
+        };
+
+        std::vector<Slot>               _slots;     // by fd
+        std::vector<char *>             _blocks;
+        std::vector<ClientConnection *> _free;      // constructed nowhere, ready for placement new
+        size_t                          _count;
+
+        void    grow();
+
+        ConnectionTable(const ConnectionTable &);
+        ConnectionTable &operator=(const ConnectionTable &);
+
+    public:
+        ConnectionTable();
+        ~ConnectionTable();
+
+        // NULL when fd is already in use
+        ClientConnection    *Open(int fd, const sockaddr_storage &client_addr, int server_index);
+        void                Close(int fd);
+
+        ClientConnection    *Find(int fd) const
+        {
+            if (fd < 0 || static_cast<size_t>(fd) >= _slots.size())
+                return NULL;
+            return _slots[fd].conn;
+        }
+        // NULL when the connection that had this generation is gone
+        ClientConnection    *Find(int fd, unsigned int generation) const
+        {
+            ClientConnection *conn = Find(fd);
+            return conn && _slots[fd].generation == generation ? conn : NULL;
+        }
+        int                 ServerIndex(int fd) const { return Find(fd) ? _slots[fd].server_index : -1; }
+        size_t              Size() const { return _count; }
+};
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <string>
+#include <sstream>
+#include <atomic>
+#include <ctime>
+#include <pthread.h>
+#include <sys/types.h>
+
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_ERROR 3
+#define LOG_LEVEL_CRIT 4
+
+// Statements under this level are not compiled at all: `make LOG_LEVEL=1` drops every LOG_DEBUG
+#ifndef LOG_COMPILED_LEVEL
+# define LOG_COMPILED_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+#define LOG_RING_SLOTS 4096         // power of two
+#define LOG_LINE_MAX 480            // longer messages are cut
+#define LOG_WRITER_IDLE_US 2000     // writer sleep when the ring is empty
+
+/*
+    Leveled logger for the event loop. A LOG_* statement below the error_log
+    level costs one compare; an enabled one formats into a fixed slot of a
+    single-producer ring and returns, the formatting of the timestamp and
+    the write() happen on a background thread that drains the ring in
+    batches. When the ring is full the line is dropped and counted rather
+    than blocking the loop.
+
+    Before Open() (config parsing, startup) lines go straight to stderr.
+*/
+class Logger
+{
+    private:
+        struct Slot
+        {
+            time_t          time;
+            int             level;
+            unsigned short  length;
+            char            text[LOG_LINE_MAX];
+        };
+
+        static Slot                         _ring[LOG_RING_SLOTS];
+        static std::atomic<unsigned long>   _head;      // next slot the event loop fills
+        static std::atomic<unsigned long>   _tail;      // next slot the writer drains
+        static std::atomic<unsigned long>   _dropped;
+        static std::atomic<bool>            _running;
+        static int                          _level;
+        static int                          _fd;
+        static bool                         _started;
+        static pthread_t                    _writer;
+        static pid_t                        _owner;     // process that started the writer
+
+        static void     *writerLoop(void *);
+        static size_t   drain(std::string &out);
+        static void     format(std::string &out, time_t time, int level, const char *text, size_t length);
+        static void     writeAll(const std::string &out);
+
+    public:
+        // path is a file opened for append or "stderr"; false on a bad level or an unopenable file
+        static bool         Open(const std::string &path, const std::string &level);
+        static void         Shutdown();
+        // -1 for an unknown name
+        static int          ParseLevel(const std::string &name);
+        static const char   *LevelName(int level);
+        // raw protocol bytes made printable for a log line: \r \n spelled out, other bytes as [n]
+        static std::string  Escape(const std::string &bytes);
+
+        static bool         Enabled(int level) { return level >= _level; }
+        static void         Write(int level, const std::string &message);
+};
+
+#define LOG_AT(level, message) \
+    do { \
+        if (Logger::Enabled(level)) { \
+            std::ostringstream log_line_; \
+            log_line_ << message; \
+            Logger::Write(level, log_line_.str()); \
+        } \
+    } while (0)
+
+#if LOG_COMPILED_LEVEL <= LOG_LEVEL_DEBUG
+# define LOG_DEBUG(message) LOG_AT(LOG_LEVEL_DEBUG, message)
+#else
+# define LOG_DEBUG(message) do {} while (0)
+#endif
+#if LOG_COMPILED_LEVEL <= LOG_LEVEL_INFO
+# define LOG_INFO(message) LOG_AT(LOG_LEVEL_INFO, message)
+#else
+# define LOG_INFO(message) do {} while (0)
+#endif
+#if LOG_COMPILED_LEVEL <= LOG_LEVEL_WARN
+# define LOG_WARN(message) LOG_AT(LOG_LEVEL_WARN, message)
+#else
+# define LOG_WARN(message) do {} while (0)
+#endif
+#define LOG_ERROR(message) LOG_AT(LOG_LEVEL_ERROR, message)
+#define LOG_CRIT(message) LOG_AT(LOG_LEVEL_CRIT, message)
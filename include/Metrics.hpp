@@ -0,0 +1,89 @@
+#pragma once
+
+#include <string>
+#include <ctime>
+
+#define METRICS_BUCKETS 18              // upper bounds METRICS_FIRST_BUCKET * 2^i, then +Inf
+#define METRICS_FIRST_BUCKET 0.0001     // seconds
+#define METRICS_CONTENT_TYPE "text/plain; version=0.0.4; charset=utf-8"
+
+/*
+    Counters, gauges and latency histograms for the metrics location,
+    rendered in the Prometheus text format. Everything is updated from the
+    event loop thread only, so the registry is a set of plain integers
+    with nothing to lock; the server being a single process, a scrape sees
+    every connection there is. Histograms have fixed power-of-two buckets,
+    an observation is one loop over METRICS_BUCKETS bounds, no allocation.
+*/
+class Metrics
+{
+    public:
+        enum Counter
+        {
+            CONNECTIONS_ACCEPTED,
+            CONNECTIONS_REJECTED,
+            LIMIT_CONN_REJECTED,
+            LIMIT_REQ_REJECTED,
+            OVERLOAD_SHED,
+            REQUESTS_PARSED,
+            SEND_ERRORS,
+            BYTES_SENT,
+            CGI_SPAWNED,
+            CGI_EXITED,
+            CGI_FAILED,
+            CGI_TIMEOUTS,
+            CGI_REJECTED,
+            UPLOADS_COMPLETED,
+            UPLOAD_BYTES,
+            COUNTER_COUNT
+        };
+
+        enum Gauge
+        {
+            CONNECTIONS_ACTIVE,
+            CGI_ACTIVE,
+            GAUGE_COUNT
+        };
+
+        enum Histogram
+        {
+            REQUEST_PARSE,      // first byte read to request parsed
+            HANDLER,            // time spent in the handler chain
+            REQUEST,            // first byte read to last byte sent
+            CGI,                // spawn to exit
+            UPLOAD,             // first byte read to upload on disk
+            LOOP_BUSY,          // poll returning to the next poll
+            HISTOGRAM_COUNT
+        };
+
+    private:
+        struct Buckets
+        {
+            unsigned long   counts[METRICS_BUCKETS + 1];   // not cumulative, the last one is +Inf
+            unsigned long   count;
+            double          sum;
+        };
+
+        static unsigned long    _counters[COUNTER_COUNT];
+        static long             _gauges[GAUGE_COUNT];
+        static Buckets          _histograms[HISTOGRAM_COUNT];
+        static unsigned long    _methods[8];
+        static unsigned long    _statuses[6];
+        static time_t           _start_time;
+
+        static void         renderHeader(std::string &out, const char *name, const char *help, const char *type);
+        static void         renderSample(std::string &out, const char *name, const char *labels, const char *value);
+        static void         renderHistogram(std::string &out, Histogram histogram);
+
+    public:
+        static void         Increment(Counter counter, unsigned long by = 1) { _counters[counter] += by; }
+        static unsigned long Get(Counter counter) { return _counters[counter]; }
+        static void         Set(Gauge gauge, long value) { _gauges[gauge] = value; }
+        static void         Observe(Histogram histogram, double seconds);
+        // a request reaching the handler chain, by method
+        static void         Dispatched(const std::string &method);
+        // a response fully written, by status class
+        static void         Responded(int status);
+
+        static std::string  Render();
+};
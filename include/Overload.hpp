@@ -0,0 +1,72 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#define OVERLOAD_SMOOTHING 0.2          // weight of the newest wakeup in the averages
+#define OVERLOAD_LOW_LEVEL 0.75         // load level from which low priority requests are shed
+#define OVERLOAD_CGI_PROCESSES 32       // cgi_max_processes when unset
+#define OVERLOAD_RETRY_AFTER 1          // seconds, Retry-After of a shed request
+
+// overload and cgi_max_processes, both outside any server block
+struct OverloadOptions
+{
+    double  lag;            // overload lag=time: smoothed loop time per wakeup, 0 when not watched
+    double  queue;          // overload queue=N: smoothed ready descriptors per wakeup, 0 when not watched
+    int     cgi_processes;  // cgi_max_processes N, 0 for no cap
+
+    OverloadOptions() : lag(0), queue(0), cgi_processes(OVERLOAD_CGI_PROCESSES) {}
+};
+
+/*
+    Admission control for the event loop. Every wakeup reports how long
+    the loop was busy between two polls, which is the time a descriptor
+    that became ready meanwhile waited to be served, and how many
+    descriptors poll returned; both are kept as moving averages. The load
+    level is the most loaded of those two against their configured limits
+    and of the poll slots in use against the slots requests may take, so
+    1 means a limit is reached. Requests are judged once their head is
+    parsed: low priority work is shed from OVERLOAD_LOW_LEVEL on, the rest
+    from 1 on, health checks never. Without an overload directive, or with
+    overload off, the level stays 0 and nothing is shed; only the accept
+    time reject past maxfds - CONNECTION_RESERVE remains. Like Metrics,
+    all of it is plain static state of the one event loop thread.
+*/
+class Overload
+{
+    public:
+        enum Priority
+        {
+            HEALTH,     // metrics and stub_status locations, never shed
+            NORMAL,     // GET and HEAD of files
+            LOW         // CGI and requests carrying a body, shed first
+        };
+
+    private:
+        static OverloadOptions  _options;
+        static double           _lag;       // smoothed seconds from poll returning to the next poll
+        static double           _queue;     // smoothed ready descriptors per wakeup
+        static double           _slots;     // poll slots in use over those open to requests
+
+    public:
+        static void     Configure(const OverloadOptions &options) { _options = options; }
+        static const OverloadOptions &Options() { return _options; }
+        // overload off | [lag=time] [queue=N]; false with the offending parameter in error,
+        // left empty when neither is given
+        static bool     ParseOptions(const std::vector<std::string> &params, OverloadOptions &options, std::string &error);
+
+        // one loop iteration: its busy time and the descriptors poll reported ready
+        static void     Sample(double busy, int ready);
+        // poll slots in use and those requests may take, past them only health checks pass
+        static void     Slots(int used, int open);
+
+        // lag or queue watched; otherwise nothing, the slots included, is shed
+        static bool     Enabled() { return _options.lag > 0 || _options.queue > 0; }
+        static double   Level();
+        static bool     Admit(Priority priority);
+        static bool     CgiFull(size_t running) { return _options.cgi_processes > 0 && running >= static_cast<size_t>(_options.cgi_processes); }
+
+        // one line for the stub_status page
+        static std::string Report();
+};
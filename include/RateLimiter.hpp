@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <sys/socket.h>
+#include "./config/ServerConfig.hpp"
+
+#define LIMIT_ZONE_SLOTS 8192       // client addresses tracked per server, a power of two
+#define LIMIT_ZONE_PROBES 16        // slots looked at before a new address goes untracked
+#define LIMIT_UNTRACKED -1          // Open: address not counted (unix socket, zone full)
+#define LIMIT_REJECTED -2           // Open: over limit_conn
+
+/*
+    limit_conn and limit_req of one server: open connections and a token
+    bucket per client address, in a fixed table allocated once. The event
+    loop is the only thread and the only process, so the table is plain
+    memory with nothing to lock or share. Addresses are found by linear
+    probing from their hash; an entry is never emptied, only taken over by
+    a new address once it is idle (no connection open and a full bucket),
+    so probe chains never break. A connection holds its slot until it
+    closes, the bucket of an address with open connections cannot vanish.
+*/
+class RateLimiter
+{
+    private:
+        struct Entry
+        {
+            unsigned char   address[16];    // IPv4 uses the first 4 bytes
+            unsigned char   family;         // 0 for a slot never used
+            unsigned int    connections;
+            double          tokens;
+            double          updated;        // monotonic seconds of the last refill
+        };
+
+        LimitOptions        _options;
+        std::vector<Entry>  _entries;
+
+        double          capacity() const { return this->_options.burst + 1; }
+        void            refill(Entry &entry, double now) const;
+        bool            idle(const Entry &entry, double now) const;
+
+    public:
+        explicit RateLimiter(const LimitOptions &options);
+
+        bool            Enabled() const { return this->_options.connections > 0 || this->_options.rate > 0; }
+        const LimitOptions &Options() const { return this->_options; }
+
+        // counts a new connection: its slot, LIMIT_UNTRACKED or LIMIT_REJECTED
+        int             Open(const sockaddr_storage &address);
+        void            Close(int slot);
+        // takes a token for one request of the connection on slot:
+        // 0 when admitted, otherwise seconds until the next token
+        double          Request(int slot);
+
+        static double   Now();
+};
@@ -4,6 +4,9 @@
 #include <iostream>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/un.h>
+#include <sys/stat.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <string.h>
@@ -17,6 +20,9 @@
 #include <vector>
 #include "./config/ServerConfig.hpp"
 #include "./ClientConnection.hpp"
+#include "./ConnectionTable.hpp"
+#include "./RateLimiter.hpp"
+#include "./Overload.hpp"
 
 class CgiHandler;
 
@@ -38,11 +44,15 @@ class WebServer
         const ServerConfig& getConfigForSocket(int socket) const;
         const ServerConfig& getConfigForClient(int client_fd) const;
 
-        ClientConnection& getClient(int fd) { return clients[fd]; }
+        ClientConnection* getClient(int fd) { return clients.Find(fd); }
+        size_t connectionCount() const { return clients.Size(); }
         void updatePollEvents(int fd, short events);
         
         // Debug function for monitoring poll state
         void debugPollState();
+        // stub_status page: connections by state, poll slots, CGIs, buffer pool;
+        // the requesting connection counts as writing, like nginx does
+        std::string statusReport(int requester_fd);
         
         // Manage CGI time out ============ 
         void addCgiToPoll(int cgi_fd);
@@ -51,24 +61,45 @@ class WebServer
         void handleCgiEvent(int fd);
         void checkCgiTimeouts();
         ServerConfig getConfigByHost(std::string host);
+        // limit_req of the client's server: true when the request is turned away,
+        // its error response is then ready and the request marked processed
+        bool limitRequest(ClientConnection &client, const HttpRequest &request);
+        // overload: true when the load level sheds the request, same contract as limitRequest
+        bool shedRequest(ClientConnection &client, const HttpRequest &request);
+        // makes the client's response a status with Retry-After, the connection closes after it
+        void refuse(ClientConnection &client, int status, long retry_after);
         
     protected:
         void closeClientConnection(int clientSocket);
         void handleClientRequest(int fd);
         void handleClientResponse(int fd);
         bool isListeningSocket(int fd) const;
+        bool listenAddress(const ServerConfig &config, sockaddr_storage &address, socklen_t &length);
+        void applyListenOptions(int server_socket, const ListenOptions &options);
         int getServerIndexForSocket(int socket) const;
+        void logAccess(int fd, const ClientConnection &client);
+        const char *connectionState(const ClientConnection &conn, short events) const;
+        void rejectConnection(int client_fd, const std::string &response);
+        void refuseRequest(ClientConnection &client, const HttpRequest &request, int status, long retry_after);
+        Overload::Priority requestPriority(ClientConnection &client, const HttpRequest &request);
         
     private:
         static const int                    DEFAULT_MAX_CONNECTIONS = 1024;
+        static const int                    CONNECTION_RESERVE = 10;       // poll slots kept for CGI pipes
+        static const int                    HEALTH_RESERVE = 16;           // poll slots below that for health checks only, with overload on
         std::vector<ServerConfig>           m_configs;              // Vector of server configurations
         std::vector<int>                    m_sockets;              // Vector of listening sockets
         std::map<int, int>                  socket_to_config_index; // Map listening socket to config index
-        std::map<int, int>                  client_to_server_index; // Map client socket to server index
+        std::vector<int>                    m_access_logs;          // AccessLog handle per config, -1 when off
+        std::vector<RateLimiter>            m_limiters;             // limit_conn / limit_req per config
+        std::vector<std::string>            m_conn_rejects;         // canned limit_conn response per config
+        std::string                         m_slots_reject;         // canned 503 once poll slots run out
+        time_t                              m_shed_logged;          // second of the last overload warning
+        unsigned long                       m_shed_unlogged;        // requests shed since
         
         struct pollfd                       *pollfds;               // Files descriptor using poll
         int                                 maxfds, numfds;
-        std::map<int, ClientConnection>     clients;                // Map of fd to ClientConnection
+        ConnectionTable                     clients;                // Client connections by fd, with their server index
         CgiHandler                          *cgiHandler;            // Pointer to the CGI handler
 };
 
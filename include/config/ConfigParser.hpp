@@ -48,6 +48,8 @@ public:
     const std::vector<Block>& get_servers() const;
     std::vector<ServerConfig> create_servers();
     bool validate_config();
+    std::string get_main_directive(const std::string& name, size_t index = 0) const;
+    std::string get_log_format(const std::string& name) const;
 
 private:
     std::string file_name_;
@@ -65,6 +67,7 @@ private:
     Directive parse_directive(std::vector<std::string>::iterator& it, 
                             const std::vector<std::string>::iterator& end);
     void process_tokens(std::vector<std::string>& tokens);
+    bool validate_main_directives();
     bool validate_server_block(const Block& server);
     bool validate_location_block(const Block& location);
     void addError(ValidationError::ErrorLevel level, const std::string& message, int line = -1, const std::string& context = "");
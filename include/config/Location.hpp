@@ -3,8 +3,22 @@
 
 #include <string>
 #include <vector>
+#include <cstring>
 #include "Block.hpp"
 
+// allow / deny address[/bits] | unix: | all
+struct AccessRule {
+    bool            allow;
+    int             family;         // AF_INET, AF_INET6, AF_UNIX for unix: clients, AF_UNSPEC for all
+    unsigned char   address[16];    // network byte order, the first 4 bytes for IPv4
+    int             bits;           // prefix length compared
+
+    bool operator==(const AccessRule &rhs) const {
+        return allow == rhs.allow && family == rhs.family && bits == rhs.bits
+            && memcmp(address, rhs.address, sizeof(address)) == 0;
+    }
+};
+
 class Location {
 private:
     std::string                 _path;
@@ -18,6 +32,12 @@ private:
     std::vector<std::string>    _cgi_path;
     std::vector<std::string>    _cgi_ext;
     unsigned long               _client_max_body_size;
+    bool                        _gzip_static;
+    bool                        _brotli_static;
+    std::string                 _autoindex_format;
+    bool                        _metrics;       // serves the Prometheus metrics page
+    bool                        _stub_status;   // serves the live connection report
+    std::vector<AccessRule>     _access;        // allow and deny in config order, the first match decides
 
 public:
     Location();
@@ -38,6 +58,11 @@ public:
     void set_cgiExt(std::vector<std::string> cgi_exts);
     void set_clientMaxBodySize(std::string client_max_body_size);
     void set_uploadStore(std::string upload);
+    void set_gzipStatic(bool gzip_static);
+    void set_brotliStatic(bool brotli_static);
+    void set_autoindexFormat(std::string format);
+    void set_metrics(bool metrics);
+    void set_stubStatus(bool stub_status);
 
     std::string                 get_path() const;
     std::string                 get_root_location() const;
@@ -50,7 +75,15 @@ public:
     std::vector<std::string>    get_cgiPath() const;
     std::vector<std::string>    get_cgiExt() const;
     unsigned long               get_clientMaxBodySize() const;
+    bool                        get_gzipStatic() const;
+    bool                        get_brotliStatic() const;
+    std::string                 get_autoindexFormat() const;
+    bool                        get_metrics() const;
+    bool                        get_stubStatus() const;
     bool                        is_method_allowed(const std::string& method) const;
+    // false when a deny rule is the first to match the client's address; no match allows
+    bool                        is_address_allowed(const std::string& address) const;
+    static bool                 parse_access_rule(const Directive& directive, AccessRule &rule);
     void print_location_config() const;
 };
 
@@ -5,19 +5,58 @@
 #include <vector>
 #include <map>
 #include <netinet/in.h>
+#include <sys/socket.h>
 #include <arpa/inet.h>
 #include <string.h>
 #include <iostream>
 #include <unistd.h>
+#include <cstdlib>
 
 class Location;
 
+// Socket options from the listen directive's parameters, 0 / false keep the kernel default
+struct ListenOptions
+{
+    int     backlog;        // backlog=N, SOMAXCONN when unset
+    bool    deferred;       // TCP_DEFER_ACCEPT: wake up on the first data, not on the handshake
+    int     fastopen;       // fastopen=N, TCP_FASTOPEN queue length
+    int     rcvbuf;         // rcvbuf=size
+    int     sndbuf;         // sndbuf=size
+    bool    reuseport;      // SO_REUSEPORT
+    bool    ipv6only;       // ipv6only=on, an [::] listener takes IPv4 clients too unless set
+
+    ListenOptions() : backlog(SOMAXCONN), deferred(false), fastopen(0), rcvbuf(0), sndbuf(0), reuseport(false), ipv6only(false) {}
+};
+
+// access_log directive, off while path is empty
+struct AccessLogOptions
+{
+    std::string path;       // a file or stderr
+    std::string format;     // log_format name
+    size_t      buffer;     // buffer=size, 0 writes every record right away
+    int         flush;      // flush=time in seconds, how long a record may wait in the buffer
+    
+    AccessLogOptions() : format("combined"), buffer(0), flush(0) {}
+};
+
+// limit_conn / limit_req, counted per client address; 0 leaves a limit off
+struct LimitOptions
+{
+    int     connections;    // limit_conn N: open connections
+    double  rate;           // limit_req rate=Nr/s or Nr/m, in requests per second
+    int     burst;          // limit_req burst=N: requests taken at once above the rate
+    int     conn_status;    // limit_conn_status, sent at accept
+    int     req_status;     // limit_req_status, sent after the request head is parsed
+
+    LimitOptions() : connections(0), rate(0), burst(0), conn_status(503), req_status(429) {}
+};
 
 class ServerConfig
 {
 private:
     uint16_t                    _port;
     std::string                   _host;
+    std::string                 _unix_path;     // listen unix:/path, takes the place of host and port
     std::string                 _server_name;
     std::string                 _root;
     unsigned long               _client_max_body_size;
@@ -26,6 +65,21 @@ private:
     std::map<short, std::string> _error_pages;
     std::vector<Location>       _locations;
 
+    // on-the-fly response compression
+    bool                        _gzip;
+    int                         _gzip_comp_level;
+    size_t                      _gzip_min_length;
+    std::vector<std::string>    _gzip_types;
+
+    // connections taken off the listen queue per wakeup
+    int                         _accept_batch;
+    ListenOptions               _listen_options;
+    bool                        _tcp_nopush;    // TCP_CORK while the head and a file body go out
+    bool                        _tcp_nodelay;   // TCP_NODELAY on client sockets
+    AccessLogOptions            _access_log;
+    int                         _slow_request_threshold;   // ms, 0 when the slow-request log is off
+    LimitOptions                _limits;
+
 public:
     ServerConfig();
     ServerConfig(const ServerConfig &other);
@@ -34,6 +88,8 @@ public:
 
     uint16_t                    get_port() const;
     std::string                   get_host() const;
+    const std::string           &get_unix_path() const;
+    std::string                 get_listen_address() const;
     std::string                 get_server_name() const;
     std::string                 get_root() const;
     unsigned long               get_client_max_body_size() const;
@@ -41,9 +97,21 @@ public:
     bool                        get_autoindex() const;
     std::map<short, std::string> get_error_pages() const;
     std::vector<Location> 	   get_locations() const ;
+    bool                        get_gzip() const;
+    int                         get_gzip_comp_level() const;
+    size_t                      get_gzip_min_length() const;
+    const std::vector<std::string> &get_gzip_types() const;
+    int                         get_accept_batch() const;
+    const ListenOptions         &get_listen_options() const;
+    bool                        get_tcp_nopush() const;
+    bool                        get_tcp_nodelay() const;
+    const AccessLogOptions      &get_access_log() const;
+    int                         get_slow_request_threshold() const;
+    const LimitOptions          &get_limits() const;
 
     void set_port(std::string param);
     void set_host(std::string param);
+    void set_unix_path(std::string param);
     void set_server_name(std::string param);
     void set_root(std::string param);
     void set_client_max_body_size(std::string param);
@@ -51,6 +119,24 @@ public:
     void set_autoindex(std::string param);
     void set_error_pages(const std::vector<std::string>& error_codes, const std::string& error_page);
     void add_location(const Location& location);
+    void set_gzip(std::string param);
+    void set_gzip_comp_level(std::string param);
+    void set_gzip_min_length(std::string param);
+    void set_gzip_types(std::vector<std::string> param);
+    void set_accept_batch(std::string param);
+    void set_listen_option(std::string param);
+    void set_tcp_nopush(std::string param);
+    void set_tcp_nodelay(std::string param);
+    void set_access_log(const std::vector<std::string>& params);
+    void set_slow_request_threshold(std::string param);
+    void set_limit_conn(std::string param);
+    void set_limit_req(const std::vector<std::string>& params);
+    void set_limit_status(const std::string& directive, std::string param);
+    static int parse_socket_size(const std::string& param);
+    static int parse_seconds(const std::string& param);
+    static int parse_msec(const std::string& param);
+    static double parse_rate(const std::string& param);
+    static bool split_listen(const std::string& param, std::string& host, std::string& port, std::string& unix_path);
 
     void initializeDefaultErrorPages();
     const Location* findMatchingLocation(const std::string& ) const;
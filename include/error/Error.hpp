@@ -27,5 +27,4 @@ class Error
         void           SetCodeError(int );
         void           SetMessage(std::string &);
         void           SetErrorType(ERROR_TYPE);
-        void           SetClientData(ClientConnection &);
 };
@@ -19,5 +19,6 @@ enum ERROR_TYPE
     NOT_IMPLEMENTED,
     SERVICE_UNAVAILABLE,
     GATEWAY_TIMEOUT,
-    BAD_GATEWAY
+    BAD_GATEWAY,
+    INSUFFICIENT_STORAGE
 };
\ No newline at end of file
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "./ErrorHandler.hpp"
+
+class InsufficientStorage : public ErrorHandler
+{
+    private:
+        /* data */
+    public:
+        InsufficientStorage();
+        bool    CanHandle(ERROR_TYPE ) const;
+        void    ProcessError(Error &error, const ServerConfig & /* server Configuration*/); 
+        const char *    what() const throw();   
+        ~InsufficientStorage();
+};
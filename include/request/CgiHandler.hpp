@@ -21,8 +21,11 @@ public:
         pid_t pid;
         int pipe_fd;
         time_t start_time;
+        struct timespec started;            // CLOCK_MONOTONIC, for $upstream_response_time
         std::string output;
         ClientConnection* client;
+        int client_fd;                      // with client_generation, tells whether client is still connected
+        unsigned int client_generation;
         HttpRequest* request;
     };
     
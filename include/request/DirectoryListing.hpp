@@ -0,0 +1,74 @@
+#ifndef DIRECTORYLISTING_HPP
+#define DIRECTORYLISTING_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <ctime>
+#include <sys/stat.h>
+
+#define DIRECTORY_LISTING_CACHE_MAX 64      // rendered listings kept before the least recently used is dropped
+#define DIRECTORY_LISTING_FLUSH 65536       // render buffer, written to the cache file whenever it fills up
+
+/*
+    autoindex pages are rendered once per version of a directory: the
+    listing is written piece by piece into a cache file and then served from
+    there like any static file, until the directory's mtime changes.
+    Entries are sorted (directories first, then by name) and carry their
+    size and modification time; autoindex_format picks html, json or xml.
+    Sizes are those of the last render: rewriting a file in place doesn't
+    touch its directory's mtime. Lookup hands out an open descriptor, so a
+    response keeps its page even when eviction unlinks the file meanwhile.
+    The cache directory is made by mkdtemp, private to this process.
+*/
+class DirectoryListing
+{
+    public:
+        // rendered listing for dir_path (stat'ed as dir_stat) opened for reading, the caller
+        // owns the descriptor; -1 on failure
+        static int          Lookup(const std::string &dir_path, const struct stat &dir_stat,
+                                   const std::string &request_path, const std::string &format,
+                                   std::string &listing, struct stat &listing_stat);
+        static std::string  ContentType(const std::string &format);
+
+    private:
+        struct Item
+        {
+            std::string     name;
+            bool            is_dir;
+            off_t           size;
+            time_t          mtime;
+        };
+
+        struct Entry
+        {
+            dev_t           dev;
+            ino_t           ino;
+            struct timespec mtime;
+            std::string     file;
+            time_t          used;
+        };
+
+        static std::map<std::string, Entry>   _entries;
+        static std::string                     _cache_dir;
+        static unsigned long                   _generation;
+        static pid_t                           _owner;         // process that made _cache_dir
+
+        static bool         readItems(const std::string &dir_path, std::vector<Item> &items);
+        static bool         render(const std::string &file, const std::string &request_path,
+                                   const std::string &format, const std::vector<Item> &items);
+        static std::string  renderItem(const Item &item, const std::string &base, const std::string &format, bool first);
+        static bool         compareItems(const Item &a, const Item &b);
+        static bool         flushBuffer(int fd, std::string &buffer);
+        static int          openListing(const std::string &file, struct stat &listing_stat);
+        static void         Evict();
+        static void         RemoveAll();
+
+        static std::string  escapeMarkup(const std::string &text);
+        static std::string  escapeJson(const std::string &text);
+        static std::string  encodeUri(const std::string &text);
+        static std::string  formatTime(time_t time, const char *layout);
+        static std::string  formatSize(off_t size);
+};
+
+#endif // DIRECTORYLISTING_HPP
@@ -4,22 +4,34 @@
 #include <dirent.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <vector>
+#include <utility>
+
+#define MAX_BYTE_RANGES 16 // more ranges than that are served as a plain 200
 
 class Get : public RequestHandler
 {
     private:
         bool _is_redirected; // Flag to indicate if the request is redirected or not
 
+        void            ServeFile(HttpRequest *, const std::string &path, const struct stat &file_stat, const Location *, const ServerConfig &serverConfig);
+        std::string     NegotiateEncoding(HttpRequest *, const std::string &path, const Location *, struct stat &file_stat);
+        bool            NotModified(HttpRequest *, const std::string &etag, time_t mtime);
+        bool            ParseRange(const std::string &header, off_t file_size, std::vector<std::pair<off_t, off_t> > &ranges);
+        void            ApplyRange(HttpRequest *, const std::string &path, const struct stat &file_stat);
+
     public:
         Get();
         bool            CanHandle(std::string method);
         void            ProccessRequest(HttpRequest *, const ServerConfig &serverConfig, ServerConfig clientConfig);
         std::string     IsValidPath( std::string &path);
+        std::string     IsValidPath( std::string &path, struct stat &file_stat);
         bool            IsDir( std::string &path);
         bool            IsFile( std::string &path);
-        std::string     ListingDir(const std::string &path, std::string /* request Path*/, const Location * /* location*/,const ServerConfig & /*config file*/);
-        std::string     determineContentType(const std::string& path);
+        bool            IsFile( std::string &path, struct stat &file_stat);
+        bool            ListingDir(HttpRequest *request, const std::string &path, const struct stat &dir_stat, const Location * /* location*/,const ServerConfig & /*config file*/);
         bool            check_auto_indexing(const Location * /* location*/, const ServerConfig & /*config file*/);
-        std::string     CheckIndexFile(const std::string &rel_path, const Location *cur_location, const ServerConfig &serverConfig);
+        std::string     CheckIndexFile(const std::string &rel_path, const Location *cur_location, const ServerConfig &serverConfig, struct stat &file_stat);
+        static std::string  MakeETag(const struct stat &file_stat);
         ~Get();
 };
\ No newline at end of file
@@ -56,6 +56,7 @@ class HttpRequest
         HttpRequest(HttpRequest const &);
         bool                                            FindHeader(std::string, std::string);
         std::string                                     GetHeader(std::string )const;
+        double                                          GetEncodingQuality(const std::string &coding) const;
         std::map<std::string, std::string>              GetHeaders()const;
         std::string                                     GetRequestLine() const;
         std::string                                     GetHttpVersion() const;
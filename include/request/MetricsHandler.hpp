@@ -0,0 +1,29 @@
+#pragma once
+
+#include "RequestHandler.hpp"
+#include "HttpRequest.hpp"
+#include "../config/ServerConfig.hpp"
+
+class ClientConnection;
+class Location;
+
+/*
+    Answers GET and HEAD on the introspection locations: `metrics on;`
+    serves the Metrics registry in the Prometheus text format,
+    `stub_status on;` the live connection report of the WebServer. Both
+    pages are built in memory at request time.
+*/
+class MetricsHandler : public RequestHandler
+{
+    private:
+        ClientConnection*   _client;
+
+        const Location  *statusLocation(HttpRequest *request) const;
+
+    public:
+        MetricsHandler(ClientConnection* client);
+        ~MetricsHandler();
+
+        bool    CanHandle(std::string method);
+        void    ProccessRequest(HttpRequest *request, const ServerConfig &serverConfig, ServerConfig clientConfig);
+};
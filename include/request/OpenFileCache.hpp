@@ -0,0 +1,52 @@
+#ifndef OPENFILECACHE_HPP
+#define OPENFILECACHE_HPP
+
+#include <string>
+#include <map>
+#include <ctime>
+#include <sys/stat.h>
+
+#define OPEN_FILE_CACHE_VALID 1       // seconds a cached stat is trusted
+#define OPEN_FILE_CACHE_MAX 1024      // entries kept before stale ones are dropped
+#define OPEN_FILE_CACHE_EVICT 128     // oldest entries dropped when none is stale
+
+/*
+    Caches stat() results of served paths, together with the precompressed
+    siblings (path.gz / path.br), so repeated requests for the same static
+    file don't hit the filesystem again until the entry is older than
+    OPEN_FILE_CACHE_VALID.
+*/
+class OpenFileCache
+{
+    public:
+        struct Variant
+        {
+            bool            checked;
+            bool            exists;
+            struct stat     st;
+
+            Variant() : checked(false), exists(false) {}
+        };
+
+        struct Entry
+        {
+            bool            exists;
+            struct stat     st;
+            Variant         gzip;
+            Variant         brotli;
+            time_t          validated;
+
+            Entry() : exists(false), validated(0) {}
+        };
+
+        static bool         Lookup(const std::string &path, struct stat &st);
+        static bool         LookupVariant(const std::string &path, const std::string &suffix, struct stat &st);
+
+    private:
+        static std::map<std::string, Entry>   _entries;
+
+        static Entry &      Fetch(const std::string &path);
+        static void         Prune(time_t now);
+};
+
+#endif // OPENFILECACHE_HPP
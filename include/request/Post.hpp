@@ -40,7 +40,6 @@ private:
     
     // Parsing utilities
     std::string extractBoundary(const std::string &contentType);
-    std::vector<FormPart> parseMultipartForm(const std::string &body, const std::string &boundary);  // Removed duplicate
     std::map<std::string, std::string> parseUrlEncodedForm(const std::string &body);
     std::string urlDecode(const std::string &encoded);
     
@@ -59,6 +58,8 @@ public:
     
     // Made public so ClientConnection can use it
     std::string getUploadsDirectory(ServerConfig clientConfig);
+    // Public for the multipart microbenchmark (bench/micro.cpp)
+    std::vector<FormPart> parseMultipartForm(const std::string &body, const std::string &boundary);
 };
 
 #endif
\ No newline at end of file
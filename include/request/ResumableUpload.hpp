@@ -0,0 +1,78 @@
+#ifndef RESUMABLEUPLOAD_HPP
+#define RESUMABLEUPLOAD_HPP
+
+#include "RequestHandler.hpp"
+#include "HttpRequest.hpp"
+#include "../config/ServerConfig.hpp"
+#include <string>
+
+class ClientConnection;
+class HttpRequest;
+class ServerConfig;
+
+#define UPLOAD_ID_LENGTH 32
+#define UPLOAD_ID_PARAM "upload_id"
+#define TUS_VERSION "1.0.0"
+#define UPLOAD_SESSION_TTL 86400        // seconds a session may go without a chunk before it is removed
+#define UPLOAD_SWEEP_INTERVAL 60        // seconds between two sweeps of an uploads dir
+
+/*
+    Resumable uploads (tus style offset protocol):
+        POST  <location>                + Upload-Length   -> 201, Location: <location>?upload_id=<id>
+        HEAD  <location>?upload_id=<id>                   -> 200, Upload-Offset / Upload-Length
+        PATCH <location>?upload_id=<id> + Upload-Offset   -> 204, new Upload-Offset
+        PUT   <location>?upload_id=<id> + Content-Range   -> 308 while incomplete, 201 once complete
+    Partial data lives beside the regular uploads as .<id>.part, the session
+    metadata in .<id>.info; the committed offset is the size of the part file.
+    A session whose part file was last written UPLOAD_SESSION_TTL ago is
+    abandoned: it is refused when used and removed by the sweep that runs
+    when a new session is created.
+*/
+class ResumableUpload : public RequestHandler
+{
+private:
+    ClientConnection*   _client;
+
+    struct Session {
+        std::string     id;
+        std::string     dir;
+        size_t          length;
+        std::string     filename;
+
+        Session() : length(0) {}
+    };
+
+    std::string     sessionId(HttpRequest *request) const;
+    std::string     partPath(const Session &session) const;
+    std::string     infoPath(const Session &session) const;
+    bool            loadSession(HttpRequest *request, Session &session);
+    size_t          committedOffset(const Session &session) const;
+    static bool     expired(const std::string &part_path, const std::string &info_path, time_t now);
+    static void     sweepSessions(const std::string &dir, time_t now);
+    bool            chunkOffset(HttpRequest *request, const Session &session, size_t &offset);
+
+    void            createSession(HttpRequest *request);
+    void            reportOffset(HttpRequest *request);
+    void            writeChunk(HttpRequest *request);
+    bool            completeSession(const Session &session, std::string &final_path);
+
+    void            setSessionResponse(HttpRequest *request, int statusCode, const Session &session, size_t offset);
+    void            setErrorResponse(HttpRequest *request, int statusCode, const std::string &message);
+
+    static std::string  toString(size_t value);
+    static std::string  decodeBase64(const std::string &input);
+    static std::string  generateId();
+
+public:
+    ResumableUpload(ClientConnection* client);
+    ~ResumableUpload();
+
+    bool CanHandle(std::string method);
+    void ProccessRequest(HttpRequest *request, const ServerConfig &serverConfig, ServerConfig clientConfig);
+
+    // Used by ClientConnection before streaming a large PATCH/PUT body into the part file
+    static bool IsChunkRequest(const HttpRequest &request);
+    bool        PrepareStreamedChunk(HttpRequest *request, std::string &part_path, size_t &offset);
+};
+
+#endif // RESUMABLEUPLOAD_HPP
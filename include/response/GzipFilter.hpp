@@ -0,0 +1,57 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+class HttpResponse;
+class HttpRequest;
+class ServerConfig;
+
+#define GZIP_POOL_MAX 32        // idle deflate streams kept per format
+#define GZIP_CHUNK_SIZE 16384   // deflate output is drained in pieces of this size
+
+/*
+    On-the-fly response compression (the gzip directive).
+    A filter is attached to the response once, before its first byte goes out,
+    and compresses the body piece by piece as the send path reads it. The
+    z_stream state (~256K each) comes from a per-process pool, so a busy
+    worker does not pay deflateInit/deflateEnd on every response.
+*/
+class GzipFilter
+{
+    public:
+        enum Format
+        {
+            GZIP,
+            DEFLATE
+        };
+
+    private:
+        z_stream                        *_stream;
+        Format                          _format;
+        bool                            _finished;
+
+        static std::vector<z_stream *>  _pool[2];
+
+        static z_stream     *acquire(Format format, int level);
+        static void         release(Format format, z_stream *stream);
+        static bool         typeAllowed(std::string type, const std::vector<std::string> &types);
+
+        GzipFilter(const GzipFilter &);
+        GzipFilter &operator=(const GzipFilter &);
+
+    public:
+        GzipFilter(Format format, int level);
+        ~GzipFilter();
+
+        std::string         Compress(const char *data, size_t length, bool finish);
+        bool                IsFinished() const;
+        const char          *Encoding() const;
+
+        // Whether a body of this media type and length gets encoded for this client, and in
+        // which format; vary is set once the type is one gzip_types encodes at all
+        static bool         Negotiate(const std::string &type, size_t length, const HttpRequest &request,
+                                const ServerConfig &config, bool &vary, Format &format);
+        // Attach a filter to the response when the config, the client and the body allow it
+        static bool         Apply(HttpResponse &response, const HttpRequest &request, const ServerConfig &config);
+};
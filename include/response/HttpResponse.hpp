@@ -6,10 +6,40 @@
 #include <istream>
 #include <sstream>
 #include <fstream>
+#include <deque>
 #include <sys/stat.h>
 #include "../request/HttpException.hpp"
 
-#define CHUNKED_SIZE 1024
+#define OUTPUT_IOV_MAX 64               // memory pieces gathered into one sendmsg
+#define OUTPUT_FLUSH_MAX (1 << 20)      // bytes written per POLLOUT before yielding to other clients
+#define OUTPUT_STREAM_BLOCK 65536       // file bytes read per refill when encoding on the fly
+
+class GzipFilter;
+
+/*
+    One piece of a response body built from parts of the file (206 ranges):
+    either literal bytes (multipart headers/boundaries) or a span of _file_path.
+*/
+struct BodySegment
+{
+    std::string     literal;
+    off_t           offset;
+    size_t          length;
+};
+
+/*
+    One queued piece of output: bytes held in memory (status line and headers,
+    a body buffer, chunk framing) or a span of the open body file that goes
+    out through sendfile. fd is -1 for memory pieces.
+*/
+struct OutputPiece
+{
+    std::string     data;
+    int             fd;
+    off_t           offset;
+    size_t          length;
+};
+
 class HttpResponse
 {
     private:
@@ -27,9 +57,47 @@ class HttpResponse
 
         bool                                                _is_chunked;
         bool                                                _keep_alive;
+        // if only parts of the file are sent, in order
+        std::vector<BodySegment>                            _segments;
+
+        // status/headers only response (HEAD, 201/204 from upload sessions...)
+        bool                                                _no_body;
         int                                                 _byte_sent;
         int                                                 _byte_to_send;
 
+        // set by GzipFilter::Apply when the body goes out content-encoded
+        GzipFilter                                          *_compressor;
+
+        // what is left to write, built on the first flush; _output_sent counts
+        // the bytes of the front memory piece that already went out
+        std::deque<OutputPiece>                             _output;
+        size_t                                              _output_sent;
+        bool                                                _output_ready;
+        int                                                 _body_fd;
+        // encoded streams are read and compressed block by block as the queue drains
+        bool                                                _streaming;
+        off_t                                               _stream_offset;
+
+        void                                                queueOutput();
+        bool                                                refillOutput();
+        void                                                queueMemory(std::string &data, bool front = false);
+        void                                                queueFile(off_t offset, size_t length);
+        void                                                openBodyFile();
+        ssize_t                                             writeFront(int socket_fd);
+
+        struct StatusEntry
+        {
+            int             code;
+            const char      *reason;
+            const char      *line;      // "HTTP/1.1 <code> <reason>\r\n"
+        };
+        static const StatusEntry                            _status_table[];
+        static const StatusEntry                            *findStatus(int code);
+        static const std::string                            &dateHeader();
+
+        HttpResponse(const HttpResponse &);
+        HttpResponse &operator=(const HttpResponse &);
+
     public:
         HttpResponse(int , std::map<std::string, std::string>, std::string, bool, bool);
 
@@ -37,12 +105,19 @@ class HttpResponse
         void                                                setStatusMessage(std::string message);
         void                                                setHeader(std::string key, std::string value);
         void                                                setFilePath(std::string path);
+        // a file body already open, the response owns fd from here on
+        void                                                setBodyFile(std::string path, int fd);
         void                                                setChunked(bool chunked);
         void                                                setKeepAlive(bool keep_alive);
         void                                                setBuffer(std::string buffer);
         void                                                setContentType(std::string content_type);
         void                                                setByteSent(int byte_sent);
         void                                                setByteToSend(int byte_to_send);
+        void                                                setNoBody(bool no_body);
+        void                                                addFileSegment(off_t offset, size_t length);
+        void                                                addBufferSegment(const std::string &literal);
+        void                                                removeHeader(std::string key);
+        void                                                setCompressor(GzipFilter *compressor);
 
 
         int                                              getByteToSend() const;
@@ -52,6 +127,10 @@ class HttpResponse
         std::string                                         getFilePath() const;
         bool                                                isChunked() const;
         bool                                                isKeepAlive() const;
+        bool                                                hasNoBody() const;
+        bool                                                hasSegments() const;
+        bool                                                hasCompressor() const;
+        size_t                                              getSegmentsLength() const;
         std::string                                         getBuffer() const;
         int                                              getByteSent() const;
         std::string                                         getContentType() const;
@@ -59,13 +138,14 @@ class HttpResponse
 
         bool                                                checkAvailablePacket() const;
 
-        void                                                sendChunkedResponse(int socekt_fd);
-        void                                                sendResponse(int socket_fd);
-        std::string  toString() ;
+        bool                                                flushOutput(int socket_fd);
+        void         appendHeaderBlock(std::string &out) const;
+        static void  appendDecimal(std::string &out, size_t value);
+        static void  appendHex(std::string &out, size_t value);
+        static std::string httpDate(time_t time);
         std::string  GetStatusMessage(int code) const;
         void         clear();
         bool         isFile() const;
-        std::string determineContentType( std::string path) ;
         ~HttpResponse();
 };
 
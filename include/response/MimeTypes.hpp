@@ -0,0 +1,54 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <utility>
+
+#define MIME_DEFAULT_TYPE "text/plain"
+
+/*
+    Static string -> index map built once with hash and displace (CHD):
+    keys are spread over buckets by a first hash, then every bucket, largest
+    first, gets the smallest seed that drops all of its keys into free slots.
+    A lookup is two hashes and a single string compare, whatever the size.
+*/
+class PerfectHash
+{
+    private:
+        std::vector<unsigned int>   _seeds;     // per bucket
+        std::vector<int>            _slots;     // slot -> key index, -1 when free
+        std::vector<std::string>    _keys;
+
+        static unsigned int hash(const char *key, size_t length, unsigned int seed);
+        bool                place(size_t slot_count);
+
+    public:
+        bool    Build(const std::vector<std::string> &keys);
+        int     Find(const char *key, size_t length) const;
+        int     Find(const std::string &key) const;
+};
+
+/*
+    The MIME catalogue shared by GET, uploads and the response path:
+    extension -> type and type -> preferred extension. Loaded once from a
+    mime.types file (the top level mime_types directive), falling back to a
+    compiled-in list when none is configured or the file is unusable.
+*/
+class MimeTypes
+{
+    private:
+        static PerfectHash                  _by_extension;
+        static std::vector<std::string>     _extension_types;
+        static PerfectHash                  _by_type;
+        static std::vector<std::string>     _type_extensions;
+        static bool                         _loaded;
+
+        static void     build(const std::vector<std::pair<std::string, std::string> > &entries);
+        static void     loadDefaults();
+
+    public:
+        static bool                 Load(const std::string &file_name);
+        // Content-Type for a file path by its extension, MIME_DEFAULT_TYPE when unknown
+        static const std::string    &TypeOf(const std::string &path);
+        // ".ext" for a Content-Type (parameters ignored), empty when unknown
+        static std::string          ExtensionFor(const std::string &content_type);
+};
@@ -1,6 +1,10 @@
 #include "./include/WebServer.hpp"
 #include "./include/config/ConfigParser.hpp"
 #include "./include/config/ServerConfig.hpp"
+#include "./include/response/MimeTypes.hpp"
+#include "./include/Logger.hpp"
+#include "./include/AccessLog.hpp"
+#include "./include/Overload.hpp"
 
 
 int main(int argc, char *argv[]) {
@@ -46,6 +50,41 @@ int main(int argc, char *argv[]) {
             return 1;
         }
         
+        // one MIME catalogue for every server, the built-in list when none is configured
+        if (!parser.get_main_directive("mime_types").empty()) {
+            MimeTypes::Load(parser.get_main_directive("mime_types"));
+        }
+        
+        // stderr at info unless the config says otherwise
+        std::string error_log = parser.get_main_directive("error_log");
+        if (!Logger::Open(error_log.empty() ? "stderr" : error_log, parser.get_main_directive("error_log", 1))) {
+            std::cerr << "Cannot open error_log " << error_log << std::endl;
+            return 1;
+        }
+
+        // formats are compiled once here, access_log directives refer to them by name
+        const Block& main_block = parser.get_root_block();
+        for (size_t i = 0; i < main_block.directives.size(); ++i) {
+            const Directive& directive = main_block.directives[i];
+            std::string error;
+            if (directive.name == "log_format"
+                && !AccessLog::DefineFormat(directive.parameters[0], parser.get_log_format(directive.parameters[0]), error)) {
+                std::cerr << "log_format " << directive.parameters[0] << ": " << error << std::endl;
+                return 1;
+            }
+        }
+
+        // shedding and the CGI cap watch the one event loop, so they are process-wide
+        OverloadOptions overload;
+        const Directive* overload_directive = main_block.find_directive("overload");
+        std::string overload_error;
+        if (overload_directive != NULL)
+            Overload::ParseOptions(overload_directive->parameters, overload, overload_error);
+        std::string cgi_max_processes = parser.get_main_directive("cgi_max_processes");
+        if (!cgi_max_processes.empty())
+            overload.cgi_processes = cgi_max_processes == "off" ? 0 : atoi(cgi_max_processes.c_str());
+        Overload::Configure(overload);
+
         std::vector<ServerConfig> configs = parser.create_servers();
         std::cout << "Created [" << configs.size() << "] server configuration(s)!" << std::endl;
         
@@ -55,15 +94,14 @@ int main(int argc, char *argv[]) {
             return 1;
         }
    
-        std::cout << "[DEBUG] *********** Configuration parsing completed successfully" << std::endl;
+        LOG_DEBUG("Configuration parsing completed successfully");
         
         // Print summary of server configurations
         std::cout << "\n=== Server Configuration Summary ===" << std::endl;
         for (size_t i = 0; i < configs.size(); ++i) {
             std::cout << "Server " << (i + 1) << ": " 
                       << configs[i].get_server_name() 
-                      << " (http://" << configs[i].get_host() 
-                      << ":" << configs[i].get_port() << ")" << std::endl;
+                      << " (http://" << configs[i].get_listen_address() << ")" << std::endl;
         }
         std::cout << "===================================\n" << std::endl;
         
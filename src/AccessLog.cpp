@@ -0,0 +1,396 @@
+#include "../include/AccessLog.hpp"
+#include "../include/ClientConnection.hpp"
+#include "../include/Logger.hpp"
+#include "../include/request/HttpRequest.hpp"
+#include "../include/response/HttpResponse.hpp"
+#include "../include/config/ServerConfig.hpp"
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+std::map<std::string, AccessLog::Format>    AccessLog::_formats;
+std::vector<AccessLog::File>                AccessLog::_files;
+std::vector<AccessLog::Log>                 AccessLog::_logs;
+pid_t                                       AccessLog::_owner = 0;
+
+bool AccessLog::compile(const std::string &source, Format &format, std::string &error)
+{
+    // $http_* is handled apart
+    static const struct { const char *name; Field field; } VARIABLES[] = {
+        { "remote_addr", REMOTE_ADDR },
+        { "remote_port", REMOTE_PORT },
+        { "time_local", TIME_LOCAL },
+        { "time_iso8601", TIME_ISO8601 },
+        { "msec", MSEC },
+        { "request", REQUEST },
+        { "request_method", REQUEST_METHOD },
+        { "request_uri", REQUEST_URI },
+        { "uri", URI },
+        { "args", ARGS },
+        { "server_protocol", SERVER_PROTOCOL },
+        { "status", STATUS },
+        { "bytes_sent", BYTES_SENT },
+        { "request_time", REQUEST_TIME },
+        { "upstream_response_time", UPSTREAM_RESPONSE_TIME },
+        { "request_phases", REQUEST_PHASES },
+        { "parse_time", PARSE_TIME },
+        { "body_time", BODY_TIME },
+        { "route_time", ROUTE_TIME },
+        { "handler_time", HANDLER_TIME },
+        { "cgi_time", CGI_TIME },
+        { "send_time", SEND_TIME },
+        { "host", HOST },
+        { "server_name", SERVER_NAME },
+    };
+    size_t i = 0;
+
+    format.clear();
+    while (i < source.size())
+    {
+        size_t dollar = source.find('$', i);
+        if (dollar != i)
+        {
+            Segment literal = { LITERAL, source.substr(i, dollar == std::string::npos ? std::string::npos : dollar - i) };
+            format.push_back(literal);
+            if (dollar == std::string::npos)
+                break;
+        }
+        size_t end = dollar + 1;
+        while (end < source.size() && (isalnum(static_cast<unsigned char>(source[end])) || source[end] == '_'))
+            ++end;
+        std::string name = source.substr(dollar + 1, end - dollar - 1);
+        Segment segment = { LITERAL, "" };
+
+        if (name.compare(0, 5, "http_") == 0 && name.size() > 5)
+        {
+            // $http_user_agent reads the User-Agent header
+            segment.field = HTTP_HEADER;
+            bool word_start = true;
+            for (size_t c = 5; c < name.size(); ++c)
+            {
+                char ch = name[c] == '_' ? '-' : name[c];
+                segment.text += word_start ? toupper(ch) : tolower(ch);
+                word_start = ch == '-';
+            }
+        }
+        else
+        {
+            for (size_t v = 0; v < sizeof(VARIABLES) / sizeof(VARIABLES[0]); ++v)
+            {
+                if (name == VARIABLES[v].name)
+                    segment.field = VARIABLES[v].field;
+            }
+            if (segment.field == LITERAL)
+            {
+                error = "unknown log_format variable \"$" + name + "\"";
+                return false;
+            }
+        }
+        format.push_back(segment);
+        i = end;
+    }
+    return true;
+}
+
+bool AccessLog::CheckFormat(const std::string &source, std::string &error)
+{
+    Format format;
+    return compile(source, format, error);
+}
+
+bool AccessLog::DefineFormat(const std::string &name, const std::string &source, std::string &error)
+{
+    Format format;
+
+    if (!compile(source, format, error))
+        return false;
+    _formats[name] = format;
+    return true;
+}
+
+int AccessLog::Open(const AccessLogOptions &options)
+{
+    if (options.path.empty())
+        return -1;
+    if (_formats.find("combined") == _formats.end())
+    {
+        std::string error;
+        DefineFormat("combined", ACCESS_LOG_COMBINED, error);
+    }
+    std::map<std::string, Format>::const_iterator format = _formats.find(options.format);
+    if (format == _formats.end())
+    {
+        LOG_ERROR("access_log: unknown log_format " << options.format);
+        return -1;
+    }
+
+    size_t file = 0;
+    while (file < _files.size() && _files[file].path != options.path)
+        ++file;
+    if (file == _files.size())
+    {
+        File opened;
+        opened.path = options.path;
+        opened.fd = options.path == "stderr" ? STDERR_FILENO
+            : open(options.path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (opened.fd < 0)
+        {
+            LOG_ERROR("access_log: cannot open " << options.path << ": " << strerror(errno));
+            return -1;
+        }
+        opened.capacity = options.buffer;
+        opened.flush = options.flush;
+        opened.first_buffered = 0;
+        opened.buffer.reserve(opened.capacity);
+        if (_files.empty())
+        {
+            _owner = getpid();
+            atexit(FlushAll);
+        }
+        _files.push_back(opened);
+    }
+
+    Log log = { file, &format->second };
+    _logs.push_back(log);
+    return static_cast<int>(_logs.size() - 1);
+}
+
+// nginx's escaping: quotes, backslashes and non-printable bytes as \xHH
+void AccessLog::appendEscaped(std::string &out, const std::string &value)
+{
+    static const char HEX[] = "0123456789ABCDEF";
+
+    if (value.empty())
+    {
+        out += '-';
+        return;
+    }
+    for (size_t i = 0; i < value.size(); ++i)
+    {
+        unsigned char c = value[i];
+        if (c < 32 || c > 126 || c == '"' || c == '\\')
+        {
+            out += "\\x";
+            out += HEX[c >> 4];
+            out += HEX[c & 0x0f];
+        }
+        else
+            out += static_cast<char>(c);
+    }
+}
+
+// phase durations keep microseconds, - for a phase the request skipped
+void AccessLog::appendPhase(std::string &out, double seconds)
+{
+    char number[32];
+
+    if (seconds < 0)
+    {
+        out += '-';
+        return;
+    }
+    snprintf(number, sizeof(number), "%.6f", seconds);
+    out += number;
+}
+
+double AccessLog::Elapsed(const struct timespec &since)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - since.tv_sec) + (now.tv_nsec - since.tv_nsec) / 1e9;
+}
+
+void AccessLog::render(std::string &out, const Format &format, const ClientConnection &client,
+    const HttpRequest *request, const HttpResponse &response, const ServerConfig &config)
+{
+    // both time strings only change once a second
+    static time_t cached_second = 0;
+    static char time_local[64];
+    static char time_iso8601[64];
+    char number[64];
+    time_t now = time(NULL);
+
+    if (now != cached_second)
+    {
+        struct tm local;
+        localtime_r(&now, &local);
+        strftime(time_local, sizeof(time_local), "%d/%b/%Y:%H:%M:%S %z", &local);
+        strftime(time_iso8601, sizeof(time_iso8601), "%Y-%m-%dT%H:%M:%S%z", &local);
+        cached_second = now;
+    }
+
+    for (size_t i = 0; i < format.size(); ++i)
+    {
+        const Segment &segment = format[i];
+        switch (segment.field)
+        {
+            case LITERAL:
+                out += segment.text;
+                break;
+            case REMOTE_ADDR:
+                out += client.ipAddress;
+                break;
+            case REMOTE_PORT:
+                HttpResponse::appendDecimal(out, client.port);
+                break;
+            case TIME_LOCAL:
+                out += time_local;
+                break;
+            case TIME_ISO8601:
+                out += time_iso8601;
+                break;
+            case MSEC:
+            {
+                struct timeval tv;
+                gettimeofday(&tv, NULL);
+                snprintf(number, sizeof(number), "%ld.%03ld", static_cast<long>(tv.tv_sec), static_cast<long>(tv.tv_usec / 1000));
+                out += number;
+                break;
+            }
+            case REQUEST:
+            {
+                std::string line = request ? request->GetRequestLine() : "";
+                if (!line.empty() && line[line.size() - 1] == '\r')
+                    line.erase(line.size() - 1);
+                appendEscaped(out, line);
+                break;
+            }
+            case REQUEST_METHOD:
+                appendEscaped(out, request ? request->GetMethod() : "");
+                break;
+            case REQUEST_URI:
+                if (request && !request->GetQueryStringStr().empty())
+                    appendEscaped(out, request->GetLocation() + "?" + request->GetQueryStringStr());
+                else
+                    appendEscaped(out, request ? request->GetLocation() : "");
+                break;
+            case URI:
+                appendEscaped(out, request ? request->GetLocation() : "");
+                break;
+            case ARGS:
+                appendEscaped(out, request ? request->GetQueryStringStr() : "");
+                break;
+            case SERVER_PROTOCOL:
+                appendEscaped(out, request ? request->GetHttpVersion() : "");
+                break;
+            case STATUS:
+                HttpResponse::appendDecimal(out, response.getStatusCode());
+                break;
+            case BYTES_SENT:
+                HttpResponse::appendDecimal(out, response.getByteSent());
+                break;
+            case REQUEST_TIME:
+                snprintf(number, sizeof(number), "%.3f", Elapsed(client.phases.start));
+                out += number;
+                break;
+            case REQUEST_PHASES:
+                out += client.phaseBreakdown();
+                break;
+            case PARSE_TIME:
+                appendPhase(out, ClientConnection::phaseTime(client.phases.start, client.phases.parsed));
+                break;
+            case BODY_TIME:
+                appendPhase(out, ClientConnection::phaseTime(client.phases.parsed, client.phases.dispatched));
+                break;
+            case ROUTE_TIME:
+                appendPhase(out, ClientConnection::phaseTime(client.phases.dispatched, client.phases.routed));
+                break;
+            case HANDLER_TIME:
+                appendPhase(out, ClientConnection::phaseTime(client.phases.routed, client.phases.handled));
+                break;
+            case CGI_TIME:
+                appendPhase(out, ClientConnection::phaseTime(client.phases.handled, client.phases.upstream));
+                break;
+            case SEND_TIME:
+                appendPhase(out, ClientConnection::phaseTime(client.responseReady(), client.phases.sent));
+                break;
+            case UPSTREAM_RESPONSE_TIME:
+                if (client.upstream_time < 0)
+                    out += '-';
+                else
+                {
+                    snprintf(number, sizeof(number), "%.3f", client.upstream_time);
+                    out += number;
+                }
+                break;
+            case HOST:
+                if (request && !request->GetHeader("Host").empty())
+                    appendEscaped(out, request->GetHeader("Host"));
+                else
+                    appendEscaped(out, config.get_server_name());
+                break;
+            case SERVER_NAME:
+                appendEscaped(out, config.get_server_name());
+                break;
+            case HTTP_HEADER:
+                appendEscaped(out, request ? request->GetHeader(segment.text) : "");
+                break;
+        }
+    }
+    out += '\n';
+}
+
+void AccessLog::flushFile(File &file)
+{
+    size_t written = 0;
+
+    while (written < file.buffer.size())
+    {
+        ssize_t n = write(file.fd, file.buffer.data() + written, file.buffer.size() - written);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+        {
+            LOG_ERROR("access_log: write to " << file.path << " failed: " << strerror(errno));
+            break;
+        }
+        written += n;
+    }
+    file.buffer.clear();
+}
+
+void AccessLog::Record(int handle, const ClientConnection &client, const HttpRequest *request,
+    const HttpResponse &response, const ServerConfig &config)
+{
+    if (handle < 0 || static_cast<size_t>(handle) >= _logs.size())
+        return;
+    const Log &log = _logs[handle];
+    File &file = _files[log.file];
+    static std::string line;
+
+    line.clear();
+    render(line, *log.format, client, request, response, config);
+    if (file.buffer.size() + line.size() > file.capacity && !file.buffer.empty())
+        flushFile(file);
+    if (file.buffer.empty())
+        file.first_buffered = time(NULL);
+    file.buffer += line;
+    if (file.buffer.size() >= file.capacity)
+        flushFile(file);
+}
+
+void AccessLog::FlushExpired(time_t now)
+{
+    for (size_t i = 0; i < _files.size(); ++i)
+    {
+        File &file = _files[i];
+        if (file.flush > 0 && !file.buffer.empty() && now - file.first_buffered >= file.flush)
+            flushFile(file);
+    }
+}
+
+void AccessLog::FlushAll()
+{
+    // a forked child holds a copy of the buffers, the parent writes them
+    if (getpid() != _owner)
+        return;
+    for (size_t i = 0; i < _files.size(); ++i)
+    {
+        if (!_files[i].buffer.empty())
+            flushFile(_files[i]);
+    }
+}
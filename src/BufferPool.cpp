@@ -0,0 +1,34 @@
+#include "../include/BufferPool.hpp"
+
+std::vector<char *> BufferPool::_small;
+std::vector<char *> BufferPool::_large;
+size_t              BufferPool::_small_borrowed = 0;
+size_t              BufferPool::_large_borrowed = 0;
+
+char *BufferPool::Acquire(size_t size, size_t &capacity)
+{
+    std::vector<char *> &free_list = size <= BUFFER_SMALL ? _small : _large;
+
+    capacity = size <= BUFFER_SMALL ? BUFFER_SMALL : BUFFER_LARGE;
+    ++(capacity == BUFFER_SMALL ? _small_borrowed : _large_borrowed);
+    if (free_list.empty())
+        return new char[capacity];
+    char *buffer = free_list.back();
+    free_list.pop_back();
+    return buffer;
+}
+
+void BufferPool::Release(char *buffer, size_t capacity)
+{
+    std::vector<char *> &free_list = capacity == BUFFER_SMALL ? _small : _large;
+
+    if (buffer == NULL)
+        return;
+    --(capacity == BUFFER_SMALL ? _small_borrowed : _large_borrowed);
+    if (free_list.size() >= BUFFER_POOL_IDLE_MAX)
+    {
+        delete[] buffer;
+        return;
+    }
+    free_list.push_back(buffer);
+}
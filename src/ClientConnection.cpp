@@ -1,14 +1,22 @@
 #include "../include/ClientConnection.hpp"
+#include "../include/Logger.hpp"
 #include "../include/WebServer.hpp"
 #include "../include/request/Get.hpp"
 #include "../include/request/Post.hpp"
 #include "../include/request/CgiHandler.hpp"
 #include "../include/request/Delete.hpp"
+#include "../include/request/ResumableUpload.hpp"
+#include "../include/request/MetricsHandler.hpp"
+#include "../include/response/MimeTypes.hpp"
+#include "../include/BufferPool.hpp"
+#include "../include/AccessLog.hpp"
+#include "../include/Metrics.hpp"
 
 #include <iostream>
 #include <string>
 #include <sstream>
 #include <cstring>
+#include <cstdio>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <algorithm>
@@ -17,32 +25,58 @@
 #include <set>
 #include <iomanip>
 #include <chrono>
+#include <sys/statvfs.h>
+#include <climits>
+#include <cctype>
 
 int ClientConnection::redirect_counter = 0;
 
 ClientConnection::ClientConnection() 
-    : fd(-1), ipAddress(""), port(0), connectTime(0), lastActivity(0),
+    : fd(-1), generation(0), ipAddress(""), port(0), limit_slot(-1), connectTime(0), lastActivity(0),
       builder(NULL), http_response(NULL), http_request(NULL),
       is_streaming_upload(false), total_content_length(0), 
-      bytes_received_so_far(0), temp_upload_fd(-1), should_close(false),
+      bytes_received_so_far(0), temp_upload_fd(-1), is_resumable_chunk(false),
+      upload_base_offset(0), should_close(false), tcp_corked(false), upstream_time(-1),
       filename_detected(false), is_multipart_upload(false), multipart_boundary(""),
       detected_filename(""), detected_extension(".bin")
 {
     this->_server = NULL;
+    memset(&this->phases, 0, sizeof(this->phases));
+    markPhase(this->phases.start);
 }
 
-ClientConnection::ClientConnection(int socketFd, const sockaddr_in& clientAddr) 
-    : _server(NULL), fd(socketFd), port(ntohs(clientAddr.sin_port)),
+ClientConnection::ClientConnection(int socketFd, const sockaddr_storage& clientAddr) 
+    : _server(NULL), fd(socketFd), generation(0), port(0), limit_slot(-1),
       connectTime(time(NULL)), lastActivity(time(NULL)),
       builder(NULL), http_response(NULL), http_request(NULL),
       is_streaming_upload(false), total_content_length(0),
-      bytes_received_so_far(0), temp_upload_fd(-1), should_close(false),
+      bytes_received_so_far(0), temp_upload_fd(-1), is_resumable_chunk(false),
+      upload_base_offset(0), should_close(false), tcp_corked(false), upstream_time(-1),
       filename_detected(false), is_multipart_upload(false), multipart_boundary(""),
       detected_filename(""), detected_extension(".bin")
 {
-    char ipStr[INET_ADDRSTRLEN];
-    inet_ntop(AF_INET, &(clientAddr.sin_addr), ipStr, INET_ADDRSTRLEN);
-    ipAddress = ipStr;
+    char ipStr[INET6_ADDRSTRLEN];
+
+    memset(&this->phases, 0, sizeof(this->phases));
+    markPhase(this->phases.start);
+
+    if (clientAddr.ss_family == AF_INET6) {
+        const sockaddr_in6 *v6 = reinterpret_cast<const sockaddr_in6 *>(&clientAddr);
+        // IPv4 clients of a dual-stack listener show up as ::ffff:a.b.c.d
+        if (IN6_IS_ADDR_V4MAPPED(&v6->sin6_addr))
+            inet_ntop(AF_INET, &v6->sin6_addr.s6_addr[12], ipStr, sizeof(ipStr));
+        else
+            inet_ntop(AF_INET6, &v6->sin6_addr, ipStr, sizeof(ipStr));
+        ipAddress = ipStr;
+        port = ntohs(v6->sin6_port);
+    } else if (clientAddr.ss_family == AF_INET) {
+        const sockaddr_in *v4 = reinterpret_cast<const sockaddr_in *>(&clientAddr);
+        inet_ntop(AF_INET, &v4->sin_addr, ipStr, sizeof(ipStr));
+        ipAddress = ipStr;
+        port = ntohs(v4->sin_port);
+    } else {
+        ipAddress = "unix:";
+    }
 }
 
 void ClientConnection::setServerConfig(const ServerConfig& config)
@@ -57,7 +91,15 @@ ServerConfig ClientConnection::getServerConfig() const
 
 ClientConnection::~ClientConnection()
 {
+    if (temp_upload_fd != -1 && is_resumable_chunk) {
+        // Interrupted chunk: keep every byte that made it so the client can resume from there
+        trimUploadFile();
+        close(temp_upload_fd);
+        temp_upload_fd = -1;
+    }
     if (temp_upload_fd != -1) {
+        // Aborted upload: give the preallocated extent back before dropping the file
+        ftruncate(temp_upload_fd, 0);
         close(temp_upload_fd);
         temp_upload_fd = -1;
         if (!temp_upload_path.empty()) {
@@ -81,49 +123,119 @@ ClientConnection::~ClientConnection()
     }
 }
 
-void ClientConnection::GenerateRequest(int fd)
+/*
+    Client sockets are non-blocking: the parts of a request that are read
+    past the first recv wait here, in poll(), for at most timeout_ms.
+*/
+ssize_t ClientConnection::recvWithin(int fd, char *buffer, size_t length, int timeout_ms)
+{
+    while (true) {
+        ssize_t count = recv(fd, buffer, length, 0);
+        if (count >= 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+            return count;
+        if (errno == EINTR)
+            continue;
+        struct pollfd readable;
+        readable.fd = fd;
+        readable.events = POLLIN;
+        readable.revents = 0;
+        int ready = poll(&readable, 1, timeout_ms);
+        if (ready == 0) {
+            errno = ETIMEDOUT;
+            return -1;
+        }
+        if (ready < 0 && errno != EINTR)
+            return -1;
+    }
+}
+
+bool ClientConnection::GenerateRequest(int fd)
 {
     if (is_streaming_upload) {
         // If we're already in streaming mode, don't try to generate a new request
-        std::cout << "Already in streaming mode, skipping request generation" << std::endl;
-        return;
+        LOG_DEBUG("Already in streaming mode, skipping request generation");
+        return false;
     }
 
-    char buffer[REQUSET_LINE_BUFFER];
-    ssize_t bytesRead = recv(fd, buffer, sizeof(buffer) - 1, 0);
+    // borrowed only for this read, idle connections hold no buffer
+    PooledBuffer pooled(REQUSET_LINE_BUFFER);
+    char *buffer = pooled.data();
+    // a head cut across reads is collected in pending_head, never past REQUSET_LINE_BUFFER in all
+    ssize_t bytesRead = recv(fd, buffer, REQUSET_LINE_BUFFER - 1 - pending_head.size(), 0);
     
-    if (bytesRead <= 0) {
-        std::cerr << "Error receiving data: "
-                  << (bytesRead == 0 ? "Connection closed" : strerror(errno))
-                  << std::endl;
+    if (bytesRead < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        // woken up without data, poll() will report the socket again
+        return false;
+    }
+    // a client that closes after a head without CRLF CRLF still gets it parsed, as a single read would
+    if (bytesRead < 0 || (bytesRead == 0 && pending_head.empty())) {
+        LOG_ERROR("Error receiving data: "
+                  << (bytesRead == 0 ? "Connection closed" : strerror(errno)));
         throw HttpException(500, "Internal Server Error", INTERNAL_SERVER_ERROR);
     }
     
-    buffer[bytesRead] = '\0';
-    std::string rawRequest(buffer);
+    if (pending_head.empty()) {
+        // the request starts with its first byte, not with the read completing its head
+        memset(&this->phases, 0, sizeof(this->phases));
+        markPhase(this->phases.start);
+        this->upstream_time = -1;
+    }
+    // keep the length, binary bodies may contain NUL bytes
+    pending_head.append(buffer, bytesRead);
+    // only CRLF CRLF ends a head for sure, the parser prefers it to a bare LF blank line seen earlier;
+    // a full buffer or the end of the stream is parsed as it is
+    if (bytesRead > 0 && pending_head.find("\r\n\r\n") == std::string::npos
+        && pending_head.size() < REQUSET_LINE_BUFFER - 1) {
+        LOG_DEBUG("Partial head from client " << this->GetFd() << ", " << pending_head.size() << " bytes so far");
+        return false;
+    }
+    std::string rawRequest;
+    rawRequest.swap(pending_head);
     
-    std::cout << "Received request from client " << buffer << std::endl;
+    // only the request line, headers may carry cookies and credentials
+    LOG_DEBUG("Received request from client " << this->GetFd() << ": "
+              << Logger::Escape(rawRequest.substr(0, rawRequest.find("\r\n"))));
 
     HttpRequestBuilder build = HttpRequestBuilder();
     build.ParseRequest(rawRequest, this->_server->getConfigForClient(this->GetFd()));
+    markPhase(this->phases.parsed);
+    Metrics::Increment(Metrics::REQUESTS_PARSED);
+    Metrics::Observe(Metrics::REQUEST_PARSE, phaseTime(this->phases.start, this->phases.parsed));
+
+    // limit_req and overload: turned away on the head, none of the body is read
+    if (this->_server->limitRequest(*this, build.GetHttpRequest())
+        || this->_server->shedRequest(*this, build.GetHttpRequest()))
+        return true;
+    // allow / deny of the location, checked on the head like the limits above
+    const Location *location = this->_server->getConfigForClient(this->GetFd()).findMatchingLocation(build.GetHttpRequest().GetLocation());
+    if (location && !location->is_address_allowed(this->ipAddress)) {
+        LOG_WARN("access forbidden by rule, client " << this->ipAddress << ", location " << location->get_path());
+        throw HttpException(403, "403 Forbidden", FORBIDDEN);
+    }
 
     std::string contentLengthStr = build.GetHttpRequest().GetHeader("Content-Length");
     if (!contentLengthStr.empty()) {
-        long contentLength = atol(contentLengthStr.c_str());
-        std::cout << "Content-Length: " << contentLength << " bytes" << std::endl;
+        char *endptr = NULL;
+        long contentLength = strtol(contentLengthStr.c_str(), &endptr, 10);
+        // digits only: a sign or trailing junk would read as a length the client never meant
+        if (!isdigit(static_cast<unsigned char>(contentLengthStr[0])) || *endptr != '\0' || contentLength == LONG_MAX) {
+            LOG_INFO("Invalid Content-Length: " << Logger::Escape(contentLengthStr));
+            throw HttpException(400, "Bad Request", BAD_REQUEST);
+        }
+        LOG_DEBUG("Content-Length: " << contentLength << " bytes");
         
         size_t bodyStart = rawRequest.find("\r\n\r\n");
         if (bodyStart != std::string::npos) {
             bodyStart += 4;
             size_t bodyBytesRead = rawRequest.length() - bodyStart;
             
-            std::cout << "Initial buffer size: " << rawRequest.length() << " bytes" << std::endl;
-            std::cout << "Body starts at position: " << bodyStart << std::endl;
-            std::cout << "Body bytes in initial read: " << bodyBytesRead << " bytes" << std::endl;
-            std::cout << "Total Content-Length: " << contentLength << " bytes" << std::endl;
+            LOG_DEBUG("Initial buffer size: " << rawRequest.length() << " bytes");
+            LOG_DEBUG("Body starts at position: " << bodyStart);
+            LOG_DEBUG("Body bytes in initial read: " << bodyBytesRead << " bytes");
+            LOG_DEBUG("Total Content-Length: " << contentLength << " bytes");
             
             if (contentLength > MAX_MEMORY_UPLOAD) {
-                std::cout << "Large upload detected, enabling streaming mode" << std::endl;
+                LOG_DEBUG("Large upload detected, enabling streaming mode");
                 
                 // Create the HTTP request object first
                 if (this->http_request) {
@@ -133,6 +245,26 @@ void ClientConnection::GenerateRequest(int fd)
                 this->http_request->SetClientData(this);
                 this->setServerConfig(this->_server->getConfigByHost(this->http_request->GetHeader("Host")));
                 
+                // Resumable chunk: validate the offset now, then stream straight into the part file
+                if (ResumableUpload::IsChunkRequest(*this->http_request)) {
+                    ResumableUpload resumable(this);
+                    std::string part_path;
+                    size_t offset = 0;
+                    if (!resumable.PrepareStreamedChunk(this->http_request, part_path, offset)) {
+                        // error response is ready, the rest of the body is never read
+                        this->http_request->SetProcessed(true);
+                        should_close = true;
+                        return true;
+                    }
+                    initializeResumableStreaming(contentLength, part_path, offset);
+                    writeUploadData(rawRequest.data() + bodyStart, rawRequest.size() - bodyStart);
+                    this->http_request->SetBody("__RESUMABLE_CHUNK:" + temp_upload_path);
+                    if (bytes_received_so_far >= total_content_length || continueStreamingRead(fd)) {
+                        finalizeStreaming();
+                    }
+                    return true;
+                }
+
                 // Get content type from the request
                 std::string content_type = this->http_request->GetHeader("Content-Type");
                 std::string initial_body = rawRequest.substr(bodyStart);
@@ -142,7 +274,7 @@ void ClientConnection::GenerateRequest(int fd)
                 
                 // For multipart/form-data uploads, we need to extract the boundary and properly parse it
                 if (content_type.find("multipart/form-data") != std::string::npos) {
-                    std::cout << "Processing multipart/form-data upload" << std::endl;
+                    LOG_DEBUG("Processing multipart/form-data upload");
                     is_multipart_upload = true;
                     
                     // Extract boundary from the Content-Type header
@@ -166,31 +298,29 @@ void ClientConnection::GenerateRequest(int fd)
                             multipart_boundary = content_type.substr(boundary_pos, boundary_end - boundary_pos);
                         }
                         
-                        std::cout << "Found multipart boundary: '" << multipart_boundary << "'" << std::endl;
+                        LOG_DEBUG("Found multipart boundary: '" << multipart_boundary << "'");
                     }
                     
                     // If we don't have enough data, read more to get the multipart headers
                     if (extended_body.find("filename=") == std::string::npos || 
                         extended_body.find("Content-Disposition:") == std::string::npos) {
                         
-                        std::cout << "Reading additional data to extract filename..." << std::endl;
+                        LOG_DEBUG("Reading additional data to extract filename...");
                         
                         // Read up to 8KB more to get the multipart headers
-                        char extra_buffer[8192];
-                        ssize_t extra_read = recv(fd, extra_buffer, sizeof(extra_buffer) - 1, 0);
+                        ssize_t extra_read = recvWithin(fd, buffer, 8192, CLIENT_BODY_TIMEOUT);
                         if (extra_read > 0) {
-                            extra_buffer[extra_read] = '\0';
-                            extended_body += std::string(extra_buffer, extra_read);
+                            extended_body.append(buffer, extra_read);
                             bodyBytesRead += extra_read;
-                            std::cout << "Read additional " << extra_read << " bytes for filename extraction" << std::endl;
-                            std::cout << "Extended body size: " << extended_body.size() << " bytes" << std::endl;
+                            LOG_DEBUG("Read additional " << extra_read << " bytes for filename extraction");
+                            LOG_DEBUG("Extended body size: " << extended_body.size() << " bytes");
                         }
                     }
                     
                     // Now try to extract filename from the extended body
                     size_t content_disposition_pos = extended_body.find("Content-Disposition:");
                     if (content_disposition_pos != std::string::npos) {
-                        std::cout << "Found Content-Disposition at position: " << content_disposition_pos << std::endl;
+                        LOG_DEBUG("Found Content-Disposition at position: " << content_disposition_pos);
                         
                         // Look for filename parameter
                         size_t filename_pos = extended_body.find("filename=\"", content_disposition_pos);
@@ -199,54 +329,39 @@ void ClientConnection::GenerateRequest(int fd)
                             size_t filename_end = extended_body.find("\"", filename_pos);
                             if (filename_end != std::string::npos) {
                                 original_filename = extended_body.substr(filename_pos, filename_end - filename_pos);
-                                std::cout << "SUCCESS: Extracted filename: '" << original_filename << "'" << std::endl;
+                                LOG_DEBUG("SUCCESS: Extracted filename: '" << original_filename << "'");
                                 
                                 // Extract extension
                                 size_t dot_pos = original_filename.find_last_of('.');
                                 if (dot_pos != std::string::npos) {
                                     file_extension = original_filename.substr(dot_pos);
-                                    std::cout << "SUCCESS: Extracted extension: '" << file_extension << "'" << std::endl;
+                                    LOG_DEBUG("SUCCESS: Extracted extension: '" << file_extension << "'");
                                 }
                             }
                         } else {
-                            std::cout << "ERROR: Could not find filename in Content-Disposition" << std::endl;
+                            LOG_WARN("Could not find filename in Content-Disposition");
                             
                             // Debug output
                             size_t debug_end = std::min(content_disposition_pos + 200, extended_body.size());
                             std::string debug_section = extended_body.substr(content_disposition_pos, debug_end - content_disposition_pos);
-                            std::cout << "Content-Disposition section: '" << debug_section << "'" << std::endl;
+                            LOG_DEBUG("Content-Disposition section: '" << debug_section << "'");
                         }
                     } else {
-                        std::cout << "ERROR: Could not find Content-Disposition in body" << std::endl;
+                        LOG_WARN("Could not find Content-Disposition in body");
                         
                         // Show first part of extended body for debugging
-                        std::cout << "First 500 chars of extended body:" << std::endl;
+                        LOG_DEBUG("First 500 chars of extended body:");
                         std::string debug_body = extended_body.substr(0, std::min((size_t)500, extended_body.size()));
-                        for (size_t i = 0; i < debug_body.length(); ++i) {
-                            char c = debug_body[i];
-                            if (c == '\r') std::cout << "\\r";
-                            else if (c == '\n') std::cout << "\\n";
-                            else if (c >= 32 && c <= 126) std::cout << c;
-                            else std::cout << "[" << (int)c << "]";
-                        }
-                        std::cout << std::endl;
+                        LOG_DEBUG(Logger::Escape(debug_body));
                     }
                 }
                 
                 // If still no extension, guess from content type
                 if (file_extension == ".bin" && !content_type.empty()) {
-                    if (content_type.find("video/mp4") != std::string::npos) {
-                        file_extension = ".mp4";
-                    } else if (content_type.find("video/webm") != std::string::npos) {
-                        file_extension = ".webm";
-                    } else if (content_type.find("video/") != std::string::npos) {
-                        file_extension = ".mp4";
-                    } else if (content_type.find("image/jpeg") != std::string::npos) {
-                        file_extension = ".jpg";
-                    } else if (content_type.find("image/png") != std::string::npos) {
-                        file_extension = ".png";
-                    }
-                    std::cout << "Guessed extension from Content-Type: " << file_extension << std::endl;
+                    std::string guessed = MimeTypes::ExtensionFor(content_type);
+                    if (!guessed.empty())
+                        file_extension = guessed;
+                    LOG_DEBUG("Guessed extension from Content-Type: " << file_extension);
                 }
                 
                 // Initialize streaming with extracted filename
@@ -254,23 +369,22 @@ void ClientConnection::GenerateRequest(int fd)
                 
                 // Write any data we've already read
                 if (!extended_body.empty()) {
-                    write(temp_upload_fd, extended_body.c_str(), extended_body.size());
-                    bytes_received_so_far = extended_body.size();
+                    writeUploadData(extended_body.c_str(), extended_body.size());
                     showProgress();
                 }
                 
                 this->http_request->SetBody("__STREAMING_UPLOAD_FILE:" + temp_upload_path);
                 
                 if (bytes_received_so_far >= total_content_length) {
-                    std::cout << "Upload complete" << std::endl;
+                    LOG_DEBUG("Upload complete");
                     finalizeStreaming();
                 } else {
                     if (continueStreamingRead(fd)) {
-                        std::cout << "Upload complete" << std::endl;
+                        LOG_DEBUG("Upload complete");
                         finalizeStreaming();
                     }
                 }
-                return;
+                return true;
             }
             
             // Handle smaller uploads that fit in memory
@@ -279,55 +393,32 @@ void ClientConnection::GenerateRequest(int fd)
             size_t bodyBytesAlreadyRead = totalBytesRead - headerSize;
             size_t remainingTotalBytes = 0;
             
-            std::cout << "DEBUG: Total bytes read: " << totalBytesRead << ", Header size: " << headerSize << ", Body bytes already read: " << bodyBytesAlreadyRead << std::endl;
+            LOG_DEBUG("DEBUG: Total bytes read: " << totalBytesRead << ", Header size: " << headerSize << ", Body bytes already read: " << bodyBytesAlreadyRead);
             
             if (bodyBytesAlreadyRead < (size_t)contentLength) {
                 remainingTotalBytes = contentLength - bodyBytesAlreadyRead;
-                std::cout << "Need to read " << remainingTotalBytes << " more bytes to complete the request" << std::endl;
-                
-                // // Set socket to blocking mode for reliable body reading
-                // int flags = fcntl(fd, F_GETFL, 0);
-                // if (flags != -1) {
-                //     fcntl(fd, F_SETFL, flags & ~O_NONBLOCK);
-                // }
+                LOG_DEBUG("Need to read " << remainingTotalBytes << " more bytes to complete the request");
                 
-                // Set receive timeout
-                struct timeval tv;
-                tv.tv_sec = 30;
-                tv.tv_usec = 0;
-                setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, (const char*)&tv, sizeof tv);
-                
-                // Read the remaining data
-                std::string remainingData;
-                remainingData.reserve(remainingTotalBytes);
-                
-                char* tempBuffer = new char[8192];
+                // Read the remaining data straight into its place, no intermediate buffer
+                std::string remainingData(remainingTotalBytes, '\0');
                 size_t totalAdditionalBytesRead = 0;
                 
                 while (totalAdditionalBytesRead < remainingTotalBytes) {
-                    size_t bytesToRead = std::min((size_t)8192, remainingTotalBytes - totalAdditionalBytesRead);
+                    size_t bytesToRead = std::min((size_t)BUFFER_LARGE, remainingTotalBytes - totalAdditionalBytesRead);
                     
-                    ssize_t chunkRead = recv(fd, tempBuffer, bytesToRead, 0);
+                    ssize_t chunkRead = recvWithin(fd, &remainingData[totalAdditionalBytesRead], bytesToRead, CLIENT_BODY_TIMEOUT);
                     if (chunkRead <= 0) {
-                        delete[] tempBuffer;
-                        //if (flags != -1) fcntl(fd, F_SETFL, flags);
-                        std::cerr << "Error reading remaining request data: " 
-                                << (chunkRead == 0 ? "Connection closed" : strerror(errno)) << std::endl;
+                        LOG_ERROR("Error reading remaining request data: " 
+                                << (chunkRead == 0 ? "Connection closed" : strerror(errno)));
                         throw HttpException(500, "Internal Server Error", INTERNAL_SERVER_ERROR);
                     }
                     
-                    remainingData.append(tempBuffer, chunkRead);
                     totalAdditionalBytesRead += chunkRead;
                     
-                    std::cout << "Read " << chunkRead << " bytes, total additional: " 
-                             << totalAdditionalBytesRead << "/" << remainingTotalBytes << std::endl;
+                    LOG_DEBUG("Read " << chunkRead << " bytes, total additional: " 
+                             << totalAdditionalBytesRead << "/" << remainingTotalBytes);
                 }
                 
-                delete[] tempBuffer;
-                
-                // Restore socket flags
-                //if (flags != -1) fcntl(fd, F_SETFL, flags);
-                
                 // Extract the initial body part from the original request
                 std::string initialBody = rawRequest.substr(bodyStart);
                 
@@ -335,18 +426,18 @@ void ClientConnection::GenerateRequest(int fd)
                 std::string completeBody = initialBody + remainingData;
                 build.SetBody(completeBody);
                 
-                std::cout << "Initial body size: " << initialBody.length() << " bytes" << std::endl;
-                std::cout << "Additional data size: " << remainingData.length() << " bytes" << std::endl;
-                std::cout << "Complete body assembled: " << completeBody.length() << " bytes" << std::endl;
+                LOG_DEBUG("Initial body size: " << initialBody.length() << " bytes");
+                LOG_DEBUG("Additional data size: " << remainingData.length() << " bytes");
+                LOG_DEBUG("Complete body assembled: " << completeBody.length() << " bytes");
             } else {
-                // All data was received in the initial read
-                std::string bodyData = rawRequest.substr(bodyStart);
+                // All data was received in the initial read, bytes past Content-Length are not body
+                std::string bodyData = rawRequest.substr(bodyStart, contentLength);
                 build.SetBody(bodyData);
-                std::cout << "Complete request received in initial read" << std::endl;
-                std::cout << "Body size: " << bodyData.size() << " bytes" << std::endl;
+                LOG_DEBUG("Complete request received in initial read");
+                LOG_DEBUG("Body size: " << bodyData.size() << " bytes");
             }
         } else {
-            std::cout << "Could not find body separator (\\r\\n\\r\\n)" << std::endl;
+            LOG_DEBUG("Could not find body separator (\\r\\n\\r\\n)");
         }
     }
     
@@ -358,13 +449,21 @@ void ClientConnection::GenerateRequest(int fd)
     this->http_request->SetClientData(this);
     this->setServerConfig(this->_server->getConfigForClient(this->GetFd()));
 
-    std::cout << "Server Name is: " << this->getServerConfig().get_server_name() << "=============\n\n\n" << std::endl;
-    std::cout << "Server Root is: " << this->getServerConfig().get_root() << "=============\n\n\n" << std::endl;
+    LOG_DEBUG("Server Name is: " << this->getServerConfig().get_server_name() << "=============");
+    LOG_DEBUG("Server Root is: " << this->getServerConfig().get_root() << "=============");
+    return true;
 }
 
 
 void ClientConnection::initializeStreamingWithFilename(size_t content_length, const std::string& original_filename, const std::string& file_extension)
 {
+    // Get the appropriate uploads directory from Post class
+    Post post_handler;
+    std::string uploads_dir = post_handler.getUploadsDirectory(server_config);
+
+    // Refuse before reading a single body byte if the declared size can't fit
+    ensureUploadSpace(uploads_dir, content_length);
+
     is_streaming_upload = true;
     total_content_length = content_length;
     bytes_received_so_far = 0;
@@ -380,10 +479,6 @@ void ClientConnection::initializeStreamingWithFilename(size_t content_length, co
         filename_detected = true;
     }
     
-    // Get the appropriate uploads directory from Post class
-    Post post_handler;
-    std::string uploads_dir = post_handler.getUploadsDirectory(server_config);
-    
     // Create a unique filename while preserving the original name
     std::string base_filename;
     if (!original_filename.empty()) {
@@ -415,17 +510,17 @@ void ClientConnection::initializeStreamingWithFilename(size_t content_length, co
     
     temp_upload_path = uploads_dir + "/" + final_filename;
     
-    std::cout << "Creating file: " << temp_upload_path << std::endl;
-    std::cout << "Original filename: " << (original_filename.empty() ? "Not found" : original_filename) << std::endl;
-    std::cout << "Base filename: " << base_filename << std::endl;
-    std::cout << "File extension: " << file_extension << std::endl;
-    std::cout << "Final filename: " << final_filename << std::endl;
+    LOG_DEBUG("Creating file: " << temp_upload_path);
+    LOG_DEBUG("Original filename: " << (original_filename.empty() ? "Not found" : original_filename));
+    LOG_DEBUG("Base filename: " << base_filename);
+    LOG_DEBUG("File extension: " << file_extension);
+    LOG_DEBUG("Final filename: " << final_filename);
     
     // Create the final file directly
     temp_upload_fd = open(temp_upload_path.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
     if (temp_upload_fd == -1) {
-        std::cerr << "Failed to create destination file: " << temp_upload_path
-                 << " (errno: " << errno << ": " << strerror(errno) << ")" << std::endl;
+        LOG_ERROR("Failed to create destination file: " << temp_upload_path
+                 << " (errno: " << errno << ": " << strerror(errno) << ")");
         
         // Fallback: If the error is that the file exists, try with a different name
         if (errno == EEXIST) {
@@ -438,19 +533,133 @@ void ClientConnection::initializeStreamingWithFilename(size_t content_length, co
         
         // If still failed, try with /tmp as a last resort
         if (temp_upload_fd == -1) {
-            std::cerr << "Failed to create file in uploads directory, falling back to /tmp" << std::endl;
+            LOG_ERROR("Failed to create file in uploads directory, falling back to /tmp");
             temp_upload_path = "/tmp/" + final_filename;
             temp_upload_fd = open(temp_upload_path.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
             
             if (temp_upload_fd == -1) {
-                std::cerr << "Failed to create destination file: " << temp_upload_path
-                         << " (errno: " << errno << ": " << strerror(errno) << ")" << std::endl;
+                LOG_ERROR("Failed to create destination file: " << temp_upload_path
+                         << " (errno: " << errno << ": " << strerror(errno) << ")");
+                is_streaming_upload = false;
                 throw HttpException(500, "Internal Server Error", INTERNAL_SERVER_ERROR);
             }
         }
     }
     
-    std::cout << "Streaming initialized for " << content_length << " bytes directly to: " << temp_upload_path << std::endl;
+    preallocateUpload();
+    LOG_DEBUG("Streaming initialized for " << content_length << " bytes directly to: " << temp_upload_path);
+}
+
+void ClientConnection::ensureUploadSpace(const std::string& dir, size_t content_length) const
+{
+    struct statvfs fs;
+    if (statvfs(dir.c_str(), &fs) != 0) {
+        // Can't tell, let fallocate/write report the real problem
+        return;
+    }
+    unsigned long long available = (unsigned long long)fs.f_bavail * fs.f_frsize;
+    if (available < content_length) {
+        LOG_WARN("Not enough space in " << dir << " for upload: need " << content_length
+                  << " bytes, " << available << " available");
+        throw HttpException(507, "Insufficient Storage", INSUFFICIENT_STORAGE);
+    }
+}
+
+void ClientConnection::preallocateUpload()
+{
+    if (temp_upload_fd == -1 || total_content_length == 0) {
+        return;
+    }
+#ifdef __linux__
+    // Reserve the whole declared size now so the file is laid out contiguously
+    // and running out of space is detected before the body is received
+    // A resumable chunk must not grow the part file past what was really received,
+    // its size is the committed offset
+    int mode = is_resumable_chunk ? FALLOC_FL_KEEP_SIZE : 0;
+    if (fallocate(temp_upload_fd, mode, upload_base_offset, total_content_length) == 0) {
+        return;
+    }
+    if (errno == EOPNOTSUPP || errno == ENOSYS) {
+        // Filesystem can't preallocate, plain writes still work
+        return;
+    }
+    int err = errno;
+    LOG_ERROR("Failed to preallocate " << total_content_length << " bytes for " << temp_upload_path
+              << " (" << strerror(err) << ")");
+    close(temp_upload_fd);
+    temp_upload_fd = -1;
+    if (!is_resumable_chunk) {
+        unlink(temp_upload_path.c_str());
+    }
+    is_streaming_upload = false;
+    is_resumable_chunk = false;
+    if (err == ENOSPC || err == EFBIG || err == EDQUOT) {
+        throw HttpException(507, "Insufficient Storage", INSUFFICIENT_STORAGE);
+    }
+    throw HttpException(500, "Internal Server Error", INTERNAL_SERVER_ERROR);
+#endif
+}
+
+// Positioned write into the upload file, never past the declared Content-Length
+void ClientConnection::writeUploadData(const char* data, size_t length)
+{
+    if (bytes_received_so_far >= total_content_length) {
+        return;
+    }
+    if (length > total_content_length - bytes_received_so_far) {
+        length = total_content_length - bytes_received_so_far;
+    }
+    size_t done = 0;
+    while (done < length) {
+        ssize_t written = pwrite(temp_upload_fd, data + done, length - done,
+                                 upload_base_offset + bytes_received_so_far + done);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            int err = errno;
+            LOG_ERROR("Error writing to temp file: " << strerror(err));
+            if (err == ENOSPC || err == EDQUOT) {
+                throw HttpException(507, "Insufficient Storage", INSUFFICIENT_STORAGE);
+            }
+            throw HttpException(500, "Failed to write upload data", INTERNAL_SERVER_ERROR);
+        }
+        done += written;
+    }
+    bytes_received_so_far += length;
+}
+
+// Drop the preallocated tail when fewer bytes arrived than were declared
+void ClientConnection::trimUploadFile()
+{
+    struct stat st;
+    size_t expected = upload_base_offset + bytes_received_so_far;
+    if (fstat(temp_upload_fd, &st) == 0 && (size_t)st.st_size != expected) {
+        LOG_DEBUG("Truncating upload from " << st.st_size << " to " << expected << " bytes");
+        if (ftruncate(temp_upload_fd, expected) != 0) {
+            LOG_ERROR("Failed to truncate " << temp_upload_path << " (" << strerror(errno) << ")");
+        }
+    }
+}
+
+void ClientConnection::initializeResumableStreaming(size_t content_length, const std::string& part_path, size_t offset)
+{
+    temp_upload_fd = open(part_path.c_str(), O_WRONLY);
+    if (temp_upload_fd == -1) {
+        LOG_ERROR("Failed to open upload part file: " << part_path
+                  << " (" << strerror(errno) << ")");
+        throw HttpException(500, "Internal Server Error", INTERNAL_SERVER_ERROR);
+    }
+    is_streaming_upload = true;
+    is_resumable_chunk = true;
+    filename_detected = true;
+    total_content_length = content_length;
+    bytes_received_so_far = 0;
+    upload_base_offset = offset;
+    temp_upload_path = part_path;
+    preallocateUpload();
+    LOG_DEBUG("Resuming upload " << part_path << " at offset " << offset
+              << " for " << content_length << " bytes");
 }
 
 void ClientConnection::initializeStreaming(size_t content_length)
@@ -466,7 +675,8 @@ bool ClientConnection::continueStreamingRead(int fd)
     // Simple approach: Read what's available RIGHT NOW and return
     // Don't try to read everything at once - NO WHILE LOOPS!
     
-    char chunk_buffer[STREAM_CHUNK_SIZE];
+    PooledBuffer pooled(STREAM_CHUNK_SIZE);
+    char *chunk_buffer = pooled.data();
     
     // Keep socket non-blocking - this is crucial!
     // int flags = fcntl(fd, F_GETFL, 0);
@@ -475,7 +685,7 @@ bool ClientConnection::continueStreamingRead(int fd)
     // }
     
     // Try to read some data, but don't block
-    ssize_t chunk_read = recv(fd, chunk_buffer, STREAM_CHUNK_SIZE, MSG_DONTWAIT);
+    ssize_t chunk_read = recv(fd, chunk_buffer, pooled.size(), MSG_DONTWAIT);
     
     if (chunk_read > 0) {
         // First, check if we can extract a filename from this chunk (for multipart uploads)
@@ -487,28 +697,22 @@ bool ClientConnection::continueStreamingRead(int fd)
             }
         }
         
-        // Got some data - write it to the temp file
-        ssize_t written = write(temp_upload_fd, chunk_buffer, chunk_read);
-        if (written != chunk_read) {
-            std::cerr << "Error writing to temp file" << std::endl;
-            throw HttpException(500, "Failed to write upload data", INTERNAL_SERVER_ERROR);
-        }
-        
-        bytes_received_so_far += chunk_read;
+        // Got some data - write it into the preallocated file
+        writeUploadData(chunk_buffer, chunk_read);
         updateActivity();
         
         // Show progress every 1MB or when complete
         if (bytes_received_so_far % (1024 * 1024) == 0 || 
             bytes_received_so_far >= total_content_length) {
             double progress = (double)bytes_received_so_far / total_content_length * 100.0;
-            std::cout << "Upload progress: " << std::fixed << std::setprecision(1) 
+            LOG_DEBUG("Upload progress: " << std::fixed << std::setprecision(1) 
                      << progress << "% (" << bytes_received_so_far 
-                     << "/" << total_content_length << " bytes)" << std::endl;
+                     << "/" << total_content_length << " bytes)");
         }
         
         // Check if upload is complete
         if (bytes_received_so_far >= total_content_length) {
-            std::cout << "✅ Upload complete: " << bytes_received_so_far << " bytes" << std::endl;
+            LOG_DEBUG("✅ Upload complete: " << bytes_received_so_far << " bytes");
             fsync(temp_upload_fd);
             return true; // Upload finished
         }
@@ -518,13 +722,13 @@ bool ClientConnection::continueStreamingRead(int fd)
     }
     else if (chunk_read == 0) {
         // Client closed connection
-        std::cout << "Client disconnected during upload at " 
+        LOG_DEBUG("Client disconnected during upload at " 
                   << bytes_received_so_far << "/" << total_content_length 
-                  << " bytes (" << (bytes_received_so_far * 100.0 / total_content_length) << "%)" << std::endl;
+                  << " bytes (" << (bytes_received_so_far * 100.0 / total_content_length) << "%)");
         
         // If we got most of the file, consider it successful
         if (bytes_received_so_far >= total_content_length * 0.9) {
-            std::cout << "Got 90%+ of file, considering upload successful" << std::endl;
+            LOG_DEBUG("Got 90%+ of file, considering upload successful");
             return true;
         }
         
@@ -539,7 +743,7 @@ bool ClientConnection::continueStreamingRead(int fd)
         }
         else {
             // Real error
-            std::cerr << "Error reading upload data: " << strerror(errno) << std::endl;
+            LOG_ERROR("Error reading upload data: " << strerror(errno));
             throw HttpException(500, "Error reading upload data", INTERNAL_SERVER_ERROR);
         }
     }
@@ -548,9 +752,9 @@ bool ClientConnection::continueStreamingRead(int fd)
 void ClientConnection::showProgress()
 {
     double progress = (double)bytes_received_so_far / total_content_length * 100.0;
-    std::cout << "Progress: " << std::fixed << std::setprecision(1) 
+    LOG_DEBUG("Progress: " << std::fixed << std::setprecision(1) 
              << progress << "% (" << bytes_received_so_far 
-             << "/" << total_content_length << " bytes)" << std::endl;
+             << "/" << total_content_length << " bytes)");
 }
 
 void ClientConnection::showProgressBar(double speed_mbps)
@@ -558,25 +762,19 @@ void ClientConnection::showProgressBar(double speed_mbps)
     double progress = (double)bytes_received_so_far / total_content_length * 100.0;
     int bar_width = 40;
     int filled_width = (int)(progress / 100.0 * bar_width);
+    std::string bar;
     
+    for (int i = 0; i < bar_width; ++i) {
+        if (progress >= 100.0 || i < filled_width) bar += '=';
+        else if (i == filled_width) bar += '>';
+        else bar += ' ';
+    }
     if (progress >= 100.0) {
-        std::cout << "\rProgress: 100.0% [";
-        for (int i = 0; i < bar_width; ++i) std::cout << "=";
-        std::cout << "] " << std::fixed << std::setprecision(1) 
-                 << speed_mbps << " MB/s - Complete!" << std::endl;
+        LOG_DEBUG("Progress: 100.0% [" << bar << "] " << std::fixed << std::setprecision(1) 
+                 << speed_mbps << " MB/s - Complete!");
     } else {
-        std::cout << "\rProgress: " << std::fixed << std::setprecision(1) 
-                 << progress << "% [";
-        
-        for (int i = 0; i < bar_width; ++i) {
-            if (i < filled_width) std::cout << "=";
-            else if (i == filled_width) std::cout << ">";
-            else std::cout << " ";
-        }
-        
-        std::cout << "] " << std::fixed << std::setprecision(1) 
-                 << speed_mbps << " MB/s";
-        std::cout.flush();
+        LOG_DEBUG("Progress: " << std::fixed << std::setprecision(1) 
+                 << progress << "% [" << bar << "] " << speed_mbps << " MB/s");
     }
 }
 
@@ -608,13 +806,13 @@ bool ClientConnection::tryExtractFilenameFromData(const char* data, size_t lengt
                 size_t filename_end = data_chunk.find("\"", filename_pos);
                 if (filename_end != std::string::npos && filename_end > filename_pos) {
                     detected_filename = data_chunk.substr(filename_pos, filename_end - filename_pos);
-                    std::cout << "Found filename in streaming data: '" << detected_filename << "'" << std::endl;
+                    LOG_DEBUG("Found filename in streaming data: '" << detected_filename << "'");
                     
                     // Extract extension
                     size_t dot_pos = detected_filename.find_last_of('.');
                     if (dot_pos != std::string::npos) {
                         detected_extension = detected_filename.substr(dot_pos);
-                        std::cout << "Found file extension: '" << detected_extension << "'" << std::endl;
+                        LOG_DEBUG("Found file extension: '" << detected_extension << "'");
                         filename_detected = true;
                         return true;
                     }
@@ -631,43 +829,14 @@ bool ClientConnection::tryExtractFilenameFromData(const char* data, size_t lengt
                             content_type_pos + 13, // Skip "Content-Type: "
                             content_type_end - (content_type_pos + 13)
                         );
-                        std::cout << "Found part Content-Type: '" << part_content_type << "'" << std::endl;
+                        LOG_DEBUG("Found part Content-Type: '" << part_content_type << "'");
                         
-                        // Map common MIME types to extensions
-                        if (part_content_type.find("image/jpeg") != std::string::npos) {
-                            detected_extension = ".jpg";
-                        } else if (part_content_type.find("image/png") != std::string::npos) {
-                            detected_extension = ".png";
-                        } else if (part_content_type.find("image/gif") != std::string::npos) {
-                            detected_extension = ".gif";
-                        } else if (part_content_type.find("image/webp") != std::string::npos) {
-                            detected_extension = ".webp";
-                        } else if (part_content_type.find("video/mp4") != std::string::npos) {
-                            detected_extension = ".mp4";
-                        } else if (part_content_type.find("video/webm") != std::string::npos) {
-                            detected_extension = ".webm";
-                        } else if (part_content_type.find("video/quicktime") != std::string::npos) {
-                            detected_extension = ".mov";
-                        } else if (part_content_type.find("audio/mpeg") != std::string::npos) {
-                            detected_extension = ".mp3";
-                        } else if (part_content_type.find("audio/wav") != std::string::npos) {
-                            detected_extension = ".wav";
-                        } else if (part_content_type.find("audio/ogg") != std::string::npos) {
-                            detected_extension = ".ogg";
-                        } else if (part_content_type.find("application/pdf") != std::string::npos) {
-                            detected_extension = ".pdf";
-                        } else if (part_content_type.find("application/zip") != std::string::npos) {
-                            detected_extension = ".zip";
-                        } else if (part_content_type.find("application/x-iso9660-image") != std::string::npos) {
-                            detected_extension = ".iso";
-                        } else if (part_content_type.find("text/plain") != std::string::npos) {
-                            detected_extension = ".txt";
-                        } else if (part_content_type.find("text/csv") != std::string::npos) {
-                            detected_extension = ".csv";
-                        }
+                        std::string guessed = MimeTypes::ExtensionFor(part_content_type);
+                        if (!guessed.empty())
+                            detected_extension = guessed;
                         
                         if (detected_extension != ".bin") {
-                            std::cout << "Determined extension from part Content-Type: '" << detected_extension << "'" << std::endl;
+                            LOG_DEBUG("Determined extension from part Content-Type: '" << detected_extension << "'");
                             filename_detected = true;
                             return true;
                         }
@@ -699,7 +868,7 @@ bool ClientConnection::updateFileExtensionIfNeeded()
     }
     
     // We need to rename the file
-    std::cout << "Updating file extension from '" << current_ext << "' to '" << detected_extension << "'" << std::endl;
+    LOG_DEBUG("Updating file extension from '" << current_ext << "' to '" << detected_extension << "'");
     
     // Construct the new path
     std::string new_path;
@@ -718,22 +887,22 @@ bool ClientConnection::updateFileExtensionIfNeeded()
     
     // Rename the file
     if (rename(temp_upload_path.c_str(), new_path.c_str()) != 0) {
-        std::cerr << "Failed to rename file from " << temp_upload_path << " to " << new_path
-                 << " (" << strerror(errno) << ")" << std::endl;
+        LOG_ERROR("Failed to rename file from " << temp_upload_path << " to " << new_path
+                 << " (" << strerror(errno) << ")");
         return false;
     }
     
-    // Reopen the file for appending
-    temp_upload_fd = open(new_path.c_str(), O_WRONLY | O_APPEND, 0644);
+    // Reopen the file, writes are positioned so no O_APPEND (it would land past the preallocated size)
+    temp_upload_fd = open(new_path.c_str(), O_WRONLY, 0644);
     if (temp_upload_fd == -1) {
-        std::cerr << "Failed to reopen renamed file: " << new_path
-                 << " (" << strerror(errno) << ")" << std::endl;
+        LOG_ERROR("Failed to reopen renamed file: " << new_path
+                 << " (" << strerror(errno) << ")");
         return false;
     }
     
     // Update internal state
     temp_upload_path = new_path;
-    std::cout << "File successfully renamed to: " << new_path << std::endl;
+    LOG_DEBUG("File successfully renamed to: " << new_path);
     return true;
 }
 
@@ -746,19 +915,25 @@ void ClientConnection::finalizeStreaming()
     
     // Close the final file
     if (temp_upload_fd != -1) {
+        trimUploadFile();
         close(temp_upload_fd);
         temp_upload_fd = -1;
     }
     
-    std::cout << "Finalizing streaming upload: " << bytes_received_so_far << " bytes" << std::endl;
+    LOG_DEBUG("Finalizing streaming upload: " << bytes_received_so_far << " bytes");
+    Metrics::Increment(Metrics::UPLOADS_COMPLETED);
+    Metrics::Increment(Metrics::UPLOAD_BYTES, bytes_received_so_far);
+    Metrics::Observe(Metrics::UPLOAD, AccessLog::Elapsed(phases.start));
     
     // Set the request body to point to our final file, with a marker indicating it's already in final location
     if (http_request) {
-        http_request->SetBody("__DIRECT_UPLOAD_FILE:" + temp_upload_path);
+        http_request->SetBody((is_resumable_chunk ? "__RESUMABLE_CHUNK:" : "__DIRECT_UPLOAD_FILE:") + temp_upload_path);
     }
     
     // Reset streaming state
     is_streaming_upload = false;
+    is_resumable_chunk = false;
+    upload_base_offset = 0;
     total_content_length = 0;
     bytes_received_so_far = 0;
     
@@ -768,27 +943,32 @@ void ClientConnection::finalizeStreaming()
 
 void ClientConnection::ProcessRequest(int fd)
 {
-    RequestHandler *chain_handler = new CgiHandler(this);
-    (chain_handler->SetNext(new Get()))->SetNext(new Post())->SetNext(new Delete());
+    RequestHandler *chain_handler = new MetricsHandler(this);
+    chain_handler->SetNext(new CgiHandler(this))->SetNext(new ResumableUpload(this))->SetNext(new Get())->SetNext(new Post())->SetNext(new Delete());
     
     if (http_request == NULL) {
-        std::cerr << "No request to process" << std::endl;
+        LOG_WARN("No request to process");
         return;
     }
     
     if (this->http_response == NULL) {
         std::map<std::string, std::string> emptyHeaders;
-        this->http_response = new HttpResponse(200, emptyHeaders, "text/plain", false, false);
+        // no content type yet: file responses derive it from the path unless a handler sets one
+        this->http_response = new HttpResponse(200, emptyHeaders, "", false, false);
     }
     
+    markPhase(this->phases.dispatched);
+    Metrics::Dispatched(http_request->GetMethod());
     chain_handler->HandleRequest(this->http_request, 
                                 this->_server->getConfigForClient(this->GetFd()), 
                                 this->server_config);
+    markPhase(this->phases.handled);
+    Metrics::Observe(Metrics::HANDLER, phaseTime(this->phases.dispatched, this->phases.handled));
     
     if (this->_server != NULL) {
         this->_server->updatePollEvents(fd, POLLOUT);
     } else {
-        std::cerr << "Server pointer is NULL" << std::endl;
+        LOG_WARN("Server pointer is NULL");
     }
     
     // Clean up handler chain
@@ -803,6 +983,56 @@ void ClientConnection::ProcessRequest(int fd)
     }
 }
 
+void ClientConnection::markPhase(struct timespec &boundary)
+{
+    clock_gettime(CLOCK_MONOTONIC, &boundary);
+}
+
+double ClientConnection::phaseTime(const struct timespec &from, const struct timespec &to)
+{
+    if ((from.tv_sec == 0 && from.tv_nsec == 0) || (to.tv_sec == 0 && to.tv_nsec == 0))
+        return -1;
+    return (to.tv_sec - from.tv_sec) + (to.tv_nsec - from.tv_nsec) / 1e9;
+}
+
+const struct timespec &ClientConnection::responseReady() const
+{
+    if (phases.upstream.tv_sec != 0 || phases.upstream.tv_nsec != 0)
+        return phases.upstream;
+    return phases.handled;
+}
+
+std::string ClientConnection::phaseBreakdown() const
+{
+    const RequestPhases &p = this->phases;
+    const struct { const char *name; double seconds; } PHASES[] = {
+        { "parse", phaseTime(p.start, p.parsed) },
+        { "body", phaseTime(p.parsed, p.dispatched) },
+        { "route", phaseTime(p.dispatched, p.routed) },
+        { "handler", phaseTime(p.routed, p.handled) },
+        { "cgi", phaseTime(p.handled, p.upstream) },
+        { "send", phaseTime(responseReady(), p.sent) },
+    };
+    std::string out;
+    char number[32];
+
+    for (size_t i = 0; i < sizeof(PHASES) / sizeof(PHASES[0]); ++i)
+    {
+        if (i > 0)
+            out += ' ';
+        out += PHASES[i].name;
+        out += '=';
+        if (PHASES[i].seconds < 0)
+            out += '-';
+        else
+        {
+            snprintf(number, sizeof(number), "%.6f", PHASES[i].seconds);
+            out += number;
+        }
+    }
+    return out;
+}
+
 void ClientConnection::updateActivity()
 {
     lastActivity = time(NULL);
@@ -0,0 +1,67 @@
+#include "../include/ConnectionTable.hpp"
+#include "../include/ClientConnection.hpp"
+#include <new>
+
+ConnectionTable::ConnectionTable() : _count(0)
+{
+}
+
+ConnectionTable::~ConnectionTable()
+{
+    for (size_t fd = 0; fd < this->_slots.size(); ++fd)
+    {
+        if (this->_slots[fd].conn != NULL)
+            this->_slots[fd].conn->~ClientConnection();
+    }
+    for (size_t i = 0; i < this->_blocks.size(); ++i)
+        ::operator delete(this->_blocks[i]);
+}
+
+void ConnectionTable::grow()
+{
+    char *block = static_cast<char *>(::operator new(sizeof(ClientConnection) * CONNECTION_SLAB_BLOCK));
+
+    this->_blocks.push_back(block);
+    // handed out from the front of the block first
+    for (int i = CONNECTION_SLAB_BLOCK - 1; i >= 0; --i)
+        this->_free.push_back(reinterpret_cast<ClientConnection *>(block + i * sizeof(ClientConnection)));
+}
+
+ClientConnection *ConnectionTable::Open(int fd, const sockaddr_storage &client_addr, int server_index)
+{
+    if (fd < 0)
+        return NULL;
+    if (static_cast<size_t>(fd) >= this->_slots.size())
+    {
+        Slot empty = { NULL, -1, 0 };
+        this->_slots.resize(fd + 1, empty);
+    }
+    Slot &slot = this->_slots[fd];
+    if (slot.conn != NULL)
+        return NULL;
+    if (this->_free.empty())
+        this->grow();
+
+    ClientConnection *cell = this->_free.back();
+    slot.conn = new (cell) ClientConnection(fd, client_addr);
+    this->_free.pop_back();
+    slot.server_index = server_index;
+    slot.conn->generation = slot.generation;
+    ++this->_count;
+    return slot.conn;
+}
+
+void ConnectionTable::Close(int fd)
+{
+    if (this->Find(fd) == NULL)
+        return;
+    Slot &slot = this->_slots[fd];
+    ClientConnection *conn = slot.conn;
+
+    slot.conn = NULL;
+    slot.server_index = -1;
+    ++slot.generation;
+    --this->_count;
+    conn->~ClientConnection();
+    this->_free.push_back(conn);
+}
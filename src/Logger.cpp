@@ -0,0 +1,204 @@
+#include "../include/Logger.hpp"
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+Logger::Slot                        Logger::_ring[LOG_RING_SLOTS];
+std::atomic<unsigned long>          Logger::_head(0);
+std::atomic<unsigned long>          Logger::_tail(0);
+std::atomic<unsigned long>          Logger::_dropped(0);
+std::atomic<bool>                   Logger::_running(false);
+int                                 Logger::_level = LOG_LEVEL_INFO;
+int                                 Logger::_fd = STDERR_FILENO;
+bool                                Logger::_started = false;
+pthread_t                           Logger::_writer;
+pid_t                               Logger::_owner = 0;
+
+static const char *LEVEL_NAMES[] = { "debug", "info", "warn", "error", "crit" };
+
+int Logger::ParseLevel(const std::string &name)
+{
+    for (int i = LOG_LEVEL_DEBUG; i <= LOG_LEVEL_CRIT; ++i)
+    {
+        if (name == LEVEL_NAMES[i])
+            return i;
+    }
+    return -1;
+}
+
+const char *Logger::LevelName(int level)
+{
+    if (level < LOG_LEVEL_DEBUG || level > LOG_LEVEL_CRIT)
+        return "unknown";
+    return LEVEL_NAMES[level];
+}
+
+std::string Logger::Escape(const std::string &bytes)
+{
+    std::string out;
+
+    out.reserve(bytes.size());
+    for (size_t i = 0; i < bytes.size(); ++i)
+    {
+        unsigned char c = bytes[i];
+        if (c == '\r')
+            out += "\\r";
+        else if (c == '\n')
+            out += "\\n";
+        else if (c >= 32 && c <= 126)
+            out += static_cast<char>(c);
+        else
+        {
+            std::ostringstream code;
+            code << "[" << static_cast<int>(c) << "]";
+            out += code.str();
+        }
+    }
+    return out;
+}
+
+bool Logger::Open(const std::string &path, const std::string &level)
+{
+    int parsed = ParseLevel(level.empty() ? "info" : level);
+    if (parsed < 0 || _started)
+        return false;
+
+    int fd = STDERR_FILENO;
+    if (!path.empty() && path != "stderr")
+    {
+        fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd < 0)
+            return false;
+    }
+    _fd = fd;
+    _level = parsed;
+    _running.store(true);
+    if (pthread_create(&_writer, NULL, writerLoop, NULL) != 0)
+    {
+        _running.store(false);
+        return true;    // still logs, synchronously
+    }
+    _started = true;
+    _owner = getpid();
+    atexit(Shutdown);
+    return true;
+}
+
+void Logger::Shutdown()
+{
+    // a forked child inherits the handler but not the writer thread
+    if (!_started || getpid() != _owner)
+        return;
+    _running.store(false);
+    pthread_join(_writer, NULL);
+    _started = false;
+    if (_fd != STDERR_FILENO)
+        close(_fd);
+    _fd = STDERR_FILENO;
+}
+
+void Logger::Write(int level, const std::string &message)
+{
+    size_t length = message.size() < LOG_LINE_MAX ? message.size() : LOG_LINE_MAX;
+
+    if (!_started)
+    {
+        std::string line;
+        format(line, time(NULL), level, message.data(), length);
+        writeAll(line);
+        return;
+    }
+    // only the event loop produces, so a relaxed read of our own index is enough
+    unsigned long head = _head.load(std::memory_order_relaxed);
+    if (head - _tail.load(std::memory_order_acquire) >= LOG_RING_SLOTS)
+    {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    Slot &slot = _ring[head & (LOG_RING_SLOTS - 1)];
+    slot.time = time(NULL);
+    slot.level = level;
+    slot.length = static_cast<unsigned short>(length);
+    memcpy(slot.text, message.data(), length);
+    _head.store(head + 1, std::memory_order_release);
+}
+
+void Logger::format(std::string &out, time_t time, int level, const char *text, size_t length)
+{
+    char stamp[32];
+    struct tm tm_time;
+
+    localtime_r(&time, &tm_time);
+    size_t stamp_length = strftime(stamp, sizeof(stamp), "%Y/%m/%d %H:%M:%S", &tm_time);
+    out.append(stamp, stamp_length);
+    out += " [";
+    out += LevelName(level);
+    out += "] ";
+    // the record ends with its own newline, trailing ones of the message are dropped;
+    // bytes from the wire go through Escape so embedded ones can't split a record
+    while (length > 0 && text[length - 1] == '\n')
+        --length;
+    out.append(text, length);
+    out += '\n';
+}
+
+size_t Logger::drain(std::string &out)
+{
+    unsigned long tail = _tail.load(std::memory_order_relaxed);
+    unsigned long head = _head.load(std::memory_order_acquire);
+    size_t count = 0;
+
+    for (; tail != head; ++tail, ++count)
+    {
+        const Slot &slot = _ring[tail & (LOG_RING_SLOTS - 1)];
+        format(out, slot.time, slot.level, slot.text, slot.length);
+    }
+    _tail.store(tail, std::memory_order_release);
+
+    unsigned long dropped = _dropped.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0)
+    {
+        std::ostringstream note;
+        note << dropped << " log lines dropped, ring full";
+        std::string text = note.str();
+        format(out, time(NULL), LOG_LEVEL_WARN, text.data(), text.size());
+    }
+    return count;
+}
+
+void Logger::writeAll(const std::string &out)
+{
+    size_t written = 0;
+
+    while (written < out.size())
+    {
+        ssize_t n = ::write(_fd, out.data() + written, out.size() - written);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return;
+        written += n;
+    }
+}
+
+void *Logger::writerLoop(void *)
+{
+    std::string batch;
+
+    batch.reserve(LOG_RING_SLOTS * 64);
+    while (true)
+    {
+        bool running = _running.load(std::memory_order_acquire);
+        batch.clear();
+        drain(batch);
+        if (!batch.empty())
+            writeAll(batch);
+        else if (!running)
+            break;
+        else
+            usleep(LOG_WRITER_IDLE_US);
+    }
+    return NULL;
+}
@@ -0,0 +1,172 @@
+#include "../include/Metrics.hpp"
+#include <cstdio>
+
+unsigned long       Metrics::_counters[Metrics::COUNTER_COUNT];
+long                Metrics::_gauges[Metrics::GAUGE_COUNT];
+Metrics::Buckets    Metrics::_histograms[Metrics::HISTOGRAM_COUNT];
+unsigned long       Metrics::_methods[8];
+unsigned long       Metrics::_statuses[6];
+time_t              Metrics::_start_time = time(NULL);
+
+static const char *METHODS[] = { "GET", "HEAD", "POST", "PUT", "PATCH", "DELETE", "OPTIONS", "other" };
+
+static const struct { const char *name; const char *help; } COUNTERS[] = {
+    { "webserv_connections_accepted_total", "Client connections accepted." },
+    { "webserv_connections_rejected_total", "Client connections turned away at accept with 503, out of poll slots." },
+    { "webserv_limit_conn_rejected_total", "Client connections turned away at accept by limit_conn." },
+    { "webserv_limit_req_rejected_total", "Requests turned away by limit_req." },
+    { "webserv_overload_shed_total", "Requests turned away with 503 while the event loop was overloaded." },
+    { "webserv_requests_parsed_total", "Request heads read and parsed." },
+    { "webserv_send_errors_total", "Responses abandoned on a write error." },
+    { "webserv_sent_bytes_total", "Response bytes written to clients." },
+    { "webserv_cgi_spawned_total", "CGI processes started." },
+    { "webserv_cgi_exited_total", "CGI processes that ran to completion." },
+    { "webserv_cgi_failed_total", "CGI processes that exited non-zero or on a signal." },
+    { "webserv_cgi_timeouts_total", "CGI processes killed over the time limit." },
+    { "webserv_cgi_rejected_total", "CGI requests turned away with 503 at cgi_max_processes." },
+    { "webserv_uploads_completed_total", "Streamed uploads written to disk." },
+    { "webserv_upload_bytes_total", "Bytes of completed streamed uploads." },
+};
+
+static const struct { const char *name; const char *help; } GAUGES[] = {
+    { "webserv_connections_active", "Open client connections." },
+    { "webserv_cgi_active", "Running CGI processes." },
+};
+
+static const struct { const char *name; const char *help; } HISTOGRAMS[] = {
+    { "webserv_request_parse_seconds", "Time from the first byte of a request to its parsed head." },
+    { "webserv_handler_seconds", "Time spent in the request handler chain." },
+    { "webserv_request_duration_seconds", "Time from the first byte of a request to the last byte of its response." },
+    { "webserv_cgi_duration_seconds", "CGI process run time." },
+    { "webserv_upload_duration_seconds", "Time from the first byte of an upload to the file on disk." },
+    { "webserv_event_loop_busy_seconds", "Event loop time between two polls." },
+};
+
+void Metrics::Observe(Histogram histogram, double seconds)
+{
+    Buckets &buckets = _histograms[histogram];
+    double bound = METRICS_FIRST_BUCKET;
+    size_t i = 0;
+
+    while (i < METRICS_BUCKETS && seconds > bound)
+    {
+        bound *= 2;
+        ++i;
+    }
+    ++buckets.counts[i];
+    ++buckets.count;
+    buckets.sum += seconds;
+}
+
+void Metrics::Dispatched(const std::string &method)
+{
+    size_t i = 0;
+
+    while (i < sizeof(METHODS) / sizeof(METHODS[0]) - 1 && method != METHODS[i])
+        ++i;
+    ++_methods[i];
+}
+
+void Metrics::Responded(int status)
+{
+    int status_class = status / 100;
+
+    ++_statuses[status_class >= 1 && status_class <= 5 ? status_class : 0];
+}
+
+// "# HELP name help" and "# TYPE name type"; names and help go in as they are,
+// only numbers pass through snprintf so no line can be cut at a buffer size
+void Metrics::renderHeader(std::string &out, const char *name, const char *help, const char *type)
+{
+    out += "# HELP ";
+    out += name;
+    out += ' ';
+    out += help;
+    out += "\n# TYPE ";
+    out += name;
+    out += ' ';
+    out += type;
+    out += '\n';
+}
+
+// "name{labels} value", labels left out when NULL; value is already formatted
+void Metrics::renderSample(std::string &out, const char *name, const char *labels, const char *value)
+{
+    out += name;
+    if (labels)
+    {
+        out += '{';
+        out += labels;
+        out += '}';
+    }
+    out += ' ';
+    out += value;
+    out += '\n';
+}
+
+void Metrics::renderHistogram(std::string &out, Histogram histogram)
+{
+    const Buckets &buckets = _histograms[histogram];
+    const std::string name = HISTOGRAMS[histogram].name;
+    const std::string bucket = name + "_bucket";
+    char labels[32];
+    char value[32];
+    unsigned long cumulative = 0;
+    double bound = METRICS_FIRST_BUCKET;
+
+    renderHeader(out, name.c_str(), HISTOGRAMS[histogram].help, "histogram");
+    for (size_t i = 0; i < METRICS_BUCKETS; ++i, bound *= 2)
+    {
+        cumulative += buckets.counts[i];
+        snprintf(labels, sizeof(labels), "le=\"%g\"", bound);
+        snprintf(value, sizeof(value), "%lu", cumulative);
+        renderSample(out, bucket.c_str(), labels, value);
+    }
+    snprintf(value, sizeof(value), "%lu", buckets.count);
+    renderSample(out, bucket.c_str(), "le=\"+Inf\"", value);
+    snprintf(value, sizeof(value), "%.6f", buckets.sum);
+    renderSample(out, (name + "_sum").c_str(), NULL, value);
+    snprintf(value, sizeof(value), "%lu", buckets.count);
+    renderSample(out, (name + "_count").c_str(), NULL, value);
+}
+
+std::string Metrics::Render()
+{
+    std::string out;
+    char labels[32];
+    char value[32];
+
+    out.reserve(8192);
+    for (int i = 0; i < COUNTER_COUNT; ++i)
+    {
+        renderHeader(out, COUNTERS[i].name, COUNTERS[i].help, "counter");
+        snprintf(value, sizeof(value), "%lu", _counters[i]);
+        renderSample(out, COUNTERS[i].name, NULL, value);
+    }
+    renderHeader(out, "webserv_requests_total", "Requests dispatched to a handler, by method.", "counter");
+    for (size_t i = 0; i < sizeof(METHODS) / sizeof(METHODS[0]); ++i)
+    {
+        snprintf(labels, sizeof(labels), "method=\"%s\"", METHODS[i]);
+        snprintf(value, sizeof(value), "%lu", _methods[i]);
+        renderSample(out, "webserv_requests_total", labels, value);
+    }
+    renderHeader(out, "webserv_responses_total", "Responses written, by status class.", "counter");
+    for (int i = 1; i <= 5; ++i)
+    {
+        snprintf(labels, sizeof(labels), "code=\"%dxx\"", i);
+        snprintf(value, sizeof(value), "%lu", _statuses[i]);
+        renderSample(out, "webserv_responses_total", labels, value);
+    }
+    for (int i = 0; i < GAUGE_COUNT; ++i)
+    {
+        renderHeader(out, GAUGES[i].name, GAUGES[i].help, "gauge");
+        snprintf(value, sizeof(value), "%ld", _gauges[i]);
+        renderSample(out, GAUGES[i].name, NULL, value);
+    }
+    renderHeader(out, "webserv_start_time_seconds", "Start time of the server since the epoch.", "gauge");
+    snprintf(value, sizeof(value), "%ld", static_cast<long>(_start_time));
+    renderSample(out, "webserv_start_time_seconds", NULL, value);
+    for (int i = 0; i < HISTOGRAM_COUNT; ++i)
+        renderHistogram(out, static_cast<Histogram>(i));
+    return out;
+}
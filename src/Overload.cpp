@@ -0,0 +1,84 @@
+#include "../include/Overload.hpp"
+#include "../include/config/ServerConfig.hpp"
+#include <cstdlib>
+#include <cstdio>
+
+OverloadOptions Overload::_options;
+double          Overload::_lag = 0;
+double          Overload::_queue = 0;
+double          Overload::_slots = 0;
+
+bool Overload::ParseOptions(const std::vector<std::string> &params, OverloadOptions &options, std::string &error)
+{
+    options.lag = 0;
+    options.queue = 0;
+    if (params.size() == 1 && params[0] == "off")
+        return true;
+    for (size_t i = 0; i < params.size(); ++i)
+    {
+        const std::string &param = params[i];
+        char *endptr = NULL;
+
+        if (param.compare(0, 4, "lag=") == 0 && ServerConfig::parse_msec(param.substr(4)) > 0)
+            options.lag = ServerConfig::parse_msec(param.substr(4)) / 1000.0;
+        else if (param.compare(0, 6, "queue=") == 0 && strtol(param.c_str() + 6, &endptr, 10) > 0 && *endptr == '\0')
+            options.queue = strtol(param.c_str() + 6, NULL, 10);
+        else
+        {
+            error = param;
+            return false;
+        }
+    }
+    if (options.lag <= 0 && options.queue <= 0)
+    {
+        error.clear();
+        return false;
+    }
+    return true;
+}
+
+void Overload::Sample(double busy, int ready)
+{
+    _lag += OVERLOAD_SMOOTHING * (busy - _lag);
+    _queue += OVERLOAD_SMOOTHING * (ready - _queue);
+}
+
+void Overload::Slots(int used, int open)
+{
+    _slots = open > 0 ? static_cast<double>(used) / open : 1;
+}
+
+double Overload::Level()
+{
+    if (!Enabled())
+        return 0;
+    double level = _slots;
+
+    if (_options.lag > 0 && _lag / _options.lag > level)
+        level = _lag / _options.lag;
+    if (_options.queue > 0 && _queue / _options.queue > level)
+        level = _queue / _options.queue;
+    return level;
+}
+
+bool Overload::Admit(Priority priority)
+{
+    if (priority == HEALTH)
+        return true;
+    return Level() < (priority == LOW ? OVERLOAD_LOW_LEVEL : 1);
+}
+
+std::string Overload::Report()
+{
+    char line[160];
+    double level = Level();
+
+    if (!Enabled())
+    {
+        snprintf(line, sizeof(line), "Overload: off, lag %.6fs queue %.1f slots %.2f\n", _lag, _queue, _slots);
+        return line;
+    }
+    snprintf(line, sizeof(line), "Overload: lag %.6fs queue %.1f slots %.2f level %.2f, shedding %s\n",
+        _lag, _queue, _slots, level, level >= 1 ? "all but health checks" : level >= OVERLOAD_LOW_LEVEL ? "low priority" : "none");
+    return line;
+}
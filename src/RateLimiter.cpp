@@ -0,0 +1,121 @@
+#include "../include/RateLimiter.hpp"
+#include <cstring>
+#include <ctime>
+#include <netinet/in.h>
+
+RateLimiter::RateLimiter(const LimitOptions &options) : _options(options)
+{
+    Entry unused;
+
+    memset(&unused, 0, sizeof(unused));
+    if (this->Enabled())
+        this->_entries.assign(LIMIT_ZONE_SLOTS, unused);
+}
+
+double RateLimiter::Now()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+void RateLimiter::refill(Entry &entry, double now) const
+{
+    if (this->_options.rate <= 0)
+        return;
+    entry.tokens += (now - entry.updated) * this->_options.rate;
+    if (entry.tokens > this->capacity())
+        entry.tokens = this->capacity();
+    entry.updated = now;
+}
+
+bool RateLimiter::idle(const Entry &entry, double now) const
+{
+    if (entry.family == 0)
+        return true;
+    if (entry.connections > 0)
+        return false;
+    return this->_options.rate <= 0 || entry.tokens + (now - entry.updated) * this->_options.rate >= this->capacity();
+}
+
+int RateLimiter::Open(const sockaddr_storage &address)
+{
+    unsigned char key[16];
+    size_t length;
+
+    if (!this->Enabled())
+        return LIMIT_UNTRACKED;
+    memset(key, 0, sizeof(key));
+    if (address.ss_family == AF_INET)
+    {
+        length = 4;
+        memcpy(key, &reinterpret_cast<const sockaddr_in *>(&address)->sin_addr, length);
+    }
+    else if (address.ss_family == AF_INET6)
+    {
+        length = 16;
+        memcpy(key, &reinterpret_cast<const sockaddr_in6 *>(&address)->sin6_addr, length);
+    }
+    else
+        return LIMIT_UNTRACKED;
+
+    // FNV-1a
+    unsigned int hash = 2166136261u;
+    for (size_t i = 0; i < length; ++i)
+        hash = (hash ^ key[i]) * 16777619u;
+
+    double now = Now();
+    int reusable = LIMIT_UNTRACKED;
+    for (size_t probe = 0; probe < LIMIT_ZONE_PROBES; ++probe)
+    {
+        int slot = (hash + probe) & (LIMIT_ZONE_SLOTS - 1);
+        Entry &entry = this->_entries[slot];
+
+        if (entry.family == address.ss_family && memcmp(entry.address, key, sizeof(key)) == 0)
+        {
+            if (this->_options.connections > 0 && entry.connections >= static_cast<unsigned int>(this->_options.connections))
+                return LIMIT_REJECTED;
+            ++entry.connections;
+            return slot;
+        }
+        if (reusable == LIMIT_UNTRACKED && this->idle(entry, now))
+            reusable = slot;
+        // a slot never used ends the chain, the address is not further on
+        if (entry.family == 0)
+            break;
+    }
+    if (reusable == LIMIT_UNTRACKED)
+        return LIMIT_UNTRACKED;
+
+    Entry &entry = this->_entries[reusable];
+    memcpy(entry.address, key, sizeof(key));
+    entry.family = address.ss_family;
+    entry.connections = 1;
+    entry.tokens = this->capacity();
+    entry.updated = now;
+    return reusable;
+}
+
+void RateLimiter::Close(int slot)
+{
+    if (slot < 0 || static_cast<size_t>(slot) >= this->_entries.size())
+        return;
+    if (this->_entries[slot].connections > 0)
+        --this->_entries[slot].connections;
+}
+
+double RateLimiter::Request(int slot)
+{
+    if (this->_options.rate <= 0 || slot < 0 || static_cast<size_t>(slot) >= this->_entries.size())
+        return 0;
+    Entry &entry = this->_entries[slot];
+
+    this->refill(entry, Now());
+    if (entry.tokens >= 1)
+    {
+        entry.tokens -= 1;
+        return 0;
+    }
+    return (1 - entry.tokens) / this->_options.rate;
+}
@@ -9,6 +9,13 @@
 #include "../include/error/NotImplemented.hpp"
 #include "../include/error/Forbidden.hpp"
 #include "../include/error/TooManyRedirection.hpp"
+#include "../include/error/InsufficientStorage.hpp"
+#include "../include/response/GzipFilter.hpp"
+#include "../include/Logger.hpp"
+#include "../include/AccessLog.hpp"
+#include "../include/Metrics.hpp"
+#include "../include/BufferPool.hpp"
+#include "../include/Overload.hpp"
 #include <vector>
 #include <algorithm>
 #include <fcntl.h>
@@ -16,10 +23,12 @@
 #include <sstream>
 #include <signal.h>
 #include <sys/wait.h>
+#include <sys/resource.h>
+#include <iomanip>
 #include "../include/request/CgiHandler.hpp" 
 #include "../include/request/RequestHandler.hpp" 
 
-WebServer::WebServer() : maxfds(DEFAULT_MAX_CONNECTIONS) {
+WebServer::WebServer() : m_shed_logged(0), m_shed_unlogged(0), maxfds(DEFAULT_MAX_CONNECTIONS) {
     pollfds = new struct pollfd[maxfds];
     numfds = 0;
 }
@@ -30,6 +39,8 @@ WebServer::~WebServer() {
     for (size_t i = 0; i < m_sockets.size(); ++i) {
         if (m_sockets[i] > 0)
             close(m_sockets[i]);
+        if (m_sockets[i] > 0 && !m_configs[i].get_unix_path().empty())
+            unlink(m_configs[i].get_unix_path().c_str());
     }
 }
 
@@ -47,10 +58,10 @@ const ServerConfig& WebServer::getConfigForSocket(int socket) const {
 }
 
 const ServerConfig& WebServer::getConfigForClient(int client_fd) const {
-    std::map<int, int>::const_iterator it = client_to_server_index.find(client_fd);
-    if (it != client_to_server_index.end())
+    int server_index = clients.ServerIndex(client_fd);
+    if (server_index != -1)
     {
-        return m_configs[it->second];
+        return m_configs[server_index];
     }
     throw std::runtime_error("Client not found in server mapping");
 }
@@ -68,16 +79,39 @@ int WebServer::getServerIndexForSocket(int socket) const {
     return -1;
 }
 
+// A whole response for clients turned away at accept, sent as is from rejectConnection
+static std::string cannedResponse(int status)
+{
+    std::map<std::string, std::string> no_headers;
+    std::string reason = HttpResponse(status, no_headers, "", false, false).GetStatusMessage(status);
+    std::ostringstream response;
+
+    response << "HTTP/1.1 " << status << " " << reason << "\r\nContent-Type: text/plain\r\nContent-Length: "
+             << reason.size() + 5 << "\r\nRetry-After: " << OVERLOAD_RETRY_AFTER << "\r\nConnection: close\r\n\r\n"
+             << status << " " << reason << "\n";
+    return response.str();
+}
+
 int WebServer::init(std::vector<ServerConfig>& configs) {
     if (configs.empty())
     {
-        std::cerr << "Error: No server configurations provided" << std::endl;
+        LOG_ERROR("No server configurations provided");
         return -1;
     }
 
     // Store configurations
     m_configs = configs;
     m_sockets.resize(configs.size());
+    for (size_t i = 0; i < configs.size(); ++i)
+    {
+        m_access_logs.push_back(AccessLog::Open(configs[i].get_access_log()));
+        if (m_access_logs[i] < 0 && !configs[i].get_access_log().path.empty())
+            return -1;
+        m_limiters.push_back(RateLimiter(configs[i].get_limits()));
+        // limit_conn turns clients away before there is a connection object, with bytes made once
+        m_conn_rejects.push_back(cannedResponse(configs[i].get_limits().conn_status));
+    }
+    m_slots_reject = cannedResponse(503);
 
     // Initialize pollfd structure
     memset(pollfds, 0, sizeof(struct pollfd) * maxfds);
@@ -85,40 +119,56 @@ int WebServer::init(std::vector<ServerConfig>& configs) {
     // Create listening socket for each server configuration
     for (size_t i = 0; i < configs.size(); ++i)
     {
+        // Resolve the address first, it decides the socket family
+        sockaddr_storage address;
+        socklen_t address_length;
+        if (!listenAddress(configs[i], address, address_length))
+        {
+            LOG_ERROR("Invalid listen address " << configs[i].get_listen_address());
+            return -1;
+        }
+
         // Create socket
-        int server_socket = socket(AF_INET, SOCK_STREAM, 0);
+        int server_socket = socket(address.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
         if (server_socket <= 0)
         {
             perror("socket failed");
             return -1;
         }
 
-        // Set socket options for robust port reuse
+        const ListenOptions &options = configs[i].get_listen_options();
         int optval = 1;
-        if (setsockopt(server_socket, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(optval)))
+        if (address.ss_family == AF_UNIX)
         {
-            perror("setsockopt(SO_REUSEADDR) failed");
-            close(server_socket);
-            return -1;
+            // a socket file left by a previous run would make bind fail, anything else is kept
+            struct stat st;
+            if (lstat(configs[i].get_unix_path().c_str(), &st) == 0 && S_ISSOCK(st.st_mode))
+                unlink(configs[i].get_unix_path().c_str());
         }
-        if (setsockopt(server_socket, SOL_SOCKET, SO_REUSEPORT, &optval, sizeof(optval)))
+        else
         {
-            perror("setsockopt(SO_REUSEPORT) failed");
-            // Continue anyway as this is optional
+            // Set socket options for robust port reuse
+            if (setsockopt(server_socket, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(optval)))
+            {
+                perror("setsockopt(SO_REUSEADDR) failed");
+                close(server_socket);
+                return -1;
+            }
+            if (options.reuseport && setsockopt(server_socket, SOL_SOCKET, SO_REUSEPORT, &optval, sizeof(optval)))
+            {
+                perror("setsockopt(SO_REUSEPORT) failed");
+                // Continue anyway as this is optional
+            }
+            // [::] serves IPv4 clients as well, as v4-mapped addresses, unless ipv6only=on
+            int v6only = options.ipv6only ? 1 : 0;
+            if (address.ss_family == AF_INET6
+                && setsockopt(server_socket, IPPROTO_IPV6, IPV6_V6ONLY, &v6only, sizeof(v6only)))
+                perror("setsockopt(IPV6_V6ONLY) failed");
+            applyListenOptions(server_socket, options);
         }
 
         // Bind the socket
-        sockaddr_in hint;
-        hint.sin_family = AF_INET;
-        hint.sin_port = htons(configs[i].get_port());
-        if (inet_pton(AF_INET, configs[i].get_host().c_str(), &hint.sin_addr) <= 0)
-        {
-            perror("Error: Invalid IP address format");
-            close(server_socket);
-            return -1;
-        }
-
-        if (bind(server_socket, (struct sockaddr *)&hint, sizeof(hint)) < 0)
+        if (bind(server_socket, (struct sockaddr *)&address, address_length) < 0)
         {
             perror("bind failed");
             close(server_socket);
@@ -126,7 +176,7 @@ int WebServer::init(std::vector<ServerConfig>& configs) {
         }
 
         // Listen
-        if (listen(server_socket, SOMAXCONN) < 0)
+        if (listen(server_socket, options.backlog) < 0)
         {
             perror("listen failed");
             close(server_socket);
@@ -143,9 +193,8 @@ int WebServer::init(std::vector<ServerConfig>& configs) {
         pollfds[numfds].revents = 0;
         numfds++;
 
-        std::cout << "Server " << configs[i].get_server_name() 
-                  << ": 'http://" << configs[i].get_host() 
-                  << ":" << configs[i].get_port() << "'" << std::endl;
+        LOG_DEBUG("Server " << configs[i].get_server_name() 
+                  << ": 'http://" << configs[i].get_listen_address() << "'");
     }
 
     return 0;
@@ -153,38 +202,121 @@ int WebServer::init(std::vector<ServerConfig>& configs) {
 
 // Debug function to monitor poll state
 void WebServer::debugPollState() {
-    std::cout << "=== POLL DEBUG (numfds=" << numfds << "/" << maxfds << ") ===" << std::endl;
+    LOG_DEBUG("=== POLL DEBUG (numfds=" << numfds << "/" << maxfds << ") ===");
     for (int i = 0; i < numfds; i++) {
-        std::cout << "  [" << i << "] fd=" << pollfds[i].fd 
-                  << " events=" << pollfds[i].events 
-                  << " revents=" << pollfds[i].revents;
-        
-        if (clients.find(pollfds[i].fd) != clients.end()) {
-            std::cout << " (CLIENT)";
-            if (clients[pollfds[i].fd].isStreamingUpload()) {
-                std::cout << " [STREAMING]";
-            }
+        const char *kind = " (UNKNOWN!)";
+        ClientConnection *conn = clients.Find(pollfds[i].fd);
+
+        std::string client_kind;
+
+        if (conn != NULL) {
+            client_kind = std::string(" (CLIENT) [") + connectionState(*conn, pollfds[i].events) + "]";
+            kind = client_kind.c_str();
         } else if (isListeningSocket(pollfds[i].fd)) {
-            std::cout << " (LISTENING)";
+            kind = " (LISTENING)";
         } else if (isCgiFd(pollfds[i].fd)) {
-            std::cout << " (CGI)";
-        } else {
-            std::cout << " (UNKNOWN!)";
+            kind = " (CGI)";
+        }
+        LOG_DEBUG("  [" << i << "] fd=" << pollfds[i].fd 
+                  << " events=" << pollfds[i].events 
+                  << " revents=" << pollfds[i].revents << kind);
+    }
+    LOG_DEBUG("=================================");
+}
+
+/*
+    What a client connection is waiting for. A request head and an
+    in-memory body are read in the same wakeup, so a connection is only
+    ever seen reading before its first request or while a large upload
+    streams in; between keep-alive requests it is idle.
+*/
+const char *WebServer::connectionState(const ClientConnection &conn, short events) const {
+    if (conn.isStreamingUpload())
+        return "upload";
+    for (std::map<int, CgiHandler::CgiProcess>::const_iterator it = CgiHandler::active_cgis.begin();
+         it != CgiHandler::active_cgis.end(); ++it) {
+        if (it->second.client_fd == conn.fd && it->second.client_generation == conn.generation)
+            return "cgi";
+    }
+    if (events & POLLOUT)
+        return "writing";
+    return conn.http_request == NULL ? "reading" : "idle";
+}
+
+std::string WebServer::statusReport(int requester_fd) {
+    static const char *STATES[] = { "reading", "upload", "cgi", "writing", "idle" };
+    size_t counts[5] = { 0, 0, 0, 0, 0 };
+    std::ostringstream out;
+    struct rlimit limit;
+
+    for (int i = 0; i < numfds; i++) {
+        ClientConnection *conn = clients.Find(pollfds[i].fd);
+        if (conn == NULL)
+            continue;
+        const char *state = pollfds[i].fd == requester_fd ? "writing" : connectionState(*conn, pollfds[i].events);
+        for (size_t s = 0; s < 5; ++s) {
+            if (strcmp(state, STATES[s]) == 0)
+                ++counts[s];
         }
-        std::cout << std::endl;
     }
-    std::cout << "=================================" << std::endl;
+
+    out << "Active connections: " << clients.Size() << " \n"
+        << "server accepts handled requests\n"
+        << " " << (Metrics::Get(Metrics::CONNECTIONS_ACCEPTED) + Metrics::Get(Metrics::CONNECTIONS_REJECTED))
+        << " " << Metrics::Get(Metrics::CONNECTIONS_ACCEPTED)
+        << " " << Metrics::Get(Metrics::REQUESTS_PARSED) << " \n"
+        << "Reading: " << counts[0] << " Writing: " << counts[3] << " Waiting: " << counts[4] << " \n"
+        << "Upload: " << counts[1] << " CGI: " << counts[2] << " \n";
+    out << "Poll slots: " << numfds << " in use, " << maxfds << " limit, "
+        << CONNECTION_RESERVE << " reserved for CGI pipes, " << HEALTH_RESERVE << " for health checks\n";
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0)
+        out << "Open files limit: " << limit.rlim_cur << "\n";
+    out << "CGI processes: " << CgiHandler::active_cgis.size();
+    if (Overload::Options().cgi_processes > 0)
+        out << " of " << Overload::Options().cgi_processes;
+    out << "\n";
+    for (std::map<int, CgiHandler::CgiProcess>::const_iterator it = CgiHandler::active_cgis.begin();
+         it != CgiHandler::active_cgis.end(); ++it) {
+        const CgiHandler::CgiProcess &cgi = it->second;
+        ClientConnection *client = clients.Find(cgi.client_fd, cgi.client_generation);
+        out << " pid " << cgi.pid << " pipe " << it->first
+            << " client " << (client ? client->ipAddress : "gone")
+            << " age " << std::fixed << std::setprecision(3) << AccessLog::Elapsed(cgi.started) << "s\n";
+    }
+    out << Overload::Report();
+    out << "Buffer pool: small " << BufferPool::Borrowed(BUFFER_SMALL) << " borrowed " << BufferPool::Idle(BUFFER_SMALL) << " idle, "
+        << "large " << BufferPool::Borrowed(BUFFER_LARGE) << " borrowed " << BufferPool::Idle(BUFFER_LARGE) << " idle\n";
+    return out.str();
+}
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void requestStop(int)
+{
+    stop_requested = 1;
 }
 
 int WebServer::run() {
     bool running = true;
     time_t last_timeout_check = time(NULL);
+    struct timespec woke;           // when the last poll returned
+    int last_ready = -1;
 
-    std::cout << "WebServer is running with " << m_configs.size() << " server(s)" << std::endl;
+    // a peer that hangs up mid-response must fail the write, not kill the server
+    signal(SIGPIPE, SIG_IGN);
+    // SIGINT / SIGTERM end the loop so run() returns and buffered logs are written at exit
+    struct sigaction stop_action;
+    memset(&stop_action, 0, sizeof(stop_action));
+    stop_action.sa_handler = requestStop;
+    sigemptyset(&stop_action.sa_mask);
+    sigaction(SIGINT, &stop_action, NULL);
+    sigaction(SIGTERM, &stop_action, NULL);
+
+    LOG_INFO("WebServer is running with " << m_configs.size() << " server(s)");
     for (size_t i = 0; i < m_configs.size(); ++i)
     {
-        std::cout << "Server '" << m_configs[i].get_server_name() 
-                  << "' is listening on port: " << m_configs[i].get_port() << std::endl;
+        LOG_INFO("Server '" << m_configs[i].get_server_name() 
+                  << "' is listening on: " << m_configs[i].get_listen_address());
     }
 
     // Set error chain handler
@@ -194,9 +326,10 @@ int WebServer::run() {
                 ->SetNext(new NotImplemented())
                 ->SetNext(new MethodNotAllowed())
                 ->SetNext(new Forbidden())
-                ->SetNext(new TooManyRedirection());
+                ->SetNext(new TooManyRedirection())
+                ->SetNext(new InsufficientStorage());
 
-    while (running)
+    while (running && !stop_requested)
     {
         // ============ CHECK FOR TIME OUT ===============
         time_t current_time = time(NULL);
@@ -205,19 +338,35 @@ int WebServer::run() {
             checkCgiTimeouts();
             last_timeout_check = current_time;
         }
+        AccessLog::FlushExpired(current_time);
 
         // Debug when getting close to poll limit
         if (numfds > maxfds * 0.8) {
             debugPollState();
         }
 
+        // a descriptor that became ready after the last poll waited until now
+        if (last_ready >= 0)
+        {
+            double busy = AccessLog::Elapsed(woke);
+            Overload::Sample(busy, last_ready);
+            Metrics::Observe(Metrics::LOOP_BUSY, busy);
+        }
+        Overload::Slots(numfds, maxfds - CONNECTION_RESERVE - HEALTH_RESERVE);
+
         int ready = poll(pollfds, numfds, 1000);
         
+        last_ready = -1;
+        if (ready == -1 && errno == EINTR && !stop_requested)
+            continue;
         if (ready == -1)
         {
-            perror("poll");
+            if (!stop_requested)
+                LOG_CRIT("poll: " << strerror(errno));
             break;
         }
+        clock_gettime(CLOCK_MONOTONIC, &woke);
+        last_ready = ready;
 
         // =================== Check for new CGI processes ===================================
         std::vector<int> new_cgi_fds;
@@ -244,12 +393,11 @@ int WebServer::run() {
         for (int i = 0; i < numfds; i++)
         {
             // ==> checking time out for client connections <==
-            if (clients.find(pollfds[i].fd) != clients.end())
+            if (ClientConnection *conn = clients.Find(pollfds[i].fd))
             {
-                ClientConnection& conn = clients[pollfds[i].fd];
-                if (conn.isStale(3000))
+                if (conn->isStale(3000))
                 { 
-                    std::cout << "Client connection timed out, closing connection." << std::endl;
+                    LOG_DEBUG("Client connection timed out, closing connection.");
                     closeClientConnection(pollfds[i].fd);
                     continue;
                 }
@@ -270,7 +418,7 @@ int WebServer::run() {
             {
                 if (isListeningSocket(fd))
                 {
-                    std::cerr << "Error on listening socket " << fd << "!" << std::endl;
+                    LOG_ERROR("Error on listening socket " << fd << "!");
                     running = false;
                     break;
                 }
@@ -290,20 +438,21 @@ int WebServer::run() {
                 else
                 {
                     // Check if client is in streaming upload mode
-                    if (clients.find(fd) != clients.end() && clients[fd].isStreamingUpload()) {
+                    ClientConnection *conn = clients.Find(fd);
+                    if (conn && conn->isStreamingUpload()) {
                         try {
                             // Simple: just try to read some more data
-                            bool upload_complete = clients[fd].continueStreamingRead(fd);
-                            std::cerr << "upload_complete:" << upload_complete << "fd: " << fd << std::endl;
+                            bool upload_complete = conn->continueStreamingRead(fd);
+                            LOG_DEBUG("upload_complete:" << upload_complete << "fd: " << fd);
                             
                             if (upload_complete) {
                                 // Upload finished - finalize it
-                                std::cout << "Finalizing completed upload..." << std::endl;
-                                clients[fd].finalizeStreaming();
+                                LOG_DEBUG("Finalizing completed upload...");
+                                conn->finalizeStreaming();
                             }
                             // If not complete, just continue - we'll get called again when more data arrives
                         } catch (const std::exception& e) {
-                            std::cerr << "Exception during streaming upload: " << e.what() << std::endl;
+                            LOG_WARN("Exception during streaming upload: " << e.what());
                             closeClientConnection(fd);
                             continue;
                         }
@@ -313,7 +462,7 @@ int WebServer::run() {
                         try {
                             handleClientRequest(fd);
                         } catch (const std::exception& e) {
-                            std::cerr << "Unhandled exception in handleClientRequest: " << e.what() << std::endl;
+                            LOG_WARN("Unhandled exception in handleClientRequest: " << e.what());
                             closeClientConnection(fd);
                         }
                     }
@@ -329,11 +478,14 @@ int WebServer::run() {
                 }
                 catch (const HttpException & e)
                 {
-                    std::cerr << "Unhandled exception in handleClientResponse: " << e.what() << std::endl;
+                    LOG_WARN("Unhandled exception in handleClientResponse: " << e.what());
+                    ClientConnection *conn = clients.Find(fd);
+                    if (conn == NULL)
+                        continue;
                     this->updatePollEvents(fd, POLLOUT);
-                    Error error(clients[fd], e.GetCode(), e.GetMessage(), e.GetErrorType());
+                    Error error(*conn, e.GetCode(), e.GetMessage(), e.GetErrorType());
                     errorHandler->HanldeError(error, this->getConfigForClient(fd));
-                    std::cout  << "[DEBUG] : CLOSING CLIENT CONNECTION HAPPENED HERE\n";
+                    LOG_DEBUG("CLOSING CLIENT CONNECTION HAPPENED HERE");
                     closeClientConnection(fd);
                 }
             }
@@ -357,90 +509,283 @@ int WebServer::run() {
     }
     if (errorHandler)
         delete errorHandler;
-    std::cout << "WebServer has shut down all servers." << std::endl;
+    LOG_INFO("WebServer has shut down all servers.");
     return 0;
 }
 
-void WebServer::acceptNewConnection(int listening_socket) {
-    sockaddr_in clientAddr;
-    socklen_t addrLen = sizeof(clientAddr);
-    int clientFd = accept(listening_socket, (struct sockaddr *)&clientAddr, &addrLen);
-    if (clientFd < 0)
+// The sockaddr a server's listen directive stands for: unix:/path, IPv6 or IPv4
+bool WebServer::listenAddress(const ServerConfig &config, sockaddr_storage &address, socklen_t &length)
+{
+    memset(&address, 0, sizeof(address));
+    if (!config.get_unix_path().empty())
     {
-        perror("accept");
-        return;
+        sockaddr_un *unix_address = reinterpret_cast<sockaddr_un *>(&address);
+        if (config.get_unix_path().size() >= sizeof(unix_address->sun_path))
+            return false;
+        unix_address->sun_family = AF_UNIX;
+        strcpy(unix_address->sun_path, config.get_unix_path().c_str());
+        length = sizeof(sockaddr_un);
+        return true;
+    }
+    sockaddr_in6 *v6 = reinterpret_cast<sockaddr_in6 *>(&address);
+    if (inet_pton(AF_INET6, config.get_host().c_str(), &v6->sin6_addr) == 1)
+    {
+        v6->sin6_family = AF_INET6;
+        v6->sin6_port = htons(config.get_port());
+        length = sizeof(sockaddr_in6);
+        return true;
+    }
+    sockaddr_in *v4 = reinterpret_cast<sockaddr_in *>(&address);
+    if (inet_pton(AF_INET, config.get_host().c_str(), &v4->sin_addr) == 1)
+    {
+        v4->sin_family = AF_INET;
+        v4->sin_port = htons(config.get_port());
+        length = sizeof(sockaddr_in);
+        return true;
     }
+    return false;
+}
 
-    // Set non-blocking
-    //fcntl(clientFd, F_SETFL, O_NONBLOCK);
+/*
+    The tuning half of the listen directive. None of these is fatal: a
+    kernel without TCP_FASTOPEN still serves, just without it.
+*/
+void WebServer::applyListenOptions(int server_socket, const ListenOptions &options)
+{
+    if (options.rcvbuf > 0 && setsockopt(server_socket, SOL_SOCKET, SO_RCVBUF, &options.rcvbuf, sizeof(options.rcvbuf)))
+        perror("setsockopt(SO_RCVBUF) failed");
+    if (options.sndbuf > 0 && setsockopt(server_socket, SOL_SOCKET, SO_SNDBUF, &options.sndbuf, sizeof(options.sndbuf)))
+        perror("setsockopt(SO_SNDBUF) failed");
+#ifdef TCP_DEFER_ACCEPT
+    // seconds the kernel holds a connection without data before handing it over anyway
+    int defer = 1;
+    if (options.deferred && setsockopt(server_socket, IPPROTO_TCP, TCP_DEFER_ACCEPT, &defer, sizeof(defer)))
+        perror("setsockopt(TCP_DEFER_ACCEPT) failed");
+#endif
+#ifdef TCP_FASTOPEN
+    if (options.fastopen > 0 && setsockopt(server_socket, IPPROTO_TCP, TCP_FASTOPEN, &options.fastopen, sizeof(options.fastopen)))
+        perror("setsockopt(TCP_FASTOPEN) failed");
+#endif
+}
 
-    // Check if we've reached maximum connections (leave buffer for CGI)
-    if (numfds >= maxfds - 10)
+/*
+    Drains the listen queue up to the server's accept_batch per POLLIN so a
+    burst of connections doesn't cost one poll() round each. Client sockets
+    come out of accept4 already non-blocking and close-on-exec (CGI children
+    must not inherit them). Past maxfds - CONNECTION_RESERVE new clients are
+    accepted and turned away with a canned 503, the reserve is kept for CGI
+    pipes. The HEALTH_RESERVE slots below that still take connections; with
+    overload enabled the load level is at 1 there and only health checks
+    get served.
+*/
+void WebServer::acceptNewConnection(int listening_socket) {
+    int server_index = getServerIndexForSocket(listening_socket);
+    if (server_index == -1)
     {
-        std::cerr << "Maximum connections reached (" << numfds << "/" << maxfds << "), rejecting client" << std::endl;
-        close(clientFd);
+        LOG_ERROR("Unable to find server configuration for socket " << listening_socket);
         return;
     }
+    int batch = m_configs[server_index].get_accept_batch();
 
-    try {
-        // Get server index for this listening socket
-        int server_index = getServerIndexForSocket(listening_socket);
-        if (server_index == -1)
+    for (int accepted = 0; accepted < batch; ++accepted)
+    {
+        sockaddr_storage clientAddr;
+        socklen_t addrLen = sizeof(clientAddr);
+        int clientFd = accept4(listening_socket, (struct sockaddr *)&clientAddr, &addrLen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (clientFd < 0)
         {
-            std::cerr << "Unable to find server configuration for socket " << listening_socket << std::endl;
-            close(clientFd);
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            // EAGAIN: the queue is empty
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                perror("accept4");
             return;
         }
 
-        // Create a client connection object first
-        ClientConnection conn(clientFd, clientAddr);
-        conn._server = this;
+        if (numfds >= maxfds - CONNECTION_RESERVE)
+        {
+            rejectConnection(clientFd, m_slots_reject);
+            Metrics::Increment(Metrics::CONNECTIONS_REJECTED);
+            LOG_WARN("Maximum connections reached (" << numfds << "/" << maxfds << "), rejected with 503");
+            continue;
+        }
+
+        int limit_slot = m_limiters[server_index].Open(clientAddr);
+        if (limit_slot == LIMIT_REJECTED)
+        {
+            rejectConnection(clientFd, m_conn_rejects[server_index]);
+            Metrics::Increment(Metrics::LIMIT_CONN_REJECTED);
+            LOG_WARN("limiting connections: " << m_configs[server_index].get_limits().connections
+                << " already open from this address, rejected with " << m_configs[server_index].get_limits().conn_status);
+            continue;
+        }
 
-        // Add to poll set
-        pollfds[numfds].fd = clientFd;
-        pollfds[numfds].events = POLLIN;
-        pollfds[numfds].revents = 0;
-        numfds++;
+        try {
+            // built in place in the connection slab, never copied
+            ClientConnection *conn = clients.Open(clientFd, clientAddr, server_index);
+            if (conn == NULL)
+            {
+                LOG_WARN("Client fd " << clientFd << " is already registered");
+                m_limiters[server_index].Close(limit_slot);
+                close(clientFd);
+                continue;
+            }
+            conn->_server = this;
+            conn->limit_slot = limit_slot;
+            // small responses leave in one write, Nagle would only hold back their last segment
+            if (clientAddr.ss_family != AF_UNIX && m_configs[server_index].get_tcp_nodelay())
+            {
+                int nodelay = 1;
+                setsockopt(clientFd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+            }
 
-        // Store mappings
-        clients[clientFd] = conn;
-        client_to_server_index[clientFd] = server_index;
+            pollfds[numfds].fd = clientFd;
+            pollfds[numfds].events = POLLIN;
+            pollfds[numfds].revents = 0;
+            numfds++;
+            Overload::Slots(numfds, maxfds - CONNECTION_RESERVE - HEALTH_RESERVE);
+            Metrics::Increment(Metrics::CONNECTIONS_ACCEPTED);
 
-        std::cout << "Client ip: " << clients[clientFd].ipAddress 
-                  << " connected to server '" << m_configs[server_index].get_server_name() 
-                  << "' (numfds=" << numfds << "/" << maxfds << ")" << std::endl;
-    }
-    catch (const std::exception& e) {
-        std::cerr << "Error creating client connection: " << e.what() << std::endl;
-        close(clientFd);
-        // Remove from poll if it was added
-        if (numfds > 0 && pollfds[numfds-1].fd == clientFd) {
-            numfds--;
+            LOG_DEBUG("Client ip: " << conn->ipAddress 
+                      << " connected to server '" << m_configs[server_index].get_server_name() 
+                      << "' (numfds=" << numfds << "/" << maxfds << ")");
+        }
+        catch (const std::exception& e) {
+            LOG_ERROR("Error creating client connection: " << e.what());
+            m_limiters[server_index].Close(limit_slot);
+            clients.Close(clientFd);
+            close(clientFd);
         }
     }
 }
 
+/*
+    A client turned away at accept, by limit_conn or out of poll slots.
+    The canned response goes out with one non-blocking send and the socket
+    is closed, no poll slot or connection object is ever spent on it. What
+    the client already sent is read first, so the close is not a reset.
+*/
+void WebServer::rejectConnection(int client_fd, const std::string &response)
+{
+    char discard[BUFFER_SIZE];
+
+    while (recv(client_fd, discard, sizeof(discard), MSG_DONTWAIT) > 0)
+        ;
+    if (send(client_fd, response.data(), response.size(), MSG_DONTWAIT | MSG_NOSIGNAL) < 0)
+        LOG_DEBUG("Rejection not sent: " << strerror(errno));
+    close(client_fd);
+}
+
+void WebServer::refuse(ClientConnection &client, int status, long retry_after)
+{
+    if (client.http_response == NULL)
+    {
+        std::map<std::string, std::string> no_headers;
+        client.http_response = new HttpResponse(status, no_headers, "", false, false);
+    }
+    std::ostringstream seconds;
+    seconds << retry_after;
+    client.http_response->setStatusCode(status);
+    client.http_response->setStatusMessage(client.http_response->GetStatusMessage(status));
+    client.http_response->setContentType("text/plain");
+    client.http_response->setHeader("Retry-After", seconds.str());
+    std::ostringstream body;
+    body << status << " " << client.http_response->getStatusMessage() << "\n";
+    client.http_response->setBuffer(body.str());
+    client.should_close = true;
+}
+
+// the parsed head becomes the connection's request, already answered; its body is left unread
+void WebServer::refuseRequest(ClientConnection &client, const HttpRequest &request, int status, long retry_after)
+{
+    if (client.http_request)
+        delete client.http_request;
+    client.http_request = new HttpRequest(request);
+    client.http_request->SetClientData(&client);
+    client.http_request->SetProcessed(true);
+    refuse(client, status, retry_after);
+}
+
+bool WebServer::limitRequest(ClientConnection &client, const HttpRequest &request)
+{
+    int server_index = clients.ServerIndex(client.GetFd());
+    if (server_index < 0)
+        return false;
+    RateLimiter &limiter = m_limiters[server_index];
+    double wait = limiter.Request(client.limit_slot);
+    if (wait <= 0)
+        return false;
+
+    int status = limiter.Options().req_status;
+    refuseRequest(client, request, status, static_cast<long>(wait) + 1);
+    Metrics::Increment(Metrics::LIMIT_REQ_REJECTED);
+    LOG_WARN("limiting requests from " << client.ipAddress << ", next token in " << wait << "s, rejected with " << status);
+    return true;
+}
+
+/*
+    Health checks are the introspection locations, so a monitor can still
+    see an overloaded server. CGI costs a process and a body costs reads
+    and disk, those go before plain GET and HEAD.
+*/
+Overload::Priority WebServer::requestPriority(ClientConnection &client, const HttpRequest &request)
+{
+    const Location *location = getConfigForClient(client.GetFd()).findMatchingLocation(request.GetLocation());
+
+    if (location && (location->get_metrics() || location->get_stubStatus()))
+        return Overload::HEALTH;
+    if (request.GetMethod() != "GET" && request.GetMethod() != "HEAD")
+        return Overload::LOW;
+    if (location && !location->get_cgiExt().empty())
+        return Overload::LOW;
+    return Overload::NORMAL;
+}
+
+bool WebServer::shedRequest(ClientConnection &client, const HttpRequest &request)
+{
+    Overload::Priority priority = requestPriority(client, request);
+    if (Overload::Admit(priority))
+        return false;
+
+    refuseRequest(client, request, 503, OVERLOAD_RETRY_AFTER);
+    Metrics::Increment(Metrics::OVERLOAD_SHED);
+    // one line a second, a warning per request would add to the load being shed
+    ++m_shed_unlogged;
+    if (time(NULL) != m_shed_logged)
+    {
+        m_shed_logged = time(NULL);
+        LOG_WARN("overloaded at level " << Overload::Level() << ", shed " << m_shed_unlogged
+            << " request(s) with 503, the last a " << (priority == Overload::LOW ? "low priority" : "normal")
+            << " one from " << client.ipAddress);
+        m_shed_unlogged = 0;
+    }
+    return true;
+}
+
 void WebServer::closeClientConnection(int clientSocket) {
-    std::map<int, ClientConnection>::iterator it = clients.find(clientSocket);
-    if (it != clients.end())
+    ClientConnection *conn = clients.Find(clientSocket);
+    if (conn != NULL)
     {
-        printf("Client ip: %s disconnected\n", it->second.ipAddress.c_str());
+        LOG_DEBUG("Client ip: " << conn->ipAddress << " disconnected");
 
         // Clean up allocated resources
-        if (it->second.http_request != NULL)
+        if (conn->http_request != NULL)
         {
-            delete it->second.http_request;
-            it->second.http_request = NULL;
+            delete conn->http_request;
+            conn->http_request = NULL;
         }
 
-        if (it->second.http_response != NULL) {
-            delete it->second.http_response;
-            it->second.http_response = NULL;
+        if (conn->http_response != NULL) {
+            delete conn->http_response;
+            conn->http_response = NULL;
         }
 
-        // Remove from all tracking maps FIRST
-        clients.erase(it);
-        client_to_server_index.erase(clientSocket);
+        int server_index = clients.ServerIndex(clientSocket);
+        if (server_index >= 0)
+            m_limiters[server_index].Close(conn->limit_slot);
+
+        // Remove from the connection table FIRST, its slot gets a new generation
+        clients.Close(clientSocket);
         
         // Close socket
         close(clientSocket);
@@ -453,14 +798,14 @@ void WebServer::closeClientConnection(int clientSocket) {
                 // Move last element to this position
                 pollfds[i] = pollfds[numfds - 1];
                 numfds--;
-                std::cout << "[EVENT] Removed client fd=" << clientSocket << " from poll (numfds=" << numfds << ")" << std::endl;
+                LOG_DEBUG("[EVENT] Removed client fd=" << clientSocket << " from poll (numfds=" << numfds << ")");
                 break;
             }
         }
     }
     else
     {
-        std::cerr << "Warning: Attempted to close non-existent client connection: " << clientSocket << std::endl;
+        LOG_WARN("Attempted to close non-existent client connection: " << clientSocket);
     }
 }
 
@@ -470,47 +815,47 @@ void WebServer::updatePollEvents(int fd, short events) {
         if (pollfds[i].fd == fd)
         {
             if (pollfds[i].events != events) {
-                std::cout << "[EVENT] fd=" << fd << " events: " << pollfds[i].events << " -> " << events << std::endl;
+                LOG_DEBUG("[EVENT] fd=" << fd << " events: " << pollfds[i].events << " -> " << events);
                 pollfds[i].events = events;
                 pollfds[i].revents = 0; // Clear any pending events
             }
             return;
         }
     }
-    std::cerr << "[EVENT ERROR] fd=" << fd << " not found in poll array!" << std::endl;
+    LOG_ERROR("[EVENT ERROR] fd=" << fd << " not found in poll array!");
 }
 
 ServerConfig WebServer::getConfigByHost(std::string host) {
-    std::cout << "---------------------Searching for config with host: " << host.length() <<host << "=======||||" << std::endl;
+    LOG_DEBUG("---------------------Searching for config with host: " << host.length() <<host << "=======||||");
     for (size_t i = 0; i < m_configs.size(); ++i)
     {
         // std::cout << "----------------------Checking config: " << m_configs[i].get_host() << std::endl;
-        std::cout << "----------------------Host to match:[" << m_configs[i].get_server_name().length()  << m_configs[i].get_server_name() <<"]" << std::endl;
-        std::cout << "----------------------ORIGANAL Host to match:[" << host << "]" << std::endl;
+        LOG_DEBUG("----------------------Host to match:[" << m_configs[i].get_server_name().length()  << m_configs[i].get_server_name() <<"]");
+        LOG_DEBUG("----------------------ORIGANAL Host to match:[" << host << "]");
         if (m_configs[i].get_server_name() == host)
         {
-            std::cout << "Found matching server configuration for host: " << host << std::endl;
+            LOG_DEBUG("Found matching server configuration for host: " << host);
             // exit(0);
             return m_configs[i];
 
         }
     }
-    std::cerr << "No matching server configuration found for host: " << host << "|"<< std::endl;
+    LOG_DEBUG("No matching server configuration found for host: " << host << "|");
     // exit(0);
     return m_configs[0]; // Return the first config if no match found
 }
 
 void WebServer::handleClientRequest(int fd) {
-    std::cout << "============== (START OF HANDLING CLIENT REQUEST) ==============\n";
-    clients[fd].updateActivity(); // Update last activity timestamp
-
+    LOG_DEBUG("============== (START OF HANDLING CLIENT REQUEST) ==============");
     // Check if client exists
-    if (clients.find(fd) == clients.end())
+    ClientConnection *conn = clients.Find(fd);
+    if (conn == NULL)
     {
-        std::cerr << "Client not found for fd " << fd << std::endl;
+        LOG_WARN("Client not found for fd " << fd);
         return;
     }
-    ClientConnection &client = clients[fd];
+    ClientConnection &client = *conn;
+    client.updateActivity(); // Update last activity timestamp
 
     // Set error chain handler
     ErrorHandler *errorHandler = new NotFound();
@@ -519,25 +864,28 @@ void WebServer::handleClientRequest(int fd) {
                 ->SetNext(new NotImplemented())
                 ->SetNext(new MethodNotAllowed())
                 ->SetNext(new Forbidden())
-                ->SetNext(new TooManyRedirection());
+                ->SetNext(new TooManyRedirection())
+                ->SetNext(new InsufficientStorage());
     try
     {
         // Generate and process the request
-        client.GenerateRequest(fd);
+        bool has_request = client.GenerateRequest(fd);
         
         // Only process if it's not a streaming upload
-        if (!client.isStreamingUpload()) {
+        if (!has_request && !client.isStreamingUpload()) {
+            // readable without data yet, poll() will report it again
+        } else if (!client.isStreamingUpload()) {
             client.ProcessRequest(fd);
             // If we get here successfully, set up for response
             this->updatePollEvents(fd, POLLOUT);
         } else {
             // For streaming uploads, keep listening for more data
-            std::cout << "Streaming upload started, waiting for data..." << std::endl;
+            LOG_DEBUG("Streaming upload started, waiting for data...");
         }
     }
     catch(HttpException &e)
     {
-        std::cerr << "HttpException: " << e.what() << std::endl;
+        LOG_INFO("HttpException: " << e.what());
 
         try
         {
@@ -547,13 +895,13 @@ void WebServer::handleClientRequest(int fd) {
         }
         catch (std::exception &ex)
         {
-            std::cerr << "Error while handling exception: " << ex.what() << std::endl;
+            LOG_ERROR("Error while handling exception: " << ex.what());
             closeClientConnection(fd);
         }
     }
     catch (...)
     {
-        std::cerr << "Unknown exception in handleClientRequest" << std::endl;
+        LOG_WARN("Unknown exception in handleClientRequest");
         closeClientConnection(fd);
     }
     
@@ -570,131 +918,152 @@ void WebServer::handleClientRequest(int fd) {
 }
 
 void WebServer::handleClientResponse(int fd) {
-    if (clients.find(fd) == clients.end())
+    ClientConnection *conn = clients.Find(fd);
+    if (conn == NULL)
     {
-        std::cerr << "Client with fd " << fd << " not found in clients map" << std::endl;
+        LOG_WARN("Client with fd " << fd << " not found in the connection table");
         return;
     }
-    ClientConnection &client = clients[fd];
+    ClientConnection &client = *conn;
 
     if (client.http_response == NULL)
     {
-        std::cerr << "Warning: client.http_response is null for fd " << fd << std::endl;
+        LOG_WARN("client.http_response is null for fd " << fd);
         updatePollEvents(fd, POLLIN);
         return;
     }
     
+    // content-encode once, before the first byte of this response goes out
+    if (client.http_request && client.http_response->getByteSent() == 0)
+        GzipFilter::Apply(*client.http_response, *client.http_request, this->getConfigForClient(fd));
+
     // Check if we have data to send
     if (client.http_response->checkAvailablePacket())
     {
-        if (client.http_response->isChunked())
+        // redirect loops are counted once per response, before any of it is written
+        if (client.http_response->getByteSent() == 0 && !client.http_response->isFile())
         {
-            try {
-                client.http_response->sendChunkedResponse(fd);
-                
-                std::cout << "----------- [Chunked response Detail] -------------\n";
-                std::cout << "File bytes sent: " << client.http_response->getByteSent() << "\n";
-                std::cout << "File bytes to send: " << client.http_response->getByteToSend() << "\n";
-                
-                if (client.http_response->getByteSent() >= client.http_response->getByteToSend())
+            if (client.http_request && client.http_request->IsRedirected())
+            {
+                client.redirect_counter++;
+                LOG_DEBUG(" -------------------- [Debug] : number of redirections: " << client.redirect_counter << "Is redirection " << client.http_request->IsRedirected());
+                if (client.redirect_counter > 10)
                 {
-                    std::cout << "Chunked response sent completely\n";
-                    if (client.http_response->isKeepAlive())
-                    {
-                        std::cout << "Resetting request for keep-alive\n";
-                        client.http_response->clear();
-                        client.http_request->ResetRequest();
-                        this->updatePollEvents(fd, POLLIN);
-                    }
-                    else
-                    {
-                        std::cout << "Closing connection after chunked response\n";
-                        closeClientConnection(fd);
-                    }
-                    return; // IMPORTANT: Return here to avoid further processing
+                    client.redirect_counter = 0;
+                    Error error(client, 429, "Too Many Redirections", TOO_MANY_REDIRECTION);
+                    ErrorHandler *errorHandler = new TooManyRedirection();
+                    errorHandler->HanldeError(error, this->getConfigForClient(fd));
+                    delete errorHandler;
+                    client.should_close = true; 
                 }
             }
-            catch (const HttpException& e)
+            else
             {
-                std::cerr << "Error in chunked response: " << e.what() << std::endl;
-                closeClientConnection(fd);
-                return;
+                LOG_DEBUG("Resetting redirect counter to 0");
+                client.redirect_counter = 0; 
             }
         }
-        else
+
+        // head and file body leave as full segments, nothing goes out until uncorked or full
+        if (client.http_response->getByteSent() == 0 && client.http_response->isFile()
+            && !client.tcp_corked && this->getConfigForClient(fd).get_tcp_nopush()
+            && this->getConfigForClient(fd).get_unix_path().empty())
         {
-            if (client.http_response->isFile())
-            {
-                client.http_response->sendResponse(fd);                
-            }
-            else
-            {
-                if (client.http_request && client.http_request->IsRedirected())
-                {
-                    client.redirect_counter++;
-                    std::cout << " -------------------- [Debug] : number of redirections: " << client.redirect_counter << "Is redirection " << client.http_request->IsRedirected() << std::endl;
-                    if (client.redirect_counter > 10)
-                    {
-                        client.redirect_counter = 0;
-                        Error error(client, 429, "Too Many Redirections", TOO_MANY_REDIRECTION);
-                        ErrorHandler *errorHandler = new TooManyRedirection();
-                        errorHandler->HanldeError(error, this->getConfigForClient(fd));
-                        delete errorHandler;
-                        client.should_close = true; 
-                    }
-                }
-                else
-                {
-                    std::cout << "Resetting redirect counter to 0\n\n\n";
-                    client.redirect_counter = 0; 
-                }
-                
-                client.http_response->sendChunkedResponse(fd);
-                
-                if (client.should_close)
-                {
-                    std::cout << "----Closing connection after error response\n";
-                    closeClientConnection(fd);
-                    return;
-                }
-            }
-            
+            int cork = 1;
+            client.tcp_corked = setsockopt(fd, IPPROTO_TCP, TCP_CORK, &cork, sizeof(cork)) == 0;
+        }
+
+        bool complete;
+        try {
+            complete = client.http_response->flushOutput(fd);
+        }
+        catch (const HttpException& e)
+        {
+            LOG_ERROR("Error while sending response: " << e.what());
+            Metrics::Increment(Metrics::SEND_ERRORS);
+            ClientConnection::markPhase(client.phases.sent);
+            logAccess(fd, client);
+            closeClientConnection(fd);
+            return;
+        }
+        // socket full: stay on POLLOUT, the queue resumes where it stopped
+        if (!complete)
+            return;
+        if (client.tcp_corked)
+        {
+            // pushes out the partial last segment right away
+            int cork = 0;
+            setsockopt(fd, IPPROTO_TCP, TCP_CORK, &cork, sizeof(cork));
+            client.tcp_corked = false;
+        }
+        ClientConnection::markPhase(client.phases.sent);
+        Metrics::Responded(client.http_response->getStatusCode());
+        Metrics::Increment(Metrics::BYTES_SENT, client.http_response->getByteSent());
+        Metrics::Observe(Metrics::REQUEST, ClientConnection::phaseTime(client.phases.start, client.phases.sent));
+        logAccess(fd, client);
+
+        if (client.should_close)
+        {
+            LOG_DEBUG("----Closing connection after error response");
+            closeClientConnection(fd);
+            return;
+        }
+        if (client.http_response->isKeepAlive())
+        {
+            LOG_DEBUG("Resetting request for keep-alive");
+            client.http_response->clear();
+            client.http_request->ResetRequest();
             this->updatePollEvents(fd, POLLIN);
-            
-            if (client.http_response->isKeepAlive())
-            {
-                std::cout << "after Resetting the request !!!\n";
-                client.http_response->clear();
-                client.http_request->ResetRequest();
-                return;
-            }
-            else
-            {
-                std::cout << "----Closing connection after response\n";
-                closeClientConnection(fd);
-                return;
-            }
+        }
+        else
+        {
+            LOG_DEBUG("----Closing connection after response");
+            closeClientConnection(fd);
         }
     }
     else
     {
         // No data available - switch back to reading
-        std::cout << "No data available for fd=" << fd << ", switching to POLLIN\n";
+        LOG_DEBUG("No data available for fd=" << fd << ", switching to POLLIN");
         updatePollEvents(fd, POLLIN);
     }
 }
 
+/*
+    One access_log record per response, once it is fully written or has
+    failed, and a warning with the phase breakdown when the request took
+    longer than the server's slow_request_threshold.
+*/
+void WebServer::logAccess(int fd, const ClientConnection &client) {
+    int server_index = clients.ServerIndex(fd);
+    if (server_index < 0 || client.http_response == NULL)
+        return;
+    AccessLog::Record(m_access_logs[server_index], client, client.http_request,
+                      *client.http_response, this->getConfigForClient(fd));
+
+    int threshold = m_configs[server_index].get_slow_request_threshold();
+    double total = ClientConnection::phaseTime(client.phases.start, client.phases.sent);
+    if (threshold > 0 && total * 1000 >= threshold)
+    {
+        std::string line = client.http_request ? client.http_request->GetRequestLine() : "";
+        if (!line.empty() && line[line.size() - 1] == '\r')
+            line.erase(line.size() - 1);
+        LOG_WARN("slow request " << total << "s from " << client.ipAddress << ": \"" << Logger::Escape(line)
+                 << "\" " << client.http_response->getStatusCode() << ", " << client.phaseBreakdown());
+    }
+}
+
 // ================= CGI TIME OUT MANAGEMENT
 void WebServer::addCgiToPoll(int cgi_fd) {
     if (numfds >= maxfds - 2) {  // Leave buffer for safety
-        std::cerr << "ERROR: Cannot add CGI fd " << cgi_fd << " - poll array full (numfds=" << numfds << "/" << maxfds << ")" << std::endl;
+        LOG_ERROR("Cannot add CGI fd " << cgi_fd << " - poll array full (numfds=" << numfds << "/" << maxfds << ")");
         return;
     }
     
     // Check if already exists
     for (int i = 0; i < numfds; i++) {
         if (pollfds[i].fd == cgi_fd) {
-            std::cout << "CGI fd " << cgi_fd << " already in poll" << std::endl;
+            LOG_DEBUG("CGI fd " << cgi_fd << " already in poll");
             return;
         }
     }
@@ -703,7 +1072,7 @@ void WebServer::addCgiToPoll(int cgi_fd) {
     pollfds[numfds].events = POLLIN;
     pollfds[numfds].revents = 0;
     numfds++;
-    std::cout << "Added CGI fd " << cgi_fd << " to poll (numfds=" << numfds << "/" << maxfds << ")" << std::endl;
+    LOG_DEBUG("Added CGI fd " << cgi_fd << " to poll (numfds=" << numfds << "/" << maxfds << ")");
 }
 
 void WebServer::removeCgiFromPoll(int cgi_fd) {
@@ -711,7 +1080,7 @@ void WebServer::removeCgiFromPoll(int cgi_fd) {
         if (pollfds[i].fd == cgi_fd) {
             pollfds[i] = pollfds[numfds - 1];
             numfds--;
-            std::cout << "Removed CGI fd " << cgi_fd << " from poll (numfds=" << numfds << ")" << std::endl;
+            LOG_DEBUG("Removed CGI fd " << cgi_fd << " from poll (numfds=" << numfds << ")");
             break;
         }
     }
@@ -731,7 +1100,7 @@ void WebServer::checkCgiTimeouts() {
          it != CgiHandler::active_cgis.end(); ++it) {
         
         if (current_time - it->second.start_time > 10) {  // 10 second timeout
-            std::cout << "CGI process " << it->second.pid << " timed out after 10 seconds" << std::endl;
+            LOG_DEBUG("CGI process " << it->second.pid << " timed out after 10 seconds");
             timed_out_fds.push_back(it->first);
         }
     }
@@ -754,14 +1123,20 @@ void WebServer::checkCgiTimeouts() {
                 waitpid(cgi_it->second.pid, &status, 0);
             }
             
-            // Set timeout error response
-            std::map<std::string, std::string> headers;
-            headers["Content-Type"] = "text/html";
-            cgi_it->second.client->http_response = new HttpResponse(504, headers, "text/html", false, false);
-            cgi_it->second.client->http_response->setBuffer("<html><body><h1>504 Gateway Timeout</h1><p>CGI script exceeded 10 second limit</p></body></html>");
-            
-            // Signal client to send response
-            updatePollEvents(cgi_it->second.client->GetFd(), POLLOUT);
+            Metrics::Increment(Metrics::CGI_TIMEOUTS);
+            Metrics::Observe(Metrics::CGI, AccessLog::Elapsed(cgi_it->second.started));
+            // Set timeout error response, unless the client is already gone
+            if (clients.Find(cgi_it->second.client_fd, cgi_it->second.client_generation)) {
+                cgi_it->second.client->upstream_time = AccessLog::Elapsed(cgi_it->second.started);
+                ClientConnection::markPhase(cgi_it->second.client->phases.upstream);
+                std::map<std::string, std::string> headers;
+                headers["Content-Type"] = "text/html";
+                cgi_it->second.client->http_response = new HttpResponse(504, headers, "text/html", false, false);
+                cgi_it->second.client->http_response->setBuffer("<html><body><h1>504 Gateway Timeout</h1><p>CGI script exceeded 10 second limit</p></body></html>");
+                
+                // Signal client to send response
+                updatePollEvents(cgi_it->second.client->GetFd(), POLLOUT);
+            }
             
             // Clean up
             close(cgi_fd);
@@ -780,11 +1155,28 @@ void WebServer::handleCgiEvent(int fd) {
     
     CgiHandler::CgiProcess& cgi = it->second;
     
+    // The client hung up, its fd may even belong to a newer connection by now
+    if (clients.Find(cgi.client_fd, cgi.client_generation) == NULL) {
+        LOG_DEBUG("CGI client is gone, killing process " << cgi.pid);
+        kill(cgi.pid, SIGKILL);
+        waitpid(cgi.pid, NULL, 0);
+        Metrics::Increment(Metrics::CGI_FAILED);
+        Metrics::Observe(Metrics::CGI, AccessLog::Elapsed(cgi.started));
+        close(fd);
+        removeCgiFromPoll(fd);
+        CgiHandler::active_cgis.erase(it);
+        return;
+    }
+    
     // Check timeout (10 seconds)
     if (time(NULL) - cgi.start_time > 10) {
-        std::cout << "CGI timeout, killing process " << cgi.pid << std::endl;
+        LOG_DEBUG("CGI timeout, killing process " << cgi.pid);
         kill(cgi.pid, SIGKILL);
         waitpid(cgi.pid, NULL, 0);
+        cgi.client->upstream_time = AccessLog::Elapsed(cgi.started);
+        ClientConnection::markPhase(cgi.client->phases.upstream);
+        Metrics::Increment(Metrics::CGI_TIMEOUTS);
+        Metrics::Observe(Metrics::CGI, cgi.client->upstream_time);
         
         std::map<std::string, std::string> headers;
         headers["Content-Type"] = "text/html";
@@ -806,33 +1198,39 @@ void WebServer::handleCgiEvent(int fd) {
     if (bytes > 0) {
         buffer[bytes] = '\0';
         cgi.output += buffer;
-        std::cout << "🔍 Read " << bytes << " bytes from CGI process " << cgi.pid << std::endl;
+        LOG_DEBUG("🔍 Read " << bytes << " bytes from CGI process " << cgi.pid);
     } else if (bytes == 0) {
         // EOF - CGI finished
-        std::cout << "🔍 CGI process " << cgi.pid << " finished (EOF)" << std::endl;
-        std::cout << "🔍 Total output length: " << cgi.output.length() << " bytes" << std::endl;
+        cgi.client->upstream_time = AccessLog::Elapsed(cgi.started);
+        ClientConnection::markPhase(cgi.client->phases.upstream);
+        LOG_DEBUG("🔍 CGI process " << cgi.pid << " finished (EOF)");
+        LOG_DEBUG("🔍 Total output length: " << cgi.output.length() << " bytes");
         
         // Print first 200 characters of output for debugging
         if (cgi.output.length() > 0) {
             std::string preview = cgi.output.substr(0, 200);
-            std::cout << "🔍 Output preview: " << preview << "..." << std::endl;
+            LOG_DEBUG("🔍 Output preview: " << preview << "...");
         } else {
-            std::cout << "🔍 No output received from CGI!" << std::endl;
+            LOG_DEBUG("🔍 No output received from CGI!");
         }
         
         int status;
         pid_t wait_result = waitpid(cgi.pid, &status, 0);
-        std::cout << "🔍 waitpid result: " << wait_result << " for PID " << cgi.pid << std::endl;
+        LOG_DEBUG("🔍 waitpid result: " << wait_result << " for PID " << cgi.pid);
+        Metrics::Increment(Metrics::CGI_EXITED);
+        if (wait_result != cgi.pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            Metrics::Increment(Metrics::CGI_FAILED);
+        Metrics::Observe(Metrics::CGI, cgi.client->upstream_time);
         
         if (wait_result == cgi.pid) {
-            std::cout << "🔍 Process status raw value: " << status << std::endl;
+            LOG_DEBUG("🔍 Process status raw value: " << status);
             
             if (WIFEXITED(status)) {
                 int exit_code = WEXITSTATUS(status);
-                std::cout << "🔍 Process exited normally with code: " << exit_code << std::endl;
+                LOG_DEBUG("🔍 Process exited normally with code: " << exit_code);
                 
                 if (exit_code == 0) {
-                    std::cout << "🔍 SUCCESS: Processing CGI output" << std::endl;
+                    LOG_DEBUG("🔍 SUCCESS: Processing CGI output");
                     
                     // Parse headers and body
                     std::string headers, body;
@@ -851,8 +1249,8 @@ void WebServer::handleCgiEvent(int fd) {
                         body = cgi.output.substr(header_end + 4);
                     }
                     
-                    std::cout << "🔍 Headers found: " << headers.length() << " chars" << std::endl;
-                    std::cout << "🔍 Body found: " << body.length() << " chars" << std::endl;
+                    LOG_DEBUG("🔍 Headers found: " << headers.length() << " chars");
+                    LOG_DEBUG("🔍 Body found: " << body.length() << " chars");
                     
                     // Parse CGI headers
                     std::map<std::string, std::string> response_headers;
@@ -890,7 +1288,7 @@ void WebServer::handleCgiEvent(int fd) {
                             header_value.pop_back();
                         }
                         
-                        std::cout << "🔍 Processing CGI header: " << header_name << ": " << header_value << std::endl;
+                        LOG_DEBUG("🔍 Processing CGI header: " << header_name << ": " << header_value);
                         
                         // Handle special CGI headers
                         if (header_name == "Status") {
@@ -901,23 +1299,23 @@ void WebServer::handleCgiEvent(int fd) {
                             } else {
                                 status_code = std::atoi(header_value.c_str());
                             }
-                            std::cout << "🔍 Set status: " << status_code << " " << status_message << std::endl;
+                            LOG_DEBUG("🔍 Set status: " << status_code << " " << status_message);
                         } 
                         else if (header_name == "Content-Type" || header_name == "Content-type") {
                             response_headers["Content-Type"] = header_value;
-                            std::cout << "🔍 Set content-type: " << header_value << std::endl;
+                            LOG_DEBUG("🔍 Set content-type: " << header_value);
                         } 
                         else if (header_name == "Location") {
                             response_headers["Location"] = header_value;
-                            std::cout << "🔍 Set redirect location: " << header_value << std::endl;
+                            LOG_DEBUG("🔍 Set redirect location: " << header_value);
                         }
                         else if (header_name == "Set-Cookie") {
                             set_cookies.push_back(header_value);
-                            std::cout << "🔍 [CRITICAL] Found Set-Cookie: " << header_value << std::endl;
+                            LOG_DEBUG("🔍 [CRITICAL] Found Set-Cookie: " << header_value);
                         }
                         else {
                             response_headers[header_name] = header_value;
-                            std::cout << "🔍 Set header: " << header_name << ": " << header_value << std::endl;
+                            LOG_DEBUG("🔍 Set header: " << header_name << ": " << header_value);
                         }
                     }
                     
@@ -928,15 +1326,15 @@ void WebServer::handleCgiEvent(int fd) {
                     for (std::vector<std::string>::iterator cookie_it = set_cookies.begin(); 
                          cookie_it != set_cookies.end(); ++cookie_it) {
                         cgi.client->http_response->setHeader("Set-Cookie", *cookie_it);
-                        std::cout << "🔍 [CRITICAL] Added Set-Cookie to response: " << *cookie_it << std::endl;
+                        LOG_DEBUG("🔍 [CRITICAL] Added Set-Cookie to response: " << *cookie_it);
                     }
                     
                     cgi.client->http_response->setBuffer(body);
                     
-                    std::cout << "🔍 Final CGI response - Status: " << status_code << " " << status_message << std::endl;
+                    LOG_DEBUG("🔍 Final CGI response - Status: " << status_code << " " << status_message);
                     updatePollEvents(cgi.client->GetFd(), POLLOUT);
                 } else {
-                    std::cout << "🔍 ERROR: CGI process exited with non-zero code: " << exit_code << std::endl;
+                    LOG_WARN("CGI process exited with non-zero code: " << exit_code);
                     
                     std::map<std::string, std::string> error_headers;
                     error_headers["Content-Type"] = "text/html";
@@ -946,7 +1344,7 @@ void WebServer::handleCgiEvent(int fd) {
                 }
             } else if (WIFSIGNALED(status)) {
                 int signal_num = WTERMSIG(status);
-                std::cout << "🔍 ERROR: CGI process terminated by signal: " << signal_num << std::endl;
+                LOG_WARN("CGI process terminated by signal: " << signal_num);
                 
                 std::map<std::string, std::string> error_headers;
                 error_headers["Content-Type"] = "text/html";
@@ -954,7 +1352,7 @@ void WebServer::handleCgiEvent(int fd) {
                 cgi.client->http_response->setBuffer("<html><body><h1>500 CGI Error</h1><p>Killed by signal: " + std::string(1, '0' + signal_num) + "</p></body></html>");
                 updatePollEvents(cgi.client->GetFd(), POLLOUT);
             } else {
-                std::cout << "🔍 ERROR: CGI process ended abnormally" << std::endl;
+                LOG_WARN("CGI process ended abnormally");
                 
                 std::map<std::string, std::string> error_headers;
                 error_headers["Content-Type"] = "text/html";
@@ -963,7 +1361,7 @@ void WebServer::handleCgiEvent(int fd) {
                 updatePollEvents(cgi.client->GetFd(), POLLOUT);
             }
         } else {
-            std::cout << "🔍 ERROR: waitpid failed or returned unexpected result" << std::endl;
+            LOG_WARN("waitpid failed or returned unexpected result");
             
             std::map<std::string, std::string> error_headers;
             error_headers["Content-Type"] = "text/html";
@@ -976,7 +1374,7 @@ void WebServer::handleCgiEvent(int fd) {
         removeCgiFromPoll(fd);
         CgiHandler::active_cgis.erase(it);
     } else if (bytes < 0) {
-        std::cout << "🔍 ERROR: read() failed: " << std::endl;
+        LOG_WARN("read() failed: ");
         
         close(fd);
         removeCgiFromPoll(fd);
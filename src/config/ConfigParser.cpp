@@ -1,6 +1,9 @@
 #include "config/ConfigParser.hpp"
 #include "config/ServerConfig.hpp"
 #include "config/Location.hpp"
+#include "Logger.hpp"
+#include "AccessLog.hpp"
+#include "Overload.hpp"
 
 ValidationError::ValidationError(ErrorLevel level, const std::string& message, int line, const std::string& context)
     : _level(level), _message(message), _line(line), _context(context) {}
@@ -99,6 +102,7 @@ std::vector<std::string> ConfigParser::tokenize(const std::string& content) {
     std::string current_token;
     bool in_comment = false;
     bool in_quotes = false;
+    char quote = '"';
     int line_number = 1;
     char c;
     
@@ -126,9 +130,11 @@ std::vector<std::string> ConfigParser::tokenize(const std::string& content) {
             continue;
         }
         
-        if (c == '"') {
+        // 'single' quotes let a value hold double ones, like log_format templates
+        if ((c == '"' || c == '\'') && (!in_quotes || c == quote)) {
             if (!in_quotes) {
                 in_quotes = true;
+                quote = c;
             } else {
                 in_quotes = false;
                 tokens.push_back(current_token);
@@ -351,6 +357,10 @@ bool ConfigParser::validate_config() {
     bool valid = true;
     _errors.clear();
     
+    if (!validate_main_directives()) {
+        valid = false;
+    }
+    
     for (size_t i = 0; i < servers_.size(); ++i) {
         if (!validate_server_block(servers_[i])) {
             valid = false;
@@ -379,6 +389,105 @@ bool ConfigParser::validate_config() {
     return valid;
 }
 
+// Directives outside any server block apply to the whole process
+bool ConfigParser::validate_main_directives() {
+    std::vector<std::string> ALLOWED_DIRECTIVES;
+    ALLOWED_DIRECTIVES.push_back("mime_types");
+    ALLOWED_DIRECTIVES.push_back("error_log");
+    ALLOWED_DIRECTIVES.push_back("log_format");
+    ALLOWED_DIRECTIVES.push_back("overload");
+    ALLOWED_DIRECTIVES.push_back("cgi_max_processes");
+    
+    bool valid = true;
+    for (size_t i = 0; i < root_block_.directives.size(); ++i) {
+        const Directive& directive = root_block_.directives[i];
+        
+        if (!validateDirective(directive, "main", ALLOWED_DIRECTIVES)) {
+            valid = false;
+            continue;
+        }
+        if (directive.name == "mime_types") {
+            if (directive.parameters.size() != 1) {
+                addError(ValidationError::ERROR, "mime_types directive requires exactly one file", 
+                        getTokenLine(directive.name), "main");
+                valid = false;
+            }
+            else if (access(directive.parameters[0].c_str(), R_OK) != 0) {
+                addError(ValidationError::ERROR, "mime_types file \"" + directive.parameters[0] + "\" is not readable", 
+                        getTokenLine(directive.name), "main");
+                valid = false;
+            }
+        }
+        else if (directive.name == "error_log") {
+            if (directive.parameters.empty() || directive.parameters.size() > 2) {
+                addError(ValidationError::ERROR, "error_log directive requires a path and an optional level", 
+                        getTokenLine(directive.name), "main");
+                valid = false;
+            }
+            else if (directive.parameters.size() == 2 && Logger::ParseLevel(directive.parameters[1]) < 0) {
+                addError(ValidationError::ERROR, "Invalid error_log level \"" + directive.parameters[1] + "\" (debug, info, warn, error, crit)", 
+                        getTokenLine(directive.name), "main");
+                valid = false;
+            }
+        }
+        else if (directive.name == "log_format") {
+            std::string error;
+            if (directive.parameters.size() < 2) {
+                addError(ValidationError::ERROR, "log_format directive requires a name and a template", 
+                        getTokenLine(directive.name), "main");
+                valid = false;
+            }
+            else if (!AccessLog::CheckFormat(get_log_format(directive.parameters[0]), error)) {
+                addError(ValidationError::ERROR, "log_format " + directive.parameters[0] + ": " + error, 
+                        getTokenLine(directive.name), "main");
+                valid = false;
+            }
+        }
+        else if (directive.name == "overload") {
+            OverloadOptions options;
+            std::string error;
+            if (!Overload::ParseOptions(directive.parameters, options, error)) {
+                addError(ValidationError::ERROR, error.empty() ? "overload requires 'off', lag=time or queue=N"
+                        : "invalid overload parameter \'" + error + "\'", getTokenLine(directive.name), "main");
+                valid = false;
+            }
+        }
+        else if (directive.name == "cgi_max_processes") {
+            char* endptr = NULL;
+            long processes = directive.parameters.size() == 1 ? strtol(directive.parameters[0].c_str(), &endptr, 10) : 0;
+            if (directive.parameters.size() != 1 || (directive.parameters[0] != "off"
+                && (*endptr != '\0' || processes < 1 || processes > 4096))) {
+                addError(ValidationError::ERROR, "cgi_max_processes requires 'off' or a process count", 
+                        getTokenLine(directive.name), "main");
+                valid = false;
+            }
+        }
+    }
+    return valid;
+}
+
+// Template of a log_format, its parameters after the name joined as nginx does
+std::string ConfigParser::get_log_format(const std::string& name) const {
+    std::string source;
+    for (size_t i = 0; i < root_block_.directives.size(); ++i) {
+        const Directive& directive = root_block_.directives[i];
+        if (directive.name != "log_format" || directive.parameters.empty() || directive.parameters[0] != name)
+            continue;
+        for (size_t p = 1; p < directive.parameters.size(); ++p)
+            source += directive.parameters[p];
+        break;
+    }
+    return source;
+}
+
+std::string ConfigParser::get_main_directive(const std::string& name, size_t index) const {
+    const Directive* directive = root_block_.find_directive(name);
+    if (directive == NULL || directive->parameters.size() <= index) {
+        return "";
+    }
+    return directive->parameters[index];
+}
+
 bool ConfigParser::validate_server_block(const Block& server) {
     std::vector<std::string> ALLOWED_DIRECTIVES;
     ALLOWED_DIRECTIVES.push_back("listen");
@@ -388,6 +497,19 @@ bool ConfigParser::validate_server_block(const Block& server) {
     ALLOWED_DIRECTIVES.push_back("error_page");
     ALLOWED_DIRECTIVES.push_back("autoindex");
     ALLOWED_DIRECTIVES.push_back("index");
+    ALLOWED_DIRECTIVES.push_back("gzip");
+    ALLOWED_DIRECTIVES.push_back("gzip_comp_level");
+    ALLOWED_DIRECTIVES.push_back("gzip_min_length");
+    ALLOWED_DIRECTIVES.push_back("gzip_types");
+    ALLOWED_DIRECTIVES.push_back("accept_batch");
+    ALLOWED_DIRECTIVES.push_back("tcp_nopush");
+    ALLOWED_DIRECTIVES.push_back("tcp_nodelay");
+    ALLOWED_DIRECTIVES.push_back("access_log");
+    ALLOWED_DIRECTIVES.push_back("slow_request_threshold");
+    ALLOWED_DIRECTIVES.push_back("limit_conn");
+    ALLOWED_DIRECTIVES.push_back("limit_req");
+    ALLOWED_DIRECTIVES.push_back("limit_conn_status");
+    ALLOWED_DIRECTIVES.push_back("limit_req_status");
     
     bool valid = true;
     bool has_listen = false;
@@ -412,25 +534,51 @@ bool ConfigParser::validate_server_block(const Block& server) {
                     valid = false;
                     continue;
                 }
-            if (directive.parameters.size() > 1) {
-                    addError(ValidationError::ERROR, " \'" + directive.parameters[1] + "\'", 
+            for (size_t p = 1; p < directive.parameters.size(); ++p) {
+                const std::string& option = directive.parameters[p];
+                size_t equal = option.find('=');
+                std::string name = option.substr(0, equal);
+                std::string value = equal == std::string::npos ? "" : option.substr(equal + 1);
+                char* end = NULL;
+                long number = strtol(value.c_str(), &end, 10);
+                bool ok;
+
+                if (name == "deferred" || name == "reuseport")
+                    ok = equal == std::string::npos;
+                else if (name == "ipv6only")
+                    ok = value == "on" || value == "off";
+                else if (name == "backlog" || name == "fastopen")
+                    ok = !value.empty() && *end == '\0' && number > 0 && number <= 65535;
+                else if (name == "rcvbuf" || name == "sndbuf")
+                    ok = ServerConfig::parse_socket_size(value) > 0;
+                else
+                    ok = false;
+                if (!ok) {
+                    addError(ValidationError::ERROR, "invalid listen parameter \'" + option + "\'", 
                         getTokenLine(directive.name), "server");
                     valid = false;
-                    continue;
+                }
             }
-                std::string param = directive.parameters[0];
-                size_t colon_pos = param.find(':');
-            std::string port_str;
-            
-            if (colon_pos != std::string::npos) {
-                port_str = param.substr(colon_pos + 1);
-            } else {
-                port_str = param;
+            std::string host, port_str, unix_path;
+            if (!ServerConfig::split_listen(directive.parameters[0], host, port_str, unix_path)) {
+                addError(ValidationError::ERROR, "Invalid listen address: " + directive.parameters[0], 
+                        getTokenLine(directive.name), "server");
+                valid = false;
+                continue;
+            }
+            if (!unix_path.empty())
+                continue;
+            in6_addr address;
+            if (!host.empty() && inet_pton(AF_INET, host.c_str(), &address) != 1
+                && inet_pton(AF_INET6, host.c_str(), &address) != 1) {
+                addError(ValidationError::ERROR, "Invalid listen host: " + host, 
+                        getTokenLine(directive.name), "server");
+                valid = false;
             }
             const char* cstr = port_str.c_str();
             char* endptr;
             unsigned long port = strtoul(cstr, &endptr, 10);
-            if (*endptr != '\0' || port < 1 || port > 65535) {
+            if (port_str.empty() || *endptr != '\0' || port < 1 || port > 65535) {
                 addError(ValidationError::ERROR, "Invalid port number: " + port_str, 
                         getTokenLine(directive.name), "server");
                 valid = false;
@@ -515,6 +663,145 @@ bool ConfigParser::validate_server_block(const Block& server) {
                 valid = false;
             }
         }
+        else if (directive.name == "gzip") {
+            if (directive.parameters.size() != 1 || 
+                (directive.parameters[0] != "on" && directive.parameters[0] != "off")) {
+                addError(ValidationError::ERROR, "gzip directive requires 'on' or 'off'", 
+                        getTokenLine(directive.name), "server");
+                valid = false;
+            }
+        }
+        else if (directive.name == "gzip_comp_level") {
+            char* endptr = NULL;
+            long level = directive.parameters.size() == 1 ? strtol(directive.parameters[0].c_str(), &endptr, 10) : 0;
+            if (directive.parameters.size() != 1 || *endptr != '\0' || level < 1 || level > 9) {
+                addError(ValidationError::ERROR, "gzip_comp_level requires a level between 1 and 9", 
+                        getTokenLine(directive.name), "server");
+                valid = false;
+            }
+        }
+        else if (directive.name == "gzip_min_length") {
+            if (directive.parameters.size() != 1 || directive.parameters[0].empty() ||
+                directive.parameters[0].find_first_not_of("0123456789") != std::string::npos) {
+                addError(ValidationError::ERROR, "gzip_min_length requires a length in bytes", 
+                        getTokenLine(directive.name), "server");
+                valid = false;
+            }
+        }
+        else if (directive.name == "gzip_types") {
+            if (directive.parameters.empty()) {
+                addError(ValidationError::ERROR, "gzip_types directive requires at least one MIME type", 
+                        getTokenLine(directive.name), "server");
+                valid = false;
+            }
+        }
+        else if (directive.name == "tcp_nopush" || directive.name == "tcp_nodelay") {
+            if (directive.parameters.size() != 1 || 
+                (directive.parameters[0] != "on" && directive.parameters[0] != "off")) {
+                addError(ValidationError::ERROR, directive.name + " directive requires 'on' or 'off'", 
+                        getTokenLine(directive.name), "server");
+                valid = false;
+            }
+        }
+        else if (directive.name == "access_log") {
+            if (directive.parameters.empty() || (directive.parameters[0] == "off" && directive.parameters.size() != 1)) {
+                addError(ValidationError::ERROR, "access_log requires 'off' or a path, a format and options", 
+                        getTokenLine(directive.name), "server");
+                valid = false;
+                continue;
+            }
+            if (directive.parameters.size() > 1 && directive.parameters[1] != "combined"
+                && get_log_format(directive.parameters[1]).empty()) {
+                addError(ValidationError::ERROR, "access_log uses unknown log_format \"" + directive.parameters[1] + "\"", 
+                        getTokenLine(directive.name), "server");
+                valid = false;
+            }
+            for (size_t p = 2; p < directive.parameters.size(); ++p) {
+                const std::string& option = directive.parameters[p];
+                bool ok;
+
+                if (option.compare(0, 7, "buffer=") == 0)
+                    ok = ServerConfig::parse_socket_size(option.substr(7)) > 0;
+                else if (option.compare(0, 6, "flush=") == 0)
+                    ok = ServerConfig::parse_seconds(option.substr(6)) >= 0;
+                else
+                    ok = false;
+                if (!ok) {
+                    addError(ValidationError::ERROR, "invalid access_log parameter \'" + option + "\'", 
+                        getTokenLine(directive.name), "server");
+                    valid = false;
+                }
+            }
+        }
+        else if (directive.name == "slow_request_threshold") {
+            if (directive.parameters.size() != 1 || (directive.parameters[0] != "off"
+                && ServerConfig::parse_msec(directive.parameters[0]) <= 0)) {
+                addError(ValidationError::ERROR, "slow_request_threshold requires 'off' or a time like 500ms", 
+                        getTokenLine(directive.name), "server");
+                valid = false;
+            }
+        }
+        else if (directive.name == "limit_conn") {
+            char* endptr = NULL;
+            long connections = directive.parameters.size() == 1 ? strtol(directive.parameters[0].c_str(), &endptr, 10) : 0;
+            if (directive.parameters.size() != 1 || (directive.parameters[0] != "off"
+                && (*endptr != '\0' || connections < 1 || connections > 65535))) {
+                addError(ValidationError::ERROR, "limit_conn requires 'off' or a connection count", 
+                        getTokenLine(directive.name), "server");
+                valid = false;
+            }
+        }
+        else if (directive.name == "limit_req") {
+            if (directive.parameters.empty() || (directive.parameters[0] == "off" && directive.parameters.size() != 1)) {
+                addError(ValidationError::ERROR, "limit_req requires 'off' or rate=Nr/s [burst=N]", 
+                        getTokenLine(directive.name), "server");
+                valid = false;
+                continue;
+            }
+            bool has_rate = directive.parameters[0] == "off";
+            for (size_t p = 0; p < directive.parameters.size() && directive.parameters[0] != "off"; ++p) {
+                const std::string& option = directive.parameters[p];
+                char* endptr = NULL;
+                bool ok;
+
+                if (option.compare(0, 5, "rate=") == 0)
+                    ok = has_rate = ServerConfig::parse_rate(option.substr(5)) > 0;
+                else if (option.compare(0, 6, "burst=") == 0) {
+                    long burst = strtol(option.c_str() + 6, &endptr, 10);
+                    ok = option.size() > 6 && *endptr == '\0' && burst >= 0 && burst <= 65535;
+                }
+                else
+                    ok = false;
+                if (!ok) {
+                    addError(ValidationError::ERROR, "invalid limit_req parameter \'" + option + "\'", 
+                        getTokenLine(directive.name), "server");
+                    valid = false;
+                }
+            }
+            if (!has_rate) {
+                addError(ValidationError::ERROR, "limit_req requires a rate=Nr/s or rate=Nr/m parameter", 
+                        getTokenLine(directive.name), "server");
+                valid = false;
+            }
+        }
+        else if (directive.name == "limit_conn_status" || directive.name == "limit_req_status") {
+            char* endptr = NULL;
+            long code = directive.parameters.size() == 1 ? strtol(directive.parameters[0].c_str(), &endptr, 10) : 0;
+            if (directive.parameters.size() != 1 || *endptr != '\0' || code < 400 || code > 599) {
+                addError(ValidationError::ERROR, directive.name + " requires a status code between 400 and 599", 
+                        getTokenLine(directive.name), "server");
+                valid = false;
+            }
+        }
+        else if (directive.name == "accept_batch") {
+            char* endptr = NULL;
+            long batch = directive.parameters.size() == 1 ? strtol(directive.parameters[0].c_str(), &endptr, 10) : 0;
+            if (directive.parameters.size() != 1 || *endptr != '\0' || batch < 1 || batch > 1024) {
+                addError(ValidationError::ERROR, "accept_batch requires a count between 1 and 1024", 
+                        getTokenLine(directive.name), "server");
+                valid = false;
+            }
+        }
     }
     
     if (!has_listen) {
@@ -538,6 +825,13 @@ bool ConfigParser::validate_location_block(const Block& location) {
     ALLOWED_DIRECTIVES.push_back("cgi_path");
     ALLOWED_DIRECTIVES.push_back("upload_store");
     ALLOWED_DIRECTIVES.push_back("alias");
+    ALLOWED_DIRECTIVES.push_back("gzip_static");
+    ALLOWED_DIRECTIVES.push_back("autoindex_format");
+    ALLOWED_DIRECTIVES.push_back("brotli_static");
+    ALLOWED_DIRECTIVES.push_back("metrics");
+    ALLOWED_DIRECTIVES.push_back("stub_status");
+    ALLOWED_DIRECTIVES.push_back("allow");
+    ALLOWED_DIRECTIVES.push_back("deny");
     
     bool valid = true;
     
@@ -567,6 +861,23 @@ bool ConfigParser::validate_location_block(const Block& location) {
                 valid = false;
             }
         }
+        else if (directive.name == "gzip_static" || directive.name == "brotli_static" || directive.name == "metrics"
+                 || directive.name == "stub_status") {
+            if (directive.parameters.size() != 1 || 
+                (directive.parameters[0] != "on" && directive.parameters[0] != "off")) {
+                addError(ValidationError::ERROR, directive.name + " directive requires 'on' or 'off'", 
+                        getTokenLine(directive.name), "location");
+                valid = false;
+            }
+        }
+        else if (directive.name == "autoindex_format") {
+            if (directive.parameters.size() != 1 || 
+                (directive.parameters[0] != "html" && directive.parameters[0] != "json" && directive.parameters[0] != "xml")) {
+                addError(ValidationError::ERROR, "autoindex_format directive requires 'html', 'json' or 'xml'", 
+                        getTokenLine(directive.name), "location");
+                valid = false;
+            }
+        }
         else if (directive.name == "index") {
             if (directive.parameters.empty()) {
                 addError(ValidationError::ERROR, "index directive requires at least one parameter", 
@@ -584,7 +895,7 @@ bool ConfigParser::validate_location_block(const Block& location) {
             for (size_t j = 0; j < directive.parameters.size(); ++j) {
                 const std::string& method = directive.parameters[j];
                 if (method != "GET" && method != "POST" && method != "DELETE" && 
-                    method != "PUT" && method != "HEAD") {
+                    method != "PUT" && method != "HEAD" && method != "PATCH") {
                     addError(ValidationError::ERROR, "invalid HTTP method in allow_methods: " + method, 
                             getTokenLine(directive.name), "location");
                     valid = false;
@@ -674,6 +985,14 @@ bool ConfigParser::validate_location_block(const Block& location) {
                 valid = false;
             }
         }
+        else if (directive.name == "allow" || directive.name == "deny") {
+            AccessRule rule;
+            if (!Location::parse_access_rule(directive, rule)) {
+                addError(ValidationError::ERROR, directive.name + " requires one address, address/bits, unix: or all", 
+                        getTokenLine(directive.name), "location");
+                valid = false;
+            }
+        }
     }
     
     return valid;
@@ -690,16 +1009,18 @@ std::vector<ServerConfig> ConfigParser::create_servers() {
             
             if (directive.name == "listen") {
                 if (!directive.parameters.empty()) {
-                    std::string param = directive.parameters[0];
-                    size_t colon_pos = param.find(':');
+                    std::string host, port, unix_path;
+                    ServerConfig::split_listen(directive.parameters[0], host, port, unix_path);
                     
-                    if (colon_pos != std::string::npos) {
-                        std::string host = param.substr(0, colon_pos);
-                        std::string port = param.substr(colon_pos + 1);
-                        server.set_host(host);
-                        server.set_port(port);
+                    if (!unix_path.empty()) {
+                        server.set_unix_path(unix_path);
                     } else {
-                        server.set_port(param);
+                        if (!host.empty())
+                            server.set_host(host);
+                        server.set_port(port);
+                    }
+                    for (size_t p = 1; p < directive.parameters.size(); ++p) {
+                        server.set_listen_option(directive.parameters[p]);
                     }
                 }
             }
@@ -733,6 +1054,62 @@ std::vector<ServerConfig> ConfigParser::create_servers() {
                     server.set_client_max_body_size(directive.parameters[0]);
                 }
             }
+            else if (directive.name == "gzip") {
+                if (!directive.parameters.empty()) {
+                    server.set_gzip(directive.parameters[0]);
+                }
+            }
+            else if (directive.name == "gzip_comp_level") {
+                if (!directive.parameters.empty()) {
+                    server.set_gzip_comp_level(directive.parameters[0]);
+                }
+            }
+            else if (directive.name == "gzip_min_length") {
+                if (!directive.parameters.empty()) {
+                    server.set_gzip_min_length(directive.parameters[0]);
+                }
+            }
+            else if (directive.name == "gzip_types") {
+                if (!directive.parameters.empty()) {
+                    server.set_gzip_types(directive.parameters);
+                }
+            }
+            else if (directive.name == "accept_batch") {
+                if (!directive.parameters.empty()) {
+                    server.set_accept_batch(directive.parameters[0]);
+                }
+            }
+            else if (directive.name == "tcp_nopush") {
+                if (!directive.parameters.empty()) {
+                    server.set_tcp_nopush(directive.parameters[0]);
+                }
+            }
+            else if (directive.name == "tcp_nodelay") {
+                if (!directive.parameters.empty()) {
+                    server.set_tcp_nodelay(directive.parameters[0]);
+                }
+            }
+            else if (directive.name == "access_log") {
+                server.set_access_log(directive.parameters);
+            }
+            else if (directive.name == "slow_request_threshold") {
+                if (!directive.parameters.empty()) {
+                    server.set_slow_request_threshold(directive.parameters[0]);
+                }
+            }
+            else if (directive.name == "limit_conn") {
+                if (!directive.parameters.empty()) {
+                    server.set_limit_conn(directive.parameters[0]);
+                }
+            }
+            else if (directive.name == "limit_req") {
+                server.set_limit_req(directive.parameters);
+            }
+            else if (directive.name == "limit_conn_status" || directive.name == "limit_req_status") {
+                if (!directive.parameters.empty()) {
+                    server.set_limit_status(directive.name, directive.parameters[0]);
+                }
+            }
             else if (directive.name == "error_page") {
                 if (directive.parameters.size() >= 2) {
                     std::vector<std::string> error_codes(directive.parameters.begin(), 
@@ -1,6 +1,10 @@
 #include "config/Location.hpp"
 #include "config/Block.hpp"
+#include "Logger.hpp"
 #include <cstdlib>
+#include <cstring>
+#include <sys/socket.h>
+#include <arpa/inet.h>
 
 Location::Location() {
     this->_path = "";
@@ -9,6 +13,11 @@ Location::Location() {
     this->_autoindex = false;
     this->_alias = "";
     this->_client_max_body_size = 0;
+    this->_gzip_static = false;
+    this->_brotli_static = false;
+    this->_autoindex_format = "html";
+    this->_metrics = false;
+    this->_stub_status = false;
     this->_cgi_ext.clear();
     this->_cgi_path.clear();
 }
@@ -23,6 +32,12 @@ Location::Location(const Location &other) {
     this->_return = other._return;
     this->_alias = other._alias;
     this->_client_max_body_size = other._client_max_body_size;
+    this->_gzip_static = other._gzip_static;
+    this->_brotli_static = other._brotli_static;
+    this->_autoindex_format = other._autoindex_format;
+    this->_metrics = other._metrics;
+    this->_stub_status = other._stub_status;
+    this->_access = other._access;
     this->_cgi_ext = other._cgi_ext;
     this->_cgi_path = other._cgi_path;
 }
@@ -34,6 +49,11 @@ Location::Location(const Block &location) {
     this->_autoindex = false;
     this->_alias = "";
     this->_client_max_body_size = 0;
+    this->_gzip_static = false;
+    this->_brotli_static = false;
+    this->_autoindex_format = "html";
+    this->_metrics = false;
+    this->_stub_status = false;
     this->_cgi_ext.clear();
     this->_cgi_path.clear();
 
@@ -82,6 +102,26 @@ Location::Location(const Block &location) {
         else if (directive.name == "cgi_path") {
             this->_cgi_path = directive.parameters;
         }
+        else if (directive.name == "gzip_static" && !directive.parameters.empty()) {
+            this->_gzip_static = (directive.parameters[0] == "on");
+        }
+        else if (directive.name == "brotli_static" && !directive.parameters.empty()) {
+            this->_brotli_static = (directive.parameters[0] == "on");
+        }
+        else if (directive.name == "autoindex_format" && !directive.parameters.empty()) {
+            this->_autoindex_format = directive.parameters[0];
+        }
+        else if (directive.name == "metrics" && !directive.parameters.empty()) {
+            this->_metrics = (directive.parameters[0] == "on");
+        }
+        else if (directive.name == "stub_status" && !directive.parameters.empty()) {
+            this->_stub_status = (directive.parameters[0] == "on");
+        }
+        else if (directive.name == "allow" || directive.name == "deny") {
+            AccessRule rule;
+            if (parse_access_rule(directive, rule))
+                this->_access.push_back(rule);
+        }
     }
 }
 
@@ -89,12 +129,19 @@ Location &Location::operator=(const Location &other) {
     if (this != &other) {
         this->_path = other._path;
         this->_root = other._root;
+        this->_upload_store = other._upload_store;
         this->_autoindex = other._autoindex;
         this->_index = other._index;
         this->_allow_methods = other._allow_methods;
         this->_return = other._return;
         this->_alias = other._alias;
         this->_client_max_body_size = other._client_max_body_size;
+        this->_gzip_static = other._gzip_static;
+        this->_brotli_static = other._brotli_static;
+    this->_autoindex_format = other._autoindex_format;
+        this->_metrics = other._metrics;
+        this->_stub_status = other._stub_status;
+        this->_access = other._access;
         this->_cgi_ext = other._cgi_ext;
         this->_cgi_path = other._cgi_path;
     }
@@ -119,6 +166,26 @@ void Location::set_uploadStore(std::string upload){
 	this->_upload_store = upload;
 }
 
+void Location::set_autoindexFormat(std::string format){
+    this->_autoindex_format = format;
+}
+
+void Location::set_gzipStatic(bool gzip_static){
+    this->_gzip_static = gzip_static;
+}
+
+void Location::set_brotliStatic(bool brotli_static){
+    this->_brotli_static = brotli_static;
+}
+
+void Location::set_metrics(bool metrics){
+    this->_metrics = metrics;
+}
+
+void Location::set_stubStatus(bool stub_status){
+    this->_stub_status = stub_status;
+}
+
 void Location::set_autoindex(bool new_auto_index){
     if (new_auto_index)
         this->_autoindex = true;
@@ -151,7 +218,7 @@ void Location::set_allowMethods(const std::vector<std::string> &methods) {
     this->_allow_methods.clear();
     for (size_t i = 0; i < methods.size(); ++i) {
         std::string method = methods[i];
-        if (method == "GET" || method == "POST" || method == "DELETE" || method == "PUT" || method == "HEAD") {
+        if (method == "GET" || method == "POST" || method == "DELETE" || method == "PUT" || method == "HEAD" || method == "PATCH") {
             this->_allow_methods.push_back(method);
         } else {
             std::cerr << "config error: set_allowMethods [" << method << "] is not a valid HTTP method" << std::endl;
@@ -166,21 +233,76 @@ bool Location::is_method_allowed(const std::string& method) const {
     if (_allow_methods.empty()) {
         return (method == "GET" || method == "HEAD");
     }
-    std::cout << "Trying to find this method >>>>>>>> " << method << std::endl;
-    for(std::vector<std::string>::const_iterator it = _allow_methods.begin(); it != _allow_methods.end(); ++it) {
-        if (*it == method) {
-            std::cout << *it << " Found" << std::endl;
-        }
-        std::cout << *it << std::endl;
-
-    }
     bool find = std::find(_allow_methods.begin(), _allow_methods.end(), method) 
            != _allow_methods.end();
-    std::string str = find ? "": "Not";
-    std::cout <<  find<< str << " -> Found" << std::endl;
+    LOG_DEBUG("Method " << method << (find ? " allowed" : " not allowed") << " in location " << _path);
     return find;
 }
 
+// allow|deny address, address/bits, unix: or all; false for anything else
+bool Location::parse_access_rule(const Directive& directive, AccessRule &rule) {
+    memset(&rule, 0, sizeof(rule));
+    rule.allow = (directive.name == "allow");
+    if (directive.parameters.size() != 1)
+        return false;
+    std::string param = directive.parameters[0];
+    if (param == "all") {
+        rule.family = AF_UNSPEC;
+        return true;
+    }
+    if (param == "unix:") {
+        rule.family = AF_UNIX;
+        return true;
+    }
+
+    std::string::size_type slash = param.find('/');
+    std::string address = param.substr(0, slash);
+    rule.family = address.find(':') != std::string::npos ? AF_INET6 : AF_INET;
+    int max_bits = rule.family == AF_INET6 ? 128 : 32;
+    if (inet_pton(rule.family, address.c_str(), rule.address) != 1)
+        return false;
+    rule.bits = max_bits;
+    if (slash != std::string::npos) {
+        const char* cstr = param.c_str() + slash + 1;
+        char* endptr;
+        long bits = strtol(cstr, &endptr, 10);
+        if (*cstr == '\0' || *endptr != '\0' || bits < 0 || bits > max_bits)
+            return false;
+        rule.bits = bits;
+    }
+    return true;
+}
+
+// address is the client's as in ClientConnection::ipAddress, IPv4-mapped clients already plain IPv4
+bool Location::is_address_allowed(const std::string& address) const {
+    if (_access.empty())
+        return true;
+
+    unsigned char bytes[16];
+    int family = AF_UNIX;
+    if (address != "unix:")
+        family = address.find(':') != std::string::npos ? AF_INET6 : AF_INET;
+    if (family != AF_UNIX && inet_pton(family, address.c_str(), bytes) != 1)
+        return false;
+
+    for (size_t i = 0; i < _access.size(); ++i) {
+        const AccessRule &rule = _access[i];
+        if (rule.family != AF_UNSPEC) {
+            if (rule.family != family)
+                continue;
+            int whole = rule.bits / 8;
+            int rest = rule.bits % 8;
+            if (memcmp(rule.address, bytes, whole) != 0)
+                continue;
+            if (rest && ((rule.address[whole] ^ bytes[whole]) & (0xFF << (8 - rest))))
+                continue;
+        }
+        LOG_DEBUG("Address " << address << (rule.allow ? " allowed" : " denied") << " in location " << _path);
+        return rule.allow;
+    }
+    return true;
+}
+
 void Location::set_return(const std::vector<std::string> &new_return){
     if (new_return.size() < 2) {
         std::cerr << "config error: set_return requires at least two parameters" << std::endl;
@@ -285,6 +407,26 @@ std::vector<std::string>	Location::get_cgiExt() const {
 unsigned long Location::get_clientMaxBodySize() const {
 	return this->_client_max_body_size;
 }
+
+std::string Location::get_autoindexFormat() const {
+	return this->_autoindex_format;
+}
+
+bool Location::get_gzipStatic() const {
+	return this->_gzip_static;
+}
+
+bool Location::get_brotliStatic() const {
+	return this->_brotli_static;
+}
+
+bool Location::get_metrics() const {
+	return this->_metrics;
+}
+
+bool Location::get_stubStatus() const {
+	return this->_stub_status;
+}
 void Location::print_location_config() const {
     std::cout << "Location Config:" << std::endl;
     std::cout << "  Path: " << this->_path << std::endl;
@@ -298,6 +440,11 @@ void Location::print_location_config() const {
     }
     std::cout << std::endl;
     std::cout << "Autoindex: " << (this->_autoindex ? "on" : "off") << std::endl;
+    std::cout << "Gzip static: " << (this->_gzip_static ? "on" : "off") << std::endl;
+    std::cout << "Autoindex format: " << this->_autoindex_format << std::endl;
+    std::cout << "Brotli static: " << (this->_brotli_static ? "on" : "off") << std::endl;
+    std::cout << "Metrics: " << (this->_metrics ? "on" : "off") << std::endl;
+    std::cout << "Stub status: " << (this->_stub_status ? "on" : "off") << std::endl;
     std::cout << "  Allow Methods: ";
     for (size_t i = 0; i < this->_allow_methods.size(); ++i) {
         const std::string &method = this->_allow_methods[i];
@@ -369,6 +516,12 @@ bool Location::operator==(const Location &rhs) const {
             this->_return == rhs._return &&
             this->_alias == rhs._alias &&
             this->_client_max_body_size == rhs._client_max_body_size &&
+            this->_gzip_static == rhs._gzip_static &&
+            this->_autoindex_format == rhs._autoindex_format &&
+            this->_brotli_static == rhs._brotli_static &&
+            this->_metrics == rhs._metrics &&
+            this->_stub_status == rhs._stub_status &&
+            this->_access == rhs._access &&
             this->_cgi_ext == rhs._cgi_ext &&
             this->_cgi_path == rhs._cgi_path);
 }
\ No newline at end of file
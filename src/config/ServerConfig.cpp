@@ -1,5 +1,8 @@
 #include "config/ServerConfig.hpp"
 #include "config/Location.hpp"
+#include "Logger.hpp"
+#include <sstream>
+#include <sys/un.h>
 
 ServerConfig::ServerConfig() {
     this->_port = 0;
@@ -11,6 +14,15 @@ ServerConfig::ServerConfig() {
     this->_index.clear();
     this->_error_pages.clear();
     this->_locations.clear();
+    this->_gzip = false;
+    this->_gzip_comp_level = 1;
+    this->_gzip_min_length = 20;
+    this->_gzip_types.clear();
+    this->_gzip_types.push_back("text/html");
+    this->_accept_batch = 64;
+    this->_tcp_nopush = true;
+    this->_tcp_nodelay = true;
+    this->_slow_request_threshold = 0;
 
     
     initializeDefaultErrorPages();
@@ -32,6 +44,7 @@ ServerConfig::ServerConfig(const ServerConfig &other){
     if (this != &other){
         this->_port = other._port;
         this->_host = other._host;
+        this->_unix_path = other._unix_path;
         this->_server_name = other._server_name;
         this->_root = other._root;
         this->_client_max_body_size = other._client_max_body_size;
@@ -39,6 +52,17 @@ ServerConfig::ServerConfig(const ServerConfig &other){
         this->_autoindex = other._autoindex;
         this->_error_pages = other._error_pages;
         this->_locations = other._locations;
+        this->_gzip = other._gzip;
+        this->_gzip_comp_level = other._gzip_comp_level;
+        this->_gzip_min_length = other._gzip_min_length;
+        this->_gzip_types = other._gzip_types;
+        this->_accept_batch = other._accept_batch;
+        this->_listen_options = other._listen_options;
+        this->_tcp_nopush = other._tcp_nopush;
+        this->_tcp_nodelay = other._tcp_nodelay;
+        this->_access_log = other._access_log;
+        this->_slow_request_threshold = other._slow_request_threshold;
+        this->_limits = other._limits;
     }
 }
 
@@ -46,6 +70,7 @@ ServerConfig& ServerConfig::operator=(const ServerConfig &other){
     if (this != &other){
         this->_port = other._port;
         this->_host = other._host;
+        this->_unix_path = other._unix_path;
         this->_server_name = other._server_name;
         this->_root = other._root;
         this->_client_max_body_size = other._client_max_body_size;
@@ -53,6 +78,17 @@ ServerConfig& ServerConfig::operator=(const ServerConfig &other){
         this->_autoindex = other._autoindex;
         this->_error_pages = other._error_pages;
         this->_locations = other._locations;
+        this->_gzip = other._gzip;
+        this->_gzip_comp_level = other._gzip_comp_level;
+        this->_gzip_min_length = other._gzip_min_length;
+        this->_gzip_types = other._gzip_types;
+        this->_accept_batch = other._accept_batch;
+        this->_listen_options = other._listen_options;
+        this->_tcp_nopush = other._tcp_nopush;
+        this->_tcp_nodelay = other._tcp_nodelay;
+        this->_access_log = other._access_log;
+        this->_slow_request_threshold = other._slow_request_threshold;
+        this->_limits = other._limits;
     }
     return (*this);
 }
@@ -70,6 +106,23 @@ std::string					ServerConfig::get_host() const {
     return this->_host;
 }
 
+const std::string&				ServerConfig::get_unix_path() const {
+    return this->_unix_path;
+}
+
+// As it would be written in a URL, for the logs
+std::string						ServerConfig::get_listen_address() const {
+    if (!this->_unix_path.empty())
+        return "unix:" + this->_unix_path;
+    std::ostringstream address;
+    if (this->_host.find(':') != std::string::npos)
+        address << "[" << this->_host << "]";
+    else
+        address << this->_host;
+    address << ":" << this->_port;
+    return address.str();
+}
+
 std::string						ServerConfig::get_server_name() const {
     return this->_server_name;
 }
@@ -100,6 +153,22 @@ std::vector<Location> 			ServerConfig::get_locations() const {
     return this->_locations;
 }
 
+bool							ServerConfig::get_gzip() const {
+    return this->_gzip;
+}
+
+int								ServerConfig::get_gzip_comp_level() const {
+    return this->_gzip_comp_level;
+}
+
+size_t							ServerConfig::get_gzip_min_length() const {
+    return this->_gzip_min_length;
+}
+
+const std::vector<std::string>	&ServerConfig::get_gzip_types() const {
+    return this->_gzip_types;
+}
+
 
 void ServerConfig::set_port(std::string param){
     const char* cstr = param.c_str();
@@ -113,12 +182,49 @@ void ServerConfig::set_port(std::string param){
 }
 
 void ServerConfig::set_host(std::string param){
-    in_addr_t host = inet_addr(param.c_str());
-    if (host == INADDR_NONE)
+    in6_addr address;
+    if (inet_pton(AF_INET, param.c_str(), &address) != 1 && inet_pton(AF_INET6, param.c_str(), &address) != 1)
         std::cerr << "Error: Invalid IP address format" << std::endl;
     _host = param;
 }
 
+void ServerConfig::set_unix_path(std::string param){
+    this->_unix_path = param;
+}
+
+/*
+    Splits the address of a listen directive: "8080", "127.0.0.1:8080",
+    "[::]:8080" (IPv6 needs the brackets) or "unix:/run/web.sock". host
+    stays empty when only a port is given.
+*/
+bool ServerConfig::split_listen(const std::string& param, std::string& host, std::string& port, std::string& unix_path){
+    host.clear();
+    port.clear();
+    unix_path.clear();
+    if (param.compare(0, 5, "unix:") == 0) {
+        unix_path = param.substr(5);
+        return !unix_path.empty() && unix_path.size() < sizeof(((sockaddr_un *)0)->sun_path);
+    }
+    if (!param.empty() && param[0] == '[') {
+        size_t close = param.find(']');
+        if (close == std::string::npos || close + 1 >= param.size() || param[close + 1] != ':')
+            return false;
+        host = param.substr(1, close - 1);
+        port = param.substr(close + 2);
+        return true;
+    }
+    size_t colon = param.find(':');
+    if (colon == std::string::npos) {
+        port = param;
+        return true;
+    }
+    if (param.find(':', colon + 1) != std::string::npos)
+        return false;
+    host = param.substr(0, colon);
+    port = param.substr(colon + 1);
+    return true;
+}
+
 void ServerConfig::set_server_name(std::string param){
     this->_server_name = param;
 }
@@ -192,6 +298,256 @@ void ServerConfig::set_autoindex(std::string index){
 }
 
 
+void ServerConfig::set_gzip(std::string param){
+    if (param == "on" || param == "off")
+		this->_gzip = (param == "on");
+	else
+		std::cout << "config error: set_gzip [" << param << "]" << std::endl;
+}
+
+void ServerConfig::set_gzip_comp_level(std::string param){
+    int level = atoi(param.c_str());
+    if (level < 1 || level > 9) {
+		std::cout << "config error: set_gzip_comp_level [" << param << "]" << std::endl;
+		return;
+	}
+    this->_gzip_comp_level = level;
+}
+
+int								ServerConfig::get_accept_batch() const {
+    return this->_accept_batch;
+}
+
+void ServerConfig::set_accept_batch(std::string param){
+    int batch = atoi(param.c_str());
+    if (batch < 1 || batch > 1024) {
+		std::cout << "config error: set_accept_batch [" << param << "]" << std::endl;
+		return;
+	}
+    this->_accept_batch = batch;
+}
+
+const ListenOptions&			ServerConfig::get_listen_options() const {
+    return this->_listen_options;
+}
+
+bool							ServerConfig::get_tcp_nopush() const {
+    return this->_tcp_nopush;
+}
+
+bool							ServerConfig::get_tcp_nodelay() const {
+    return this->_tcp_nodelay;
+}
+
+const AccessLogOptions&			ServerConfig::get_access_log() const {
+    return this->_access_log;
+}
+
+int								ServerConfig::get_slow_request_threshold() const {
+    return this->_slow_request_threshold;
+}
+
+const LimitOptions&				ServerConfig::get_limits() const {
+    return this->_limits;
+}
+
+// 4096, 64k, 1m; -1 when malformed
+int ServerConfig::parse_socket_size(const std::string& param){
+    char* endptr = NULL;
+    long size = strtol(param.c_str(), &endptr, 10);
+    if (endptr == param.c_str() || size <= 0)
+        return -1;
+    if (*endptr == 'k' || *endptr == 'K') {
+        size *= 1024;
+        ++endptr;
+    }
+    else if (*endptr == 'm' || *endptr == 'M') {
+        size *= 1024 * 1024;
+        ++endptr;
+    }
+    if (*endptr != '\0' || size > 0x7fffffff)
+        return -1;
+    return size;
+}
+
+// 30, 30s, 5m, 1h; -1 when malformed
+int ServerConfig::parse_seconds(const std::string& param){
+    char* endptr = NULL;
+    long seconds = strtol(param.c_str(), &endptr, 10);
+    if (endptr == param.c_str() || seconds < 0)
+        return -1;
+    if (*endptr == 'm')
+        seconds *= 60;
+    else if (*endptr == 'h')
+        seconds *= 3600;
+    if (*endptr == 's' || *endptr == 'm' || *endptr == 'h')
+        ++endptr;
+    if (*endptr != '\0' || seconds > 86400)
+        return -1;
+    return seconds;
+}
+
+// 250ms, 2s, 1m, a bare number is seconds; -1 when malformed
+int ServerConfig::parse_msec(const std::string& param){
+    char* endptr = NULL;
+    long msec = strtol(param.c_str(), &endptr, 10);
+    if (endptr == param.c_str() || msec < 0)
+        return -1;
+    if (strcmp(endptr, "ms") == 0)
+        endptr += 2;
+    else {
+        if (*endptr == 'm')
+            msec *= 60;
+        if (*endptr == 's' || *endptr == 'm')
+            ++endptr;
+        msec *= 1000;
+    }
+    if (*endptr != '\0' || msec > 3600000)
+        return -1;
+    return msec;
+}
+
+// limit_req rate: Nr/s or Nr/m, in requests per second; -1 when malformed
+double ServerConfig::parse_rate(const std::string& param){
+    char* endptr = NULL;
+    long requests = strtol(param.c_str(), &endptr, 10);
+    if (endptr == param.c_str() || requests <= 0 || requests > 1000000)
+        return -1;
+    if (strcmp(endptr, "r/s") == 0)
+        return requests;
+    if (strcmp(endptr, "r/m") == 0)
+        return requests / 60.0;
+    return -1;
+}
+
+// One "name" or "name=value" parameter of listen after the address
+void ServerConfig::set_listen_option(std::string param){
+    size_t equal = param.find('=');
+    std::string name = param.substr(0, equal);
+    std::string value = equal == std::string::npos ? "" : param.substr(equal + 1);
+
+    if (name == "deferred" && value.empty())
+        this->_listen_options.deferred = true;
+    else if (name == "reuseport" && value.empty())
+        this->_listen_options.reuseport = true;
+    else if (name == "ipv6only" && (value == "on" || value == "off"))
+        this->_listen_options.ipv6only = (value == "on");
+    else if (name == "backlog" && atoi(value.c_str()) > 0)
+        this->_listen_options.backlog = atoi(value.c_str());
+    else if (name == "fastopen" && atoi(value.c_str()) > 0)
+        this->_listen_options.fastopen = atoi(value.c_str());
+    else if (name == "rcvbuf" && parse_socket_size(value) > 0)
+        this->_listen_options.rcvbuf = parse_socket_size(value);
+    else if (name == "sndbuf" && parse_socket_size(value) > 0)
+        this->_listen_options.sndbuf = parse_socket_size(value);
+    else
+        std::cout << "config error: set_listen_option [" << param << "]" << std::endl;
+}
+
+void ServerConfig::set_tcp_nopush(std::string param){
+    this->_tcp_nopush = (param == "on");
+}
+
+void ServerConfig::set_tcp_nodelay(std::string param){
+    this->_tcp_nodelay = (param == "on");
+}
+
+// access_log off | path [format [buffer=size] [flush=time]]
+void ServerConfig::set_access_log(const std::vector<std::string>& params){
+    this->_access_log = AccessLogOptions();
+    if (params.empty() || params[0] == "off")
+        return;
+    this->_access_log.path = params[0];
+    if (params.size() > 1)
+        this->_access_log.format = params[1];
+    for (size_t i = 2; i < params.size(); ++i) {
+        if (params[i].compare(0, 7, "buffer=") == 0 && parse_socket_size(params[i].substr(7)) > 0)
+            this->_access_log.buffer = parse_socket_size(params[i].substr(7));
+        else if (params[i].compare(0, 6, "flush=") == 0 && parse_seconds(params[i].substr(6)) >= 0)
+            this->_access_log.flush = parse_seconds(params[i].substr(6));
+        else
+            std::cout << "config error: set_access_log [" << params[i] << "]" << std::endl;
+    }
+}
+
+// slow_request_threshold off | time
+void ServerConfig::set_slow_request_threshold(std::string param){
+    if (param == "off") {
+        this->_slow_request_threshold = 0;
+        return;
+    }
+    int msec = parse_msec(param);
+    if (msec <= 0) {
+        std::cout << "config error: set_slow_request_threshold [" << param << "]" << std::endl;
+        return;
+    }
+    this->_slow_request_threshold = msec;
+}
+
+// limit_conn off | number
+void ServerConfig::set_limit_conn(std::string param){
+    char* endptr = NULL;
+    long connections = strtol(param.c_str(), &endptr, 10);
+
+    if (param == "off") {
+        this->_limits.connections = 0;
+        return;
+    }
+    if (param.empty() || *endptr != '\0' || connections < 1 || connections > 65535) {
+        std::cout << "config error: set_limit_conn [" << param << "]" << std::endl;
+        return;
+    }
+    this->_limits.connections = connections;
+}
+
+// limit_req off | rate=Nr/s [burst=N]
+void ServerConfig::set_limit_req(const std::vector<std::string>& params){
+    this->_limits.rate = 0;
+    this->_limits.burst = 0;
+    if (params.empty() || params[0] == "off")
+        return;
+    for (size_t i = 0; i < params.size(); ++i) {
+        char* endptr = NULL;
+        long burst = params[i].compare(0, 6, "burst=") == 0 ? strtol(params[i].c_str() + 6, &endptr, 10) : -1;
+
+        if (params[i].compare(0, 5, "rate=") == 0 && parse_rate(params[i].substr(5)) > 0)
+            this->_limits.rate = parse_rate(params[i].substr(5));
+        else if (burst >= 0 && burst <= 65535 && params[i].size() > 6 && *endptr == '\0')
+            this->_limits.burst = burst;
+        else
+            std::cout << "config error: set_limit_req [" << params[i] << "]" << std::endl;
+    }
+}
+
+// limit_conn_status / limit_req_status code, a 4xx or 5xx
+void ServerConfig::set_limit_status(const std::string& directive, std::string param){
+    char* endptr = NULL;
+    long code = strtol(param.c_str(), &endptr, 10);
+
+    if (param.empty() || *endptr != '\0' || code < 400 || code > 599) {
+        std::cout << "config error: set_" << directive << " [" << param << "]" << std::endl;
+        return;
+    }
+    if (directive == "limit_conn_status")
+        this->_limits.conn_status = code;
+    else
+        this->_limits.req_status = code;
+}
+
+void ServerConfig::set_gzip_min_length(std::string param){
+    this->_gzip_min_length = strtoul(param.c_str(), NULL, 10);
+}
+
+// text/html is always compressed, like nginx
+void ServerConfig::set_gzip_types(std::vector<std::string> param){
+    this->_gzip_types.clear();
+    this->_gzip_types.push_back("text/html");
+    for (size_t i = 0; i < param.size(); ++i) {
+        if (param[i] != "text/html")
+            this->_gzip_types.push_back(param[i]);
+    }
+}
+
 void ServerConfig::set_error_pages(const std::vector<std::string>& error_codes, const std::string& error_page) {
     if (error_codes.empty()) {
         std::cerr << "Error: No error codes provided" << std::endl;
@@ -220,7 +576,7 @@ const Location *ServerConfig::findMatchingLocation(const std::string &path) cons
 {
     const Location *default_location = NULL;
     
-    std::cout << "[DEBUG] Searching for matching location for path: " << path << std::endl;
+    LOG_DEBUG("Searching for matching location for path: " << path);
     std::string tmp_path;
 
     tmp_path = path;
@@ -230,7 +586,7 @@ const Location *ServerConfig::findMatchingLocation(const std::string &path) cons
     }
     for (size_t i = 0; i < this->_locations.size(); i++)
     {
-        std::cout << "[DEBUG] Checking location: " << this->_locations[i].get_path() << std::endl << std::endl;
+        LOG_DEBUG("Checking location: " << this->_locations[i].get_path());
         if (!this->_locations[i].get_path().empty() && this->_locations[i].get_path() == tmp_path)
             return &this->_locations[i];
         if (this->_locations[i].get_path() == "/")
@@ -245,6 +601,8 @@ void ServerConfig::print_server_config() const {
     std::cout << "Server Config:" << std::endl;
     std::cout << "  Port: " << this->_port << std::endl;
     std::cout << "  Host: " << this->_host << std::endl;
+    if (!this->_unix_path.empty())
+        std::cout << "  Unix Socket: " << this->_unix_path << std::endl;
     std::cout << "  Server Name: " << this->_server_name << std::endl;
     std::cout << "  Root: " << this->_root << std::endl;
     std::cout << "  Client Max Body Size: " << this->_client_max_body_size << " bytes" << std::endl;
@@ -261,6 +619,29 @@ void ServerConfig::print_server_config() const {
         std::cout << std::endl;
     }
     std::cout << "  Autoindex: " << (this->_autoindex ? "on" : "off") << std::endl;
+    std::cout << "  Gzip: " << (this->_gzip ? "on" : "off") << " (level " << this->_gzip_comp_level
+              << ", min length " << this->_gzip_min_length << ")" << std::endl;
+    std::cout << "  Accept Batch: " << this->_accept_batch << std::endl;
+    std::cout << "  Listen: backlog " << this->_listen_options.backlog
+              << (this->_listen_options.deferred ? ", deferred" : "")
+              << (this->_listen_options.reuseport ? ", reuseport" : "")
+              << (this->_listen_options.ipv6only ? ", ipv6only" : "")
+              << ", fastopen " << this->_listen_options.fastopen
+              << ", rcvbuf " << this->_listen_options.rcvbuf << ", sndbuf " << this->_listen_options.sndbuf << std::endl;
+    std::cout << "  TCP: nopush " << (this->_tcp_nopush ? "on" : "off")
+              << ", nodelay " << (this->_tcp_nodelay ? "on" : "off") << std::endl;
+    if (this->_access_log.path.empty())
+        std::cout << "  Access Log: off" << std::endl;
+    else
+        std::cout << "  Access Log: " << this->_access_log.path << " " << this->_access_log.format
+                  << " (buffer " << this->_access_log.buffer << ", flush " << this->_access_log.flush << "s)" << std::endl;
+    if (this->_slow_request_threshold > 0)
+        std::cout << "  Slow Request Threshold: " << this->_slow_request_threshold << "ms" << std::endl;
+    if (this->_limits.connections > 0)
+        std::cout << "  Limit Conn: " << this->_limits.connections << " per address (" << this->_limits.conn_status << ")" << std::endl;
+    if (this->_limits.rate > 0)
+        std::cout << "  Limit Req: " << this->_limits.rate << "r/s burst " << this->_limits.burst
+                  << " per address (" << this->_limits.req_status << ")" << std::endl;
 
     std::cout << "  Error Pages: " << this->_error_pages.size() << std::endl;
     for (std::map<short, std::string>::const_iterator it = this->_error_pages.begin(); 
@@ -1,4 +1,5 @@
 #include "../../include/error/BadRequest.hpp"
+#include "../../include/Logger.hpp"
 
 BadRequest::BadRequest()
 {}
@@ -7,7 +8,7 @@ bool    BadRequest::CanHandle(ERROR_TYPE type) const
 {
     if (type == BAD_REQUEST)
     {
-        std::cout << "Bad Request Error Handler is being used!!!!!!!!!!!!!\n";
+        LOG_DEBUG("Bad Request Error Handler is being used!!!!!!!!!!!!!");
     }
     return BAD_REQUEST == type;
 }
@@ -16,12 +17,12 @@ BadRequest::~BadRequest() {}
 
 void    BadRequest::ProcessError(Error &error, const ServerConfig & config)
 {
-    std::cout << "[INFO] [---ERRORS HANDLING --- Start of Processing Bad Request Error --- ]\n";
-    std::cout << "Bad Request Error: " << error.GetErroeMessage() << std::endl;
+    LOG_DEBUG("[---ERRORS HANDLING --- Start of Processing Bad Request Error --- ]");
+    LOG_INFO("Bad Request Error: " << error.GetErroeMessage());
     // Check if the error page is defined in the server configuration
     if (IsErrorPageDefined(config, error.GetCodeError()))
     {
-        std::cout << "[INFO] [---ERRORS HANDLING --- Bad Request Error Page is defined in the server configuration --- ]\n";
+        LOG_DEBUG("[---ERRORS HANDLING --- Bad Request Error Page is defined in the server configuration --- ]");
         ErrorPageChecker(error, config);
         return;
     }
@@ -43,8 +44,7 @@ void    BadRequest::ProcessError(Error &error, const ServerConfig & config)
     error.GetClientData().http_response->setBuffer(response);
     error.GetClientData().http_response->setStatusCode(error.GetCodeError());
     error.GetClientData().http_response->setStatusMessage("Bad Request");
-    if (!error.GetClientData().http_response->getContentType().empty())
-        error.GetClientData().http_response->setContentType("text/html");
+    error.GetClientData().http_response->setContentType("text/html");
 }
 
 const char *    BadRequest::what() const throw()
@@ -23,11 +23,6 @@ ERROR_TYPE Error::GetErrorType()
     return _error_type;
 }
 
-void Error::SetClientData(ClientConnection &client)
-{
-    this->_client =  client;
-}
-
 void    Error::SetCodeError(int code)
 {
     this->_code_error =  code;
@@ -1,4 +1,5 @@
 #include "../../include/error/ErrorHandler.hpp"
+#include "../../include/Logger.hpp"
 
 ErrorHandler::ErrorHandler():nextHandler(NULL)
 {
@@ -35,7 +36,7 @@ ErrorHandler *ErrorHandler::SetNext(ErrorHandler *handler)
 
 bool ErrorHandler::IsErrorPageDefined(const ServerConfig &config, short error_code) const
 {
-    std::cout << " [DEBUG] : Checking if error page is defined for error code: " << error_code << std::endl;
+    LOG_DEBUG("Checking if error page is defined for error code: " << error_code);
 
     std::map<short, std::string> error_pages = config.get_error_pages();
     if (error_pages.find(error_code) != error_pages.end() && !error_pages[error_code].empty())
@@ -44,11 +45,11 @@ bool ErrorHandler::IsErrorPageDefined(const ServerConfig &config, short error_co
         if (!root.empty() && root[root.length() - 1] != '/')
             root += '/';
         std::string error_page_path = root + error_pages[error_code];
-        std::cout << " [ INFO ] : Error page is defined for error code: " << error_code << " at " << error_page_path << std::endl;
+        LOG_DEBUG("Error page is defined for error code: " << error_code << " at " << error_page_path);
         struct stat _statinfo;
         if (stat(error_page_path.c_str(), &_statinfo) != 0)
         {
-            std::cerr << " [ ERROR ] : Error page file does not exist for error code: " << error_code << std::endl;
+            LOG_DEBUG("Error page file does not exist for error code: " << error_code);
             return false;
         }
         return true;
@@ -59,7 +60,7 @@ bool ErrorHandler::IsErrorPageDefined(const ServerConfig &config, short error_co
 void ErrorHandler::ErrorPageChecker(Error &error, const ServerConfig &config)
 {
 
-    std::cout << " [ INFO ] : Error Page is defined for error code: " << error.GetCodeError() << std::endl;
+    LOG_DEBUG("Error Page is defined for error code: " << error.GetCodeError());
     if (error.GetClientData().http_response == NULL)
     {
         std::map<std::string, std::string> emptyHeaders;
@@ -69,10 +70,12 @@ void ErrorHandler::ErrorPageChecker(Error &error, const ServerConfig &config)
     std::map<short, std::string> error_pages = config.get_error_pages();
     if (error_pages.find(error.GetCodeError()) == error_pages.end())
     {
-        std::cerr << " [ ERROR ] : Error page not defined for error code: " << error.GetCodeError() << std::endl;
+        LOG_DEBUG("Error page not defined for error code: " << error.GetCodeError());
         // exit(1);
     }
     // std::cout << " [ Debug] : Error page path : " << config.get_root() + error_pages[error.GetCodeError()] << " ] " << std::endl; 
+    // the error page type comes from its own path
+    error.GetClientData().http_response->setContentType("");
     error.GetClientData().http_response->setFilePath((config.get_root()[config.get_root().length() -1] == '/' ? config.get_root() : config.get_root() + "/" ) + error_pages[error.GetCodeError()]);
     error.GetClientData().http_response->setStatusCode(error.GetCodeError());
     // std::cout << " [ Debug] : Error page file path : " << error.GetClientData().http_response->getFilePath() <<" ] " << std::endl; 
@@ -82,7 +85,7 @@ void ErrorHandler::ErrorPageChecker(Error &error, const ServerConfig &config)
 void ErrorHandler::HanldeError(Error &error, const ServerConfig & config)
 {
    
-    std::cout << "Error Type ::::: " << error.GetCodeError() << "=================\n\n" ;
+    LOG_DEBUG("Error Type ::::: " << error.GetCodeError() << "=================");
     try
     {   
         if (CanHandle(error.GetErrorType()))
@@ -95,7 +98,7 @@ void ErrorHandler::HanldeError(Error &error, const ServerConfig & config)
     }
     catch(const std::exception& e)
     {
-        std::cerr << e.what() << '\n';
+        LOG_WARN(e.what());
     }
     return ;
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "../../include/error/Forbidden.hpp"
+#include "../../include/Logger.hpp"
 
 Forbidden::Forbidden()
 {
@@ -13,14 +14,14 @@ bool Forbidden::CanHandle(ERROR_TYPE error_type) const
 
 void    Forbidden::ProcessError(Error &error, const ServerConfig & config)
 {
-    std::cout << "================= [Start of Processing Forbidden Error] ====================\n";
+    LOG_DEBUG("================= [Start of Processing Forbidden Error] ====================");
     if (IsErrorPageDefined(config, error.GetCodeError()))
     {
-        std::cout << "[INFO] [---ERRORS HANDLING --- Forbidden Error Page is defined in the server configuration --- ]\n";
+        LOG_DEBUG("[---ERRORS HANDLING --- Forbidden Error Page is defined in the server configuration --- ]");
         ErrorPageChecker(error, config);
         return;
     }
-    std::cout << "Forbidden Error: " << error.GetErroeMessage() << std::endl;
+    LOG_INFO("Forbidden Error: " << error.GetErroeMessage());
     std::stringstream iss;
     iss << "<html><head><title>403 Forbidden</title></head>";
     iss << "<body><h1>Forbidden</h1>";
@@ -34,14 +35,13 @@ void    Forbidden::ProcessError(Error &error, const ServerConfig & config)
         error.GetClientData().http_response = new HttpResponse(error.GetCodeError(), emptyHeaders, "text/html", false, false);
     }
     
-    if (!error.GetClientData().http_response->getContentType().empty())
-        error.GetClientData().http_response->setContentType("text/html");
+    error.GetClientData().http_response->setContentType("text/html");
     // Set the response buffer
     error.GetClientData().http_response->setBuffer(response);
     error.GetClientData().http_response->setStatusCode(error.GetCodeError());
     error.GetClientData().http_response->setStatusMessage("Forbidden");
 
-    std::cout << "================= (End of Processing Forbidden Error) ====================\n";
+    LOG_DEBUG("================= (End of Processing Forbidden Error) ====================");
     return ;
 }
 
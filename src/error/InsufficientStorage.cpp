@@ -0,0 +1,50 @@
+#include "../../include/error/InsufficientStorage.hpp"
+#include "../../include/Logger.hpp"
+
+InsufficientStorage::InsufficientStorage()
+{
+    this->SetNext(NULL);
+}
+
+bool InsufficientStorage::CanHandle(ERROR_TYPE error_type) const
+{
+    return error_type == INSUFFICIENT_STORAGE;
+}
+
+void    InsufficientStorage::ProcessError(Error &error, const ServerConfig & config)
+{
+    LOG_DEBUG("================= [Start of Processing Insufficient Storage Error] ====================");
+    if (IsErrorPageDefined(config, error.GetCodeError()))
+    {
+        ErrorPageChecker(error, config);
+        return;
+    }
+    LOG_INFO("Insufficient Storage Error: " << error.GetErroeMessage());
+    std::stringstream iss;
+    iss << "<html><head><title>507 Insufficient Storage</title></head>";
+    iss << "<body><h1>Insufficient Storage</h1>";
+    iss << "<p>The server does not have enough space to store the uploaded content.</p>";
+    iss << "</body></html>";
+    std::string response = iss.str();
+    if (!error.GetClientData().http_response)
+    {
+        std::map<std::string, std::string> emptyHeaders;
+        error.GetClientData().http_response = new HttpResponse(error.GetCodeError(), emptyHeaders, "text/html", false, false);
+    }
+    error.GetClientData().http_response->setContentType("text/html");
+    error.GetClientData().http_response->setBuffer(response);
+    error.GetClientData().http_response->setStatusCode(error.GetCodeError());
+    error.GetClientData().http_response->setStatusMessage("Insufficient Storage");
+    // the client is still pushing the body we refused, the connection can't be reused
+    error.GetClientData().should_close = true;
+    LOG_DEBUG("================= (End of Processing Insufficient Storage Error) ====================");
+}
+
+const char *    InsufficientStorage::what() const throw()
+{
+    return "507 Insufficient Storage";
+}
+
+InsufficientStorage::~InsufficientStorage()
+{
+}
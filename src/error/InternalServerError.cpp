@@ -1,4 +1,5 @@
 #include "../../include/error/InternalServerError.hpp"
+#include "../../include/Logger.hpp"
 
 InternalServerError::InternalServerError()
 {
@@ -8,18 +9,18 @@ bool    InternalServerError::CanHandle(ERROR_TYPE type) const
 {
     if (type == INTERNAL_SERVER_ERROR)
     {
-        std::cout << "Internal Server Error Handler is being used!!!!!!!!!!!!!\n";
+        LOG_DEBUG("Internal Server Error Handler is being used!!!!!!!!!!!!!");
     }
     return INTERNAL_SERVER_ERROR == type;
 }
 
 void    InternalServerError::ProcessError(Error &error, const ServerConfig & config)
 {
-    std::cout << "================= [Start of Processing Internal Server Error] ====================\n";
-    std::cout << "Internal Server Error: " << error.GetErroeMessage() << std::endl;
+    LOG_DEBUG("================= [Start of Processing Internal Server Error] ====================");
+    LOG_WARN("Internal Server Error: " << error.GetErroeMessage());
     if (IsErrorPageDefined(config, error.GetCodeError()))
     {
-        std::cout << "[INFO] [---ERRORS HANDLING --- Internal Server Error Page is defined in the server configuration --- ]\n";    
+        LOG_DEBUG("[---ERRORS HANDLING --- Internal Server Error Page is defined in the server configuration --- ]");    
         ErrorPageChecker(error, config);
         return;
     }
@@ -42,8 +43,7 @@ void    InternalServerError::ProcessError(Error &error, const ServerConfig & con
     error.GetClientData().http_response->setBuffer(response);
     error.GetClientData().http_response->setStatusCode(error.GetCodeError());
     error.GetClientData().http_response->setStatusMessage("Internal Server Error");
-    if (!error.GetClientData().http_response->getContentType().empty())
-        error.GetClientData().http_response->setContentType("text/html");
+    error.GetClientData().http_response->setContentType("text/html");
 }
 
 const char *    InternalServerError::what() const throw()
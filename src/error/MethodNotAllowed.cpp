@@ -1,4 +1,5 @@
 #include "../../include/error/MethodNotAllowed.hpp"
+#include "../../include/Logger.hpp"
 
 
 MethodNotAllowed::MethodNotAllowed()
@@ -9,7 +10,7 @@ bool    MethodNotAllowed::CanHandle(ERROR_TYPE type) const
 {
     if (type == METHOD_NOT_ALLOWED)
     {
-        std::cout << "Method Not Allowed Error Handler is being used!!!!!!!!!!!!!\n";
+        LOG_DEBUG("Method Not Allowed Error Handler is being used!!!!!!!!!!!!!");
     }
     return METHOD_NOT_ALLOWED == type;
 }
@@ -18,12 +19,12 @@ MethodNotAllowed::~MethodNotAllowed() {}
 
 void    MethodNotAllowed::ProcessError(Error &error, const ServerConfig & config)
 {
-    std::cout << "================= [Start of Processing Method Not Allowed Error] ====================\n";
-    std::cout << "Method Not Allowed Error: " << error.GetErroeMessage() << std::endl;
+    LOG_DEBUG("================= [Start of Processing Method Not Allowed Error] ====================");
+    LOG_INFO("Method Not Allowed Error: " << error.GetErroeMessage());
 
     if (IsErrorPageDefined(config, error.GetCodeError()))
     {
-        std::cout << "[INFO] [---ERRORS HANDLING --- Method Not Allowed Error Page is defined in the server configuration --- ]\n";
+        LOG_DEBUG("[---ERRORS HANDLING --- Method Not Allowed Error Page is defined in the server configuration --- ]");
         ErrorPageChecker(error, config);
         return;
     }
@@ -44,8 +45,7 @@ void    MethodNotAllowed::ProcessError(Error &error, const ServerConfig & config
     // Set the response buffer
     error.GetClientData().http_response->setBuffer(response);
     error.GetClientData().http_response->setStatusCode(error.GetCodeError());
-    if (!error.GetClientData().http_response->getContentType().empty())
-        error.GetClientData().http_response->setContentType("text/html");
+    error.GetClientData().http_response->setContentType("text/html");
 }
 
 const char *    MethodNotAllowed::what() const throw()
@@ -1,4 +1,5 @@
 #include "../../include/error/NotFound.hpp"
+#include "../../include/Logger.hpp"
 
 NotFound::NotFound()
 {
@@ -6,22 +7,22 @@ NotFound::NotFound()
 
 bool    NotFound::CanHandle(ERROR_TYPE type) const
 {
-    std::cout << "Can Handle Error Type: " << (int)(type) << std::endl;
+    LOG_DEBUG("Can Handle Error Type: " << (int)(type));
     if (type == NOT_FOUND)
     {
-        std::cout << "Not Found Error Handler is being used!!!!!!!!!!!!!\n";
+        LOG_DEBUG("Not Found Error Handler is being used!!!!!!!!!!!!!");
     }
     return NOT_FOUND == type;
 }
 
 void    NotFound::ProcessError(Error &error, const ServerConfig & config)
 {
-    std::cout << "================= [Start of Processing Not Found Error] ====================\n";
-    std::cout << "Not Found Error: " << error.GetErroeMessage() << std::endl;
+    LOG_DEBUG("================= [Start of Processing Not Found Error] ====================");
+    LOG_INFO("Not Found Error: " << error.GetErroeMessage());
 
     if (IsErrorPageDefined(config, error.GetCodeError()))
     {
-        std::cout << "[INFO] [---ERRORS HANDLING --- Not Found Error Page is defined in the server configuration --- ]\n";
+        LOG_DEBUG("[---ERRORS HANDLING --- Not Found Error Page is defined in the server configuration --- ]");
         ErrorPageChecker(error, config);
         return;
     }
@@ -39,14 +40,13 @@ void    NotFound::ProcessError(Error &error, const ServerConfig & config)
         std::map<std::string, std::string> emptyHeaders;
         error.GetClientData().http_response = new HttpResponse(error.GetCodeError(), emptyHeaders, "text/html", false, false);
     }
-    std::cout << "[Rsponse] : " << response << std::endl;
+    LOG_DEBUG("[Rsponse] : " << response);
     error.GetClientData().http_response->setBuffer(response);
     error.GetClientData().http_response->setStatusCode(error.GetCodeError());
     error.GetClientData().http_response->setStatusMessage("Not Found");
-    if (!error.GetClientData().http_response->getContentType().empty())
-        error.GetClientData().http_response->setContentType("text/html");
+    error.GetClientData().http_response->setContentType("text/html");
     // error->GetClientData().http_response.send(response, response);
-    std::cerr << "Not Found Error: " << error.GetErroeMessage() << std::endl;
+    LOG_INFO("Not Found Error: " << error.GetErroeMessage());
 }
 
 const char *    NotFound::what() const throw()
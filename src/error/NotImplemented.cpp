@@ -1,4 +1,5 @@
 #include "../../include/error/NotImplemented.hpp"
+#include "../../include/Logger.hpp"
 
 
 NotImplemented::NotImplemented()
@@ -9,19 +10,19 @@ bool    NotImplemented::CanHandle(ERROR_TYPE type) const
 {
     if (type == NOT_IMPLEMENTED)
     {
-        std::cout << "Not Implemented Error Handler is being used!!!!!!!!!!!!!\n";
+        LOG_DEBUG("Not Implemented Error Handler is being used!!!!!!!!!!!!!");
     }
     return NOT_IMPLEMENTED == type;
 }
 
 void    NotImplemented::ProcessError(Error &error, const ServerConfig & config)
 {
-    std::cout << "================= [Start of Processing Not Implemented Error] ====================\n";
-    std::cout << "Not Implemented Error: " << error.GetErroeMessage() << std::endl;
+    LOG_DEBUG("================= [Start of Processing Not Implemented Error] ====================");
+    LOG_INFO("Not Implemented Error: " << error.GetErroeMessage());
 
     if (IsErrorPageDefined(config, error.GetCodeError()))
     {
-        std::cout << "[INFO] [---ERRORS HANDLING --- Not Implemented Error Page is defined in the server configuration --- ]\n";
+        LOG_DEBUG("[---ERRORS HANDLING --- Not Implemented Error Page is defined in the server configuration --- ]");
         ErrorPageChecker(error, config);
         return;
     }
@@ -43,8 +44,7 @@ void    NotImplemented::ProcessError(Error &error, const ServerConfig & config)
     error.GetClientData().http_response->setBuffer(response);
     error.GetClientData().http_response->setStatusCode(error.GetCodeError());
     error.GetClientData().http_response->setStatusMessage("Not Implemented");
-    if (!error.GetClientData().http_response->getContentType().empty())
-        error.GetClientData().http_response->setContentType("text/html");
+    error.GetClientData().http_response->setContentType("text/html");
 }
 
 const char *    NotImplemented::what() const throw()
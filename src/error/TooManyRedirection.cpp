@@ -1,4 +1,5 @@
 #include "../../include/error/TooManyRedirection.hpp"
+#include "../../include/Logger.hpp"
 
 
 TooManyRedirection::TooManyRedirection(/* args */)
@@ -13,14 +14,14 @@ bool TooManyRedirection::CanHandle(ERROR_TYPE error_type) const
 
 void TooManyRedirection::ProcessError(Error &error, const ServerConfig & config)
 {
-    std::cout << "================= [Start of Processing Forbidden Error] ====================\n";
+    LOG_DEBUG("================= [Start of Processing Forbidden Error] ====================");
     if (IsErrorPageDefined(config, error.GetCodeError()))
     {
-        std::cout << "[INFO] [---ERRORS HANDLING --- Too Many Redirections Error Page is defined in the server configuration --- ]\n";
+        LOG_DEBUG("[---ERRORS HANDLING --- Too Many Redirections Error Page is defined in the server configuration --- ]");
         ErrorPageChecker(error, config);
         return;
     }
-    std::cout << "Too Many Redirections Error: " << error.GetErroeMessage() << std::endl;
+    LOG_INFO("Too Many Redirections Error: " << error.GetErroeMessage());
     std::stringstream iss;
     iss << "<html><head><title>Too Many Redirections</title></head>";
     iss << "<body><h1>Too Many Redirections</h1>";
@@ -33,13 +34,12 @@ void TooManyRedirection::ProcessError(Error &error, const ServerConfig & config)
         std::map<std::string, std::string> emptyHeaders;
         error.GetClientData().http_response = new HttpResponse(error.GetCodeError(), emptyHeaders, "text/html", false, false);
     }
-    if (!error.GetClientData().http_response->getContentType().empty())
-        error.GetClientData().http_response->setContentType("text/html");
+    error.GetClientData().http_response->setContentType("text/html");
     // Set the response buffer
     error.GetClientData().http_response->setBuffer(response);
     error.GetClientData().http_response->setStatusCode(error.GetCodeError());
     error.GetClientData().http_response->setStatusMessage("Too Many Redirections");
-    std::cout << "================= (End of Processing Too Many Redirections Error) ====================\n";
+    LOG_DEBUG("================= (End of Processing Too Many Redirections Error) ====================");
     return ;
 }
 
@@ -4,6 +4,9 @@
 #include "../../include/request/HttpRequest.hpp"
 #include "../../include/config/ServerConfig.hpp"
 #include "../../include/config/Location.hpp"
+#include "../../include/Metrics.hpp"
+#include "../../include/Overload.hpp"
+#include "../../include/Logger.hpp"
 #include <iostream>
 #include <stdexcept>
 #include <fstream>
@@ -118,6 +121,15 @@ void CgiHandler::ProccessRequest(HttpRequest *request, const ServerConfig &serve
         return;
     }
     
+    // cgi_max_processes: one more would only queue behind the running ones for the CPU
+    if (Overload::CgiFull(active_cgis.size())) {
+        _client->_server->refuse(*_client, 503, OVERLOAD_RETRY_AFTER);
+        Metrics::Increment(Metrics::CGI_REJECTED);
+        LOG_WARN("cgi_max_processes " << Overload::Options().cgi_processes << " running, "
+            << request->GetLocation() << " rejected with 503");
+        return;
+    }
+
     try {
         if (startCgiProcess(request)) {
         } else {
@@ -272,13 +284,13 @@ bool CgiHandler::startCgiProcess(HttpRequest *request) {
         
         std::string script_dir = getDirectoryFromPath(script_path);
         if (chdir(script_dir.c_str()) != 0) {
-            exit(1);
+            _exit(1);
         }
         
         std::string script_filename = getFilenameFromPath(script_path);
         char **env = setGgiEnv(request);
         if (!env) {
-            exit(1);
+            _exit(1);
         }
         
         char* argv[] = {
@@ -288,7 +300,7 @@ bool CgiHandler::startCgiProcess(HttpRequest *request) {
         };
         if (!argv[0] || !argv[1]) {
             cleanupEnvironment(env);
-            exit(1);
+            _exit(1);
         }
         
         execve(interpreter_path.c_str(), argv, env);
@@ -296,7 +308,7 @@ bool CgiHandler::startCgiProcess(HttpRequest *request) {
         free(argv[0]);
         free(argv[1]);
         cleanupEnvironment(env);
-        exit(1);
+        _exit(1);
     }
     
     close(pipe_out[1]);
@@ -316,11 +328,15 @@ bool CgiHandler::startCgiProcess(HttpRequest *request) {
     cgi.pid = cgi_pid;
     cgi.pipe_fd = pipe_out[0];
     cgi.start_time = time(NULL);
+    clock_gettime(CLOCK_MONOTONIC, &cgi.started);
     cgi.output = "";
     cgi.client = _client;
+    cgi.client_fd = _client->fd;
+    cgi.client_generation = _client->generation;
     cgi.request = request;
     
     active_cgis[pipe_out[0]] = cgi;
+    Metrics::Increment(Metrics::CGI_SPAWNED);
     
     _client->_server->addCgiToPoll(pipe_out[0]);
     
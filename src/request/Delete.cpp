@@ -1,4 +1,5 @@
 #include "../../include/request/Delete.hpp"
+#include "../../include/Logger.hpp"
 
 
 Delete::Delete() {
@@ -10,41 +11,41 @@ Delete::~Delete() {
 
 // Inherited from RequestHandler
 bool Delete::CanHandle(std::string method) {
-    std::cout << "***************************** 1] CAN HANDLE DELETE REQUEST *****************************************" << std::endl;
+    LOG_DEBUG("***************************** 1] CAN HANDLE DELETE REQUEST *****************************************");
     return (method == "DELETE");
 }
 
 
 void Delete::ProccessRequest(HttpRequest *request, const ServerConfig &serverConfig, ServerConfig clientConfig) {
-    std::cout << "🛠️ ***************************** [BEGIN] DELETE REQUEST HANDLER CALLED *****************************************" << std::endl;
+    LOG_DEBUG("🛠️ ***************************** [BEGIN] DELETE REQUEST HANDLER CALLED *****************************************");
     std::string rel_path;
     const Location *cur_location;
 
     if (!request)
     {
-        std::cerr << "Error: Null request pointer\n";
+        LOG_ERROR("Null request pointer");
         throw HttpException(500, "Internal Server Error", INTERNAL_SERVER_ERROR);
     }
     if (!request->GetClientDatat())
     {
-        std::cerr << "Error: Null client data pointer\n";
+        LOG_ERROR("Null client data pointer");
         throw HttpException(500, "Internal Server Error", INTERNAL_SERVER_ERROR);
     }
     // Get the current location from the server configuration
     cur_location = clientConfig.findBestMatchingLocation(request->GetLocation());
-    std::cout << "[ Debug ] rel LOCATION: " << request->GetLocation() << std::endl;
-    std::cout << "[ Debug ] client location server name: " << clientConfig.get_server_name()<< std::endl;
-    std::cout << "[ Debug ] client location server name: " << request->GetClientDatat()->getServerConfig().get_server_name() << std::endl;
+    LOG_DEBUG("rel LOCATION: " << request->GetLocation());
+    LOG_DEBUG("client location server name: " << clientConfig.get_server_name());
+    LOG_DEBUG("client location server name: " << request->GetClientDatat()->getServerConfig().get_server_name());
     
     rel_path = request->GetRelativePath(cur_location, request->GetClientDatat());
     if (rel_path.empty() || IsValidPath(rel_path) == "")
     {
-        std::cerr << "[empty rel_path Not Found ]\n";
+        LOG_DEBUG("[empty rel_path Not Found ]");
         throw HttpException(404, "404 Not Found", NOT_FOUND);
     }
     // Check the type if it a directory or a regular file
     if (IsDir(rel_path)) {
-        std::cout << "✅✅✅ This is a directory to be handled with other function" << std::endl;
+        LOG_DEBUG("✅✅✅ This is a directory to be handled with other function");
         handleDirectoryDeletion(request, rel_path, request->GetLocation());
     } else { // in case it's a regular file delete it
         handleFileDeletion(request, rel_path);
@@ -54,17 +55,17 @@ void Delete::ProccessRequest(HttpRequest *request, const ServerConfig &serverCon
 
 
 
- std::cout << "***************************** [END OF] DELETE REQUEST HANDLER CALLED *****************************************" << std::endl;
+ LOG_DEBUG("***************************** [END OF] DELETE REQUEST HANDLER CALLED *****************************************");
 }
 
 void Delete::handleFileDeletion(HttpRequest *request, const std::string &filePath) {
-    std::cout << "Handling file deletion: " << filePath << std::endl;
+    LOG_DEBUG("Handling file deletion: " << filePath);
     // Try to delete the file
     if (unlink(filePath.c_str()) == 0) {
-        std::cout << "Successfully deleted file: " << filePath << std::endl;
+        LOG_DEBUG("Successfully deleted file: " << filePath);
         sendSuccessResponse(request);
     } else {
-        std::cout << "Failed to delete file: " << filePath << " (errno: " << errno << " - " << strerror(errno) << ")" << std::endl;
+        LOG_WARN("Failed to delete file: " << filePath << " (errno: " << errno << " - " << strerror(errno) << ")");
         sendErrorResponse(request, 500, "Internal Server Error", "Failed to delete file");
     }
 }
@@ -72,32 +73,32 @@ void Delete::handleFileDeletion(HttpRequest *request, const std::string &filePat
 
 
 void Delete::handleDirectoryDeletion(HttpRequest *request, const std::string &dirPath, const std::string &originalUri) {
-    std::cout << "Handling directory deletion: " << dirPath << std::endl;
-    std::cout << "Original URI: " << originalUri << std::endl;
+    LOG_DEBUG("Handling directory deletion: " << dirPath);
+    LOG_DEBUG("Original URI: " << originalUri);
     
     // RULE: Directory deletion requires URI to end with '/'
     if (originalUri.empty() || originalUri.back() != '/') {
-        std::cout << "Directory deletion requires URI to end with '/'" << std::endl;
+        LOG_DEBUG("Directory deletion requires URI to end with '/'");
         sendErrorResponse(request, 409, "Conflict", "Directory deletion requires URI to end with '/'");
         return;
     }
     
     // Try to delete the directory
     if (deleteDirectoryRecursive(dirPath)) {
-        std::cout << "Successfully deleted directory: " << dirPath << std::endl;
+        LOG_DEBUG("Successfully deleted directory: " << dirPath);
         sendSuccessResponse(request);
     } else {
-        std::cout << "Failed to delete directory: " << dirPath << std::endl;
+        LOG_WARN("Failed to delete directory: " << dirPath);
         sendErrorResponse(request, 500, "Internal Server Error", "Failed to delete directory");
     }
 }
 
 bool Delete::deleteDirectoryRecursive(const std::string &dirPath) {
-    std::cout << "Deleting directory recursively: " << dirPath << std::endl;
+    LOG_DEBUG("Deleting directory recursively: " << dirPath);
     
     DIR *dir = opendir(dirPath.c_str());
     if (!dir) {
-        std::cerr << "Failed to open directory: " << dirPath << " (errno: " << errno << ")" << std::endl;
+        LOG_ERROR("Failed to open directory: " << dirPath << " (errno: " << errno << ")");
         return false;
     }
     
@@ -127,12 +128,12 @@ bool Delete::deleteDirectoryRecursive(const std::string &dirPath) {
             } else {
                 // Delete file
                 if (unlink(fullPath.c_str()) != 0) {
-                    std::cerr << "Failed to delete file: " << fullPath << std::endl;
+                    LOG_ERROR("Failed to delete file: " << fullPath);
                     success = false;
                 }
             }
         } else {
-            std::cerr << "Failed to stat: " << fullPath << std::endl;
+            LOG_ERROR("Failed to stat: " << fullPath);
             success = false;
         }
     }
@@ -140,7 +141,7 @@ bool Delete::deleteDirectoryRecursive(const std::string &dirPath) {
     // Remove the directory itself
     if (success) {
         if (rmdir(dirPath.c_str()) != 0) {
-            std::cerr << "Failed to remove directory: " << dirPath << std::endl;
+            LOG_ERROR("Failed to remove directory: " << dirPath);
             success = false;
         }
     }
@@ -162,7 +163,7 @@ void Delete::sendSuccessResponse(HttpRequest *request) {
     // Mark request as processed
     request->SetProcessed(true);
     
-    std::cout << "Sent 204 No Content response" << std::endl;
+    LOG_DEBUG("Sent 204 No Content response");
 }
 
 
@@ -175,5 +176,5 @@ void Delete::sendErrorResponse(HttpRequest *request, int statusCode, const std::
     // Mark request as processed
     request->SetProcessed(true);
     
-    std::cout << "Sent " << statusCode << " " << statusMessage << " response" << std::endl;
+    LOG_DEBUG("Sent " << statusCode << " " << statusMessage << " response");
 }
\ No newline at end of file
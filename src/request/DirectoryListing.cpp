@@ -0,0 +1,385 @@
+#include "../../include/request/DirectoryListing.hpp"
+#include "../../include/Logger.hpp"
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <algorithm>
+#include <iostream>
+
+std::map<std::string, DirectoryListing::Entry>  DirectoryListing::_entries;
+std::string                                     DirectoryListing::_cache_dir;
+unsigned long                                   DirectoryListing::_generation = 0;
+pid_t                                           DirectoryListing::_owner = 0;
+
+std::string DirectoryListing::ContentType(const std::string &format)
+{
+    if (format == "json")
+        return "application/json";
+    if (format == "xml")
+        return "text/xml";
+    return "text/html";
+}
+
+int DirectoryListing::openListing(const std::string &file, struct stat &listing_stat)
+{
+    int fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (fd >= 0 && fstat(fd, &listing_stat) != 0)
+    {
+        close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+int DirectoryListing::Lookup(const std::string &dir_path, const struct stat &dir_stat,
+                             const std::string &request_path, const std::string &format,
+                             std::string &listing, struct stat &listing_stat)
+{
+    std::string key = dir_path + '\n' + request_path + '\n' + format;
+    std::map<std::string, Entry>::iterator it = _entries.find(key);
+    time_t now = time(NULL);
+
+    if (it != _entries.end() && it->second.dev == dir_stat.st_dev && it->second.ino == dir_stat.st_ino
+        && it->second.mtime.tv_sec == dir_stat.st_mtim.tv_sec && it->second.mtime.tv_nsec == dir_stat.st_mtim.tv_nsec)
+    {
+        int fd = openListing(it->second.file, listing_stat);
+        if (fd >= 0)
+        {
+            it->second.used = now;
+            listing = it->second.file;
+            return fd;
+        }
+    }
+
+    if (_cache_dir.empty())
+    {
+        // a fresh name with mode 0700, nothing another user made beforehand
+        char name[] = "/tmp/webserv-autoindex.XXXXXX";
+        if (mkdtemp(name) == NULL)
+        {
+            LOG_ERROR("cannot create listing cache " << name << ": " << strerror(errno));
+            return -1;
+        }
+        _cache_dir = name;
+        _owner = getpid();
+        atexit(RemoveAll);
+    }
+
+    std::vector<Item> items;
+    if (!readItems(dir_path, items))
+        return -1;
+    std::sort(items.begin(), items.end(), compareItems);
+
+    char name[64];
+    snprintf(name, sizeof(name), "/%lu.%s", ++_generation, format.c_str());
+    std::string file = _cache_dir + name;
+    int fd = render(file, request_path, format, items) ? openListing(file, listing_stat) : -1;
+    if (fd < 0)
+    {
+        unlink(file.c_str());
+        return -1;
+    }
+    LOG_DEBUG("rendered listing of " << dir_path << " (" << items.size() << " entries)");
+
+    if (it != _entries.end())
+        unlink(it->second.file.c_str());
+    else if (_entries.size() >= DIRECTORY_LISTING_CACHE_MAX)
+        Evict();
+    Entry &entry = _entries[key];
+    entry.dev = dir_stat.st_dev;
+    entry.ino = dir_stat.st_ino;
+    entry.mtime = dir_stat.st_mtim;
+    entry.file = file;
+    entry.used = now;
+    listing = file;
+    return fd;
+}
+
+bool DirectoryListing::readItems(const std::string &dir_path, std::vector<Item> &items)
+{
+    DIR *dir = opendir(dir_path.c_str());
+    struct dirent *entry;
+
+    if (dir == NULL)
+    {
+        LOG_ERROR("Failed to open directory: " << dir_path << " - " << strerror(errno));
+        return false;
+    }
+    while ((entry = readdir(dir)) != NULL)
+    {
+        struct stat st;
+        Item item;
+
+        item.name = entry->d_name;
+        if (item.name == "." || item.name == "..")
+            continue;
+        // follows symlinks so links are listed as what they point to
+        if (fstatat(dirfd(dir), entry->d_name, &st, 0) != 0)
+            continue;
+        item.is_dir = S_ISDIR(st.st_mode);
+        item.size = st.st_size;
+        item.mtime = st.st_mtime;
+        items.push_back(item);
+    }
+    closedir(dir);
+    return true;
+}
+
+bool DirectoryListing::compareItems(const Item &a, const Item &b)
+{
+    if (a.is_dir != b.is_dir)
+        return a.is_dir;
+    return a.name < b.name;
+}
+
+bool DirectoryListing::flushBuffer(int fd, std::string &buffer)
+{
+    size_t written = 0;
+
+    while (written < buffer.size())
+    {
+        ssize_t count = write(fd, buffer.data() + written, buffer.size() - written);
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count <= 0)
+        {
+            LOG_ERROR("writing directory listing: " << strerror(errno));
+            return false;
+        }
+        written += count;
+    }
+    buffer.clear();
+    return true;
+}
+
+// The page goes out to the cache file in DIRECTORY_LISTING_FLUSH pieces, never as one string
+bool DirectoryListing::render(const std::string &file, const std::string &request_path,
+                              const std::string &format, const std::vector<Item> &items)
+{
+    int fd = open(file.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0600);
+    std::string base = request_path;
+    std::string buffer;
+    bool ok = true;
+
+    if (fd < 0)
+    {
+        LOG_ERROR("cannot create " << file << ": " << strerror(errno));
+        return false;
+    }
+    if (base.empty() || base[base.length() - 1] != '/')
+        base += "/";
+    buffer.reserve(DIRECTORY_LISTING_FLUSH + 1024);
+
+    if (format == "json")
+        buffer += "[\n";
+    else if (format == "xml")
+        buffer += "<?xml version=\"1.0\"?>\n<list>\n";
+    else
+    {
+        std::string title = escapeMarkup(request_path);
+        buffer += "<html>\n<head>\n<title>Index of " + title + "</title>\n"
+            "<link rel=\"stylesheet\" href=\"https://cdnjs.cloudflare.com/ajax/libs/font-awesome/6.7.2/css/all.min.css\" integrity=\"sha512-Evv84Mr4kqVGRNSgIGL/F/aIDqQb7xQ2vcrdIwxfjThSH8CSR7PBEakCr51Ck+w+/U6swU2Im1vVX0SVk9ABhg==\" crossorigin=\"anonymous\" referrerpolicy=\"no-referrer\" />"
+            "<style>\n"
+            "   * { box-sizing: border-box;  color: rgb(0, 0, 0);}\n"
+            "    body { font-family: Arial, sans-serif; margin: 20px; }\n"
+            "    h1 { border-bottom: 1px solid #ccc; padding-bottom: 10px; }\n"
+            "    ul { list-style-type: none; padding: 0; }\n"
+            "    li { margin: 5px 0; }\n"
+            "    li a { text-decoration: none; }\n"
+            "    li a:hover { text-decoration: underline; }\n"
+            "    .folder { font-weight: bold; font-size : 18px }\n"
+            "    .meta { color: rgb(120, 120, 120); margin-left: 20px; font-size: 13px; }\n"
+            "</style>\n"
+            "<meta charset=\"UTF-8\">\n"
+            "</head>\n"
+            "<body>\n"
+            "<h1>Index of " + title + "</h1>\n"
+            "<ul>\n";
+        if (request_path != "/")
+        {
+            std::string parent = base.substr(0, base.find_last_of('/', base.length() - 2) + 1);
+            buffer += "<li><a href=\"" + escapeMarkup(encodeUri(parent)) + "\"> <i class=\"fa-solid fa-arrow-left\" style=\"margin-right: 20px; font-wieght : 700; color : rgb(235, 219, 52);\"></i>Parent Directory</a></li>\n";
+        }
+    }
+
+    for (size_t i = 0; i < items.size() && ok; ++i)
+    {
+        buffer += renderItem(items[i], base, format, i == 0);
+        if (buffer.size() >= DIRECTORY_LISTING_FLUSH)
+            ok = flushBuffer(fd, buffer);
+    }
+
+    if (format == "json")
+        buffer += items.empty() ? "]\n" : "\n]\n";
+    else if (format == "xml")
+        buffer += "</list>\n";
+    else
+        buffer += "</ul>\n</body>\n</html>\n";
+    ok = ok && flushBuffer(fd, buffer);
+    close(fd);
+    return ok;
+}
+
+std::string DirectoryListing::renderItem(const Item &item, const std::string &base, const std::string &format, bool first)
+{
+    std::string out;
+    char size[32];
+
+    snprintf(size, sizeof(size), "%lld", static_cast<long long>(item.size));
+    if (format == "json")
+    {
+        if (!first)
+            out += ",\n";
+        out += "  { \"name\": \"" + escapeJson(item.name) + "\", \"type\": \"" + (item.is_dir ? "directory" : "file")
+            + "\", \"mtime\": \"" + formatTime(item.mtime, "%a, %d %b %Y %H:%M:%S GMT") + "\"";
+        if (!item.is_dir)
+            out += std::string(", \"size\": ") + size;
+        out += " }";
+    }
+    else if (format == "xml")
+    {
+        out += item.is_dir ? "<directory" : "<file";
+        out += " mtime=\"" + formatTime(item.mtime, "%Y-%m-%dT%H:%M:%SZ") + "\"";
+        if (!item.is_dir)
+            out += std::string(" size=\"") + size + "\"";
+        out += ">" + escapeMarkup(item.name) + (item.is_dir ? "</directory>\n" : "</file>\n");
+    }
+    else
+    {
+        std::string href = escapeMarkup(encodeUri(base + item.name));
+        std::string name = escapeMarkup(item.name);
+        if (item.is_dir)
+            out += "<li> <a href=\"" + href + "/\" class=\"folder\"> <i class=\"fa-solid fa-folder\" style=\"margin-right: 20px; font-wieght : 700; color : rgb(235, 219, 52);\"></i>" + name + "/</a>";
+        else
+            out += "<li> <a href=\"" + href + "\" class=\"file\"> <i class=\"fa-solid fa-file\" style=\"margin-right: 20px; \" ></i>" + name + "</a>";
+        out += "<span class=\"meta\">" + (item.is_dir ? std::string("-") : formatSize(item.size)) + " &middot; "
+            + formatTime(item.mtime, "%d-%b-%Y %H:%M") + "</span></li>\n";
+    }
+    return out;
+}
+
+// Least recently served listing goes first; responses still sending it hold it open
+void DirectoryListing::Evict()
+{
+    std::map<std::string, Entry>::iterator oldest = _entries.begin();
+
+    for (std::map<std::string, Entry>::iterator it = _entries.begin(); it != _entries.end(); ++it)
+    {
+        if (it->second.used < oldest->second.used)
+            oldest = it;
+    }
+    if (oldest == _entries.end())
+        return;
+    unlink(oldest->second.file.c_str());
+    _entries.erase(oldest);
+}
+
+void DirectoryListing::RemoveAll()
+{
+    // a forked child inherits the handler, the directory stays its parent's
+    if (getpid() != _owner)
+        return;
+    for (std::map<std::string, Entry>::iterator it = _entries.begin(); it != _entries.end(); ++it)
+        unlink(it->second.file.c_str());
+    _entries.clear();
+    if (!_cache_dir.empty())
+        rmdir(_cache_dir.c_str());
+}
+
+std::string DirectoryListing::escapeMarkup(const std::string &text)
+{
+    std::string out;
+
+    for (size_t i = 0; i < text.length(); ++i)
+    {
+        switch (text[i])
+        {
+            case '&': out += "&amp;"; break;
+            case '<': out += "&lt;"; break;
+            case '>': out += "&gt;"; break;
+            case '"': out += "&quot;"; break;
+            case '\'': out += "&#39;"; break;
+            default: out += text[i];
+        }
+    }
+    return out;
+}
+
+std::string DirectoryListing::escapeJson(const std::string &text)
+{
+    std::string out;
+    char escaped[8];
+
+    for (size_t i = 0; i < text.length(); ++i)
+    {
+        unsigned char c = text[i];
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+            out += c;
+        }
+        else if (c < 0x20)
+        {
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        }
+        else
+            out += c;
+    }
+    return out;
+}
+
+// Percent-encodes everything but unreserved characters and the path separators
+std::string DirectoryListing::encodeUri(const std::string &text)
+{
+    static const char hex[] = "0123456789ABCDEF";
+    std::string out;
+
+    for (size_t i = 0; i < text.length(); ++i)
+    {
+        unsigned char c = text[i];
+        if (isalnum(c) || c == '/' || c == '-' || c == '_' || c == '.' || c == '~')
+            out += c;
+        else
+        {
+            out += '%';
+            out += hex[c >> 4];
+            out += hex[c & 0xf];
+        }
+    }
+    return out;
+}
+
+std::string DirectoryListing::formatTime(time_t time, const char *layout)
+{
+    char buffer[64];
+    struct tm gmt;
+
+    gmtime_r(&time, &gmt);
+    strftime(buffer, sizeof(buffer), layout, &gmt);
+    return buffer;
+}
+
+std::string DirectoryListing::formatSize(off_t size)
+{
+    static const char units[] = "BKMGT";
+    double value = size;
+    size_t unit = 0;
+    char buffer[32];
+
+    while (value >= 1024 && unit < sizeof(units) - 2)
+    {
+        value /= 1024;
+        ++unit;
+    }
+    if (unit == 0)
+        snprintf(buffer, sizeof(buffer), "%lld B", static_cast<long long>(size));
+    else
+        snprintf(buffer, sizeof(buffer), "%.1f %c", value, units[unit]);
+    return buffer;
+}
@@ -1,6 +1,15 @@
 #include "../../include/request/Get.hpp"
+#include "../../include/Logger.hpp"
 #include "../../include/request/HttpRequest.hpp"
 #include "../../include/config/Location.hpp" 
+#include "../../include/request/OpenFileCache.hpp"
+#include "../../include/response/MimeTypes.hpp"
+#include "../../include/response/GzipFilter.hpp"
+#include "../../include/request/DirectoryListing.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
 
 Get::Get()
 {
@@ -28,20 +37,35 @@ std::string Get::IsValidPath( std::string &path)
             path = path.substr(0, path.length() - 1);
             if (stat(path.c_str(), &_statinfo) != 0)
             {
-                std::cerr << "[ ERROR ] : Path does not exist: " << path << std::endl;
+                LOG_DEBUG("Path does not exist: " << path);
                 return "";
             }
             else
             {
-                std::cout << "[ INFO ] : Path is a directory: " << path << std::endl;
+                LOG_DEBUG("Path is a directory: " << path);
                 return path;
             }
         }
     }
-    std::cout << "[ INFO ] : Path is a file: " << path << std::endl;
+    LOG_DEBUG("Path is a file: " << path);
     return path;
 }
 
+// Same as above but keeps the stat result so the caller never stats the path again
+std::string Get::IsValidPath( std::string &path, struct stat &file_stat)
+{
+    if (OpenFileCache::Lookup(path, file_stat))
+        return path;
+    if (!path.empty() && path[path.length() - 1] == '/')
+    {
+        path = path.substr(0, path.length() - 1);
+        if (OpenFileCache::Lookup(path, file_stat))
+            return path;
+    }
+    LOG_DEBUG("Path does not exist: " << path);
+    return "";
+}
+
 bool    Get::IsDir( std::string &path)
 {
     struct stat _statinfo;
@@ -60,104 +84,49 @@ bool    Get::IsFile( std::string &path)
     return (S_ISREG(_statinfo.st_mode));
 }
 
+bool    Get::IsFile( std::string &path, struct stat &file_stat)
+{
+    if (!OpenFileCache::Lookup(path, file_stat))
+        return false;
+    return (S_ISREG(file_stat.st_mode));
+}
+
 bool Get::check_auto_indexing(const Location *cur_location, const ServerConfig &serverConfig)
 {
     if (!cur_location)
     {
         if (serverConfig.get_autoindex())
             return true;
-        std::cerr << "[ WARNING ] : No matching location found, auto indexing cannot be checked." << std::endl;
+        LOG_DEBUG("No matching location found, auto indexing cannot be checked.");
         return false;
     }
     return cur_location->get_autoindex();
 }
 
-std::string Get::ListingDir(const std::string &path, std::string request_path, const Location *cur_location,const ServerConfig &serverConfig)
+bool Get::ListingDir(HttpRequest *request, const std::string &path, const struct stat &dir_stat, const Location *cur_location, const ServerConfig &serverConfig)
 {
-    std::cout << "[DEBUG] REL PATH :" << path << std::endl;
-    std::cout << "==>[DEBUG AUTO INDEXING] : " << (cur_location ? (cur_location->get_autoindex() ? "ON" : "OFF") : "No location found") << std::endl;
+    HttpResponse *response = request->GetClientDatat()->http_response;
+    std::string format = cur_location ? cur_location->get_autoindexFormat() : "html";
+    struct stat listing_stat;
+    std::string listing;
+
+    LOG_DEBUG("==>[DEBUG AUTO INDEXING] : " << (cur_location ? (cur_location->get_autoindex() ? "ON" : "OFF") : "No location found"));
     //To Check the auto indexing Option  Conf File
     if (!check_auto_indexing(cur_location, serverConfig))
     {
-        std::cerr << "[ WARNING ] : Auto indexing is disabled for this location." << std::endl;
-        return "";
-    }
-    DIR *dir;
-    struct dirent *entry;
-    std::stringstream response;
-    std::string path_;
-    std::string normalized_path = path;
-    
-    std::cout << "[ DEBUG ] : NORMALIZED PATH : " << normalized_path << std::endl;
-    if (normalized_path.empty() || normalized_path[normalized_path.length() - 1] != '/')
-        normalized_path += "/";
-    path_ = normalized_path; 
-    std::cout << "Opening directory: " << path_ << std::endl;
-    dir = opendir(path_.c_str());
-    if (dir == NULL)
-    {
-        std::cerr << "Failed to open directory: " << path_ << " - " << strerror(errno) << std::endl;
-        return "";
-    }
-    response << "<html>\n"
-    << "<head>\n<title>Index of " << request_path << "</title>\n"
-    << "<link rel=\"stylesheet\" href=\"https://cdnjs.cloudflare.com/ajax/libs/font-awesome/6.7.2/css/all.min.css\" integrity=\"sha512-Evv84Mr4kqVGRNSgIGL/F/aIDqQb7xQ2vcrdIwxfjThSH8CSR7PBEakCr51Ck+w+/U6swU2Im1vVX0SVk9ABhg==\" crossorigin=\"anonymous\" referrerpolicy=\"no-referrer\" />"
-    << "<style>\n"
-    << "   * { box-sizing: border-box;  color: rgb(0, 0, 0);}\n"
-    << "    body { font-family: Arial, sans-serif; margin: 20px; }\n"
-    << "    h1 { border-bottom: 1px solid #ccc; padding-bottom: 10px; }\n"
-    << "    ul { list-style-type: none; padding: 0; }\n"
-    << "    li { margin: 5px 0; }\n"
-    << "    li a { text-decoration: none; }\n"
-    << "    li a:hover { text-decoration: underline; }\n"
-    << "    .folder { font-weight: bold; font-size : 18px }\n"
-    
-    << "</style>\n"
-    << "<meta charset=\"UTF-8\">\n"
-    << "</head>\n"
-    << "<body>\n"
-    << "<h1>Index of " << request_path << "</h1>\n"
-    << "<ul>\n";
-    
-    // Add parent directory link if not at root
-    if (request_path != "/")
-    {
-        if (request_path[request_path.length() - 1] == '/')
-            request_path.erase(request_path.length() - 1);
-
-        std::string parent_path = request_path.substr(0, request_path.find_last_of('/'));
-        if (parent_path.empty())
-            parent_path = "/";
-        response << "<li><a href=\"" << parent_path << "\"> <i class=\"fa-solid fa-arrow-left\" style=\"margin-right: 20px; font-wieght : 700; color : rgb(235, 219, 52);\"></i>Parent Directory</a></li>\n";
-    }
-    while ((entry = readdir(dir)) != NULL)
-    {
-        std::string rs_name;//ressource name
-  
-        rs_name = entry->d_name;
-        if (rs_name == "." || rs_name == "..")
-            continue;
-        // Making !!! sure path ends with a slash
-        std::string href_path = path;
-        if (request_path[request_path.length()-1] != '/')
-            request_path += "/";
-        /*
-            std::cout << "[ DEBUG ] : request_path : " << request_path << std::endl;
-            std::cout << "[ DEBUG ] : rs_name : " << rs_name << std::endl;
-            std::cout << "[ DEBUG ] : href_path : " << href_path << std::endl;
-        */
-        response << "<li> <a href=\"" << request_path << rs_name;
-        if (entry->d_type == DT_DIR)
-           response << "/\" class=\"folder\"> <i class=\"fa-solid fa-folder\" style=\"margin-right: 20px; font-wieght : 700; color : rgb(235, 219, 52);\"></i>"  << rs_name << "/";
-        else if (entry->d_type == DT_REG)
-            response << "\" class=\"file\"> <i class=\"fa-solid fa-file\" style=\"margin-right: 20px; \" ></i>" << rs_name;
-        response << "</a></li>\n";
+        LOG_DEBUG("Auto indexing is disabled for this location.");
+        return false;
     }
-    response << "</ul>\n";
-    response << "</body>\n";
-    response << "</html>\n";
-    closedir(dir);
-    return response.str();
+    // rendered once per directory mtime, then sent from the cache file like any static file
+    int listing_fd = DirectoryListing::Lookup(path, dir_stat, request->GetLocation(), format, listing, listing_stat);
+    if (listing_fd < 0)
+        return false;
+    response->setContentType(DirectoryListing::ContentType(format));
+    response->setBuffer("");
+    response->setBodyFile(listing, listing_fd);
+    response->setByteToSend(listing_stat.st_size);
+    response->setChunked(listing_stat.st_size > 1000000);
+    return true;
 }
 
 /*
@@ -184,46 +153,27 @@ std::string Get::ListingDir(const std::string &path, std::string request_path, c
     }
 */
 
-std::string Get::determineContentType(const std::string& path)
-{
-    int size;
-    size_t dot_pos;
-    
-    std::string contentType[] = { "html", "css", "js", "png", "jpeg", "gif", "json", "xml" , "pdf", "mp4", "mpeg", "x-www-form-urlencoded", "form-data", "woff2", "woff", "zip", "csv"};
-    std::string contenetFormat[] = { "text/html", "text/css", "application/javascript", "image/png", "image/jpeg", "image/gif", "application/json", "application/xml", "application/pdf", "video/mp4", "audio/mpeg", "application/x-www-form-urlencoded", "multipart/form-data", "font/woff2", "font/woff", "application/zip", "text/csv"};
-    size = sizeof(contentType) / sizeof(contentType[0]);
-    dot_pos = path.rfind('.');
-    if (dot_pos != std::string::npos)
-    {
-        std::string ext = path.substr(dot_pos + 1);
-        for (int i = 0; i < size; i++)
-            if (contentType[i] == ext)
-        return contenetFormat[i];
-    }
-    return "text/plain";
-}
-
-std::string Get::CheckIndexFile(const std::string &rel_path, const Location *cur_location, const ServerConfig &serverConfig)
+std::string Get::CheckIndexFile(const std::string &rel_path, const Location *cur_location, const ServerConfig &serverConfig, struct stat &file_stat)
 {
     std::string indexFile;
     
     if (!cur_location)
     {
-        std::cout << "[ DEBUG ] : No matching location found, using server index file: " << indexFile << std::endl;
+        LOG_DEBUG("No matching location found, using server index file: " << indexFile);
         // this was updtated to use the server's index file as a vector of strings
         if (serverConfig.get_index().empty())
         {
-            std::cerr << "[ ERROR ] : No index file specified in server configuration." << std::endl;
+            LOG_DEBUG("No index file specified in server configuration.");
             return "";
         }
         // Check if the server's index file exists
         for (size_t i = 0; i < serverConfig.get_index().size(); i++)
         {
-            std::cout << "[ DEBUG ] : Checking index file: " << serverConfig.get_index()[i] << std::endl;
+            LOG_DEBUG("Checking index file: " << serverConfig.get_index()[i]);
             indexFile = rel_path + serverConfig.get_index()[i];
-            if (IsFile(indexFile))
+            if (IsFile(indexFile, file_stat))
             {
-                std::cout << "[ DEBUG ] : Index file found at: " << indexFile << std::endl;
+                LOG_DEBUG("Index file found at: " << indexFile);
                 return indexFile;
             }
         }
@@ -235,10 +185,10 @@ std::string Get::CheckIndexFile(const std::string &rel_path, const Location *cur
         for (size_t i = 0; i < cur_location->get_index().size(); i++)
         {
             indexFile = rel_path + cur_location->get_index()[i];
-            std::cout << "[ DEBUG ] : Checking index file: " << indexFile << std::endl;
-            if (IsFile(indexFile))
+            LOG_DEBUG("Checking index file: " << indexFile);
+            if (IsFile(indexFile, file_stat))
             {
-                std::cout << "[ DEBUG ] : Index file found at: " << indexFile << std::endl;
+                LOG_DEBUG("Index file found at: " << indexFile);
                 return indexFile;
             }
         }
@@ -251,104 +201,350 @@ void    Get::ProccessRequest(HttpRequest *request,const ServerConfig &serverConf
 {
     std::string rel_path;
     const Location *cur_location;
-    std::cout << "[DEBUG ]: --- PROCCESSING GET REQUEST ---\n";
+    LOG_DEBUG("--- PROCCESSING GET REQUEST ---");
     
     if (!request)
     {
-        std::cerr << "Error: Null request pointer\n";
+        LOG_ERROR("Null request pointer");
         throw HttpException(500, "Internal Server Error", INTERNAL_SERVER_ERROR);
     }
     if (!request->GetClientDatat())
     {
-        std::cerr << "Error: Null client data pointer\n";
+        LOG_ERROR("Null client data pointer");
         throw HttpException(500, "Internal Server Error", INTERNAL_SERVER_ERROR);
     }
     // Get the current location from the server configuration
     cur_location = clientConfig.findBestMatchingLocation(request->GetLocation());
-    std::cout << "[ Debug ] rel LOCATION: " << request->GetLocation() << std::endl;
-    std::cout << "[ Debug ] client location server name: " << clientConfig.get_server_name()<< std::endl;
-    std::cout << "[ Debug ] client location server name: " << request->GetClientDatat()->getServerConfig().get_server_name() << std::endl;
+    LOG_DEBUG("rel LOCATION: " << request->GetLocation());
+    LOG_DEBUG("client location server name: " << clientConfig.get_server_name());
+    LOG_DEBUG("client location server name: " << request->GetClientDatat()->getServerConfig().get_server_name());
     
     rel_path = request->GetRelativePath(cur_location, request->GetClientDatat());
     if (rel_path.empty())
     {
-        std::cerr << "[empty rel_path Not Found ]\n";
+        LOG_DEBUG("[empty rel_path Not Found ]");
         throw HttpException(404, "404 Not Found", NOT_FOUND);
     }
-    // Check if the relative path is valid
-    rel_path =  IsValidPath(rel_path);
+    // Check if the relative path is valid, this stat is reused for the validators and ranges
+    struct stat file_stat;
+    rel_path =  IsValidPath(rel_path, file_stat);
     if (rel_path.empty())
     {
-        std::cerr << "[ Debug ] : file is not a Valid one \n";
+        LOG_DEBUG("file is not a Valid one ");
         throw HttpException(404, "404 Not Found", NOT_FOUND);
     }
     else
-        std::cout << "[Debug] : Valid Path Found : " << rel_path << std::endl;
-    if (IsDir(rel_path))
+        LOG_DEBUG("Valid Path Found : " << rel_path);
+    if (S_ISDIR(file_stat.st_mode))
     {
-        std::cout << "IS DIIIIIIIIIIIIRECTORY !!!!!!!!!!!!!!!!!!!!!!!!!!!!" << std::endl;
+        LOG_DEBUG(rel_path << " is a directory");
         request->GetClientDatat()->http_response->setStatusCode(200);
         request->GetClientDatat()->http_response->setStatusMessage("OK");
         request->GetClientDatat()->http_response->setContentType("text/html");
         request->GetClientDatat()->http_response->setChunked(false);
         /*
         // std::cout << "[Debug] : Index file check for current location : " << cur_location->get_index() << std::endl;
-        std::cout << "[Debug] : Checking error page for the server configuration :" << std::endl;
+        LOG_DEBUG("Checking error page for the server configuration :");
         std::map<short, std::string> error_page = serverConfig.get_error_pages();
         for (std::map<short, std::string>::iterator i =error_page.begin(); i != error_page.end(); i++)
         {
-            std::cout << "Error Code: " << i->first << ", Page: " << i->second << std::endl;
+            LOG_DEBUG("Error Code: " << i->first << ", Page: " << i->second);
         }
         */
         /* check if there is any valid index file from the list of index files !!!*/
-        std::string indexFile = CheckIndexFile(rel_path, cur_location, clientConfig);
+        struct stat dir_stat = file_stat;
+        std::string indexFile = CheckIndexFile(rel_path, cur_location, clientConfig, file_stat);
         if (!indexFile.empty())
         {
-            // I'm supponsing that the default max size of file to be sent at once is 1MB 
-            // checking if file  size is less than 1MB or not to shoose the right way to send the file
-            request->GetClientDatat()->http_response->setByteToSend(GetFileSize(indexFile));
-            if (request->GetClientDatat()->http_response->getByteToSend() > 1000000 )
-            {
-
-                // std::cout << "[Debug] : File size is greater than 1MB, sending as chunked response." << std::endl;
-                request->GetClientDatat()->http_response->setChunked(true);
-            }
-            else
-            {
-                // std::cout << "[Debug] : File size is less than 1MB, sending as normal response." << std::endl;
-                request->GetClientDatat()->http_response->setChunked(false);
-            }
-            std::cout << "[Debug] : Index file found : " << indexFile << std::endl;
-            request->GetClientDatat()->http_response->setFilePath(indexFile);
-            request->GetClientDatat()->http_response->setContentType(determineContentType(indexFile));
+            LOG_DEBUG("Index file found : " << indexFile);
+            request->GetClientDatat()->http_response->setContentType(MimeTypes::TypeOf(indexFile));
             request->GetClientDatat()->http_response->setBuffer("");
+            ServeFile(request, indexFile, file_stat, cur_location, serverConfig);
             return;
         }
         else
         {
-            std::string response = ListingDir(rel_path, request->GetLocation(), cur_location, serverConfig);
-            if (response.empty())
+            if (!ListingDir(request, rel_path, dir_stat, cur_location, serverConfig))
                    throw HttpException(403, "403 Forbidden", FORBIDDEN);
-            request->GetClientDatat()->http_response->setBuffer(response);
             return;
         }
     }
     else
     {
-        std::cout << "[Debug] : File is a regular file.!!!!!!!!!!!!!!!!!!!!" << std::endl;
-        request->GetClientDatat()->http_response->setByteToSend(GetFileSize(rel_path));
-        std::cout << "[Debug] : File size to send: " << request->GetClientDatat()->http_response->getByteToSend() << " bytes." << std::endl;
-        if (request->GetClientDatat()->http_response->getByteToSend() > 1000000)
+        LOG_DEBUG("File is a regular file.!!!!!!!!!!!!!!!!!!!!");
+        ServeFile(request, rel_path, file_stat, cur_location, serverConfig);
+        return;
+    }
+}
+
+void    Get::ServeFile(HttpRequest *request, const std::string &path, const struct stat &original_stat, const Location *cur_location, const ServerConfig &serverConfig)
+{
+    HttpResponse *response = request->GetClientDatat()->http_response;
+    struct stat file_stat = original_stat;
+    // the validators and ranges below describe the representation actually sent
+    std::string send_path = NegotiateEncoding(request, path, cur_location, file_stat);
+    std::string etag = MakeETag(file_stat);
+
+    response->setHeader("ETag", etag);
+    // on-the-fly gzip is decided here as GzipFilter::Apply will decide it for the 200,
+    // a 304 has to carry the same validator and Vary
+    bool gzipped = false;
+    if (response->getHeader("Content-Encoding").empty())
+    {
+        std::string type = response->getContentType().empty() ? MimeTypes::TypeOf(path) : response->getContentType();
+        bool vary;
+        GzipFilter::Format format;
+        gzipped = GzipFilter::Negotiate(type, file_stat.st_size, *request, serverConfig, vary, format);
+        if (vary)
+            response->setHeader("Vary", "Accept-Encoding");
+    }
+    response->setHeader("Last-Modified", HttpResponse::httpDate(file_stat.st_mtime));
+    if (NotModified(request, etag, file_stat.st_mtime))
+    {
+        LOG_DEBUG("Client copy of " << path << " is current, 304");
+        // Apply weakens the tag of the encoded 200, it leaves 304s alone
+        if (gzipped)
+            response->setHeader("ETag", "W/" + etag);
+        response->setStatusCode(304);
+        response->setStatusMessage("Not Modified");
+        response->setFilePath("");
+        response->setByteToSend(0);
+        response->setChunked(false);
+        response->setNoBody(true);
+        return;
+    }
+    response->setFilePath(send_path);
+    response->setByteToSend(file_stat.st_size);
+    response->setHeader("Accept-Ranges", "bytes");
+    ApplyRange(request, path, file_stat);
+    LOG_DEBUG("File size to send: " << response->getByteToSend() << " bytes.");
+    // I'm supponsing that the default max size of file to be sent at once is 1MB 
+    // checking if file  size is less than 1MB or not to shoose the right way to send the file
+    if (response->getByteToSend() > 1000000)
+    {
+        LOG_DEBUG("File size is greater than 1MB, sending as chunked response.");
+        response->setChunked(true);
+    }
+    else
+    {
+        LOG_DEBUG("File size is less than 1MB, sending as normal response.");
+        response->setChunked(false);
+    }
+}
+
+/*
+    gzip_static / brotli_static: when the client accepts it and a precompressed
+    sibling (file.css.br, file.css.gz) exists, send that one instead. Returns
+    the path to send and updates file_stat to describe it; the sibling lookups
+    come from the open file cache.
+*/
+std::string Get::NegotiateEncoding(HttpRequest *request, const std::string &path, const Location *cur_location, struct stat &file_stat)
+{
+    HttpResponse *response = request->GetClientDatat()->http_response;
+
+    if (!cur_location || (!cur_location->get_gzipStatic() && !cur_location->get_brotliStatic()))
+        return path;
+    // the answer depends on Accept-Encoding whether or not a variant is used
+    response->setHeader("Vary", "Accept-Encoding");
+    response->setContentType(MimeTypes::TypeOf(path));
+
+    double br_quality = cur_location->get_brotliStatic() ? request->GetEncodingQuality("br") : 0;
+    double gzip_quality = cur_location->get_gzipStatic() ? request->GetEncodingQuality("gzip") : 0;
+    struct stat variant_stat;
+
+    // brotli wins ties, it is the smaller one
+    if (br_quality > 0 && br_quality >= gzip_quality && OpenFileCache::LookupVariant(path, ".br", variant_stat))
+    {
+        response->setHeader("Content-Encoding", "br");
+        file_stat = variant_stat;
+        return path + ".br";
+    }
+    if (gzip_quality > 0 && OpenFileCache::LookupVariant(path, ".gz", variant_stat))
+    {
+        response->setHeader("Content-Encoding", "gzip");
+        file_stat = variant_stat;
+        return path + ".gz";
+    }
+    if (br_quality > 0 && OpenFileCache::LookupVariant(path, ".br", variant_stat))
+    {
+        response->setHeader("Content-Encoding", "br");
+        file_stat = variant_stat;
+        return path + ".br";
+    }
+    return path;
+}
+
+// Strong validator: changes whenever the file is replaced, resized or rewritten
+std::string Get::MakeETag(const struct stat &file_stat)
+{
+    std::stringstream etag;
+    etag << "\"" << std::hex << file_stat.st_ino << "-" << file_stat.st_size << "-"
+         << (static_cast<unsigned long long>(file_stat.st_mtim.tv_sec) * 1000 + file_stat.st_mtim.tv_nsec / 1000000) << "\"";
+    return etag.str();
+}
+
+/*
+    If-None-Match wins over If-Modified-Since (RFC 7232 6), both only ever
+    turn a 200 into a 304.
+*/
+bool    Get::NotModified(HttpRequest *request, const std::string &etag, time_t mtime)
+{
+    std::string if_none_match = request->GetHeader("If-None-Match");
+    if (!if_none_match.empty())
+    {
+        std::istringstream iss(if_none_match);
+        std::string tag;
+        while (std::getline(iss, tag, ','))
         {
-            std::cout << "[Debug] : File size is greater than 1MB, sending as chunked response." << std::endl;
-            request->GetClientDatat()->http_response->setChunked(true);
+            tag.erase(0, tag.find_first_not_of(" \t"));
+            tag.erase(tag.find_last_not_of(" \t") + 1);
+            // weak comparison
+            if (tag.compare(0, 2, "W/") == 0)
+                tag.erase(0, 2);
+            if (tag == "*" || tag == etag)
+                return true;
+        }
+        return false;
+    }
+
+    std::string if_modified_since = request->GetHeader("If-Modified-Since");
+    if (if_modified_since.empty())
+        return false;
+    struct tm since;
+    memset(&since, 0, sizeof(since));
+    if (strptime(if_modified_since.c_str(), "%a, %d %b %Y %H:%M:%S GMT", &since) == NULL)
+        return false;
+    return mtime <= timegm(&since);
+}
+
+/*
+    Range: bytes=0-499, 1000-, -200
+    Returns false when the header is not a byte range we understand (the whole
+    file is served then); `ranges` only keeps the satisfiable ones, sorted and
+    with overlapping/adjacent spans merged.
+*/
+bool    Get::ParseRange(const std::string &header, off_t file_size, std::vector<std::pair<off_t, off_t> > &ranges)
+{
+    if (header.compare(0, 6, "bytes=") != 0)
+        return false;
+    std::istringstream iss(header.substr(6));
+    std::string spec;
+    size_t count = 0;
+
+    while (std::getline(iss, spec, ','))
+    {
+        spec.erase(0, spec.find_first_not_of(" \t"));
+        spec.erase(spec.find_last_not_of(" \t") + 1);
+        size_t dash = spec.find('-');
+        if (dash == std::string::npos || ++count > MAX_BYTE_RANGES)
+            return false;
+        std::string first = spec.substr(0, dash);
+        std::string last = spec.substr(dash + 1);
+        if (first.find_first_not_of("0123456789") != std::string::npos
+            || last.find_first_not_of("0123456789") != std::string::npos
+            || (first.empty() && last.empty()))
+            return false;
+
+        off_t start, end;
+        if (first.empty())
+        {
+            // suffix range: the last N bytes
+            off_t suffix = strtoll(last.c_str(), NULL, 10);
+            if (suffix == 0)
+                continue;
+            start = suffix >= file_size ? 0 : file_size - suffix;
+            end = file_size - 1;
         }
         else
         {
-            std::cout << "[Debug] : File size is less than 1MB, sending as normal response." << std::endl;
-            request->GetClientDatat()->http_response->setChunked(false);
+            start = strtoll(first.c_str(), NULL, 10);
+            end = last.empty() ? start : strtoll(last.c_str(), NULL, 10);
+            if (end < start)
+                return false;
+            if (start >= file_size)
+                continue;
+            if (last.empty())
+                end = file_size - 1;
+            if (end >= file_size)
+                end = file_size - 1;
         }
-        request->GetClientDatat()->http_response->setFilePath(rel_path);
+        ranges.push_back(std::make_pair(start, end));
+    }
+
+    std::sort(ranges.begin(), ranges.end());
+    std::vector<std::pair<off_t, off_t> > merged;
+    for (size_t i = 0; i < ranges.size(); ++i)
+    {
+        if (!merged.empty() && ranges[i].first <= merged.back().second + 1)
+            merged.back().second = std::max(merged.back().second, ranges[i].second);
+        else
+            merged.push_back(ranges[i]);
+    }
+    ranges.swap(merged);
+    return true;
+}
+
+void    Get::ApplyRange(HttpRequest *request, const std::string &path, const struct stat &file_stat)
+{
+    std::string range_header = request->GetHeader("Range");
+    if (range_header.empty())
+        return;
+
+    // If-Range: only honour the range when the client's copy is still current,
+    // an entity tag must match strongly, anything else is taken as a date
+    std::string if_range = request->GetHeader("If-Range");
+    bool is_etag = !if_range.empty() && (if_range[0] == '"' || if_range.compare(0, 2, "W/") == 0);
+    if (!if_range.empty() && (is_etag ? if_range != MakeETag(file_stat)
+                                      : if_range != HttpResponse::httpDate(file_stat.st_mtime)))
+    {
+        LOG_DEBUG("If-Range does not match, sending the whole file");
         return;
     }
-}
\ No newline at end of file
+
+    HttpResponse *response = request->GetClientDatat()->http_response;
+    std::vector<std::pair<off_t, off_t> > ranges;
+    off_t file_size = file_stat.st_size;
+    if (!ParseRange(range_header, file_size, ranges))
+        return;
+
+    std::stringstream total;
+    total << file_size;
+    if (ranges.empty())
+    {
+        response->setStatusCode(416);
+        response->setStatusMessage("Range Not Satisfiable");
+        response->setHeader("Content-Range", "bytes */" + total.str());
+        response->setFilePath("");
+        response->setByteToSend(0);
+        response->setNoBody(true);
+        return;
+    }
+
+    response->setStatusCode(206);
+    response->setStatusMessage("Partial Content");
+    if (ranges.size() == 1)
+    {
+        std::stringstream content_range;
+        content_range << "bytes " << ranges[0].first << "-" << ranges[0].second << "/" << file_size;
+        response->setHeader("Content-Range", content_range.str());
+        response->addFileSegment(ranges[0].first, ranges[0].second - ranges[0].first + 1);
+    }
+    else
+    {
+        std::stringstream boundary;
+        boundary << std::hex << file_stat.st_ino << file_stat.st_mtime << time(NULL);
+        std::string content_type = MimeTypes::TypeOf(path);
+        for (size_t i = 0; i < ranges.size(); ++i)
+        {
+            std::stringstream part;
+            part << "\r\n--" << boundary.str() << "\r\n"
+                 << "Content-Type: " << content_type << "\r\n"
+                 << "Content-Range: bytes " << ranges[i].first << "-" << ranges[i].second << "/" << file_size << "\r\n\r\n";
+            response->addBufferSegment(part.str());
+            response->addFileSegment(ranges[i].first, ranges[i].second - ranges[i].first + 1);
+        }
+        response->addBufferSegment("\r\n--" + boundary.str() + "--\r\n");
+        response->setContentType("multipart/byteranges; boundary=" + boundary.str());
+    }
+    response->setByteToSend(response->getSegmentsLength());
+}
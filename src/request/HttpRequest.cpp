@@ -1,4 +1,5 @@
 #include "../../include/request/HttpRequest.hpp"
+#include "../../include/Logger.hpp"
 #include "../../include/ClientConnection.hpp"
 
 HttpRequest::HttpRequest()
@@ -46,6 +47,37 @@ std::string HttpRequest::GetHeader(std::string key) const
     return "";
 }
 
+// q-value of a content-coding in Accept-Encoding ("gzip;q=0.8, br, *;q=0")
+double  HttpRequest::GetEncodingQuality(const std::string &coding) const
+{
+    std::istringstream iss(this->GetHeader("Accept-Encoding"));
+    std::string item;
+    double wildcard = 0;
+    bool has_wildcard = false;
+
+    while (std::getline(iss, item, ','))
+    {
+        std::string name = item.substr(0, item.find(';'));
+        name.erase(0, name.find_first_not_of(" \t"));
+        name.erase(name.find_last_not_of(" \t") + 1);
+        for (size_t i = 0; i < name.length(); ++i)
+            name[i] = std::tolower(name[i]);
+
+        double quality = 1;
+        size_t q = item.find("q=");
+        if (q != std::string::npos)
+            quality = strtod(item.c_str() + q + 2, NULL);
+        if (name == coding)
+            return quality;
+        if (name == "*")
+        {
+            wildcard = quality;
+            has_wildcard = true;
+        }
+    }
+    return has_wildcard ? wildcard : 0;
+}
+
 std::map<std::string, std::string> HttpRequest::GetHeaders() const
 {
     return _headers;
@@ -99,7 +131,7 @@ size_t  GetFileSize(std::string &file)
 
     if (stat(file.c_str(), &_stat_info) != 0)
     {
-        std::cerr << "[ ERROR ] : File does not exist: " << file << std::endl;
+        LOG_ERROR("File does not exist: " << file);
         return 0;
     }
     return _stat_info.st_size;
@@ -273,59 +305,59 @@ std::string HttpRequest::GetRelativePath(const Location *cur_location, ClientCon
     char cwd[PATH_MAX];
     if (getcwd(cwd, sizeof(cwd)) == NULL)
     {
-        std::cerr << "[ ERROR ] : Failed to get current working directory." << std::endl;
+        LOG_ERROR("Failed to get current working directory.");
         cwd[0] = '\0';
     }
     if (!cur_location)
     {
         rel_path = join_path(join_path(cwd, client->getServerConfig().get_root()), this->GetLocation());
         rel_path = ensure_trailing_slash(rel_path);
-        std::cout << "[ WARNING ] : No matching location found, using server root: " << rel_path << std::endl;
-        std::cout << "[ INFO ] : Current working directory: " << cwd << std::endl;
+        LOG_DEBUG("No matching location found, using server root: " << rel_path);
+        LOG_DEBUG("Current working directory: " << cwd);
         return rel_path;
     }
-    std::cout << "[ DEBUG ] : Current location path: RETUN------------------" << cur_location->get_return().empty() << std::endl;
+    LOG_DEBUG("Current location path: RETUN------------------" << cur_location->get_return().empty());
     if (cur_location->get_return().empty())
     {
-        std::cerr << "[ ERROR ] : Location return is empty." << std::endl;
+        LOG_DEBUG("Location return is empty.");
         // return "";
     }
     else
     {
-        std::cout << "[ DEBUG ] : Location return isn't empty "  << std::endl;
+        LOG_DEBUG("Location return isn't empty ");
     }
     if (!cur_location->get_return().empty())
     {
         // std::cout << ""
         SetIsRedirected(true);
-        std::cout << "\n\n\n-------------------------[ DEBUG ] : [ORIGIN ]Redirecting to : " 
+        LOG_DEBUG("-------------------------[ DEBUG ] : [ORIGIN ]Redirecting to : " 
                   << cur_location->get_path() << "------" << cur_location->get_return()[1] 
-                  << "------------------\n\n" << std::endl;
+                  << "------------------");
         client->redirect_counter++;
         rel_path = cur_location->get_return()[1];
-        std::cout << "[ INFO ] : Current working directory: " << cwd << std::endl;
+        LOG_DEBUG("Current working directory: " << cwd);
         return rel_path;
     }
     else if (!cur_location->get_alias().empty())
     {
-        std::cout << "[ DEBUG ] : Using alias : " << cur_location->get_alias() << std::endl;
+        LOG_DEBUG("Using alias : " << cur_location->get_alias());
         rel_path = join_path(join_path(cwd, client->getServerConfig().get_root()), cur_location->get_alias());
     }
     else if (!cur_location->get_root_location().empty())
     {
-        std::cout << "[ DEBUG ] : Using root location : " << cur_location->get_root_location() << std::endl;
+        LOG_DEBUG("Using root location : " << cur_location->get_root_location());
         rel_path = join_path(join_path(join_path(cwd, client->getServerConfig().get_root()), cur_location->get_root_location()), this->GetLocation());
     }
     else if (rel_path.empty())
     {
-        std::cerr << "[ WARNING ] : No alias or root location specified, using server root." << std::endl;
-        std::cout << "[ Server Root Path :" << client->getServerConfig().get_root() << " ]\n";
+        LOG_DEBUG("No alias or root location specified, using server root.");
+        LOG_DEBUG("[ Server Root Path :" << client->getServerConfig().get_root() << " ]");
         rel_path = join_path(join_path(cwd, client->getServerConfig().get_root()), this->GetLocation());
     }
     rel_path = ensure_trailing_slash(rel_path);
 
-    std::cout << "[------------ FInal rel_path :" << rel_path << " ----------------------]\n";
-    std::cout << "[ INFO ] : Current working directory: " << cwd << std::endl;
+    LOG_DEBUG("[------------ FInal rel_path :" << rel_path << " ----------------------]");
+    LOG_DEBUG("Current working directory: " << cwd);
     return rel_path;
 }
 
@@ -365,7 +397,7 @@ void HttpRequest::handleRedirect(const Location *cur_location, std::string &rel_
 
     ss << cur_location->get_return()[0];
     ss >> status_code;
-    std::cout << "[REDIRECTED TO : " << rel_path << " ]" << std::endl;
+    LOG_DEBUG("[REDIRECTED TO : " << rel_path << " ]");
     
     this->GetClientDatat()->http_response->setStatusCode(status_code);
     this->GetClientDatat()->http_response->setStatusMessage(GetRedirectionMessage(status_code));
@@ -374,7 +406,7 @@ void HttpRequest::handleRedirect(const Location *cur_location, std::string &rel_
     
     if (status_code == 307 || status_code == 308)
     {
-        std::cout << "[ INFO ] : Handling " << status_code << " redirect with method preservation" << std::endl;
+        LOG_DEBUG("Handling " << status_code << " redirect with method preservation");
         
         this->GetClientDatat()->http_response->setHeader("X-Original-Method", this->GetMethod());
         
@@ -391,7 +423,7 @@ void HttpRequest::handleRedirect(const Location *cur_location, std::string &rel_
             if (!content_type.empty())
             {
                 this->GetClientDatat()->http_response->setHeader("Content-Type", content_type);
-                std::cout << "[ INFO ] : Setting Content-Type: " << content_type << std::endl;
+                LOG_DEBUG("Setting Content-Type: " << content_type);
             }
             
             std::stringstream ss_content_length;
@@ -402,22 +434,22 @@ void HttpRequest::handleRedirect(const Location *cur_location, std::string &rel_
             if (body_size > MAX_ALLOWED_BODY_SIZE)
             {
                 // For extremely large bodies, reject the redirect to prevent server overload
-                std::cerr << "[ ERROR ] : Body size (" << body_size << " bytes) exceeds maximum allowed size for redirect" << std::endl;
+                LOG_ERROR("Body size (" << body_size << " bytes) exceeds maximum allowed size for redirect");
                 
                 this->GetClientDatat()->http_response->setStatusCode(413); // Payload Too Large
                 this->GetClientDatat()->http_response->setStatusMessage("Payload Too Large");
                 this->GetClientDatat()->http_response->setBuffer("Request body too large for redirect operation");
                 
                 // Log the rejection for monitoring
-                std::cerr << "[ PERFORMANCE ] : Rejected redirect due to excessive body size: " 
-                          << body_size << " bytes (limit: " << MAX_ALLOWED_BODY_SIZE << ")" << std::endl;
+                LOG_WARN("[ PERFORMANCE ] : Rejected redirect due to excessive body size: " 
+                          << body_size << " bytes (limit: " << MAX_ALLOWED_BODY_SIZE << ")");
                 return;
             }
             else if (body_size > CRITICAL_BODY_SIZE)
             {
                 // For very large bodies, use streaming approach or chunked transfer
-                std::cout << "[ WARNING ] : Critical body size (" << body_size << " bytes) in " 
-                          << status_code << " redirection - using optimized handling" << std::endl;
+                LOG_WARN("Critical body size (" << body_size << " bytes) in " 
+                          << status_code << " redirection - using optimized handling");
                 
                 // Set chunked transfer for large bodies to avoid memory issues
                 this->GetClientDatat()->http_response->setChunked(true);
@@ -433,14 +465,14 @@ void HttpRequest::handleRedirect(const Location *cur_location, std::string &rel_
                 this->GetClientDatat()->http_response->setBuffer(minimal_body);
                 
                 // Log performance impact
-                std::cout << "[ PERFORMANCE ] : Using chunked transfer for large body redirect: " 
-                          << body_size << " bytes" << std::endl;
+                LOG_DEBUG("[ PERFORMANCE ] : Using chunked transfer for large body redirect: " 
+                          << body_size << " bytes");
             }
             else if (body_size > MAX_BODY_SIZE_FOR_REDIRECT)
             {
                 // For moderately large bodies, include metadata but optimize memory usage
-                std::cout << "[ WARNING ] : Large body size (" << body_size << " bytes) in " 
-                          << status_code << " redirection - applying performance optimizations" << std::endl;
+                LOG_WARN("Large body size (" << body_size << " bytes) in " 
+                          << status_code << " redirection - applying performance optimizations");
                 
                 this->GetClientDatat()->http_response->setHeader("X-Large-Content", "true");
                 
@@ -459,8 +491,8 @@ void HttpRequest::handleRedirect(const Location *cur_location, std::string &rel_
                         std::string preview = this->GetBody().substr(0, PREVIEW_SIZE) + "... [truncated]";
                         this->GetClientDatat()->http_response->setBuffer(preview);
                         this->GetClientDatat()->http_response->setHeader("X-Body-Truncated", "true");
-                        std::cout << "[ PERFORMANCE ] : Body truncated for redirect response (preview: " 
-                                  << PREVIEW_SIZE << " bytes)" << std::endl;
+                        LOG_DEBUG("[ PERFORMANCE ] : Body truncated for redirect response (preview: " 
+                                  << PREVIEW_SIZE << " bytes)");
                     }
                     else
                     {
@@ -474,15 +506,15 @@ void HttpRequest::handleRedirect(const Location *cur_location, std::string &rel_
                 }
                 
                 // Log performance metrics
-                std::cout << "[ PERFORMANCE ] : Handling large body redirect: " 
-                          << body_size << " bytes (threshold: " << MAX_BODY_SIZE_FOR_REDIRECT << ")" << std::endl;
+                LOG_DEBUG("[ PERFORMANCE ] : Handling large body redirect: " 
+                          << body_size << " bytes (threshold: " << MAX_BODY_SIZE_FOR_REDIRECT << ")");
             }
             else
             {
                 // For small bodies, include normally
                 this->GetClientDatat()->http_response->setBuffer(this->GetBody());
-                std::cout << "[ INFO ] : Including original body in redirect response (" 
-                          << body_size << " bytes)" << std::endl;
+                LOG_DEBUG("Including original body in redirect response (" 
+                          << body_size << " bytes)");
             }
             
             // Additional performance headers for client optimization
@@ -500,14 +532,14 @@ void HttpRequest::handleRedirect(const Location *cur_location, std::string &rel_
         else
         {
             this->GetClientDatat()->http_response->setBuffer(" ");
-            std::cout << "[ INFO ] : Empty body in redirect" << std::endl;
+            LOG_DEBUG("Empty body in redirect");
         }
     }
     else
     {
         // For non-method-preserving redirects (301, 302, 303), don't include body
-        std::cout << "[ INFO ] : Standard redirect " << status_code 
-                  << ", not preserving body (performance optimized)" << std::endl;
+        LOG_DEBUG("Standard redirect " << status_code 
+                  << ", not preserving body (performance optimized)");
         this->GetClientDatat()->http_response->setBuffer(" ");
         
         // Still log if original request had large body for monitoring
@@ -516,8 +548,8 @@ void HttpRequest::handleRedirect(const Location *cur_location, std::string &rel_
             size_t original_body_size = this->GetBody().size();
             if (original_body_size > 1024 * 1024) // 1MB
             {
-                std::cout << "[ PERFORMANCE ] : Discarded large body (" << original_body_size 
-                          << " bytes) in standard redirect for performance" << std::endl;
+                LOG_DEBUG("[ PERFORMANCE ] : Discarded large body (" << original_body_size 
+                          << " bytes) in standard redirect for performance");
             }
         }
     }
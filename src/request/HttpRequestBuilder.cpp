@@ -1,4 +1,5 @@
 #include "../../include/request/HttpRequestBuilder.hpp"
+#include "../../include/Logger.hpp"
 #include "../../include/config/Location.hpp"
 HttpRequestBuilder::HttpRequestBuilder()
 {
@@ -95,7 +96,7 @@ void    HttpRequestBuilder::TrimPath(std::string &path)
 
 void HttpRequestBuilder::ParseRequestLine(std::string &request_line,const ServerConfig &serverConfig)
 {
-    std::cout << "[INFO] : PARSING REQ LINE !!!!!!!!!!!!!!\n";
+    LOG_DEBUG("PARSING REQ LINE !!!!!!!!!!!!!!");
     // decode the request line
     std::string         decoded_request_line = UrlDecode(request_line);
     std::istringstream  iss(decoded_request_line);
@@ -105,9 +106,9 @@ void HttpRequestBuilder::ParseRequestLine(std::string &request_line,const Server
     TrimPath(path);
     
     // Debug the raw request line and parsed components
-    std::cout << "Raw request line: '" << request_line << "'" << std::endl;
-    std::cout << "Decoded request line: '" << decoded_request_line << "'" << std::endl;
-    std::cout << "Parsed method: '" << method << "', path: '" << path << "', version: '" << http_version << "'" << std::endl;
+    LOG_DEBUG("Raw request line: '" << request_line << "'");
+    LOG_DEBUG("Decoded request line: '" << decoded_request_line << "'");
+    LOG_DEBUG("Parsed method: '" << method << "', path: '" << path << "', version: '" << http_version << "'");
     
     // check if the request line is a query string ?
     if (path.find("?") != std::string::npos)
@@ -118,21 +119,21 @@ void HttpRequestBuilder::ParseRequestLine(std::string &request_line,const Server
         std::string query_string = path.substr(pos + 1);
         path = path.substr(0, pos);
         this->_http_request.SetQueryStringStr(query_string);
-        std::cout << "Extracted query string: '" << query_string << "'" << std::endl;
-        std::cout << "Updated path: '" << path << "'" << std::endl;
+        LOG_DEBUG("Extracted query string: '" << query_string << "'");
+        LOG_DEBUG("Updated path: '" << path << "'");
         ParseQueryString(query_string);
     }
     _http_request.SetRequestLine(request_line);
     //check crlf of the request line
-    std::cout << "<< RL :: " << _http_request.GetRequestLine() << ";;   >>>\n";
-    std::cout << "Methode :" << method << "\n";
-    std::cout << "Location :" << path << "\n";
-    std::cout << "Http Version:" << http_version << "\n";
+    LOG_DEBUG("<< RL :: " << _http_request.GetRequestLine() << ";;   >>>");
+    LOG_DEBUG("Methode :" << method);
+    LOG_DEBUG("Location :" << path);
+    LOG_DEBUG("Http Version:" << http_version);
 
     // check if the request line is valid
     if (http_version != "HTTP/1.1" && http_version != "HTTP/1.0")
     {
-        std::cerr << "HTTP VERSION ERROR\n";
+        LOG_INFO("HTTP VERSION ERROR");
         // exit(2);
         _http_request.SetIsRl(REQ_HTTP_VERSION_ERROR);
         return;
@@ -144,7 +145,7 @@ void HttpRequestBuilder::ParseRequestLine(std::string &request_line,const Server
         _http_request.SetIsRl(REQ_LOCATION_ERROR);
         return;
     }
-    std::cout << "HTTP LOCATION TEST passed!!\n";
+    LOG_DEBUG("HTTP LOCATION TEST passed!!");
     _http_request.SetLocation(path);
     // check if the method is valid
 
@@ -152,11 +153,11 @@ void HttpRequestBuilder::ParseRequestLine(std::string &request_line,const Server
     // check if the method is valid
         check for location -> default locatoin -> error page 404
 
-        std::cout << "PATH (( " << path << "  ))\n";  
+        LOG_DEBUG("PATH (( " << path << "  ))");  
         if (cur_location)
-            std::cout << "CURRENT LOCATION EXIST !!!!!!!!!!!!!---" << cur_location->get_path() << "==" << cur_location->get_allowMethods().size() << "===" << cur_location->get_root_location() << std::endl;
+            LOG_DEBUG("CURRENT LOCATION EXIST !!!!!!!!!!!!!---" << cur_location->get_path() << "==" << cur_location->get_allowMethods().size() << "===" << cur_location->get_root_location());
         else
-            std::cout << "CURRENT LOCATION DOESN'T EXIST !!!!!!!!!!!!!\n";
+            LOG_DEBUG("CURRENT LOCATION DOESN'T EXIST !!!!!!!!!!!!!");
     */
     // need to intergate the conf file congiguration!!!
     std::vector<std::string> valid_methods;
@@ -178,11 +179,11 @@ void HttpRequestBuilder::ParseRequestLine(std::string &request_line,const Server
     const Location *cur_location = serverConfig.findMatchingLocation(path);
     if (cur_location && !cur_location->is_method_allowed(method))
     {
-        std::cout << "NOT VALID METHOD >>>>>>>>>> " << method <<std::endl;
+        LOG_DEBUG("NOT VALID METHOD >>>>>>>>>> " << method);
         _http_request.SetIsRl(REQ_METHOD_ERROR);
         return;
     }
-    std::cout << "Http METHOD TEST passed!!\n";
+    LOG_DEBUG("Http METHOD TEST passed!!");
 
     _http_request.SetMethod(method);
     _http_request.SetIsRl(REQ_DONE);
@@ -203,7 +204,7 @@ void HttpRequestBuilder::ParseRequsetHeaders(std::istringstream &iss)
         size_t pos = line.find(":");
         if (pos == std::string::npos)
         {
-            std::cerr << "Malformed Header: Missing ':'" << std::endl;
+            LOG_INFO("Malformed Header: Missing ':'");
             throw HttpException(400, "Malformed Header: Missing ':'", BAD_REQUEST);
         }
         key = line.substr(0, pos);
@@ -219,7 +220,8 @@ void HttpRequestBuilder::ParseRequsetHeaders(std::istringstream &iss)
 
         if (!value.empty())
         {
-            std::cout << "Header Key: [" << key << "] (" << key.length() << "), Value: [" << value << "] (" << value.length() << ")" << std::endl;
+            // the value stays out of the log, it may be a cookie or credentials
+            LOG_DEBUG("Header Key: [" << Logger::Escape(key) << "] (" << key.length() << "), value of " << value.length() << " bytes");
         }
 
         _http_request.SetHeader(key, value);
@@ -235,15 +237,15 @@ void HttpRequestBuilder::ParseRequestBody(std::string &body)
 
 void HttpRequestBuilder::ParseRequest(std::string &rawRequest,const ServerConfig &serverConfig)
 {
-    std::cout << "Parsing the Request !!!!!!!!!\n";
+    LOG_DEBUG("Parsing the Request !!!!!!!!!");
     
     // Split the raw request into lines
     if (rawRequest.find("\r\n") == std::string::npos && rawRequest.find("/r/n/r/n") == std::string::npos)
     {
-        std::cerr << "Invalid request format" << std::endl;
+        LOG_INFO("Invalid request format");
         throw HttpException(400, "Bad Request", BAD_REQUEST);
     }
-    std::cout << "Crlf Test is BEING PASSED WELL!!!\n";
+    LOG_DEBUG("Crlf Test is BEING PASSED WELL!!!");
     
     // Find the separation between headers and body
     size_t bodyStart = rawRequest.find("\r\n\r\n");
@@ -282,9 +284,9 @@ void HttpRequestBuilder::ParseRequest(std::string &rawRequest,const ServerConfig
     ParseRequestLine(line, serverConfig);
     if (_http_request.GetIsRl() != REQ_DONE)
     {
-        std::cerr << "Invalid request line" << std::endl;
-        std::cerr << "Debug - Request status: " << _http_request.GetIsRl() << std::endl;
-        std::cerr << "Method: '" << _http_request.GetMethod() << "', Location: '" << _http_request.GetLocation() << "'" << std::endl;
+        LOG_INFO("Invalid request line");
+        LOG_DEBUG("Debug - Request status: " << _http_request.GetIsRl());
+        LOG_DEBUG("Method: '" << _http_request.GetMethod() << "', Location: '" << _http_request.GetLocation() << "'");
         
         if (_http_request.GetIsRl() == REQ_HTTP_VERSION_ERROR)
         {
@@ -292,17 +294,17 @@ void HttpRequestBuilder::ParseRequest(std::string &rawRequest,const ServerConfig
         }
         else if (_http_request.GetIsRl() == METHOD_NOT_ALLOWED)
         {
-            std::cerr << "Method error: '" << _http_request.GetMethod() << "'" << std::endl;
+            LOG_INFO("Method error: '" << _http_request.GetMethod() << "'");
             throw HttpException(405, "Bad Request - Method Not Allowed", METHOD_NOT_ALLOWED);
         }
         else if (_http_request.GetIsRl() == REQ_METHOD_ERROR)
         {
-            std::cerr << "Method error: '" << _http_request.GetMethod() << "'" << std::endl;
+            LOG_INFO("Method error: '" << _http_request.GetMethod() << "'");
             throw HttpException(405, "Bad Request - Invalid Method", BAD_REQUEST);
         }
         else if (_http_request.GetIsRl() == REQ_LOCATION_ERROR)
         {
-            std::cerr << "Location error: '" << _http_request.GetLocation() << "'" << std::endl;
+            LOG_INFO("Location error: '" << _http_request.GetLocation() << "'");
             throw HttpException(404, "Not Found - Invalid Location", NOT_FOUND);
         }
         else if (_http_request.GetIsRl() == REQ_NOT_IMPLEMENTED)
@@ -320,7 +322,7 @@ void HttpRequestBuilder::ParseRequest(std::string &rawRequest,const ServerConfig
     ParseRequsetHeaders(iss);
     if (_http_request.GetStatus() != PARSER)
     {
-        std::cerr << "Invalid headers" << std::endl;
+        LOG_INFO("Invalid headers");
         if (_http_request.GetIsRl() == REQ_HTTP_VERSION_ERROR)
             throw HttpException(400, "HTTP Version Not Supported", BAD_REQUEST);
         else if (_http_request.GetIsRl() == REQ_METHOD_ERROR || _http_request.GetIsRl() == REQ_LOCATION_ERROR)
@@ -336,7 +338,7 @@ void HttpRequestBuilder::ParseRequest(std::string &rawRequest,const ServerConfig
     std::string contentLength = _http_request.GetHeader("Content-Length");
     if (!contentLength.empty())
     {
-        size_t expectedLength;
+        size_t expectedLength = 0;
         std::stringstream ss(contentLength);
         ss >> expectedLength;
         
@@ -347,21 +349,21 @@ void HttpRequestBuilder::ParseRequest(std::string &rawRequest,const ServerConfig
                 // We have the complete body in the initial read
                 bodyPart = bodyPart.substr(0, expectedLength);
                 ParseRequestBody(bodyPart);
-                std::cout << "Complete body received: " << bodyPart.size() << " bytes" << std::endl;
+                LOG_DEBUG("Complete body received: " << bodyPart.size() << " bytes");
             }
             else
             {
                 // CRITICAL FIX: Don't set incomplete body!
                 // Let ClientConnection handle reading the rest
-                std::cout << "Body incomplete: got " << bodyPart.size() 
+                LOG_DEBUG("Body incomplete: got " << bodyPart.size() 
                          << " bytes, expected " << expectedLength 
-                         << " - will read remaining data" << std::endl;
+                         << " - will read remaining data");
                 // Don't call ParseRequestBody here - let ClientConnection handle it
             }
         }
         else if (expectedLength > 0)
         {
-            std::cout << "No body in initial read, expecting " << expectedLength << " bytes" << std::endl;
+            LOG_DEBUG("No body in initial read, expecting " << expectedLength << " bytes");
             // Don't set body - let ClientConnection handle reading it
         }
     }
@@ -369,11 +371,11 @@ void HttpRequestBuilder::ParseRequest(std::string &rawRequest,const ServerConfig
     {
         // No Content-Length but we have body data - set it
         ParseRequestBody(bodyPart);
-        std::cout << "Body set without Content-Length: " << bodyPart.size() << " bytes" << std::endl;
+        LOG_DEBUG("Body set without Content-Length: " << bodyPart.size() << " bytes");
     }
     else
     {
-        std::cout << "No body found in request" << std::endl;
+        LOG_DEBUG("No body found in request");
     }
 }
 
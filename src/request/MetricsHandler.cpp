@@ -0,0 +1,52 @@
+#include "../../include/request/MetricsHandler.hpp"
+#include "../../include/request/CgiHandler.hpp"
+#include "../../include/Metrics.hpp"
+#include "../../include/Logger.hpp"
+
+MetricsHandler::MetricsHandler(ClientConnection* client) : _client(client) {}
+
+MetricsHandler::~MetricsHandler() {}
+
+// the matched location when it serves metrics or stub_status, NULL otherwise
+const Location *MetricsHandler::statusLocation(HttpRequest *request) const
+{
+    if (!request || !_client || !_client->_server)
+        return NULL;
+    const Location *location = _client->_server->getConfigForClient(_client->GetFd()).findMatchingLocation(request->GetLocation());
+    if (location && (location->get_metrics() || location->get_stubStatus()))
+        return location;
+    return NULL;
+}
+
+bool MetricsHandler::CanHandle(std::string method)
+{
+    return (method == "GET" || method == "HEAD") && statusLocation(_client->http_request) != NULL;
+}
+
+void MetricsHandler::ProccessRequest(HttpRequest *request, const ServerConfig &serverConfig, ServerConfig clientConfig)
+{
+    (void)serverConfig;
+    (void)clientConfig;
+    HttpResponse *response = request->GetClientDatat()->http_response;
+    const Location *location = statusLocation(request);
+
+    response->setStatusCode(200);
+    response->setStatusMessage(response->GetStatusMessage(200));
+    response->setHeader("Cache-Control", "no-store");
+    if (request->GetMethod() == "HEAD")
+        response->setNoBody(true);
+    if (location->get_metrics())
+    {
+        LOG_DEBUG("Metrics scrape from " << _client->ipAddress);
+        Metrics::Set(Metrics::CONNECTIONS_ACTIVE, _client->_server->connectionCount());
+        Metrics::Set(Metrics::CGI_ACTIVE, CgiHandler::active_cgis.size());
+        response->setContentType(METRICS_CONTENT_TYPE);
+        response->setBuffer(Metrics::Render());
+    }
+    else
+    {
+        LOG_DEBUG("Status report for " << _client->ipAddress);
+        response->setContentType("text/plain");
+        response->setBuffer(_client->_server->statusReport(_client->GetFd()));
+    }
+}
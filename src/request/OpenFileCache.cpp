@@ -0,0 +1,99 @@
+#include "../../include/request/OpenFileCache.hpp"
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+std::map<std::string, OpenFileCache::Entry> OpenFileCache::_entries;
+
+OpenFileCache::Entry & OpenFileCache::Fetch(const std::string &path)
+{
+    time_t now = time(NULL);
+    std::map<std::string, Entry>::iterator it = _entries.find(path);
+
+    if (it != _entries.end() && now - it->second.validated < OPEN_FILE_CACHE_VALID)
+        return it->second;
+
+    if (it == _entries.end())
+    {
+        if (_entries.size() >= OPEN_FILE_CACHE_MAX)
+            Prune(now);
+        it = _entries.insert(std::make_pair(path, Entry())).first;
+    }
+    // (re)validate: siblings are looked up again lazily
+    Entry &entry = it->second;
+    entry = Entry();
+    entry.exists = (stat(path.c_str(), &entry.st) == 0);
+    entry.validated = now;
+    return entry;
+}
+
+void OpenFileCache::Prune(time_t now)
+{
+    std::map<std::string, Entry>::iterator it = _entries.begin();
+    while (it != _entries.end())
+    {
+        if (now - it->second.validated >= OPEN_FILE_CACHE_VALID)
+            _entries.erase(it++);
+        else
+            ++it;
+    }
+    if (_entries.size() < OPEN_FILE_CACHE_MAX)
+        return;
+
+    // everything is fresh: drop the OPEN_FILE_CACHE_EVICT least recently validated,
+    // the hot entries stay cached
+    std::vector<time_t> validated;
+    validated.reserve(_entries.size());
+    for (it = _entries.begin(); it != _entries.end(); ++it)
+        validated.push_back(it->second.validated);
+    std::nth_element(validated.begin(), validated.begin() + (OPEN_FILE_CACHE_EVICT - 1), validated.end());
+    time_t cutoff = validated[OPEN_FILE_CACHE_EVICT - 1];
+
+    // strictly older first, then those validated at the cutoff second until the batch is full
+    size_t evicted = 0;
+    for (it = _entries.begin(); it != _entries.end(); )
+    {
+        if (it->second.validated < cutoff)
+        {
+            _entries.erase(it++);
+            ++evicted;
+        }
+        else
+            ++it;
+    }
+    for (it = _entries.begin(); it != _entries.end() && evicted < OPEN_FILE_CACHE_EVICT; )
+    {
+        if (it->second.validated == cutoff)
+        {
+            _entries.erase(it++);
+            ++evicted;
+        }
+        else
+            ++it;
+    }
+}
+
+bool OpenFileCache::Lookup(const std::string &path, struct stat &st)
+{
+    Entry &entry = Fetch(path);
+    if (entry.exists)
+        st = entry.st;
+    return entry.exists;
+}
+
+// suffix is ".gz" or ".br", only regular files count as a usable variant
+bool OpenFileCache::LookupVariant(const std::string &path, const std::string &suffix, struct stat &st)
+{
+    Entry &entry = Fetch(path);
+    Variant &variant = (suffix == ".br") ? entry.brotli : entry.gzip;
+
+    if (!variant.checked)
+    {
+        std::string variant_path = path + suffix;
+        variant.exists = (stat(variant_path.c_str(), &variant.st) == 0 && S_ISREG(variant.st.st_mode));
+        variant.checked = true;
+    }
+    if (variant.exists)
+        st = variant.st;
+    return variant.exists;
+}
@@ -1,4 +1,6 @@
 #include "../include/request/Post.hpp"
+#include "../include/Logger.hpp"
+#include "../include/response/MimeTypes.hpp"
 #include <iostream>
 #include <sstream>
 #include <ctime>
@@ -39,9 +41,9 @@ void Post::ProccessRequest(HttpRequest *request, const ServerConfig &serverConfi
     
     std::string location = request->GetLocation();
     
-    std::cout << "POST request to: " << location << std::endl;
-    std::cout << "Content-Type: " << contentType << std::endl;
-    std::cout << "Body size: " << body.size() << " bytes" << std::endl;
+    LOG_DEBUG("POST request to: " << location);
+    LOG_DEBUG("Content-Type: " << contentType);
+    LOG_DEBUG("Body size: " << body.size() << " bytes");
     
     // Handle streaming or direct upload files
     if (body.find("__STREAMING_UPLOAD_FILE:") != std::string::npos ||
@@ -55,7 +57,7 @@ void Post::ProccessRequest(HttpRequest *request, const ServerConfig &serverConfi
         // Check if this is a duplicate processing attempt
         static std::set<std::string> processed_files;
         if (processed_files.find(file_path) != processed_files.end()) {
-            std::cout << "File already processed, skipping duplicate processing: " << file_path << std::endl;
+            LOG_DEBUG("File already processed, skipping duplicate processing: " << file_path);
             std::stringstream ss;
             ss << "File uploaded successfully: " << file_path;
             setSuccessResponse(request, ss.str());
@@ -95,16 +97,16 @@ void Post::ProccessRequest(HttpRequest *request, const ServerConfig &serverConfi
     }
     else {
         // More detailed error message for unsupported content types
-        std::cout << "Unsupported content type: " << contentType << std::endl;
+        LOG_DEBUG("Unsupported content type: " << contentType);
         setErrorResponse(request, 415, "Unsupported Media Type. Supported types: multipart/form-data, application/x-www-form-urlencoded, text/plain, application/json");
     }
 }
 
 void Post::handleUrlEncodedForm(HttpRequest *request) {
-    std::cout << "Handling URL-encoded form data" << std::endl;
+    LOG_DEBUG("Handling URL-encoded form data");
     
     std::string body = request->GetBody();
-    std::cout << "Form data: " << body << std::endl;
+    LOG_DEBUG("Form data: " << body);
     
     std::map<std::string, std::string> formData = parseUrlEncodedForm(body);
     
@@ -126,14 +128,14 @@ void Post::handleUrlEncodedForm(HttpRequest *request) {
     response << "</ul><p><a href=\"/\">Back to Home</a></p></body></html>";
     setSuccessResponse(request, response.str());
     
-    std::cout << "URL-encoded form processed successfully" << std::endl;
+    LOG_DEBUG("URL-encoded form processed successfully");
 }
 
 void Post::handlePlainText(HttpRequest *request) {
-    std::cout << "Handling plain text data" << std::endl;
+    LOG_DEBUG("Handling plain text data");
     
     std::string body = request->GetBody();
-    std::cout << "Text data: " << body << std::endl;
+    LOG_DEBUG("Text data: " << body);
     
     std::stringstream response;
     response << "<!DOCTYPE html><html><head><title>Text Received</title>";
@@ -148,14 +150,14 @@ void Post::handlePlainText(HttpRequest *request) {
     
     setSuccessResponse(request, response.str());
     
-    std::cout << "Plain text processed successfully" << std::endl;
+    LOG_DEBUG("Plain text processed successfully");
 }
 
 void Post::handleJsonData(HttpRequest *request) {
-    std::cout << "Handling JSON data" << std::endl;
+    LOG_DEBUG("Handling JSON data");
     
     std::string body = request->GetBody();
-    std::cout << "JSON data: " << body << std::endl;
+    LOG_DEBUG("JSON data: " << body);
     
     std::stringstream response;
     response << "<!DOCTYPE html><html><head><title>JSON Received</title>";
@@ -170,7 +172,7 @@ void Post::handleJsonData(HttpRequest *request) {
     
     setSuccessResponse(request, response.str());
     
-    std::cout << "JSON data processed successfully" << std::endl;
+    LOG_DEBUG("JSON data processed successfully");
 }
 
 // Add this debug code to your Post.cpp in handleMultipartForm method:
@@ -181,70 +183,56 @@ void Post::handleMultipartForm(HttpRequest *request, const std::string &boundary
     // ✅ ADD THIS CHECK TO PREVENT DUPLICATE PROCESSING
     if (body.find("__DIRECT_UPLOAD_FILE:") != std::string::npos ||
         body.find("__STREAMING_UPLOAD_FILE:") != std::string::npos) {
-        std::cout << "File already processed via streaming, skipping multipart processing" << std::endl;
+        LOG_DEBUG("File already processed via streaming, skipping multipart processing");
         setSuccessResponse(request, "File uploaded successfully");
         return;
     }
     
-    std::cout << "handleMultipartForm called with boundary: " << boundary << std::endl;
+    LOG_DEBUG("handleMultipartForm called with boundary: " << boundary);
 
-    std::cout << "Body size for parsing: " << body.size() << " bytes" << std::endl;
+    LOG_DEBUG("Body size for parsing: " << body.size() << " bytes");
     
     // Flag to track if we've already processed the upload
     bool fileProcessed = false;
     
     // DEBUG: Print the first 500 characters of the body to see the structure
-    std::cout << "=== BODY PREVIEW (first 500 chars) ===" << std::endl;
+    LOG_DEBUG("=== BODY PREVIEW (first 500 chars) ===");
     std::string preview = body.substr(0, std::min((size_t)500, body.size()));
-    for (size_t i = 0; i < preview.length(); ++i) {
-        char c = preview[i];
-        if (c == '\r') std::cout << "\\r";
-        else if (c == '\n') std::cout << "\\n";
-        else if (c >= 32 && c <= 126) std::cout << c;
-        else std::cout << "[" << (int)c << "]";
-    }
-    std::cout << std::endl << "=== END BODY PREVIEW ===" << std::endl;
+    LOG_DEBUG(Logger::Escape(preview));
+    LOG_DEBUG("=== END BODY PREVIEW ===");
     
     // DEBUG: Check what the boundary looks like
-    std::cout << "Boundary: '" << boundary << "'" << std::endl;
-    std::cout << "Looking for: '--" << boundary << "'" << std::endl;
+    LOG_DEBUG("Boundary: '" << boundary << "'");
+    LOG_DEBUG("Looking for: '--" << boundary << "'");
     
     // DEBUG: Check if boundary exists in body
     std::string fullBoundary = "--" + boundary;
     size_t boundaryPos = body.find(fullBoundary);
     if (boundaryPos != std::string::npos) {
-        std::cout << "Found boundary at position: " << boundaryPos << std::endl;
+        LOG_DEBUG("Found boundary at position: " << boundaryPos);
     } else {
-        std::cout << "ERROR: Boundary not found in body!" << std::endl;
-        std::cout << "Searching for variations..." << std::endl;
+        LOG_WARN("Boundary not found in body!");
+        LOG_DEBUG("Searching for variations...");
         
         // Try different boundary formats
         if (body.find(boundary) != std::string::npos) {
-            std::cout << "Found boundary without '--' prefix" << std::endl;
+            LOG_DEBUG("Found boundary without '--' prefix");
         }
         if (body.find("\r\n--" + boundary) != std::string::npos) {
-            std::cout << "Found boundary with \\r\\n-- prefix" << std::endl;
+            LOG_DEBUG("Found boundary with \\r\\n-- prefix");
         }
         if (body.find("\n--" + boundary) != std::string::npos) {
-            std::cout << "Found boundary with \\n-- prefix" << std::endl;
+            LOG_DEBUG("Found boundary with \\n-- prefix");
         }
         
         // Print first few boundary-like strings found in body
-        std::cout << "Looking for any '--' sequences in body:" << std::endl;
+        LOG_DEBUG("Looking for any '--' sequences in body:");
         size_t pos = 0;
         int count = 0;
         while ((pos = body.find("--", pos)) != std::string::npos && count < 3) {
             size_t endPos = std::min(pos + 50, body.length());
             std::string boundaryCandidate = body.substr(pos, endPos - pos);
-            std::cout << "Found '--' at position " << pos << ": '";
-            for (size_t i = 0; i < boundaryCandidate.length(); ++i) {
-                char c = boundaryCandidate[i];
-                if (c == '\r') std::cout << "\\r";
-                else if (c == '\n') std::cout << "\\n";
-                else if (c >= 32 && c <= 126) std::cout << c;
-                else break;
-            }
-            std::cout << "'" << std::endl;
+            LOG_DEBUG("Found '--' at position " << pos << ": '" << Logger::Escape(boundaryCandidate) << "'");
             pos++;
             count++;
         }
@@ -252,7 +240,7 @@ void Post::handleMultipartForm(HttpRequest *request, const std::string &boundary
     
     // Special handling for small files
     if (body.size() < 1024 * 10) { // Less than 10KB
-        std::cout << "Small file detected, using enhanced parsing for small files" << std::endl;
+        LOG_DEBUG("Small file detected, using enhanced parsing for small files");
         
         // Check if this is a simple form with just one file
         size_t contentDispositionPos = body.find("Content-Disposition:");
@@ -264,7 +252,7 @@ void Post::handleMultipartForm(HttpRequest *request, const std::string &boundary
             
             if (filenameEnd != std::string::npos) {
                 std::string filename = body.substr(filenamePos, filenameEnd - filenamePos);
-                std::cout << "Detected filename in small file: " << filename << std::endl;
+                LOG_DEBUG("Detected filename in small file: " << filename);
                 
                 // Find the start of the file content (after the double CRLF)
                 size_t contentStart = body.find("\r\n\r\n", filenameEnd);
@@ -319,11 +307,11 @@ void Post::handleMultipartForm(HttpRequest *request, const std::string &boundary
                         std::vector<FormPart> manualParts;
                         manualParts.push_back(part);
                         
-                        std::cout << "Manually created form part for small file:" << std::endl;
-                        std::cout << "  Name: " << part.name << std::endl;
-                        std::cout << "  Filename: " << part.filename << std::endl;
-                        std::cout << "  Content-Type: " << part.contentType << std::endl;
-                        std::cout << "  Content size: " << part.body.size() << " bytes" << std::endl;
+                        LOG_DEBUG("Manually created form part for small file:");
+                        LOG_DEBUG("  Name: " << part.name);
+                        LOG_DEBUG("  Filename: " << part.filename);
+                        LOG_DEBUG("  Content-Type: " << part.contentType);
+                        LOG_DEBUG("  Content size: " << part.body.size() << " bytes");
                         
                         // Process the manually created parts
                         processFormParts(request, manualParts);
@@ -339,7 +327,7 @@ void Post::handleMultipartForm(HttpRequest *request, const std::string &boundary
         std::vector<FormPart> parts = parseMultipartForm(body, boundary);
         
         if (parts.empty()) {
-            std::cout << "ERROR: parseMultipartForm returned empty parts!" << std::endl;
+            LOG_WARN("parseMultipartForm returned empty parts!");
             setErrorResponse(request, 400, "No valid parts found in multipart form data");
             return;
         }
@@ -413,12 +401,12 @@ void Post::processFormParts(HttpRequest *request, const std::vector<FormPart> &p
 
 void Post::handleStreamingUpload(HttpRequest *request, const std::string &file_path, bool is_direct_upload) {
     std::string upload_type = is_direct_upload ? "direct" : "streaming";
-    std::cout << "Handling " << upload_type << " upload from: " << file_path << std::endl;
+    LOG_DEBUG("Handling " << upload_type << " upload from: " << file_path);
     
     // Check if this upload has already been processed
     std::string alreadyProcessed = request->GetHeader("X-Upload-Processed");
     if (alreadyProcessed == "true") {
-        std::cout << "Upload already processed, skipping duplicate processing" << std::endl;
+        LOG_DEBUG("Upload already processed, skipping duplicate processing");
         setSuccessResponse(request, "File uploaded successfully");
         return;
     }
@@ -426,35 +414,35 @@ void Post::handleStreamingUpload(HttpRequest *request, const std::string &file_p
     // Check if temp file exists and get its stats
     struct stat file_stat;
     if (stat(file_path.c_str(), &file_stat) == -1) {
-        std::cerr << "Upload file not found: " << file_path << " (errno: " << errno << ")" << std::endl;
+        LOG_WARN("Upload file not found: " << file_path << " (errno: " << errno << ")");
         setErrorResponse(request, 500, "Upload file not found or inaccessible");
         return;
     }
     
-    std::cout << "Temp file found with size: " << file_stat.st_size << " bytes" << std::endl;
+    LOG_DEBUG("Temp file found with size: " << file_stat.st_size << " bytes");
     
     // Verify file size against Content-Length (but don't be too strict)
     std::string contentLength = request->GetHeader("Content-Length");
     std::string content_type = request->GetHeader("Content-Type");
     
-    std::cout << "Content-Type: " << content_type << std::endl;
+    LOG_DEBUG("Content-Type: " << content_type);
     
     if (!contentLength.empty()) {
         size_t expectedSize = 0;
         std::stringstream ss(contentLength);
         ss >> expectedSize;
         
-        std::cout << "Verifying file size: expected " << expectedSize 
-                 << " bytes, actual " << file_stat.st_size << " bytes" << std::endl;
+        LOG_DEBUG("Verifying file size: expected " << expectedSize 
+                 << " bytes, actual " << file_stat.st_size << " bytes");
         
         // More lenient size checking
         if (file_stat.st_size > 0) {
             double percent_complete = (file_stat.st_size * 100.0 / expectedSize);
-            std::cout << "Upload completeness: " << percent_complete << "%" << std::endl;
+            LOG_DEBUG("Upload completeness: " << percent_complete << "%");
             
             // Only reject if file is suspiciously small (less than 50% of expected)
             if (percent_complete < 50.0 && file_stat.st_size < 1024) {
-                std::cout << "File appears incomplete and very small, waiting for more data" << std::endl;
+                LOG_DEBUG("File appears incomplete and very small, waiting for more data");
                 setErrorResponse(request, 202, "Upload incomplete, please retry");
                 return;
             }
@@ -485,38 +473,12 @@ void Post::handleStreamingUpload(HttpRequest *request, const std::string &file_p
                 
                 // If extension is still empty, try to guess from content-type
                 if (file_extension.empty()) {
-                    if (content_type.find("image/jpeg") != std::string::npos) {
-                        file_extension = ".jpg";
-                    } else if (content_type.find("image/png") != std::string::npos) {
-                        file_extension = ".png";
-                    } else if (content_type.find("image/gif") != std::string::npos) {
-                        file_extension = ".gif";
-                    } else if (content_type.find("text/html") != std::string::npos) {
-                        file_extension = ".html";
-                    } else if (content_type.find("text/css") != std::string::npos) {
-                        file_extension = ".css";
-                    } else if (content_type.find("application/javascript") != std::string::npos) {
-                        file_extension = ".js";
-                    } else if (content_type.find("application/json") != std::string::npos) {
-                        file_extension = ".json";
-                    } else if (content_type.find("application/pdf") != std::string::npos) {
-                        file_extension = ".pdf";
-                    } else if (content_type.find("application/zip") != std::string::npos) {
-                        file_extension = ".zip";
-                    } else if (content_type.find("video/mp4") != std::string::npos) {
-                        file_extension = ".mp4";
-                    } else if (content_type.find("video/webm") != std::string::npos) {
-                        file_extension = ".webm";
-                    } else if (content_type.find("video/") != std::string::npos) {
-                        file_extension = ".mp4"; // Default for videos
-                    } else if (content_type.find("audio/") != std::string::npos) {
-                        file_extension = ".mp3"; // Default for audio
-                    } else {
+                    file_extension = MimeTypes::ExtensionFor(content_type);
+                    if (file_extension.empty())
                         file_extension = ".bin"; // Default extension
-                    }
                 }
                 
-                std::cout << "Original filename: " << original_filename << std::endl;
+                LOG_DEBUG("Original filename: " << original_filename);
             }
         }
     }
@@ -536,7 +498,7 @@ void Post::handleStreamingUpload(HttpRequest *request, const std::string &file_p
             unique_filename = dest_path;
         }
         
-        std::cout << "Direct upload already at final destination: " << dest_path << std::endl;
+        LOG_DEBUG("Direct upload already at final destination: " << dest_path);
     } else {
         // For traditional uploads, determine destination as before
         std::string uploads_dir = getUploadsDirectory(request->GetClientDatat()->getServerConfig());
@@ -554,7 +516,7 @@ off_t content_offset = 0;
 size_t content_length = file_stat.st_size;
 
 if (is_direct_upload && content_type.find("multipart/form-data") != std::string::npos) {
-    std::cout << "Direct upload needs multipart header cleanup" << std::endl;
+    LOG_DEBUG("Direct upload needs multipart header cleanup");
     
     // Read the file to find where actual content starts
     int header_fd = open(file_path.c_str(), O_RDONLY);
@@ -571,7 +533,7 @@ if (is_direct_upload && content_type.find("multipart/form-data") != std::string:
             size_t content_start = header_data.find("\r\n\r\n");
             if (content_start != std::string::npos) {
                 content_offset = content_start + 4;
-                std::cout << "Found multipart content start at offset: " << content_offset << std::endl;
+                LOG_DEBUG("Found multipart content start at offset: " << content_offset);
                 
                 // Clean the file by removing the multipart headers
                 std::string clean_path = file_path + ".clean";
@@ -595,7 +557,7 @@ if (is_direct_upload && content_type.find("multipart/form-data") != std::string:
                     
                     // Replace the original file with the clean one
                     if (rename(clean_path.c_str(), file_path.c_str()) == 0) {
-                        std::cout << "Successfully cleaned multipart headers, removed " << content_offset << " bytes" << std::endl;
+                        LOG_DEBUG("Successfully cleaned multipart headers, removed " << content_offset << " bytes");
                         content_length = total_copied;
                     }
                 }
@@ -609,7 +571,7 @@ if (is_direct_upload && content_type.find("multipart/form-data") != std::string:
     
     if (is_direct_upload) {
         // Skip file copying for direct uploads
-        std::cout << "Direct upload - skipping file copy operation" << std::endl;
+        LOG_DEBUG("Direct upload - skipping file copy operation");
         
         // Get the file size as total_written
         total_written = file_stat.st_size;
@@ -620,7 +582,7 @@ if (is_direct_upload && content_type.find("multipart/form-data") != std::string:
         // Open source file
         int source_fd = open(file_path.c_str(), O_RDONLY);
         if (source_fd < 0) {
-            std::cerr << "Failed to open source file: " << strerror(errno) << std::endl;
+            LOG_ERROR("Failed to open source file: " << strerror(errno));
             setErrorResponse(request, 500, "Failed to process uploaded file");
             return;
         }
@@ -628,15 +590,15 @@ if (is_direct_upload && content_type.find("multipart/form-data") != std::string:
         // Seek to content start if needed
         if (content_offset > 0) {
             if (lseek(source_fd, content_offset, SEEK_SET) != content_offset) {
-                std::cerr << "Failed to seek to content start: " << strerror(errno) << std::endl;
+                LOG_ERROR("Failed to seek to content start: " << strerror(errno));
                 close(source_fd);
                 setErrorResponse(request, 500, "Failed to process uploaded file");
                 return;
             }
         }
         
-        std::cout << "Copying file from " << file_path << " to " << dest_path 
-                  << " (offset: " << content_offset << ", length: " << content_length << ")" << std::endl;
+        LOG_DEBUG("Copying file from " << file_path << " to " << dest_path 
+                  << " (offset: " << content_offset << ", length: " << content_length << ")");
         
         // Get uploads directory for traditional uploads
         std::string uploads_dir = getUploadsDirectory(request->GetClientDatat()->getServerConfig());
@@ -646,15 +608,15 @@ if (is_direct_upload && content_type.find("multipart/form-data") != std::string:
         
         // If file already exists (EEXIST), generate a new unique name and try again
         if (dest_fd < 0 && errno == EEXIST) {
-            std::cout << "File already exists, generating new unique name" << std::endl;
+            LOG_DEBUG("File already exists, generating new unique name");
             unique_filename = generateUniqueFilename(unique_filename); // Generate a new unique name
             dest_path = uploads_dir + "/" + unique_filename;
             dest_fd = open(dest_path.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
         }
         
         if (dest_fd < 0) {
-            std::cerr << "Failed to create destination file: " << dest_path 
-                     << " (errno: " << errno << ": " << strerror(errno) << ")" << std::endl;
+            LOG_ERROR("Failed to create destination file: " << dest_path 
+                     << " (errno: " << errno << ": " << strerror(errno) << ")");
             close(source_fd);
             setErrorResponse(request, 500, "Failed to save upload: " + std::string(strerror(errno)));
             return;
@@ -665,7 +627,7 @@ if (is_direct_upload && content_type.find("multipart/form-data") != std::string:
         ssize_t bytes_read, bytes_written;
         size_t remaining_content = content_length;
         
-        std::cout << "Starting file copy..." << std::endl;
+        LOG_DEBUG("Starting file copy...");
         
         while (remaining_content > 0 && (bytes_read = read(source_fd, buffer, std::min(sizeof(buffer), remaining_content))) > 0) {
             char* ptr = buffer;
@@ -674,7 +636,7 @@ if (is_direct_upload && content_type.find("multipart/form-data") != std::string:
             while (remaining_chunk > 0) {
                 bytes_written = write(dest_fd, ptr, remaining_chunk);
                 if (bytes_written <= 0) {
-                    std::cerr << "Write error: " << strerror(errno) << std::endl;
+                    LOG_ERROR("Write error: " << strerror(errno));
                     copy_success = false;
                     break;
                 }
@@ -688,31 +650,31 @@ if (is_direct_upload && content_type.find("multipart/form-data") != std::string:
             
             // Progress indicator for large files
             if (total_written % (1024 * 1024) == 0 || remaining_content == 0) {
-                std::cout << "Copied " << total_written << " / " << content_length << " bytes" << std::endl;
+                LOG_DEBUG("Copied " << total_written << " / " << content_length << " bytes");
             }
         }
         
         close(source_fd);
         close(dest_fd);
         
-        std::cout << "File copy completed. Total written: " << total_written << " bytes" << std::endl;
+        LOG_DEBUG("File copy completed. Total written: " << total_written << " bytes");
         
         // Clean up temporary file - use a mutex to prevent concurrent access issues
         static std::mutex temp_file_mutex;
         {
             std::lock_guard<std::mutex> lock(temp_file_mutex);
             if (unlink(file_path.c_str()) == 0) {
-                std::cout << "Temporary file deleted: " << file_path << std::endl;
+                LOG_DEBUG("Temporary file deleted: " << file_path);
             } else {
-                std::cerr << "Failed to delete temporary file: " << file_path 
-                         << " (errno: " << errno << ": " << strerror(errno) << ")" << std::endl;
+                LOG_ERROR("Failed to delete temporary file: " << file_path 
+                         << " (errno: " << errno << ": " << strerror(errno) << ")");
             }
         }
     }
     
     if (copy_success && (!is_direct_upload || total_written > 0)) {
-        std::cout << "✅ UPLOAD SUCCESS: " << dest_path 
-                  << " (" << total_written << " bytes)" << std::endl;
+        LOG_DEBUG("✅ UPLOAD SUCCESS: " << dest_path 
+                  << " (" << total_written << " bytes)");
         
         // Mark this upload as processed
         request->SetHeader("X-Upload-Processed", "true");
@@ -736,7 +698,7 @@ if (is_direct_upload && content_type.find("multipart/form-data") != std::string:
         
         setSuccessResponse(request, response.str());
     } else {
-        std::cerr << "❌ UPLOAD FAILED: Copy failed or no data written" << std::endl;
+        LOG_ERROR("❌ UPLOAD FAILED: Copy failed or no data written");
         setErrorResponse(request, 500, "Failed to save upload: " + std::string(strerror(errno)));
     }
 }
@@ -764,13 +726,13 @@ bool Post::saveFileInChunks(HttpRequest *request, const std::string &content, co
     std::string uploadsDir = getUploadsDirectory(request->GetClientDatat()->getServerConfig());
     std::string fullPath = uploadsDir + "/" + filename;
     
-    std::cout << "Attempting to save file to: " << fullPath << std::endl;
+    LOG_DEBUG("Attempting to save file to: " << fullPath);
     
     // Use low-level file operations for better control
     int fd = open(fullPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
     if (fd < 0) {
-        std::cerr << "Failed to open file for writing: " << fullPath 
-                 << " (errno: " << errno << ")" << std::endl;
+        LOG_ERROR("Failed to open file for writing: " << fullPath 
+                 << " (errno: " << errno << ")");
         return false;
     }
     
@@ -778,7 +740,7 @@ bool Post::saveFileInChunks(HttpRequest *request, const std::string &content, co
     size_t bytesWritten = 0;
     size_t chunkSize = CHUNK_SIZE;
     
-    std::cout << "Writing " << totalSize << " bytes in chunks of " << chunkSize << std::endl;
+    LOG_DEBUG("Writing " << totalSize << " bytes in chunks of " << chunkSize);
     
     while (bytesWritten < totalSize) {
         size_t remainingBytes = totalSize - bytesWritten;
@@ -787,8 +749,8 @@ bool Post::saveFileInChunks(HttpRequest *request, const std::string &content, co
         ssize_t written = write(fd, content.c_str() + bytesWritten, currentChunkSize);
         
         if (written < 0) {
-            std::cerr << "Error writing to file at position " << bytesWritten 
-                     << " (errno: " << errno << ")" << std::endl;
+            LOG_ERROR("Error writing to file at position " << bytesWritten 
+                     << " (errno: " << errno << ")");
             close(fd);
             return false;
         }
@@ -802,15 +764,15 @@ bool Post::saveFileInChunks(HttpRequest *request, const std::string &content, co
     struct stat st;
     if (stat(fullPath.c_str(), &st) == 0) {
         if (static_cast<size_t>(st.st_size) == totalSize) {
-            std::cout << "Successfully wrote " << totalSize << " bytes to " << fullPath << std::endl;
+            LOG_DEBUG("Successfully wrote " << totalSize << " bytes to " << fullPath);
             return true;
         } else {
-            std::cerr << "File size mismatch: expected " << totalSize 
-                     << " bytes, got " << st.st_size << " bytes" << std::endl;
+            LOG_WARN("File size mismatch: expected " << totalSize 
+                     << " bytes, got " << st.st_size << " bytes");
         }
     } else {
-        std::cerr << "Failed to stat file after writing: " << fullPath 
-                 << " (errno: " << errno << ")" << std::endl;
+        LOG_ERROR("Failed to stat file after writing: " << fullPath 
+                 << " (errno: " << errno << ")");
     }
     
     return false;
@@ -858,7 +820,7 @@ std::string Post::getUploadsDirectory(ServerConfig clientConf) {
     const Location *uploadLoc = clientConf.findMatchingLocation("/uploads");
     if (uploadLoc != NULL) {
         uploadsDir = uploadLoc->get_uploadStore();
-        std::cout << "Trying configured upload store: " << uploadsDir << std::endl;
+        LOG_DEBUG("Trying configured upload store: " << uploadsDir);
         
         // Test if it's writable by trying to create a test file
         std::string test_file = uploadsDir + "/test_write_access";
@@ -867,9 +829,9 @@ std::string Post::getUploadsDirectory(ServerConfig clientConf) {
             close(fd);
             unlink(test_file.c_str()); // Clean up test file
             is_writable = true;
-            std::cout << "Configured upload directory is writable" << std::endl;
+            LOG_DEBUG("Configured upload directory is writable");
         } else {
-            std::cerr << "Configured upload directory is not writable: " << strerror(errno) << std::endl;
+            LOG_ERROR("Configured upload directory is not writable: " << strerror(errno));
         }
     }
     
@@ -878,7 +840,7 @@ std::string Post::getUploadsDirectory(ServerConfig clientConf) {
         std::string serverRoot = clientConf.get_root();
         if (!serverRoot.empty()) {
             uploadsDir = serverRoot + "/uploads";
-            std::cout << "Trying server root upload directory: " << uploadsDir << std::endl;
+            LOG_DEBUG("Trying server root upload directory: " << uploadsDir);
             
             // Test if it's writable
             std::string test_file = uploadsDir + "/test_write_access";
@@ -887,9 +849,9 @@ std::string Post::getUploadsDirectory(ServerConfig clientConf) {
                 close(fd);
                 unlink(test_file.c_str()); // Clean up test file
                 is_writable = true;
-                std::cout << "Server root upload directory is writable" << std::endl;
+                LOG_DEBUG("Server root upload directory is writable");
             } else {
-                std::cerr << "Server root upload directory is not writable: " << strerror(errno) << std::endl;
+                LOG_ERROR("Server root upload directory is not writable: " << strerror(errno));
             }
         }
     }
@@ -899,7 +861,7 @@ std::string Post::getUploadsDirectory(ServerConfig clientConf) {
         char cwd[1024];
         if (getcwd(cwd, sizeof(cwd)) != NULL) {
             uploadsDir = std::string(cwd) + "/uploads";
-            std::cout << "Trying current directory upload path: " << uploadsDir << std::endl;
+            LOG_DEBUG("Trying current directory upload path: " << uploadsDir);
             
             // Test if it's writable
             std::string test_file = uploadsDir + "/test_write_access";
@@ -908,9 +870,9 @@ std::string Post::getUploadsDirectory(ServerConfig clientConf) {
                 close(fd);
                 unlink(test_file.c_str()); // Clean up test file
                 is_writable = true;
-                std::cout << "CWD upload directory is writable" << std::endl;
+                LOG_DEBUG("CWD upload directory is writable");
             } else {
-                std::cerr << "CWD upload directory is not writable: " << strerror(errno) << std::endl;
+                LOG_ERROR("CWD upload directory is not writable: " << strerror(errno));
             }
         }
     }
@@ -918,7 +880,7 @@ std::string Post::getUploadsDirectory(ServerConfig clientConf) {
     // 4. Final fallback: Use /tmp which should always be writable
     if (!is_writable) {
         uploadsDir = "/tmp/webserver_uploads";
-        std::cout << "Using /tmp fallback upload directory: " << uploadsDir << std::endl;
+        LOG_DEBUG("Using /tmp fallback upload directory: " << uploadsDir);
         is_writable = true; // Assume /tmp is writable
     }
     
@@ -941,30 +903,30 @@ std::string Post::getUploadsDirectory(ServerConfig clientConf) {
         
         struct stat st;
         if (stat(path_to_create.c_str(), &st) == -1) {
-            std::cout << "Creating directory: " << path_to_create << std::endl;
+            LOG_DEBUG("Creating directory: " << path_to_create);
             if (mkdir(path_to_create.c_str(), 0755) != 0) {
-                std::cerr << "Failed to create directory: " << path_to_create 
-                         << " (errno: " << errno << ": " << strerror(errno) << ")" << std::endl;
+                LOG_ERROR("Failed to create directory: " << path_to_create 
+                         << " (errno: " << errno << ": " << strerror(errno) << ")");
                 creation_error = true;
             } else {
-                std::cout << "Successfully created directory: " << path_to_create << std::endl;
+                LOG_DEBUG("Successfully created directory: " << path_to_create);
             }
         }
     }
     
     // If we had errors creating the recursive path, fall back to /tmp
     if (creation_error && uploadsDir != "/tmp/webserver_uploads") {
-        std::cerr << "Falling back to /tmp directory due to creation errors" << std::endl;
+        LOG_ERROR("Falling back to /tmp directory due to creation errors");
         uploadsDir = "/tmp/webserver_uploads";
         
         // Create /tmp/webserver_uploads
         struct stat st;
         if (stat(uploadsDir.c_str(), &st) == -1) {
             if (mkdir(uploadsDir.c_str(), 0755) != 0) {
-                std::cerr << "Failed to create fallback directory: " << uploadsDir 
-                         << " (errno: " << errno << ": " << strerror(errno) << ")" << std::endl;
+                LOG_ERROR("Failed to create fallback directory: " << uploadsDir 
+                         << " (errno: " << errno << ": " << strerror(errno) << ")");
             } else {
-                std::cout << "Successfully created fallback directory: " << uploadsDir << std::endl;
+                LOG_DEBUG("Successfully created fallback directory: " << uploadsDir);
             }
         }
     }
@@ -972,16 +934,16 @@ std::string Post::getUploadsDirectory(ServerConfig clientConf) {
     // Final verification
     struct stat st;
     if (stat(uploadsDir.c_str(), &st) == -1) {
-        std::cerr << "Warning: Upload directory doesn't exist: " << uploadsDir << std::endl;
+        LOG_WARN("Upload directory doesn't exist: " << uploadsDir);
         // Last ditch effort - use /tmp directly
         uploadsDir = "/tmp";
     } else if (!S_ISDIR(st.st_mode)) {
-        std::cerr << "Warning: Upload path exists but is not a directory: " << uploadsDir << std::endl;
+        LOG_WARN("Upload path exists but is not a directory: " << uploadsDir);
         // Last ditch effort - use /tmp directly
         uploadsDir = "/tmp";
     }
     
-    std::cout << "Final uploads directory: " << uploadsDir << std::endl;
+    LOG_DEBUG("Final uploads directory: " << uploadsDir);
     return uploadsDir;
 }
 
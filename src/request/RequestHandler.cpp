@@ -1,4 +1,5 @@
 #include "../../include/request/RequestHandler.hpp"
+#include "../../include/Logger.hpp"
 
 RequestHandler::RequestHandler():_nextHandler(NULL)
 {
@@ -27,21 +28,25 @@ void    RequestHandler::HandleRequest(HttpRequest *request, const ServerConfig &
 {
     if (!request)
     {
-        std::cerr << "Error: Null request in RequestHandler" << std::endl;
+        LOG_ERROR("Null request in RequestHandler");
         throw HttpException(500, "Internal Server Error", INTERNAL_SERVER_ERROR);
     }
     
     // Check if this request has already been processed
     if (request->IsProcessed())
     {
-        std::cout << "[DEBUG] Request already processed, skipping handler chain" << std::endl;
+        LOG_DEBUG("Request already processed, skipping handler chain");
         return;
     }
     /* check for redirection */
     std::string rel_path;
     // std::cout << "RequestHandler::HandleRequest=================" << std::endl;
-    std::cout << "[DEBUG] Handling request for location: " << request->GetLocation() << std::endl;
+    LOG_DEBUG("Handling request for location: " << request->GetLocation());
      const Location *cur_location = serverConfig.findMatchingLocation(request->GetLocation());
+    // every handler of the chain matches again, the first match is the routing phase
+    ClientConnection *client = request->GetClientDatat();
+    if (client && client->phases.routed.tv_sec == 0 && client->phases.routed.tv_nsec == 0)
+        ClientConnection::markPhase(client->phases.routed);
     rel_path = request->GetRelativePath(cur_location, request->GetClientDatat());
 
     if (request->IsRedirected())
@@ -59,7 +64,7 @@ void    RequestHandler::HandleRequest(HttpRequest *request, const ServerConfig &
         this->_nextHandler->HandleRequest(request, serverConfig, clientConfig);
     }
     else {
-        std::cerr << "No handler for method: " << request->GetMethod() << std::endl;
+        LOG_WARN("No handler for method: " << request->GetMethod());
         throw HttpException(501, "Not Implemented", NOT_IMPLEMENTED);
     }
 
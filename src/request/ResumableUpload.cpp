@@ -0,0 +1,507 @@
+#include "../../include/request/ResumableUpload.hpp"
+#include "../../include/Logger.hpp"
+#include "../../include/request/Post.hpp"
+#include "../../include/ClientConnection.hpp"
+#include "../../include/config/Location.hpp"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <cerrno>
+#include <ctime>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <dirent.h>
+
+ResumableUpload::ResumableUpload(ClientConnection* client) : _client(client) {}
+
+ResumableUpload::~ResumableUpload() {}
+
+bool ResumableUpload::IsChunkRequest(const HttpRequest &request)
+{
+    if (request.GetMethod() == "PATCH")
+        return true;
+    return request.GetMethod() == "PUT" && !request.GetHeader("Content-Range").empty();
+}
+
+bool ResumableUpload::CanHandle(std::string method)
+{
+    if (!_client || !_client->http_request)
+        return false;
+    HttpRequest *request = _client->http_request;
+    if (IsChunkRequest(*request))
+        return true;
+    if (method == "POST")
+        return !request->GetHeader("Upload-Length").empty();
+    if (method == "HEAD")
+        return !sessionId(request).empty();
+    return false;
+}
+
+void ResumableUpload::ProccessRequest(HttpRequest *request, const ServerConfig &serverConfig, ServerConfig clientConfig)
+{
+    (void)serverConfig;
+    (void)clientConfig;
+    std::string method = request->GetMethod();
+
+    LOG_DEBUG("Resumable upload " << method << " " << request->GetLocation());
+    if (method == "POST")
+        createSession(request);
+    else if (method == "HEAD")
+        reportOffset(request);
+    else
+        writeChunk(request);
+}
+
+/*
+    Session urls keep the upload location path (so its allow_methods and
+    client_max_body_size apply) and carry the id in the query string. The id
+    is only accepted when it looks like one we generated so it can't be used
+    to reach outside the uploads dir.
+*/
+std::string ResumableUpload::sessionId(HttpRequest *request) const
+{
+    std::istringstream query(request->GetQueryStringStr());
+    std::string param;
+    std::string id;
+    while (std::getline(query, param, '&'))
+    {
+        if (param.find(UPLOAD_ID_PARAM "=") == 0)
+            id = param.substr(param.find('=') + 1);
+    }
+
+    if (id.length() != UPLOAD_ID_LENGTH)
+        return "";
+    for (size_t i = 0; i < id.length(); ++i)
+    {
+        if (!isxdigit(static_cast<unsigned char>(id[i])))
+            return "";
+    }
+    return id;
+}
+
+std::string ResumableUpload::partPath(const Session &session) const
+{
+    return session.dir + "/." + session.id + ".part";
+}
+
+std::string ResumableUpload::infoPath(const Session &session) const
+{
+    return session.dir + "/." + session.id + ".info";
+}
+
+bool ResumableUpload::loadSession(HttpRequest *request, Session &session)
+{
+    session.id = sessionId(request);
+    if (session.id.empty())
+        return false;
+    Post post_handler;
+    session.dir = post_handler.getUploadsDirectory(_client->server_config);
+
+    if (expired(partPath(session), infoPath(session), time(NULL)))
+    {
+        LOG_INFO("Upload session " << session.id << " expired, removed");
+        unlink(partPath(session).c_str());
+        unlink(infoPath(session).c_str());
+        return false;
+    }
+    std::ifstream info(infoPath(session).c_str());
+    if (!info)
+        return false;
+    std::string key;
+    while (info >> key)
+    {
+        if (key == "length")
+            info >> session.length;
+        else if (key == "filename")
+        {
+            std::getline(info, session.filename);
+            session.filename.erase(0, session.filename.find_first_not_of(' '));
+        }
+    }
+    return session.length > 0;
+}
+
+// last activity is the last chunk written, or the session's creation before any
+bool ResumableUpload::expired(const std::string &part_path, const std::string &info_path, time_t now)
+{
+    struct stat st;
+
+    if (stat(part_path.c_str(), &st) != 0 && stat(info_path.c_str(), &st) != 0)
+        return false;
+    return now - st.st_mtime > UPLOAD_SESSION_TTL;
+}
+
+// Removes the abandoned .<id>.part / .<id>.info pairs of an uploads dir
+void ResumableUpload::sweepSessions(const std::string &dir, time_t now)
+{
+    static std::map<std::string, time_t> last_sweep;
+    DIR *entries;
+    struct dirent *entry;
+
+    if (now - last_sweep[dir] < UPLOAD_SWEEP_INTERVAL || (entries = opendir(dir.c_str())) == NULL)
+        return;
+    last_sweep[dir] = now;
+    while ((entry = readdir(entries)) != NULL)
+    {
+        std::string name = entry->d_name;
+        // .<id>.info, the id being UPLOAD_ID_LENGTH hex digits
+        if (name.length() != UPLOAD_ID_LENGTH + 6 || name[0] != '.' || name.compare(UPLOAD_ID_LENGTH + 1, 5, ".info") != 0)
+            continue;
+        std::string base = dir + "/" + name.substr(0, UPLOAD_ID_LENGTH + 1);
+        if (!expired(base + ".part", base + ".info", now))
+            continue;
+        LOG_INFO("Upload session " << name.substr(1, UPLOAD_ID_LENGTH) << " expired, removed");
+        unlink((base + ".part").c_str());
+        unlink((base + ".info").c_str());
+    }
+    closedir(entries);
+}
+
+size_t ResumableUpload::committedOffset(const Session &session) const
+{
+    struct stat st;
+    if (stat(partPath(session).c_str(), &st) != 0)
+        return 0;
+    return static_cast<size_t>(st.st_size);
+}
+
+/*
+    Reads the offset the client wants to write at (Upload-Offset for PATCH,
+    Content-Range for PUT) and checks it against what is already on disk.
+*/
+bool ResumableUpload::chunkOffset(HttpRequest *request, const Session &session, size_t &offset)
+{
+    size_t chunk_length = strtoull(request->GetHeader("Content-Length").c_str(), NULL, 10);
+
+    if (request->GetMethod() == "PATCH")
+    {
+        std::string value = request->GetHeader("Upload-Offset");
+        if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos)
+        {
+            setErrorResponse(request, 400, "Missing or invalid Upload-Offset");
+            return false;
+        }
+        offset = strtoull(value.c_str(), NULL, 10);
+    }
+    else
+    {
+        // Content-Range: bytes <first>-<last>/<total>
+        std::string range = request->GetHeader("Content-Range");
+        unsigned long long first = 0, last = 0;
+        char total[32] = {0};
+        if (sscanf(range.c_str(), "bytes %llu-%llu/%31s", &first, &last, total) != 3 || last < first)
+        {
+            setErrorResponse(request, 400, "Invalid Content-Range");
+            return false;
+        }
+        if (std::string(total) != "*" && strtoull(total, NULL, 10) != session.length)
+        {
+            setErrorResponse(request, 400, "Content-Range total does not match Upload-Length");
+            return false;
+        }
+        if (last - first + 1 != chunk_length)
+        {
+            setErrorResponse(request, 400, "Content-Range does not match Content-Length");
+            return false;
+        }
+        offset = first;
+    }
+
+    size_t committed = committedOffset(session);
+    if (offset != committed)
+    {
+        LOG_WARN("Upload " << session.id << ": offset " << offset << " does not match committed " << committed);
+        setErrorResponse(request, 409, "Upload-Offset does not match the stored offset");
+        _client->http_response->setHeader("Upload-Offset", toString(committed));
+        return false;
+    }
+    if (offset + chunk_length > session.length)
+    {
+        setErrorResponse(request, 400, "Chunk goes past Upload-Length");
+        return false;
+    }
+    return true;
+}
+
+bool ResumableUpload::PrepareStreamedChunk(HttpRequest *request, std::string &part_path, size_t &offset)
+{
+    Session session;
+    if (!loadSession(request, session))
+    {
+        setErrorResponse(request, 404, "Upload session not found");
+        return false;
+    }
+    if (!chunkOffset(request, session, offset))
+        return false;
+    part_path = partPath(session);
+    return true;
+}
+
+void ResumableUpload::createSession(HttpRequest *request)
+{
+    std::string value = request->GetHeader("Upload-Length");
+    if (value.find_first_not_of("0123456789") != std::string::npos)
+    {
+        setErrorResponse(request, 400, "Invalid Upload-Length");
+        return;
+    }
+    Session session;
+    session.length = strtoull(value.c_str(), NULL, 10);
+    if (session.length == 0)
+    {
+        setErrorResponse(request, 400, "Invalid Upload-Length");
+        return;
+    }
+
+    unsigned long max_size = _client->server_config.get_client_max_body_size();
+    const Location *location = _client->server_config.findMatchingLocation(request->GetLocation());
+    if (location && location->get_clientMaxBodySize() > 0)
+        max_size = location->get_clientMaxBodySize();
+    if (max_size > 0 && session.length > max_size)
+    {
+        setErrorResponse(request, 413, "Request Entity Too Large");
+        return;
+    }
+
+    // Upload-Metadata: filename <base64>,filetype <base64>
+    std::istringstream metadata(request->GetHeader("Upload-Metadata"));
+    std::string pair;
+    while (std::getline(metadata, pair, ','))
+    {
+        std::istringstream kv(pair);
+        std::string key, encoded;
+        kv >> key >> encoded;
+        if (key == "filename")
+            session.filename = decodeBase64(encoded);
+    }
+    // keep only the base name, the session must not place files outside the uploads dir
+    size_t slash = session.filename.find_last_of("/\\");
+    if (slash != std::string::npos)
+        session.filename = session.filename.substr(slash + 1);
+    if (session.filename == "." || session.filename == ".." || session.filename.find('\n') != std::string::npos)
+        session.filename.clear();
+
+    Post post_handler;
+    session.dir = post_handler.getUploadsDirectory(_client->server_config);
+    sweepSessions(session.dir, time(NULL));
+    session.id = generateId();
+
+    int fd = open(partPath(session).c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+    if (fd == -1)
+    {
+        LOG_ERROR("Failed to create upload session file: " << strerror(errno));
+        setErrorResponse(request, 500, "Failed to create upload session");
+        return;
+    }
+    close(fd);
+
+    std::ofstream info(infoPath(session).c_str());
+    info << "length " << session.length << "\n";
+    info << "filename " << session.filename << "\n";
+    if (!info)
+    {
+        unlink(partPath(session).c_str());
+        setErrorResponse(request, 500, "Failed to create upload session");
+        return;
+    }
+
+    LOG_DEBUG("Upload session " << session.id << " created for " << session.length << " bytes");
+    setSessionResponse(request, 201, session, 0);
+    _client->http_response->setHeader("Location", request->GetLocation() + "?" + UPLOAD_ID_PARAM + "=" + session.id);
+}
+
+void ResumableUpload::reportOffset(HttpRequest *request)
+{
+    Session session;
+    if (!loadSession(request, session))
+    {
+        _client->http_response->setStatusCode(404);
+        _client->http_response->setStatusMessage("Not Found");
+        _client->http_response->setNoBody(true);
+        return;
+    }
+    setSessionResponse(request, 200, session, committedOffset(session));
+}
+
+void ResumableUpload::writeChunk(HttpRequest *request)
+{
+    Session session;
+    if (!loadSession(request, session))
+    {
+        setErrorResponse(request, 404, "Upload session not found");
+        return;
+    }
+
+    std::string body = request->GetBody();
+    if (body.find("__RESUMABLE_CHUNK:") != 0)
+    {
+        // Small chunk, the body is already in memory
+        size_t offset = 0;
+        if (!chunkOffset(request, session, offset))
+            return;
+        int fd = open(partPath(session).c_str(), O_WRONLY);
+        if (fd == -1)
+        {
+            setErrorResponse(request, 500, "Failed to open upload session");
+            return;
+        }
+        size_t done = 0;
+        while (done < body.size())
+        {
+            ssize_t written = pwrite(fd, body.data() + done, body.size() - done, offset + done);
+            if (written < 0 && errno == EINTR)
+                continue;
+            if (written < 0)
+            {
+                int err = errno;
+                // keep what made it, the client resumes from the committed offset
+                ftruncate(fd, offset + done);
+                close(fd);
+                if (err == ENOSPC || err == EDQUOT)
+                    setErrorResponse(request, 507, "Insufficient Storage");
+                else
+                    setErrorResponse(request, 500, "Failed to write upload data");
+                return;
+            }
+            done += written;
+        }
+        close(fd);
+    }
+
+    size_t committed = committedOffset(session);
+    LOG_DEBUG("Upload " << session.id << ": " << committed << "/" << session.length << " bytes committed");
+
+    if (committed < session.length)
+    {
+        if (request->GetMethod() == "PATCH")
+            setSessionResponse(request, 204, session, committed);
+        else
+        {
+            // PUT clients follow the "308 Resume Incomplete" convention
+            setSessionResponse(request, 308, session, committed);
+            _client->http_response->setStatusMessage("Resume Incomplete");
+            if (committed > 0)
+                _client->http_response->setHeader("Range", "bytes=0-" + toString(committed - 1));
+        }
+        return;
+    }
+
+    std::string final_path;
+    if (!completeSession(session, final_path))
+    {
+        setErrorResponse(request, 500, "Failed to finalize upload");
+        return;
+    }
+    LOG_DEBUG("Upload " << session.id << " complete: " << final_path);
+    setSessionResponse(request, request->GetMethod() == "PATCH" ? 204 : 201, session, committed);
+}
+
+bool ResumableUpload::completeSession(const Session &session, std::string &final_path)
+{
+    std::string name = session.filename.empty() ? session.id : session.filename;
+    final_path = session.dir + "/" + name;
+
+    struct stat st;
+    if (stat(final_path.c_str(), &st) == 0)
+        final_path = session.dir + "/" + session.id + "_" + name;
+    if (rename(partPath(session).c_str(), final_path.c_str()) != 0)
+    {
+        LOG_ERROR("Failed to move " << partPath(session) << " to " << final_path
+                  << " (" << strerror(errno) << ")");
+        return false;
+    }
+    unlink(infoPath(session).c_str());
+    return true;
+}
+
+void ResumableUpload::setSessionResponse(HttpRequest *request, int statusCode, const Session &session, size_t offset)
+{
+    HttpResponse *response = request->GetClientDatat()->http_response;
+
+    response->setStatusCode(statusCode);
+    response->setStatusMessage(response->GetStatusMessage(statusCode));
+    response->setHeader("Tus-Resumable", TUS_VERSION);
+    response->setHeader("Upload-Offset", toString(offset));
+    response->setHeader("Upload-Length", toString(session.length));
+    response->setHeader("Cache-Control", "no-store");
+    response->setNoBody(true);
+}
+
+void ResumableUpload::setErrorResponse(HttpRequest *request, int statusCode, const std::string &message)
+{
+    ClientConnection *client = request->GetClientDatat();
+    if (client->http_response == NULL)
+    {
+        std::map<std::string, std::string> emptyHeaders;
+        client->http_response = new HttpResponse(statusCode, emptyHeaders, "text/html", false, false);
+    }
+    std::stringstream response;
+    response << "<!DOCTYPE html><html><head><title>Error " << statusCode << "</title></head><body>";
+    response << "<h1>Error " << statusCode << "</h1>";
+    response << "<p>" << message << "</p>";
+    response << "</body></html>";
+
+    client->http_response->setStatusCode(statusCode);
+    client->http_response->setStatusMessage(client->http_response->GetStatusMessage(statusCode));
+    client->http_response->setHeader("Tus-Resumable", TUS_VERSION);
+    client->http_response->setContentType("text/html");
+    client->http_response->setBuffer(response.str());
+}
+
+std::string ResumableUpload::toString(size_t value)
+{
+    std::stringstream ss;
+    ss << value;
+    return ss.str();
+}
+
+std::string ResumableUpload::decodeBase64(const std::string &input)
+{
+    static const std::string alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string output;
+    unsigned int value = 0;
+    int bits = -8;
+
+    for (size_t i = 0; i < input.length(); ++i)
+    {
+        size_t pos = alphabet.find(input[i]);
+        if (pos == std::string::npos)
+            break;
+        value = (value << 6) | static_cast<unsigned int>(pos);
+        bits += 6;
+        if (bits >= 0)
+        {
+            output += static_cast<char>((value >> bits) & 0xFF);
+            // only the bits not yet output are kept, value never exceeds 14 bits
+            value &= (1u << bits) - 1;
+            bits -= 8;
+        }
+    }
+    return output;
+}
+
+std::string ResumableUpload::generateId()
+{
+    unsigned char bytes[UPLOAD_ID_LENGTH / 2];
+    int fd = open("/dev/urandom", O_RDONLY);
+    if (fd == -1 || read(fd, bytes, sizeof(bytes)) != (ssize_t)sizeof(bytes))
+    {
+        for (size_t i = 0; i < sizeof(bytes); ++i)
+            bytes[i] = static_cast<unsigned char>(rand() ^ time(NULL));
+    }
+    if (fd != -1)
+        close(fd);
+
+    static const char hex[] = "0123456789abcdef";
+    std::string id;
+    for (size_t i = 0; i < sizeof(bytes); ++i)
+    {
+        id += hex[bytes[i] >> 4];
+        id += hex[bytes[i] & 0x0F];
+    }
+    return id;
+}
@@ -1,4 +1,5 @@
 #include "../../../include/request/Post.hpp"
+#include "../../../include/Logger.hpp"
 #include <iostream>
 #include <sstream>
 #include <vector>
@@ -7,47 +8,41 @@
 std::vector<Post::FormPart> Post::parseMultipartForm(const std::string &body, const std::string &boundary) {
     std::vector<FormPart> parts;
     
-    std::cout << "Parsing multipart form with boundary: '" << boundary << "'" << std::endl;
-    std::cout << "Body length: " << body.length() << " bytes" << std::endl;
+    LOG_DEBUG("Parsing multipart form with boundary: '" << boundary << "'");
+    LOG_DEBUG("Body length: " << body.length() << " bytes");
     
     // DEBUG: Print the first 200 characters of the body to see the structure
-    std::cout << "=== BODY PREVIEW (first 200 chars) ===" << std::endl;
+    LOG_DEBUG("=== BODY PREVIEW (first 200 chars) ===");
     std::string preview = body.substr(0, std::min((size_t)200, body.size()));
-    for (size_t i = 0; i < preview.length(); ++i) {
-        char c = preview[i];
-        if (c == '\r') std::cout << "\\r";
-        else if (c == '\n') std::cout << "\\n";
-        else if (c >= 32 && c <= 126) std::cout << c;
-        else std::cout << "[" << (int)c << "]";
-    }
-    std::cout << std::endl << "=== END BODY PREVIEW ===" << std::endl;
+    LOG_DEBUG(Logger::Escape(preview));
+    LOG_DEBUG("=== END BODY PREVIEW ===");
     
     // Construct the boundary delimiters
     std::string startBoundary = "--" + boundary;
     std::string endBoundary = "--" + boundary + "--";
     
-    std::cout << "Looking for start boundary: '" << startBoundary << "'" << std::endl;
+    LOG_DEBUG("Looking for start boundary: '" << startBoundary << "'");
     
     // Find the first boundary
     size_t pos = body.find(startBoundary);
     if (pos == std::string::npos) {
-        std::cout << "Error: Could not find start boundary in body" << std::endl;
+        LOG_WARN("Could not find start boundary in body");
         
         // DEBUG: Try to find any boundary-like patterns
-        std::cout << "Searching for any '--' patterns in first 500 chars:" << std::endl;
+        LOG_DEBUG("Searching for any '--' patterns in first 500 chars:");
         std::string searchArea = body.substr(0, std::min((size_t)500, body.size()));
         size_t dashPos = 0;
         while ((dashPos = searchArea.find("--", dashPos)) != std::string::npos) {
             size_t lineEnd = searchArea.find('\n', dashPos);
             if (lineEnd == std::string::npos) lineEnd = searchArea.length();
             std::string line = searchArea.substr(dashPos, std::min((size_t)50, lineEnd - dashPos));
-            std::cout << "Found '--' at pos " << dashPos << ": '" << line << "'" << std::endl;
+            LOG_DEBUG("Found '--' at pos " << dashPos << ": '" << line << "'");
             dashPos++;
         }
         return parts;
     }
     
-    std::cout << "Found first boundary at position: " << pos << std::endl;
+    LOG_DEBUG("Found first boundary at position: " << pos);
     
     // Skip the first boundary and any following CRLF
     pos += startBoundary.length();
@@ -57,7 +52,7 @@ std::vector<Post::FormPart> Post::parseMultipartForm(const std::string &body, co
     int partNumber = 1;
     
     while (pos < body.length()) {
-        std::cout << "\n=== Processing Part " << partNumber << " ===" << std::endl;
+        LOG_DEBUG("=== Processing Part " << partNumber << " ===");
         
         // Find the next boundary (could be start or end boundary)
         size_t nextBoundaryPos = body.find("\r\n--" + boundary, pos);
@@ -70,7 +65,7 @@ std::vector<Post::FormPart> Post::parseMultipartForm(const std::string &body, co
             (altNextBoundaryPos == std::string::npos || endBoundaryPos < altNextBoundaryPos)) {
             // We found the end boundary directly
             nextBoundaryPos = endBoundaryPos;
-            std::cout << "Found end boundary directly at position: " << nextBoundaryPos << std::endl;
+            LOG_DEBUG("Found end boundary directly at position: " << nextBoundaryPos);
         }
         // Use whichever boundary we find first
         else if (nextBoundaryPos == std::string::npos || 
@@ -84,32 +79,23 @@ std::vector<Post::FormPart> Post::parseMultipartForm(const std::string &body, co
         }
         
         if (nextBoundaryPos == std::string::npos) {
-            std::cout << "Could not find next boundary, searching for end boundary" << std::endl;
+            LOG_DEBUG("Could not find next boundary, searching for end boundary");
             // Last attempt: search for end boundary without CRLF prefix
             nextBoundaryPos = body.find(endBoundary, pos);
             if (nextBoundaryPos == std::string::npos) {
-                std::cout << "Could not find end boundary either, breaking" << std::endl;
+                LOG_DEBUG("Could not find end boundary either, breaking");
                 break;
             } else {
-                std::cout << "Found end boundary at position: " << nextBoundaryPos << std::endl;
+                LOG_DEBUG("Found end boundary at position: " << nextBoundaryPos);
             }
         }
         
         // Extract this part's content
         std::string partContent = body.substr(pos, nextBoundaryPos - pos);
-        std::cout << "Part content length: " << partContent.length() << " bytes" << std::endl;
+        LOG_DEBUG("Part content length: " << partContent.length() << " bytes");
         
         // Debug: Show a preview of the part content
-        std::cout << "Part content preview: ";
-        std::string contentPreview = partContent.substr(0, std::min((size_t)50, partContent.size()));
-        for (size_t i = 0; i < contentPreview.length(); ++i) {
-            char c = contentPreview[i];
-            if (c == '\r') std::cout << "\\r";
-            else if (c == '\n') std::cout << "\\n";
-            else if (c >= 32 && c <= 126) std::cout << c;
-            else std::cout << "[" << (int)c << "]";
-        }
-        std::cout << std::endl;
+        LOG_DEBUG("Part content preview: " << Logger::Escape(partContent.substr(0, std::min((size_t)50, partContent.size()))));
         
         // Find headers/body separator
         size_t headerEndPos = partContent.find("\r\n\r\n");
@@ -118,7 +104,7 @@ std::vector<Post::FormPart> Post::parseMultipartForm(const std::string &body, co
             headerEndPos = partContent.find("\n\n");
             foundCRLF = false;
             if (headerEndPos == std::string::npos) {
-                std::cout << "Could not find header/body separator in part" << std::endl;
+                LOG_DEBUG("Could not find header/body separator in part");
                 pos = nextBoundaryPos + boundary.length() + 2;
                 partNumber++;
                 continue;
@@ -129,8 +115,8 @@ std::vector<Post::FormPart> Post::parseMultipartForm(const std::string &body, co
         std::string headers = partContent.substr(0, headerEndPos);
         std::string partBody = partContent.substr(headerEndPos + (foundCRLF ? 4 : 2));
         
-        std::cout << "Headers: " << headers << std::endl;
-        std::cout << "Body length: " << partBody.length() << " bytes" << std::endl;
+        LOG_DEBUG("Headers: " << headers);
+        LOG_DEBUG("Body length: " << partBody.length() << " bytes");
         
         // Parse the Content-Disposition header
         FormPart part;
@@ -147,7 +133,7 @@ std::vector<Post::FormPart> Post::parseMultipartForm(const std::string &body, co
                 headerLine.pop_back();
             }
             
-            std::cout << "Processing header: '" << headerLine << "'" << std::endl;
+            LOG_DEBUG("Processing header: '" << headerLine << "'");
             
             if (headerLine.find("Content-Disposition:") == 0) {
                 // Extract name
@@ -157,7 +143,7 @@ std::vector<Post::FormPart> Post::parseMultipartForm(const std::string &body, co
                     size_t nameEnd = headerLine.find("\"", namePos);
                     if (nameEnd != std::string::npos) {
                         part.name = headerLine.substr(namePos, nameEnd - namePos);
-                        std::cout << "Extracted name: '" << part.name << "'" << std::endl;
+                        LOG_DEBUG("Extracted name: '" << part.name << "'");
                     }
                 }
                 
@@ -169,7 +155,7 @@ std::vector<Post::FormPart> Post::parseMultipartForm(const std::string &body, co
                     if (filenameEnd != std::string::npos) {
                         part.filename = headerLine.substr(filenamePos, filenameEnd - filenamePos);
                         part.isFile = !part.filename.empty();
-                        std::cout << "Extracted filename: '" << part.filename << "'" << std::endl;
+                        LOG_DEBUG("Extracted filename: '" << part.filename << "'");
                     }
                 }
             } 
@@ -185,18 +171,18 @@ std::vector<Post::FormPart> Post::parseMultipartForm(const std::string &body, co
                         part.contentType = part.contentType.substr(0, end + 1);
                     }
                 }
-                std::cout << "Extracted content type: '" << part.contentType << "'" << std::endl;
+                LOG_DEBUG("Extracted content type: '" << part.contentType << "'");
             }
         }
         
         // Only add parts that have a name or filename
         if (!part.name.empty() || !part.filename.empty()) {
             parts.push_back(part);
-            std::cout << "Added part: name='" << part.name << "', filename='" << part.filename 
+            LOG_DEBUG("Added part: name='" << part.name << "', filename='" << part.filename 
                      << "', isFile=" << (part.isFile ? "true" : "false") 
-                     << ", body size=" << part.body.size() << std::endl;
+                     << ", body size=" << part.body.size());
         } else {
-            std::cout << "Skipping part with no name or filename" << std::endl;
+            LOG_DEBUG("Skipping part with no name or filename");
         }
         
         // Move to next part
@@ -207,7 +193,7 @@ std::vector<Post::FormPart> Post::parseMultipartForm(const std::string &body, co
         if (nextBoundaryPos + endBoundary.length() <= body.length()) {
             std::string potentialEndBoundary = body.substr(nextBoundaryPos, endBoundary.length());
             if (potentialEndBoundary == endBoundary) {
-                std::cout << "Found end boundary, stopping parsing" << std::endl;
+                LOG_DEBUG("Found end boundary, stopping parsing");
                 isEndBoundary = true;
             }
         }
@@ -228,11 +214,11 @@ std::vector<Post::FormPart> Post::parseMultipartForm(const std::string &body, co
         
         // Safety check to prevent infinite loops
         if (partNumber > 100) {
-            std::cout << "Too many parts, breaking to prevent infinite loop" << std::endl;
+            LOG_DEBUG("Too many parts, breaking to prevent infinite loop");
             break;
         }
     }
     
-    std::cout << "Total valid parts found: " << parts.size() << std::endl;
+    LOG_DEBUG("Total valid parts found: " << parts.size());
     return parts;
 }
\ No newline at end of file
@@ -0,0 +1,196 @@
+#include "../../include/response/GzipFilter.hpp"
+#include "../../include/Logger.hpp"
+#include "../../include/response/HttpResponse.hpp"
+#include "../../include/response/MimeTypes.hpp"
+#include "../../include/request/HttpRequest.hpp"
+#include "../../include/config/ServerConfig.hpp"
+#include <sys/stat.h>
+#include <iostream>
+#include <cctype>
+
+std::vector<z_stream *> GzipFilter::_pool[2];
+
+GzipFilter::GzipFilter(Format format, int level) : _format(format), _finished(false)
+{
+    this->_stream = acquire(format, level);
+}
+
+GzipFilter::~GzipFilter()
+{
+    release(this->_format, this->_stream);
+}
+
+/*
+    Idle streams are reset and re-tuned instead of being torn down; windowBits
+    15 + 16 makes zlib write the gzip wrapper, plain 15 the zlib wrapper that
+    HTTP calls "deflate".
+*/
+z_stream *GzipFilter::acquire(Format format, int level)
+{
+    z_stream *stream;
+
+    if (!_pool[format].empty())
+    {
+        stream = _pool[format].back();
+        _pool[format].pop_back();
+        if (deflateReset(stream) == Z_OK && deflateParams(stream, level, Z_DEFAULT_STRATEGY) == Z_OK)
+            return stream;
+        deflateEnd(stream);
+        delete stream;
+    }
+    stream = new z_stream();
+    stream->zalloc = Z_NULL;
+    stream->zfree = Z_NULL;
+    stream->opaque = Z_NULL;
+    if (deflateInit2(stream, level, Z_DEFLATED, format == GZIP ? 15 + 16 : 15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        LOG_ERROR("deflateInit2 failed: " << (stream->msg ? stream->msg : ""));
+        delete stream;
+        return NULL;
+    }
+    return stream;
+}
+
+void GzipFilter::release(Format format, z_stream *stream)
+{
+    if (!stream)
+        return;
+    if (_pool[format].size() < GZIP_POOL_MAX)
+    {
+        _pool[format].push_back(stream);
+        return;
+    }
+    deflateEnd(stream);
+    delete stream;
+}
+
+/*
+    Compresses the next piece of the body. zlib keeps what it has not
+    emitted yet, so the result may be empty until enough input arrived;
+    finish drains everything and writes the trailer.
+*/
+std::string GzipFilter::Compress(const char *data, size_t length, bool finish)
+{
+    std::string out;
+    char buffer[GZIP_CHUNK_SIZE];
+
+    if (!this->_stream || this->_finished)
+        return out;
+    this->_stream->next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+    this->_stream->avail_in = length;
+    int flush = finish ? Z_FINISH : Z_NO_FLUSH;
+    int ret;
+    do
+    {
+        this->_stream->next_out = reinterpret_cast<Bytef *>(buffer);
+        this->_stream->avail_out = sizeof(buffer);
+        ret = deflate(this->_stream, flush);
+        if (ret == Z_STREAM_ERROR)
+        {
+            LOG_ERROR("deflate failed");
+            throw HttpException(500, "Internal Server Error", INTERNAL_SERVER_ERROR);
+        }
+        out.append(buffer, sizeof(buffer) - this->_stream->avail_out);
+    } while (this->_stream->avail_out == 0 || (finish && ret != Z_STREAM_END));
+    if (finish)
+        this->_finished = true;
+    return out;
+}
+
+bool GzipFilter::IsFinished() const
+{
+    return this->_finished;
+}
+
+const char *GzipFilter::Encoding() const
+{
+    return this->_format == GZIP ? "gzip" : "deflate";
+}
+
+// gzip_types entries match the media type without its parameters, "*" matches all
+bool GzipFilter::typeAllowed(std::string type, const std::vector<std::string> &types)
+{
+    size_t semicolon = type.find(';');
+    if (semicolon != std::string::npos)
+        type.erase(semicolon);
+    type.erase(type.find_last_not_of(" \t") + 1);
+    for (size_t i = 0; i < type.length(); ++i)
+        type[i] = std::tolower(type[i]);
+    for (size_t i = 0; i < types.size(); ++i)
+    {
+        if (types[i] == "*" || types[i] == type)
+            return true;
+    }
+    return false;
+}
+
+/*
+    The decision of Apply, shared with the 304 path of Get: a 304 must carry
+    the validator and Vary of the 200 it stands for.
+*/
+bool GzipFilter::Negotiate(const std::string &type, size_t length, const HttpRequest &request,
+    const ServerConfig &config, bool &vary, Format &format)
+{
+    vary = false;
+    if (!config.get_gzip() || !typeAllowed(type.empty() ? "text/plain" : type, config.get_gzip_types()))
+        return false;
+    // from here on the representation depends on Accept-Encoding
+    vary = true;
+    if (length < config.get_gzip_min_length())
+        return false;
+
+    double gzip_quality = request.GetEncodingQuality("gzip");
+    double deflate_quality = request.GetEncodingQuality("deflate");
+    if (gzip_quality <= 0 && deflate_quality <= 0)
+        return false;
+    format = gzip_quality >= deflate_quality ? GZIP : DEFLATE;
+    return true;
+}
+
+bool GzipFilter::Apply(HttpResponse &response, const HttpRequest &request, const ServerConfig &config)
+{
+    if (!config.get_gzip() || response.hasCompressor())
+        return false;
+    // nothing to encode, or already a representation of its own
+    if (response.hasNoBody() || response.hasSegments() || !response.checkAvailablePacket()
+        || response.getStatusCode() == 204 || response.getStatusCode() == 304 || response.getStatusCode() == 206
+        || !response.getHeader("Content-Encoding").empty())
+        return false;
+
+    std::string type = response.getContentType();
+    if (type.empty() && response.isFile())
+        type = MimeTypes::TypeOf(response.getFilePath());
+
+    size_t length = response.getBuffer().size();
+    if (response.isFile())
+    {
+        struct stat file_stat;
+        if (response.getByteToSend() > 0)
+            length = response.getByteToSend();
+        else if (stat(response.getFilePath().c_str(), &file_stat) == 0)
+            length = file_stat.st_size;
+    }
+    bool vary;
+    Format format;
+    bool encode = Negotiate(type, length, request, config, vary, format);
+    if (vary)
+        response.setHeader("Vary", "Accept-Encoding");
+    if (!encode)
+        return false;
+    GzipFilter *filter = new GzipFilter(format, config.get_gzip_comp_level());
+    if (!filter->_stream)
+    {
+        delete filter;
+        return false;
+    }
+
+    response.setHeader("Content-Encoding", filter->Encoding());
+    // the encoded bytes differ from the file: ranges no longer apply and the validator is only weak
+    response.removeHeader("Accept-Ranges");
+    response.removeHeader("Content-Length");
+    std::string etag = response.getHeader("ETag");
+    if (!etag.empty() && etag.compare(0, 2, "W/") != 0)
+        response.setHeader("ETag", "W/" + etag);
+    response.setCompressor(filter);
+    return true;
+}
@@ -0,0 +1,246 @@
+#include "../../include/response/MimeTypes.hpp"
+#include "../../include/Logger.hpp"
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <map>
+#include <algorithm>
+#include <cctype>
+
+PerfectHash                 MimeTypes::_by_extension;
+std::vector<std::string>    MimeTypes::_extension_types;
+PerfectHash                 MimeTypes::_by_type;
+std::vector<std::string>    MimeTypes::_type_extensions;
+bool                        MimeTypes::_loaded = false;
+
+// FNV-1a over the key, then a murmur3 finalizer so nearby seeds give unrelated slots
+unsigned int PerfectHash::hash(const char *key, size_t length, unsigned int seed)
+{
+    unsigned int h = 2166136261u ^ (seed * 0x9e3779b9u);
+
+    for (size_t i = 0; i < length; ++i)
+    {
+        h ^= static_cast<unsigned char>(key[i]);
+        h *= 16777619u;
+    }
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+bool PerfectHash::place(size_t slot_count)
+{
+    size_t bucket_count = this->_keys.size() / 4 + 1;
+    std::vector<std::vector<int> > buckets(bucket_count);
+    std::vector<std::pair<size_t, size_t> > order;
+
+    this->_seeds.assign(bucket_count, 0);
+    this->_slots.assign(slot_count, -1);
+    for (size_t i = 0; i < this->_keys.size(); ++i)
+        buckets[hash(this->_keys[i].data(), this->_keys[i].size(), 0) % bucket_count].push_back(i);
+    for (size_t b = 0; b < bucket_count; ++b)
+        order.push_back(std::make_pair(buckets[b].size(), b));
+    std::sort(order.rbegin(), order.rend());
+
+    for (size_t o = 0; o < order.size() && order[o].first > 0; ++o)
+    {
+        const std::vector<int> &bucket = buckets[order[o].second];
+        std::vector<size_t> taken;
+        unsigned int seed;
+
+        for (seed = 1; seed < (1u << 16); ++seed)
+        {
+            taken.clear();
+            for (size_t k = 0; k < bucket.size(); ++k)
+            {
+                size_t slot = hash(this->_keys[bucket[k]].data(), this->_keys[bucket[k]].size(), seed) % slot_count;
+                if (this->_slots[slot] != -1 || std::find(taken.begin(), taken.end(), slot) != taken.end())
+                    break;
+                taken.push_back(slot);
+            }
+            if (taken.size() == bucket.size())
+                break;
+        }
+        if (taken.size() != bucket.size())
+            return false;
+        this->_seeds[order[o].second] = seed;
+        for (size_t k = 0; k < bucket.size(); ++k)
+            this->_slots[taken[k]] = bucket[k];
+    }
+    return true;
+}
+
+// Keys must be unique; the table only grows when no seed fits at the current size
+bool PerfectHash::Build(const std::vector<std::string> &keys)
+{
+    this->_keys = keys;
+    for (size_t slot_count = keys.size() + keys.size() / 4 + 1; slot_count <= keys.size() * 4 + 8; slot_count += keys.size() / 4 + 1)
+    {
+        if (this->place(slot_count))
+            return true;
+    }
+    LOG_ERROR("could not build a perfect hash over " << keys.size() << " keys");
+    this->_keys.clear();
+    this->_seeds.clear();
+    this->_slots.clear();
+    return false;
+}
+
+int PerfectHash::Find(const char *key, size_t length) const
+{
+    if (this->_seeds.empty())
+        return -1;
+    unsigned int seed = this->_seeds[hash(key, length, 0) % this->_seeds.size()];
+    int index = this->_slots[hash(key, length, seed) % this->_slots.size()];
+    if (index < 0 || this->_keys[index].size() != length || this->_keys[index].compare(0, length, key, length) != 0)
+        return -1;
+    return index;
+}
+
+int PerfectHash::Find(const std::string &key) const
+{
+    return this->Find(key.data(), key.size());
+}
+
+// entries are (type, extension) in file order: the first type of an extension wins,
+// the first extension listed for a type is the one uploads get
+void MimeTypes::build(const std::vector<std::pair<std::string, std::string> > &entries)
+{
+    std::vector<std::string> extensions;
+    std::vector<std::string> types;
+    std::map<std::string, bool> seen_extension;
+    std::map<std::string, bool> seen_type;
+
+    _extension_types.clear();
+    _type_extensions.clear();
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        if (!seen_extension[entries[i].second])
+        {
+            seen_extension[entries[i].second] = true;
+            extensions.push_back(entries[i].second);
+            _extension_types.push_back(entries[i].first);
+        }
+        if (!seen_type[entries[i].first])
+        {
+            seen_type[entries[i].first] = true;
+            types.push_back(entries[i].first);
+            _type_extensions.push_back("." + entries[i].second);
+        }
+    }
+    _by_extension.Build(extensions);
+    _by_type.Build(types);
+    _loaded = true;
+}
+
+void MimeTypes::loadDefaults()
+{
+    static const char *defaults[][2] = {
+        { "text/html", "html" }, { "text/html", "htm" }, { "text/css", "css" },
+        { "text/plain", "txt" }, { "text/csv", "csv" }, { "text/xml", "xml" },
+        { "application/javascript", "js" }, { "application/json", "json" },
+        { "application/pdf", "pdf" }, { "application/zip", "zip" },
+        { "application/x-iso9660-image", "iso" }, { "application/octet-stream", "bin" },
+        { "image/jpeg", "jpg" }, { "image/jpeg", "jpeg" }, { "image/png", "png" },
+        { "image/gif", "gif" }, { "image/webp", "webp" }, { "image/svg+xml", "svg" },
+        { "image/x-icon", "ico" }, { "font/woff2", "woff2" }, { "font/woff", "woff" },
+        { "video/mp4", "mp4" }, { "video/webm", "webm" }, { "video/quicktime", "mov" },
+        { "audio/mpeg", "mp3" }, { "audio/wav", "wav" }, { "audio/ogg", "ogg" },
+    };
+    std::vector<std::pair<std::string, std::string> > entries;
+
+    for (size_t i = 0; i < sizeof(defaults) / sizeof(defaults[0]); ++i)
+        entries.push_back(std::make_pair(std::string(defaults[i][0]), std::string(defaults[i][1])));
+    build(entries);
+}
+
+/*
+    Accepts both the nginx layout (types { text/html html htm; ... }) and the
+    Apache one (one "type ext ext" per line); # starts a comment.
+*/
+bool MimeTypes::Load(const std::string &file_name)
+{
+    std::ifstream file(file_name.c_str());
+    std::vector<std::pair<std::string, std::string> > entries;
+    std::string content;
+    std::string line;
+
+    if (!file.is_open())
+    {
+        LOG_ERROR("could not open mime types file " << file_name << ", using the built-in list");
+        loadDefaults();
+        return false;
+    }
+    while (std::getline(file, line))
+        content += line.substr(0, line.find('#')) + "\n";
+
+    char separator = '\n';
+    size_t open_brace = content.find('{');
+    if (open_brace != std::string::npos)
+    {
+        size_t close_brace = content.rfind('}');
+        content = content.substr(open_brace + 1, close_brace == std::string::npos || close_brace < open_brace ? std::string::npos : close_brace - open_brace - 1);
+        separator = ';';
+    }
+
+    std::istringstream statements(content);
+    std::string statement;
+    while (std::getline(statements, statement, separator))
+    {
+        std::istringstream words(statement);
+        std::string type;
+        std::string extension;
+
+        if (!(words >> type) || type.find('/') == std::string::npos)
+            continue;
+        std::transform(type.begin(), type.end(), type.begin(), ::tolower);
+        while (words >> extension)
+        {
+            std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+            entries.push_back(std::make_pair(type, extension));
+        }
+    }
+    if (entries.empty())
+    {
+        LOG_ERROR("no types found in " << file_name << ", using the built-in list");
+        loadDefaults();
+        return false;
+    }
+    build(entries);
+    LOG_DEBUG("loaded " << _extension_types.size() << " extensions from " << file_name);
+    return true;
+}
+
+const std::string &MimeTypes::TypeOf(const std::string &path)
+{
+    static const std::string default_type = MIME_DEFAULT_TYPE;
+    char extension[32];
+
+    if (!_loaded)
+        loadDefaults();
+    size_t dot = path.rfind('.');
+    if (dot == std::string::npos || path.find('/', dot) != std::string::npos)
+        return default_type;
+    size_t length = path.size() - dot - 1;
+    if (length == 0 || length > sizeof(extension))
+        return default_type;
+    for (size_t i = 0; i < length; ++i)
+        extension[i] = std::tolower(static_cast<unsigned char>(path[dot + 1 + i]));
+    int index = _by_extension.Find(extension, length);
+    return index < 0 ? default_type : _extension_types[index];
+}
+
+std::string MimeTypes::ExtensionFor(const std::string &content_type)
+{
+    if (!_loaded)
+        loadDefaults();
+    std::string type = content_type.substr(0, content_type.find(';'));
+    type.erase(0, type.find_first_not_of(" \t"));
+    type.erase(type.find_last_not_of(" \t\r") + 1);
+    std::transform(type.begin(), type.end(), type.begin(), ::tolower);
+    int index = _by_type.Find(type);
+    return index < 0 ? "" : _type_extensions[index];
+}
@@ -1,10 +1,23 @@
 #include "../../include/response/HttpResponse.hpp"
+#include "../../include/Logger.hpp"
+#include "../../include/response/GzipFilter.hpp"
+#include "../../include/response/MimeTypes.hpp"
+#include "../../include/BufferPool.hpp"
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <cstring>  // for strerror
 #include <cerrno>   // for errno
 #include <iostream>
 #include <fstream>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <algorithm>
+#include <vector>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
 
 HttpResponse::HttpResponse(int status_code, std::map<std::string, std::string> headers, std::string content_type, bool is_chunked, bool keep_alive)
     : _status_code(status_code), _content_type(content_type), _is_chunked(is_chunked), _keep_alive(keep_alive)
@@ -15,6 +28,14 @@ HttpResponse::HttpResponse(int status_code, std::map<std::string, std::string> h
     this->_buffer = "";
     this->_byte_sent = 0;
     this->_byte_to_send = 0;
+    this->_no_body = false;
+    this->_segments.clear();
+    this->_compressor = NULL;
+    this->_output_sent = 0;
+    this->_output_ready = false;
+    this->_body_fd = -1;
+    this->_streaming = false;
+    this->_stream_offset = 0;
 }
 
 void HttpResponse::setStatusCode(int code)
@@ -32,10 +53,29 @@ void HttpResponse::setHeader(std::string key, std::string value)
     this->_headers[key] = value;
 }
 
+void HttpResponse::removeHeader(std::string key)
+{
+    this->_headers.erase(key);
+}
+
+void HttpResponse::setCompressor(GzipFilter *compressor)
+{
+    delete this->_compressor;
+    this->_compressor = compressor;
+}
+
 void HttpResponse::setFilePath(std::string path)
 {
     this->_file_path = path;
 }
+
+void HttpResponse::setBodyFile(std::string path, int fd)
+{
+    if (this->_body_fd >= 0)
+        close(this->_body_fd);
+    this->_file_path = path;
+    this->_body_fd = fd;
+}
 void HttpResponse::setChunked(bool chunked)
 {
     this->_is_chunked = chunked;
@@ -56,6 +96,28 @@ void HttpResponse::setByteSent(int byte_sent)
     this->_byte_sent = byte_sent;
 }
 
+void HttpResponse::setNoBody(bool no_body)
+{
+    this->_no_body = no_body;
+}
+
+void HttpResponse::addFileSegment(off_t offset, size_t length)
+{
+    BodySegment segment;
+    segment.offset = offset;
+    segment.length = length;
+    this->_segments.push_back(segment);
+}
+
+void HttpResponse::addBufferSegment(const std::string &literal)
+{
+    BodySegment segment;
+    segment.literal = literal;
+    segment.offset = 0;
+    segment.length = literal.size();
+    this->_segments.push_back(segment);
+}
+
 void HttpResponse::setContentType(std::string content_type)
 {
     this->_content_type = content_type;
@@ -74,6 +136,17 @@ void HttpResponse::clear()
     this->_byte_sent = 0;
     this->_content_type.clear();
     this->_byte_to_send = 0;
+    this->_no_body = false;
+    this->_segments.clear();
+    this->setCompressor(NULL);
+    this->_output.clear();
+    this->_output_sent = 0;
+    this->_output_ready = false;
+    if (this->_body_fd >= 0)
+        close(this->_body_fd);
+    this->_body_fd = -1;
+    this->_streaming = false;
+    this->_stream_offset = 0;
 }
 
 int HttpResponse::getStatusCode() const
@@ -119,6 +192,39 @@ bool HttpResponse::isKeepAlive() const
     return this->_keep_alive;
 }
 
+bool HttpResponse::hasNoBody() const
+{
+    return this->_no_body;
+}
+
+bool HttpResponse::hasSegments() const
+{
+    return !this->_segments.empty();
+}
+
+bool HttpResponse::hasCompressor() const
+{
+    return this->_compressor != NULL;
+}
+
+size_t HttpResponse::getSegmentsLength() const
+{
+    size_t total = 0;
+    for (size_t i = 0; i < this->_segments.size(); ++i)
+        total += this->_segments[i].length;
+    return total;
+}
+
+std::string HttpResponse::httpDate(time_t time)
+{
+    char buffer[64];
+    struct tm gmt;
+
+    gmtime_r(&time, &gmt);
+    strftime(buffer, sizeof(buffer), "%a, %d %b %Y %H:%M:%S GMT", &gmt);
+    return buffer;
+}
+
 std::string HttpResponse::getBuffer() const
 {
     return this->_buffer;
@@ -142,7 +248,7 @@ std::string HttpResponse::getContentType() const
 
 bool HttpResponse::checkAvailablePacket() const
 {
-    if (!this->_buffer.empty() || !this->_file_path.empty())
+    if (this->_output_ready || this->_no_body || !this->_buffer.empty() || !this->_file_path.empty())
         return true;
     return false;
 }
@@ -152,59 +258,102 @@ bool HttpResponse::isFile() const
     return !this->_file_path.empty();
 }
 
-std::string HttpResponse::GetStatusMessage(int code) const 
+/*
+    Every registered status code with its reason phrase and the complete
+    status line, assembled by the preprocessor. Sorted by code for the
+    binary search in findStatus.
+*/
+#define STATUS_ENTRY(code, reason) { code, reason, "HTTP/1.1 " #code " " reason "\r\n" }
+
+const HttpResponse::StatusEntry HttpResponse::_status_table[] = {
+    STATUS_ENTRY(100, "Continue"),
+    STATUS_ENTRY(101, "Switching Protocols"),
+    STATUS_ENTRY(102, "Processing"),
+    STATUS_ENTRY(103, "Early Hints"),
+    STATUS_ENTRY(200, "OK"),
+    STATUS_ENTRY(201, "Created"),
+    STATUS_ENTRY(202, "Accepted"),
+    STATUS_ENTRY(203, "Non-Authoritative Information"),
+    STATUS_ENTRY(204, "No Content"),
+    STATUS_ENTRY(205, "Reset Content"),
+    STATUS_ENTRY(206, "Partial Content"),
+    STATUS_ENTRY(207, "Multi-Status"),
+    STATUS_ENTRY(208, "Already Reported"),
+    STATUS_ENTRY(226, "IM Used"),
+    STATUS_ENTRY(300, "Multiple Choices"),
+    STATUS_ENTRY(301, "Moved Permanently"),
+    STATUS_ENTRY(302, "Found"),
+    STATUS_ENTRY(303, "See Other"),
+    STATUS_ENTRY(304, "Not Modified"),
+    STATUS_ENTRY(305, "Use Proxy"),
+    STATUS_ENTRY(307, "Temporary Redirect"),
+    STATUS_ENTRY(308, "Permanent Redirect"),
+    STATUS_ENTRY(400, "Bad Request"),
+    STATUS_ENTRY(401, "Unauthorized"),
+    STATUS_ENTRY(402, "Payment Required"),
+    STATUS_ENTRY(403, "Forbidden"),
+    STATUS_ENTRY(404, "Not Found"),
+    STATUS_ENTRY(405, "Method Not Allowed"),
+    STATUS_ENTRY(406, "Not Acceptable"),
+    STATUS_ENTRY(407, "Proxy Authentication Required"),
+    STATUS_ENTRY(408, "Request Timeout"),
+    STATUS_ENTRY(409, "Conflict"),
+    STATUS_ENTRY(410, "Gone"),
+    STATUS_ENTRY(411, "Length Required"),
+    STATUS_ENTRY(412, "Precondition Failed"),
+    STATUS_ENTRY(413, "Content Too Large"),
+    STATUS_ENTRY(414, "URI Too Long"),
+    STATUS_ENTRY(415, "Unsupported Media Type"),
+    STATUS_ENTRY(416, "Range Not Satisfiable"),
+    STATUS_ENTRY(417, "Expectation Failed"),
+    STATUS_ENTRY(418, "I'm a teapot"),
+    STATUS_ENTRY(421, "Misdirected Request"),
+    STATUS_ENTRY(422, "Unprocessable Content"),
+    STATUS_ENTRY(423, "Locked"),
+    STATUS_ENTRY(424, "Failed Dependency"),
+    STATUS_ENTRY(425, "Too Early"),
+    STATUS_ENTRY(426, "Upgrade Required"),
+    STATUS_ENTRY(428, "Precondition Required"),
+    STATUS_ENTRY(429, "Too Many Requests"),
+    STATUS_ENTRY(431, "Request Header Fields Too Large"),
+    STATUS_ENTRY(451, "Unavailable For Legal Reasons"),
+    STATUS_ENTRY(500, "Internal Server Error"),
+    STATUS_ENTRY(501, "Not Implemented"),
+    STATUS_ENTRY(502, "Bad Gateway"),
+    STATUS_ENTRY(503, "Service Unavailable"),
+    STATUS_ENTRY(504, "Gateway Timeout"),
+    STATUS_ENTRY(505, "HTTP Version Not Supported"),
+    STATUS_ENTRY(506, "Variant Also Negotiates"),
+    STATUS_ENTRY(507, "Insufficient Storage"),
+    STATUS_ENTRY(508, "Loop Detected"),
+    STATUS_ENTRY(510, "Not Extended"),
+    STATUS_ENTRY(511, "Network Authentication Required"),
+};
+
+#undef STATUS_ENTRY
+
+const HttpResponse::StatusEntry *HttpResponse::findStatus(int code)
 {
-    switch (code)
+    size_t low = 0;
+    size_t high = sizeof(_status_table) / sizeof(_status_table[0]);
+
+    while (low < high)
     {
-        case 200:
-            return "OK";
-        case 404:
-            return "Not Found";
-        case 401:
-            return "Unauthorized";
-        case 403:
-            return "Forbidden";
-        case 405:
-            return "Method Not Allowed";
-        case 408:
-            return "Request Timeout";
-        case 500:
-            return "Internal Server Error";
-        case 501:
-            return "Not Implemented";
-        case 503:
-            return "Service Unavailable";
-        default:
-            return "Unknown Status";
+        size_t middle = (low + high) / 2;
+        if (_status_table[middle].code == code)
+            return &_status_table[middle];
+        if (_status_table[middle].code < code)
+            low = middle + 1;
+        else
+            high = middle;
     }
+    return NULL;
 }
 
-std::string HttpResponse::determineContentType(std::string path) 
+std::string HttpResponse::GetStatusMessage(int code) const 
 {
-    int size;
-    size_t dot_pos;
-    
-    // Convert extension to lowercase for case-insensitive matching
-    std::string contentType[] = { "html", "css", "js", "png", "jpeg", "jpg", "gif", "json", "xml", "pdf", "mp4", "mpeg", "x-www-form-urlencoded", "form-data", "woff2", "woff", "zip", "csv", "txt", "ico"};
-    std::string contenetFormat[] = { "text/html", "text/css", "application/javascript", "image/png", "image/jpeg", "image/jpeg", "image/gif", "application/json", "application/xml", "application/pdf", "video/mp4", "audio/mpeg", "application/x-www-form-urlencoded", "multipart/form-data", "font/woff2", "font/woff", "application/zip", "text/csv", "text/plain", "image/x-icon"};
-    size = sizeof(contentType) / sizeof(contentType[0]);
-    dot_pos = path.rfind('.');
-    
-    if (dot_pos != std::string::npos)
-    {
-        std::string ext = path.substr(dot_pos + 1);
-        // Convert extension to lowercase
-        for (size_t i = 0; i < ext.length(); i++) {
-            ext[i] = std::tolower(ext[i]);
-        }
-        
-        for (int i = 0; i < size; i++) {
-            if (contentType[i] == ext) {
-                return contenetFormat[i];
-            }
-        }
-    }
-    return "text/plain";
+    const StatusEntry *status = findStatus(code);
+    return status ? status->reason : "Unknown Status";
 }
 
 long getFileSize(std::string &file_name)
@@ -212,7 +361,7 @@ long getFileSize(std::string &file_name)
     struct stat file_info;
     if (stat(file_name.c_str(), &file_info) != 0)
     {
-        std::cerr << "error while trying to get file size";
+        LOG_ERROR("error while trying to get file size");
         return -1;
     }
     return file_info.st_size;
@@ -220,204 +369,400 @@ long getFileSize(std::string &file_name)
 
 
     
-std::string HttpResponse::toString() 
+void HttpResponse::appendDecimal(std::string &out, size_t value)
+{
+    char digits[24];
+    size_t length = 0;
+
+    do
+    {
+        digits[length++] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+    while (length)
+        out += digits[--length];
+}
+
+void HttpResponse::appendHex(std::string &out, size_t value)
+{
+    static const char hex[] = "0123456789abcdef";
+    char digits[24];
+    size_t length = 0;
+
+    do
+    {
+        digits[length++] = hex[value & 0xf];
+        value >>= 4;
+    } while (value);
+    while (length)
+        out += digits[--length];
+}
+
+// "Date: ...\r\n", formatted again only when the second changes
+const std::string &HttpResponse::dateHeader()
+{
+    static std::string line;
+    static time_t formatted_at = -1;
+    time_t now = time(NULL);
+
+    if (now != formatted_at)
+    {
+        line = "Date: " + httpDate(now) + "\r\n";
+        formatted_at = now;
+    }
+    return line;
+}
+
+/*
+    Status line and headers shared by every send path, without
+    Content-Type/Content-Length, appended straight onto out. Registered
+    codes with their standard reason are a single table append.
+*/
+void HttpResponse::appendHeaderBlock(std::string &out) const
 {
-    std::cout << "[INFO ] : [ --- HTTP RESPONSE TO STRING METHOD --- ]\n";
-    std::stringstream ss;
     std::map<std::string, std::string>::const_iterator it;
+    const StatusEntry *status = findStatus(this->_status_code);
 
-    ss << this->getStatusCode();
-    std::string response = "HTTP/1.1 " + ss.str() + " " + this->_status_message + "\r\n";
-    
-    // CRITICAL FIX: Handle Set-Cookie headers specially
-    std::vector<std::string> set_cookie_headers;
-    
-    // First pass: collect Set-Cookie headers and add other headers
+    if (status && (this->_status_message.empty() || this->_status_message == status->reason))
+        out += status->line;
+    else
+    {
+        out += "HTTP/1.1 ";
+        appendDecimal(out, this->_status_code);
+        out += ' ';
+        out += this->_status_message.empty() && status ? status->reason : this->_status_message;
+        out += "\r\n";
+    }
+    if (this->_headers.find("Date") == this->_headers.end())
+        out += dateHeader();
+
+    // Set-Cookie lines go last, one line each
     for (it = this->_headers.begin(); it != this->_headers.end(); ++it)
     {
-        if (it->first == "Set-Cookie") {
-            set_cookie_headers.push_back(it->second);
-            std::cout << "🍪 Found Set-Cookie header: " << it->second << std::endl;
-        } else {
-            response += it->first + ": " + it->second + "\r\n";
-            std::cout << "📤 Adding header: " << it->first << ": " << it->second << std::endl;
-        }
+        if (it->first == "Set-Cookie")
+            continue;
+        out += it->first;
+        out += ": ";
+        out += it->second;
+        out += "\r\n";
     }
-    
-    // CRITICAL: Add each Set-Cookie header on a separate line
-    for (size_t i = 0; i < set_cookie_headers.size(); ++i) {
-        response += "Set-Cookie: " + set_cookie_headers[i] + "\r\n";
-        std::cout << "🍪 Added Set-Cookie to response: " << set_cookie_headers[i] << std::endl;
+    it = this->_headers.find("Set-Cookie");
+    if (it != this->_headers.end())
+    {
+        out += "Set-Cookie: ";
+        out += it->second;
+        out += "\r\n";
     }
-    
+
     if (this->_is_chunked)
-        response += "Transfer-Encoding: chunked\r\n";
+        out += "Transfer-Encoding: chunked\r\n";
     if (this->_keep_alive)
-        response += "Connection: keep-alive\r\n";
-    if (!this->_file_path.empty())
-        this->_content_type = determineContentType(this->_file_path);
-    response += "Content-Type: " + (this->_content_type.empty() ? "text/plain" : this->_content_type) + "\r\n";
+        out += "Connection: keep-alive\r\n";
+}
+
+void HttpResponse::queueMemory(std::string &data, bool front)
+{
+    OutputPiece piece;
+
+    if (data.empty())
+        return;
+    // the bytes are moved in, never copied
+    piece.data.swap(data);
+    piece.fd = -1;
+    piece.offset = 0;
+    piece.length = piece.data.size();
+    if (front)
+        this->_output.push_front(piece);
+    else
+        this->_output.push_back(piece);
+}
+
+void HttpResponse::queueFile(off_t offset, size_t length)
+{
+    OutputPiece piece;
+
+    if (length == 0)
+        return;
+    piece.fd = this->_body_fd;
+    piece.offset = offset;
+    piece.length = length;
+    this->_output.push_back(piece);
+}
+
+void HttpResponse::openBodyFile()
+{
+    if (this->_body_fd >= 0)
+        return;
+    this->_body_fd = open(this->_file_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (this->_body_fd < 0)
+    {
+        LOG_ERROR("Error opening file: " << this->_file_path);
+        throw HttpException(404, "Not Found", NOT_FOUND);
+    }
+}
+
+/*
+    Lays the whole response out as output pieces on the first flush: the
+    status line and headers are one piece, a body buffer is moved in behind
+    it and file bodies stay on disk as spans for sendfile. Only an encoded
+    file stream is produced later, block by block, in refillOutput.
+*/
+void HttpResponse::queueOutput()
+{
+    std::string head;
+    size_t body_length = 0;
+
+    this->_output_ready = true;
+    head.reserve(512);
+    this->appendHeaderBlock(head);
+    if (this->_no_body)
+    {
+        // headers only: 204/304 carry no length at all, others advertise an empty
+        // body unless the handler already set Content-Length itself (HEAD)
+        if (this->_status_code != 204 && this->_status_code != 304 && this->_headers.find("Content-Length") == this->_headers.end())
+            head += "Content-Length: 0\r\n";
+        head += "\r\n";
+        this->queueMemory(head);
+        return;
+    }
+    if (!this->_file_path.empty() && this->_content_type.empty())
+        this->_content_type = MimeTypes::TypeOf(this->_file_path);
+    head += "Content-Type: ";
+    head += this->_content_type.empty() ? "text/plain" : this->_content_type;
+    head += "\r\n";
 
-    std::string body;
     if (!this->_buffer.empty())
     {
-        body = this->_buffer;
-        std::stringstream ss;
-        ss << body.size();
-        response += "Content-Length: " + ss.str() + "\r\n";
+        // the whole body is at hand here, so it is encoded in one go and keeps a Content-Length
+        if (this->_compressor)
+            this->_buffer = this->_compressor->Compress(this->_buffer.data(), this->_buffer.size(), true);
+        body_length = this->_buffer.size();
+        this->queueMemory(this->_buffer);
+    }
+    else if (!this->_segments.empty())
+    {
+        this->openBodyFile();
+        body_length = this->getSegmentsLength();
+        for (size_t i = 0; i < this->_segments.size(); ++i)
+        {
+            if (this->_segments[i].literal.empty())
+                this->queueFile(this->_segments[i].offset, this->_segments[i].length);
+            else
+                this->queueMemory(this->_segments[i].literal);
+        }
     }
     else if (!this->_file_path.empty())
     {
-        std::string normalized_path = this->_file_path;
-        std::string file_name = normalized_path;
-        std::ifstream file(file_name.c_str(), std::ios::binary);
-        if (!file)
+        struct stat file_stat;
+
+        this->openBodyFile();
+        if (fstat(this->_body_fd, &file_stat) < 0)
+        {
+            LOG_ERROR("Error reading file status: " << this->_file_path);
+            throw HttpException(500, "Internal Server Error", INTERNAL_SERVER_ERROR);
+        }
+        if (this->_compressor && this->_is_chunked)
+            this->_streaming = true;
+        else if (this->_compressor)
+        {
+            std::string body(file_stat.st_size, '\0');
+            if (pread(this->_body_fd, &body[0], body.size(), 0) != static_cast<ssize_t>(body.size()))
+            {
+                LOG_ERROR("Error reading file: " << this->_file_path);
+                throw HttpException(500, "Internal Server Error", INTERNAL_SERVER_ERROR);
+            }
+            body = this->_compressor->Compress(body.data(), body.size(), true);
+            body_length = body.size();
+            this->queueMemory(body);
+        }
+        else
         {
-            std::cerr << "Error opening file: " << file_name << std::endl;
-            throw HttpException(404, "Not Found", NOT_FOUND);
+            body_length = file_stat.st_size;
+            this->queueFile(0, body_length);
         }
-        std::ostringstream file_stream;
-        file_stream << file.rdbuf();
-        body = file_stream.str();
-        file.close();
-        std::stringstream ss2;
-        ss2 << body.size();
-        response += "Content-Length: " + ss2.str() + "\r\n";
     }
 
-    // Final CRLF to end headers
-    response += "\r\n";
-    response += body;
-    
-    std::cout << "🔐 Final response headers:" << std::endl;
-    // Log the full response headers for debugging
-    size_t header_end = response.find("\r\n\r\n");
-    if (header_end != std::string::npos) {
-        std::string headers_only = response.substr(0, header_end);
-        std::cout << "========== RESPONSE HEADERS START ==========" << std::endl;
-        std::cout << headers_only << std::endl;
-        std::cout << "========== RESPONSE HEADERS END ==========" << std::endl;
+    if (this->_is_chunked)
+    {
+        // everything known up front is a single chunk, the encoded stream frames its own
+        if (body_length > 0)
+        {
+            std::string line;
+            appendHex(line, body_length);
+            line += "\r\n";
+            std::string crlf = "\r\n";
+            this->queueMemory(line, true);
+            this->queueMemory(crlf);
+        }
+        if (!this->_streaming)
+        {
+            std::string last_chunk = "0\r\n\r\n";
+            this->queueMemory(last_chunk);
+        }
     }
-    
-    return response;
+    else
+    {
+        head += "Content-Length: ";
+        appendDecimal(head, body_length);
+        head += "\r\n";
+    }
+    head += "\r\n";
+    this->queueMemory(head, true);
 }
 
-
-
-void HttpResponse::sendResponse(int socket_fd)
+// Reads and encodes the next block of a streamed file, false once the stream is complete
+bool HttpResponse::refillOutput()
 {
-    std::cout << "[Debug : ] ---Start of Sending A response--- !!\n";
+    if (!this->_streaming || !this->_compressor || this->_compressor->IsFinished())
+        return false;
 
-    std::string response = this->toString();
-    
-    ssize_t bytes_sent = send(socket_fd, response.c_str(), response.size(), 0);
-    if (bytes_sent < 0)
+    PooledBuffer block(OUTPUT_STREAM_BLOCK);
+    ssize_t bytes_read = pread(this->_body_fd, block.data(), OUTPUT_STREAM_BLOCK, this->_stream_offset);
+    if (bytes_read < 0)
     {
-        std::cerr << "Error sending response: " << strerror(errno) << std::endl;
+        LOG_ERROR("Error reading file chunk: " << strerror(errno));
         throw HttpException(500, "Internal Server Error", INTERNAL_SERVER_ERROR);
     }
-    std::cout << "Bytes sent: " << bytes_sent << " out of " << response.size() << " bytes" << std::endl;
-
+    this->_stream_offset += bytes_read;
+    // a short read of a regular file is its end
+    bool last = bytes_read < OUTPUT_STREAM_BLOCK;
+    // zlib may hold everything back until the last block, an empty frame would end the body early
+    std::string data = this->_compressor->Compress(block.data(), bytes_read, last);
+    if (!data.empty())
+    {
+        std::string line;
+        appendHex(line, data.size());
+        line += "\r\n";
+        std::string crlf = "\r\n";
+        this->queueMemory(line);
+        this->queueMemory(data);
+        this->queueMemory(crlf);
+    }
+    if (last)
+    {
+        std::string last_chunk = "0\r\n\r\n";
+        this->queueMemory(last_chunk);
+    }
+    return true;
 }
-#include <cstdlib>
-void HttpResponse::sendChunkedResponse(int socket_fd)
+
+/*
+    One non-blocking write from the front of the queue: consecutive memory
+    pieces are gathered into a single sendmsg, a file span goes through
+    sendfile. Returns the bytes written, or -1 when the socket is full.
+*/
+ssize_t HttpResponse::writeFront(int socket_fd)
 {
-    std::cout << "[Debug] ---Start of Sending A Chunked response---\n";
-    std::string response;
-    
-    // Handle buffer-based responses (non-file) -> BUFFER
-    if (!this->_buffer.empty())
+    OutputPiece &front = this->_output.front();
+    ssize_t written;
+
+    if (front.fd >= 0)
     {
-        std::cout << "[Debug] Sending chunked response from buffer\n";
-        response = this->toString();
-        ssize_t bytes_sent = send(socket_fd, response.c_str(), response.size(), MSG_NOSIGNAL);
-        if (bytes_sent < 0) {
-            std::cerr << "Error sending chunked response: " << strerror(errno) << std::endl;
-            throw HttpException(500, "Internal Server Error", INTERNAL_SERVER_ERROR);
+        size_t count = std::min(front.length, static_cast<size_t>(OUTPUT_FLUSH_MAX));
+#ifdef __linux__
+        off_t offset = front.offset;
+        written = sendfile(socket_fd, front.fd, &offset, count);
+#else
+        PooledBuffer buffer(OUTPUT_STREAM_BLOCK);
+        written = pread(front.fd, buffer.data(), std::min(count, buffer.size()), front.offset);
+        if (written > 0)
+            written = send(socket_fd, buffer.data(), written, MSG_NOSIGNAL | MSG_DONTWAIT);
+#endif
+    }
+    else
+    {
+        struct iovec iov[OUTPUT_IOV_MAX];
+        struct msghdr message;
+        size_t count = 0;
+
+        for (std::deque<OutputPiece>::iterator it = this->_output.begin();
+             it != this->_output.end() && it->fd < 0 && count < OUTPUT_IOV_MAX; ++it, ++count)
+        {
+            size_t skip = count == 0 ? this->_output_sent : 0;
+            iov[count].iov_base = const_cast<char *>(it->data.data()) + skip;
+            iov[count].iov_len = it->data.size() - skip;
         }
-        this->_byte_sent = this->_byte_to_send; 
-        std::cout << "Buffer response sent: " << bytes_sent << " bytes" << std::endl;
-        std::cout << "[Debug] Chunked response sent from buffer\n";
-        std::cout << "---> [DEBUG] RESPONSE SENT: " << response << std::endl;
-        return;
+        memset(&message, 0, sizeof(message));
+        message.msg_iov = iov;
+        message.msg_iovlen = count;
+        written = sendmsg(socket_fd, &message, MSG_NOSIGNAL | MSG_DONTWAIT);
     }
-    
-    // Handle file-based responses
-    std::ifstream file(this->_file_path.c_str(), std::ios::binary);
-    if (!file)
+    if (written < 0)
     {
-        std::cerr << "Error opening file: " << this->_file_path << std::endl;
-        throw HttpException(404, "Not Found", NOT_FOUND);
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+            return -1;
+        LOG_ERROR("Error sending response: " << strerror(errno));
+        throw HttpException(500, "Internal Server Error", INTERNAL_SERVER_ERROR);
     }
-    
-    // Send headers only once (when _byte_sent == 0) => FIRST CHUNK
-    if (this->_byte_sent == 0)
+    if (front.fd >= 0)
     {
-        std::ostringstream headers;
-        headers << "HTTP/1.1 200 OK\r\n";
-        headers << "Transfer-Encoding: chunked\r\n";
-        headers << "Connection: keep-alive\r\n";
-        
-        if (!this->_file_path.empty())
-            this->_content_type = determineContentType(this->_file_path);
-        headers << "Content-Type: " + (this->_content_type.empty() ? "text/plain" : this->_content_type) + "\r\n";
-        headers << "\r\n";
-        
-        std::string header_str = headers.str();
-        ssize_t header_bytes = send(socket_fd, header_str.c_str(), header_str.size(), MSG_NOSIGNAL);
-        if (header_bytes < 0) {
-            std::cerr << "Error sending headers: " << strerror(errno) << std::endl;
+        if (written == 0)
+        {
+            LOG_ERROR("Error sending response: " << this->_file_path << " shrank while being sent");
             throw HttpException(500, "Internal Server Error", INTERNAL_SERVER_ERROR);
         }
-        std::cout << "[Debug] Headers sent: " << header_bytes << " bytes\n";
-        std::cout << "[Debug] Content type: " << this->_content_type << std::endl;
+        front.offset += written;
+        front.length -= written;
+        if (front.length == 0)
+            this->_output.pop_front();
     }
-
-    // HANDLE FINAL CHUNK
-    if (this->_byte_sent >= this->_byte_to_send)
+    else
     {
-        std::cout << "[Debug] Sending final chunk (size 0)\n";
-        std::string final_chunk = "0\r\n\r\n";
-        ssize_t final_bytes = send(socket_fd, final_chunk.c_str(), final_chunk.size(), MSG_NOSIGNAL);
-        if (final_bytes < 0) {
-            std::cerr << "Error sending final chunk: " << strerror(errno) << std::endl;
-            throw HttpException(500, "Internal Server Error", INTERNAL_SERVER_ERROR);
+        size_t left = written;
+        while (left > 0)
+        {
+            size_t remaining = this->_output.front().data.size() - this->_output_sent;
+            if (left < remaining)
+            {
+                this->_output_sent += left;
+                break;
+            }
+            left -= remaining;
+            this->_output_sent = 0;
+            this->_output.pop_front();
         }
-        std::cout << "[Debug] Final chunk sent: " << final_bytes << " bytes\n";
-        return;
     }
-    file.seekg(this->_byte_sent);
-    size_t remaining_bytes = this->_byte_to_send - this->_byte_sent;
-    size_t chunk_size = std::min(static_cast<size_t>(CHUNKED_SIZE), remaining_bytes);
-    // Read chunk from file
-    std::vector<char> buffer(chunk_size);
-    file.read(buffer.data(), chunk_size);
-    if (!file && !file.eof()) {
-        std::cerr << "Error reading file chunk" << std::endl;
-        throw HttpException(500, "Internal Server Error", INTERNAL_SERVER_ERROR);
-    }
-    
-    // Get actual bytes read (might be less than requested at end of file)
-    size_t actual_bytes_read = file.gcount();
-    
-    // Create chunk response
-    std::ostringstream chunk_stream;
-    chunk_stream << std::hex << actual_bytes_read << "\r\n";
-    std::string chunk_response = chunk_stream.str();
-    chunk_response += std::string(buffer.data(), actual_bytes_read);
-    chunk_response += "\r\n";
-    ssize_t bytes_sent = send(socket_fd, chunk_response.c_str(), chunk_response.size(), MSG_NOSIGNAL);
-    if (bytes_sent < 0)
+    this->_byte_sent += written;
+    return written;
+}
+
+/*
+    Writes as much of the response as the socket takes right now and
+    remembers where it stopped. Returns true once everything is out; false
+    means the socket is full, or this client used up its share of the round,
+    and the rest goes out on the next POLLOUT.
+*/
+bool HttpResponse::flushOutput(int socket_fd)
+{
+    size_t flushed = 0;
+    bool complete = false;
+
+    if (!this->_output_ready)
+        this->queueOutput();
+    // sendfile has no MSG_DONTWAIT, client sockets are non-blocking from accept4 on
+    while (flushed < OUTPUT_FLUSH_MAX)
     {
-        std::cerr << "Error sending chunk: " << strerror(errno) << std::endl;
-        throw HttpException(500, "Internal Server Error", INTERNAL_SERVER_ERROR);
+        if (this->_output.empty())
+        {
+            if (!this->refillOutput())
+            {
+                complete = true;
+                break;
+            }
+            continue;
+        }
+        ssize_t written = this->writeFront(socket_fd);
+        if (written < 0)
+            break;
+        flushed += written;
     }
-    this->_byte_sent += actual_bytes_read;
-    std::cout << "[Debug] Chunk sent: size=" << actual_bytes_read 
-              << ", total_sent=" << this->_byte_sent 
-              << "/" << this->_byte_to_send << std::endl;
-    
-    file.close();
+    LOG_DEBUG("Response bytes sent: " << this->_byte_sent << (complete ? " (complete)" : " (pending)"));
+    return complete;
 }
+
 HttpResponse::~HttpResponse()
-{}
\ No newline at end of file
+{
+    delete this->_compressor;
+    if (this->_body_fd >= 0)
+        close(this->_body_fd);
+}
\ No newline at end of file